@@ -0,0 +1,384 @@
+#pragma once
+
+#include <RTPacket.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace qualisys_cpp_sdk::benchmarks
+{
+    inline std::uint64_t NowMicroseconds()
+    {
+        return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    // Little endian QTM packet writer.
+    class PacketWriter
+    {
+    public:
+        explicit PacketWriter(CRTPacket::EPacketType type)
+        {
+            Put<std::uint32_t>(0);
+            Put<std::uint32_t>(type);
+        }
+
+        template <typename T>
+        void Put(T value)
+        {
+            const auto offset = mData.size();
+            mData.resize(offset + sizeof(T));
+            std::memcpy(mData.data() + offset, &value, sizeof(T));
+        }
+
+        void PutString(const std::string& str)
+        {
+            mData.insert(mData.end(), str.begin(), str.end());
+            mData.push_back(0);
+        }
+
+        std::size_t Size() const
+        {
+            return mData.size();
+        }
+
+        void Patch(std::size_t offset, std::uint32_t value)
+        {
+            std::memcpy(mData.data() + offset, &value, sizeof(value));
+        }
+
+        std::vector<char>& Finish()
+        {
+            Patch(0, static_cast<std::uint32_t>(mData.size()));
+            return mData;
+        }
+
+    private:
+        std::vector<char> mData;
+    };
+
+    // Data packet with one 6DOF component. The QTM timestamp field holds the steady clock time (in
+    // microseconds) when the packet was built, which lets a receiver measure delivery latency.
+    inline std::vector<char> Create6DOFPacket(unsigned int frameNumber, unsigned int bodyCount, std::uint64_t timestamp)
+    {
+        PacketWriter writer(CRTPacket::PacketData);
+        writer.Put<std::uint64_t>(timestamp);
+        writer.Put<std::uint32_t>(frameNumber);
+        writer.Put<std::uint32_t>(1); // Component count
+
+        const auto componentStart = writer.Size();
+        writer.Put<std::uint32_t>(0);
+        writer.Put<std::uint32_t>(CRTPacket::Component6d);
+        writer.Put<std::uint32_t>(bodyCount);
+        writer.Put<std::uint16_t>(0); // Drop rate
+        writer.Put<std::uint16_t>(0); // Out of sync rate
+        for (unsigned int body = 0; body < bodyCount; body++)
+        {
+            writer.Put<float>(100.0f * body);
+            writer.Put<float>(200.0f);
+            writer.Put<float>(300.0f);
+            for (int i = 0; i < 9; i++)
+            {
+                writer.Put<float>(i % 4 == 0 ? 1.0f : 0.0f);
+            }
+        }
+        writer.Patch(componentStart, static_cast<std::uint32_t>(writer.Size() - componentStart));
+
+        return writer.Finish();
+    }
+
+    inline std::vector<char> CreateStringPacket(CRTPacket::EPacketType type, const std::string& str)
+    {
+        PacketWriter writer(type);
+        writer.PutString(str);
+        return writer.Finish();
+    }
+
+    inline std::vector<char> CreateEventPacket(CRTPacket::EEvent event)
+    {
+        PacketWriter writer(CRTPacket::PacketEvent);
+        writer.Put<std::uint8_t>(static_cast<std::uint8_t>(event));
+        return writer.Finish();
+    }
+
+    struct StreamOptions
+    {
+        unsigned int frameCount = 100000;
+        unsigned int bodyCount = 10;
+        unsigned int frequency = 0;          // Frames per second. 0 sends as fast as possible.
+        unsigned int handshakeDelayUs = 0;   // Simulated network round trip. Every response, also the welcome message, is
+                                             // sent this long after its command arrived, also when commands are pipelined.
+        unsigned int maxMinorVersion = 0;    // Highest accepted protocol version 1.x, 0 accepts any.
+    };
+
+    // Minimal loopback stand-in for the QTM RT server. Answers the connect handshake and streams
+    // synthetic 6DOF frames over TCP, or UDP if the StreamFrames command asks for it.
+    // Listens on the little endian port, so pass GetBasePort() to CRTProtocol::Connect.
+    class BenchmarkServer
+    {
+    public:
+        explicit BenchmarkServer(const StreamOptions& options) : mOptions(options)
+        {
+            mListenSocket = socket(AF_INET, SOCK_STREAM, 0);
+            int reuse = 1;
+            setsockopt(mListenSocket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+            sockaddr_in addr {};
+            addr.sin_family = AF_INET;
+            addr.sin_port = 0;
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            if (bind(mListenSocket, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || listen(mListenSocket, 4) != 0)
+            {
+                std::perror("BenchmarkServer");
+            }
+
+            socklen_t length = sizeof(addr);
+            getsockname(mListenSocket, reinterpret_cast<sockaddr*>(&addr), &length);
+            mPort = ntohs(addr.sin_port);
+
+            mThread = std::thread([this]() { Run(); });
+        }
+
+        ~BenchmarkServer()
+        {
+            mStop = true;
+            mThread.join();
+            close(mListenSocket);
+        }
+
+        unsigned short GetBasePort() const
+        {
+            return static_cast<unsigned short>(mPort - 1);
+        }
+
+        unsigned int GetSentFrames() const
+        {
+            return mSentFrames;
+        }
+
+    private:
+        void Run()
+        {
+            while (!mStop)
+            {
+                if (!WaitReadable(mListenSocket, 50))
+                {
+                    continue;
+                }
+                int client = accept(mListenSocket, nullptr, nullptr);
+                if (client < 0)
+                {
+                    continue;
+                }
+                int noDelay = 1;
+                setsockopt(client, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+                Serve(client);
+                close(client);
+            }
+        }
+
+        void Serve(int client)
+        {
+            // Responses wait here until their simulated round trip has passed.
+            std::deque<std::pair<std::chrono::steady_clock::time_point, std::vector<char>>> responses;
+            auto respond = [&](std::vector<char> packet)
+            {
+                responses.emplace_back(std::chrono::steady_clock::now() + std::chrono::microseconds(mOptions.handshakeDelayUs), std::move(packet));
+            };
+            auto sendDue = [&](bool all)
+            {
+                while (!responses.empty() && (all || responses.front().first <= std::chrono::steady_clock::now()))
+                {
+                    std::this_thread::sleep_until(responses.front().first);
+                    SendAll(client, responses.front().second);
+                    responses.pop_front();
+                }
+            };
+
+            respond(CreateStringPacket(CRTPacket::PacketCommand, "QTM RT Interface connected"));
+
+            std::string command;
+            while (!mStop)
+            {
+                sendDue(false);
+                int timeoutMs = 50;
+                if (!responses.empty())
+                {
+                    const auto untilDue = std::chrono::duration_cast<std::chrono::milliseconds>(responses.front().first - std::chrono::steady_clock::now());
+                    timeoutMs = std::max(0, std::min(timeoutMs, static_cast<int>(untilDue.count()) + 1));
+                }
+                if (!WaitReadable(client, timeoutMs))
+                {
+                    continue;
+                }
+                if (!ReadCommand(client, command))
+                {
+                    return;
+                }
+
+                if (command.rfind("Version ", 0) == 0)
+                {
+                    const auto minor = std::stoi(command.substr(command.find('.') + 1));
+                    if (mOptions.maxMinorVersion == 0 || minor <= static_cast<int>(mOptions.maxMinorVersion))
+                    {
+                        respond(CreateStringPacket(CRTPacket::PacketCommand, "Version set to " + command.substr(8)));
+                    }
+                    else
+                    {
+                        respond(CreateStringPacket(CRTPacket::PacketCommand, "Version NOT supported"));
+                    }
+                }
+                else if (command == "GetState")
+                {
+                    respond(CreateEventPacket(CRTPacket::EventCaptureStopped));
+                }
+                else if (command.rfind("StreamFrames Stop", 0) == 0)
+                {
+                }
+                else if (command.rfind("StreamFrames", 0) == 0)
+                {
+                    sendDue(true);
+                    Stream(client, UdpPort(command));
+                }
+                else
+                {
+                    respond(CreateStringPacket(CRTPacket::PacketCommand, "Ok"));
+                }
+            }
+        }
+
+        void Stream(int client, unsigned short udpPort)
+        {
+            int udpSocket = -1;
+            sockaddr_in udpAddr {};
+            if (udpPort != 0)
+            {
+                udpSocket = socket(AF_INET, SOCK_DGRAM, 0);
+                udpAddr.sin_family = AF_INET;
+                udpAddr.sin_port = htons(udpPort);
+                udpAddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            }
+
+            // Build the packet once and only patch timestamp and frame number, so that the server
+            // is not the bottleneck.
+            auto packet = Create6DOFPacket(0, mOptions.bodyCount, 0);
+
+            const auto start = std::chrono::steady_clock::now();
+            for (unsigned int frame = 1; frame <= mOptions.frameCount && !mStop; frame++)
+            {
+                if (mOptions.frequency > 0)
+                {
+                    std::this_thread::sleep_until(start + std::chrono::microseconds(1000000ull * frame / mOptions.frequency));
+                }
+                const auto timestamp = NowMicroseconds();
+                std::memcpy(packet.data() + 8, &timestamp, sizeof(timestamp));
+                std::memcpy(packet.data() + 16, &frame, sizeof(frame));
+                if (udpSocket != -1)
+                {
+                    // Loopback UDP drops datagrams when the receiver falls behind. Back off briefly instead.
+                    while (sendto(udpSocket, packet.data(), packet.size(), 0, reinterpret_cast<sockaddr*>(&udpAddr), sizeof(udpAddr)) < 0 && !mStop)
+                    {
+                        std::this_thread::yield();
+                    }
+                }
+                else if (!SendAll(client, packet))
+                {
+                    break;
+                }
+                mSentFrames = frame;
+            }
+
+            if (udpSocket != -1)
+            {
+                close(udpSocket);
+            }
+        }
+
+        static unsigned short UdpPort(const std::string& command)
+        {
+            const auto udp = command.find(" UDP");
+            if (udp == std::string::npos)
+            {
+                return 0;
+            }
+            const auto end = command.find(' ', udp + 1);
+            const auto colon = command.rfind(':', end);
+            return static_cast<unsigned short>(std::stoi(command.substr(colon + 1, end - colon - 1)));
+        }
+
+        static bool WaitReadable(int socket, int timeoutMs)
+        {
+            pollfd pfd { socket, POLLIN, 0 };
+            return poll(&pfd, 1, timeoutMs) > 0;
+        }
+
+        static bool ReadAll(int socket, char* data, std::size_t size)
+        {
+            while (size > 0)
+            {
+                auto received = recv(socket, data, size, 0);
+                if (received <= 0)
+                {
+                    return false;
+                }
+                data += received;
+                size -= static_cast<std::size_t>(received);
+            }
+            return true;
+        }
+
+        static bool ReadCommand(int socket, std::string& command)
+        {
+            std::uint32_t header[2];
+            if (!ReadAll(socket, reinterpret_cast<char*>(header), sizeof(header)) || header[0] < sizeof(header))
+            {
+                return false;
+            }
+            std::vector<char> body(header[0] - sizeof(header));
+            if (!ReadAll(socket, body.data(), body.size()))
+            {
+                return false;
+            }
+            command.assign(body.data(), strnlen(body.data(), body.size()));
+            return true;
+        }
+
+        static bool SendAll(int socket, const std::vector<char>& data)
+        {
+            std::size_t sent = 0;
+            while (sent < data.size())
+            {
+                auto result = send(socket, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+                if (result <= 0)
+                {
+                    return false;
+                }
+                sent += static_cast<std::size_t>(result);
+            }
+            return true;
+        }
+
+    private:
+        StreamOptions mOptions;
+        int mListenSocket;
+        unsigned short mPort;
+        std::atomic<bool> mStop { false };
+        std::atomic<unsigned int> mSentFrames { 0 };
+        std::thread mThread;
+    };
+}
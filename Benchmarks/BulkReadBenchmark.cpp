@@ -0,0 +1,184 @@
+// Measures reading all 3D markers of a packet, one marker at a time with Get3DMarker and in one pass with the
+// bulk Get3DMarkers, into an array of markers and into one array per coordinate, with the occluded markers as
+// a bit mask. Little endian packets are copied as they are, big endian ones are byte swapped. Then the same
+// for the 6DOF bodies, as rotation matrices and as poses with quaternions, converted one body at a time with
+// RotationMatrixToQuaternion and in SIMD batches by the bulk Get6DOFBodies.
+
+#include "BenchmarkServer.h"
+
+#include <RTPacket.h>
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <utility>
+#include <vector>
+
+using namespace qualisys_cpp_sdk::benchmarks;
+
+namespace
+{
+    // All fields read by the benchmark are 32-bit.
+    void SwapByteOrder(std::vector<char>& packet)
+    {
+        for (std::size_t offset = 0; offset + 4 <= packet.size(); offset += 4)
+        {
+            std::swap(packet[offset], packet[offset + 3]);
+            std::swap(packet[offset + 1], packet[offset + 2]);
+        }
+    }
+
+    // Every tenth marker is occluded.
+    std::vector<char> Create3DPacket(unsigned int frameNumber, unsigned int markerCount, bool bigEndian)
+    {
+        PacketWriter writer(CRTPacket::PacketData);
+        writer.Put<std::uint64_t>(frameNumber * 1000ull);
+        writer.Put<std::uint32_t>(frameNumber);
+        writer.Put<std::uint32_t>(1);
+        writer.Put<std::uint32_t>(16 + markerCount * 12);
+        writer.Put<std::uint32_t>(CRTPacket::Component3d);
+        writer.Put<std::uint32_t>(markerCount);
+        writer.Put<std::uint32_t>(0); // Drop and out of sync rates
+        for (unsigned int marker = 0; marker < markerCount; marker++)
+        {
+            writer.Put<float>(marker % 10 == 9 ? std::numeric_limits<float>::quiet_NaN() : marker * 10.0f);
+            writer.Put<float>(frameNumber * 1.0f);
+            writer.Put<float>(1000.0f);
+        }
+        auto& packet = writer.Finish();
+        if (bigEndian)
+        {
+            SwapByteOrder(packet);
+        }
+        return packet;
+    }
+
+    // Bodies rotated about z by different angles.
+    std::vector<char> CreateRotated6DOFPacket(unsigned int frameNumber, unsigned int bodyCount, bool bigEndian)
+    {
+        auto packet = Create6DOFPacket(frameNumber, bodyCount, frameNumber * 1000ull);
+        for (unsigned int body = 0; body < bodyCount; body++)
+        {
+            const float angle = (body + frameNumber) * 0.1f;
+            const float rotation[9] = { std::cos(angle), std::sin(angle), 0.0f, -std::sin(angle), std::cos(angle), 0.0f, 0.0f, 0.0f, 1.0f };
+            std::memcpy(packet.data() + 24 + 16 + body * 48 + 12, rotation, sizeof(rotation));
+        }
+        if (bigEndian)
+        {
+            SwapByteOrder(packet);
+        }
+        return packet;
+    }
+
+    volatile float sink; // Keeps the reads
+
+    void RunBenchmark(const char* name, unsigned int itemCount, bool bigEndian, unsigned int packetCount,
+                      const std::function<std::vector<char>(unsigned int, unsigned int, bool)>& createPacket,
+                      const std::function<float(CRTPacket&)>& read)
+    {
+        std::vector<std::vector<char>> packets;
+        for (unsigned int frame = 1; frame <= 16; frame++)
+        {
+            packets.push_back(createPacket(frame, itemCount, bigEndian));
+        }
+
+        CRTPacket packet(MAJOR_VERSION, MINOR_VERSION, bigEndian);
+        float sum = 0.0f;
+        const auto start = NowMicroseconds();
+        for (unsigned int i = 0; i < packetCount; i++)
+        {
+            packet.SetData(packets[i % packets.size()].data());
+            sum += read(packet);
+        }
+        const auto elapsed = static_cast<double>(NowMicroseconds() - start);
+        sink = sum;
+
+        std::printf("  %-34s %-13s %8.1f ns/packet  %6.2f ns/item\n", name, bigEndian ? "big endian" : "little endian",
+            elapsed * 1000.0 / packetCount, elapsed * 1000.0 / packetCount / itemCount);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const unsigned int packetCount = argc > 1 ? static_cast<unsigned int>(std::atoi(argv[1])) : 200000;
+    const unsigned int markerCount = argc > 2 ? static_cast<unsigned int>(std::atoi(argv[2])) : 300;
+    const unsigned int bodyCount = argc > 3 ? static_cast<unsigned int>(std::atoi(argv[3])) : 64;
+
+    std::vector<CRTPacket::SPosition> positions(markerCount);
+    std::vector<float> x(markerCount), y(markerCount), z(markerCount);
+    std::vector<unsigned int> validMask((markerCount + 31) / 32);
+    const CRTPacket::S3DMarkerArrays arrays = { x.data(), y.data(), z.data(), nullptr, nullptr };
+
+    std::vector<CRTPacket::S6DOFBody> bodies(bodyCount);
+    std::vector<CRTPacket::SPose> poses(bodyCount);
+
+    std::printf("%u packets with %u 3D markers or %u rigid bodies.\n\n", packetCount, markerCount, bodyCount);
+
+    for (bool bigEndian : { false, true })
+    {
+        RunBenchmark("Get3DMarker per marker", markerCount, bigEndian, packetCount, Create3DPacket, [&](CRTPacket& packet)
+        {
+            float sum = 0.0f;
+            const unsigned int count = packet.Get3DMarkerCount();
+            for (unsigned int marker = 0; marker < count; marker++)
+            {
+                CRTPacket::SPosition& position = positions[marker];
+                if (packet.Get3DMarker(marker, position.x, position.y, position.z))
+                {
+                    sum += position.y;
+                }
+            }
+            return sum;
+        });
+        RunBenchmark("Get3DMarkers, markers", markerCount, bigEndian, packetCount, Create3DPacket, [&](CRTPacket& packet)
+        {
+            const unsigned int count = packet.Get3DMarkers(positions.data(), markerCount, validMask.data());
+            return count > 0 ? positions[count - 1].y + static_cast<float>(validMask[0]) : 0.0f;
+        });
+        RunBenchmark("Get3DMarkers, arrays", markerCount, bigEndian, packetCount, Create3DPacket, [&](CRTPacket& packet)
+        {
+            const unsigned int count = packet.Get3DMarkers(arrays, markerCount, validMask.data());
+            return count > 0 ? y[count - 1] + static_cast<float>(validMask[0]) : 0.0f;
+        });
+    }
+    std::printf("\n");
+    for (bool bigEndian : { false, true })
+    {
+        RunBenchmark("Get6DOFBody per body, matrix", bodyCount, bigEndian, packetCount, CreateRotated6DOFPacket, [&](CRTPacket& packet)
+        {
+            const unsigned int count = packet.Get6DOFBodyCount();
+            for (unsigned int body = 0; body < count; body++)
+            {
+                CRTPacket::S6DOFBody& sBody = bodies[body];
+                packet.Get6DOFBody(body, sBody.x, sBody.y, sBody.z, sBody.rotation);
+            }
+            return count > 0 ? bodies[count - 1].rotation[1] : 0.0f;
+        });
+        RunBenchmark("Get6DOFBodies, matrices", bodyCount, bigEndian, packetCount, CreateRotated6DOFPacket, [&](CRTPacket& packet)
+        {
+            const unsigned int count = packet.Get6DOFBodies(bodies.data(), bodyCount);
+            return count > 0 ? bodies[count - 1].rotation[1] : 0.0f;
+        });
+        RunBenchmark("Get6DOFBody per body, quaternion", bodyCount, bigEndian, packetCount, CreateRotated6DOFPacket, [&](CRTPacket& packet)
+        {
+            const unsigned int count = packet.Get6DOFBodyCount();
+            float rotation[9];
+            for (unsigned int body = 0; body < count; body++)
+            {
+                CRTPacket::SPose& pose = poses[body];
+                packet.Get6DOFBody(body, pose.position.x, pose.position.y, pose.position.z, rotation);
+                CRTPacket::RotationMatrixToQuaternion(rotation, pose.rotation);
+            }
+            return count > 0 ? poses[count - 1].rotation.z : 0.0f;
+        });
+        RunBenchmark("Get6DOFBodies, poses", bodyCount, bigEndian, packetCount, CreateRotated6DOFPacket, [&](CRTPacket& packet)
+        {
+            const unsigned int count = packet.Get6DOFBodies(poses.data(), bodyCount);
+            return count > 0 ? poses[count - 1].rotation.z : 0.0f;
+        });
+    }
+    return 0;
+}
@@ -0,0 +1,75 @@
+// Measures CRTProtocol::Connect against a loopback server with a simulated network round trip, with the
+// sequential handshake (Version, then GetState, one round trip each) and with fast connect (all handshake
+// commands sent at once, remembered protocol version). The server either supports the current protocol
+// version or only an older one, which the sequential handshake finds by trying the versions one at a time.
+
+#include "BenchmarkServer.h"
+
+#include <RTProtocol.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace qualisys_cpp_sdk::benchmarks;
+
+namespace
+{
+    bool RunBenchmark(bool fastConnect, unsigned int roundTripUs, unsigned int maxMinorVersion, int connects)
+    {
+        StreamOptions options;
+        options.handshakeDelayUs = roundTripUs;
+        options.maxMinorVersion = maxMinorVersion;
+        BenchmarkServer server(options);
+
+        CRTProtocol protocol;
+        protocol.SetFastConnect(fastConnect);
+
+        // The first connect negotiates the version, which fast connect remembers for the others.
+        std::vector<double> times;
+        for (int i = 0; i <= connects; i++)
+        {
+            const auto start = NowMicroseconds();
+            if (!protocol.Connect("127.0.0.1", server.GetBasePort()))
+            {
+                std::printf("Connect failed: %s\n", protocol.GetErrorString());
+                return false;
+            }
+            const auto end = NowMicroseconds();
+            protocol.Disconnect();
+            if (i > 0)
+            {
+                times.push_back(static_cast<double>(end - start));
+            }
+        }
+
+        std::sort(times.begin(), times.end());
+        std::printf("  %-10s round trip %5u us  server 1.%-4s  p50 %8.1f us  max %8.1f us  (%.1f round trips)\n",
+            fastConnect ? "Fast" : "Sequential", roundTripUs,
+            maxMinorVersion == 0 ? "any" : std::to_string(maxMinorVersion).c_str(),
+            times[times.size() / 2], times.back(), roundTripUs > 0 ? times[times.size() / 2] / roundTripUs : 0.0);
+        return true;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const int connects = argc > 1 ? std::atoi(argv[1]) : 20;
+    const unsigned int roundTripUs = argc > 2 ? static_cast<unsigned int>(std::atoi(argv[2])) : 2000;
+
+    std::printf("%d connects per configuration.\n\n", connects);
+
+    bool result = true;
+    for (unsigned int roundTrip : { 0u, roundTripUs })
+    {
+        for (unsigned int maxMinorVersion : { 0u, 25u })
+        {
+            for (bool fastConnect : { false, true })
+            {
+                result &= RunBenchmark(fastConnect, roundTrip, maxMinorVersion, connects);
+            }
+        }
+    }
+    return result ? 0 : 1;
+}
@@ -0,0 +1,137 @@
+// Compares the select based CNetwork receive path with CEpollNetwork by streaming synthetic 6DOF
+// frames from a loopback server through CRTProtocol::Receive. Also measures the batched UDP receive
+// (CRTProtocol::ReceiveBatch) and the receive thread (CRTProtocol::PopFrame).
+
+#include "BenchmarkServer.h"
+
+#include <EpollNetwork.h>
+#include <RTProtocol.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <thread>
+
+using namespace qualisys_cpp_sdk::benchmarks;
+
+namespace
+{
+    enum class Mode
+    {
+        Receive,
+        Batch,
+        Thread
+    };
+
+    const char* const ModeName[2][3] = { { "UDP", "UDP batch", "UDP thread" }, { "TCP", "TCP batch", "TCP thread" } };
+
+    bool RunBenchmark(const char* name, const std::function<INetwork*()>& createNetwork, const StreamOptions& options, bool udp, Mode mode = Mode::Receive)
+    {
+        BenchmarkServer server(options);
+
+        CRTProtocol protocol;
+        protocol.OverrideNetwork(createNetwork());
+
+        unsigned short udpPort = 0;
+        if (!protocol.Connect("127.0.0.1", server.GetBasePort(), udp ? &udpPort : nullptr))
+        {
+            std::printf("%s: Connect failed. %s\n", name, protocol.GetErrorString());
+            return false;
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        if (!protocol.StreamFrames(CRTProtocol::EStreamRate::RateAllFrames, 0, udpPort, nullptr, CRTProtocol::cComponent6d))
+        {
+            std::printf("%s: StreamFrames failed. %s\n", name, protocol.GetErrorString());
+            return false;
+        }
+
+        if (mode == Mode::Thread && !protocol.StartReceiveThread())
+        {
+            std::printf("%s: StartReceiveThread failed. %s\n", name, protocol.GetErrorString());
+            return false;
+        }
+
+        unsigned int frames = 0;
+        CRTPacket::EPacketType type;
+        auto lastPacketTime = NowMicroseconds();
+        while (mode == Mode::Thread && frames < options.frameCount && protocol.IsReceiveThreadRunning())
+        {
+            auto packet = protocol.PopFrame();
+            if (packet == nullptr)
+            {
+                // Frames dropped by the queue never arrive, so stop when the stream goes quiet.
+                if (NowMicroseconds() - lastPacketTime > 200000)
+                {
+                    break;
+                }
+                std::this_thread::yield();
+                continue;
+            }
+            lastPacketTime = NowMicroseconds();
+            if (packet->GetType() == CRTPacket::PacketData)
+            {
+                frames++;
+            }
+        }
+        while (mode == Mode::Batch && frames < options.frameCount)
+        {
+            unsigned int batchFrames;
+            auto response = protocol.ReceiveBatch(batchFrames, CRTProtocol::cDefaultBatchRingSize, 200000);
+            if (response != CNetwork::ResponseType::success)
+            {
+                break;
+            }
+            for (unsigned int i = 0; i < batchFrames; i++)
+            {
+                if (protocol.GetBatchPacket(i)->GetType() == CRTPacket::PacketData)
+                {
+                    frames++;
+                }
+            }
+        }
+        while (mode == Mode::Receive && frames < options.frameCount)
+        {
+            // UDP frames may be dropped on loopback, so stop when the stream goes quiet.
+            auto response = protocol.Receive(type, true, 200000);
+            if (response != CNetwork::ResponseType::success)
+            {
+                break;
+            }
+            if (type == CRTPacket::PacketData)
+            {
+                frames++;
+            }
+        }
+        const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::printf("%-22s %-10s %8u frames  %10.0f frames/s  %8.1f ns/frame\n",
+            name, (udp ? ModeName[0][static_cast<int>(mode)] : ModeName[1][static_cast<int>(mode)]), frames, frames / elapsed, elapsed * 1e9 / (frames > 0 ? frames : 1));
+
+        protocol.Disconnect();
+        if (mode == Mode::Thread && protocol.GetDroppedFrameCount() > 0)
+        {
+            std::printf("%22s %u frames dropped by the receive queue\n", "", protocol.GetDroppedFrameCount());
+        }
+        return true;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    StreamOptions options;
+    options.frameCount = argc > 1 ? static_cast<unsigned int>(std::atoi(argv[1])) : 200000;
+    options.bodyCount = argc > 2 ? static_cast<unsigned int>(std::atoi(argv[2])) : 10;
+
+    std::printf("Streaming %u frames with %u 6DOF bodies each.\n\n", options.frameCount, options.bodyCount);
+
+    bool result = true;
+    for (bool udp : { false, true })
+    {
+        result &= RunBenchmark("CNetwork (select)", []() { return new CNetwork(); }, options, udp);
+        result &= RunBenchmark("CEpollNetwork (epoll)", []() { return new CEpollNetwork(); }, options, udp);
+    }
+    result &= RunBenchmark("CNetwork (select)", []() { return new CNetwork(); }, options, true, Mode::Batch);
+    result &= RunBenchmark("CNetwork (select)", []() { return new CNetwork(); }, options, false, Mode::Thread);
+    return result ? 0 : 1;
+}
@@ -0,0 +1,118 @@
+// Measures packet log playback through CRTProtocol, as fast as possible. A log of 6DOF frames is recorded
+// first, then played back with Receive, which gets each packet straight from the memory mapped log, and
+// with ProcessReadable, which copies the packets into the receive buffer like it does for a socket.
+
+#include "BenchmarkServer.h"
+
+#include <PacketLog.h>
+#include <RTProtocol.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+
+using namespace qualisys_cpp_sdk;
+using namespace qualisys_cpp_sdk::benchmarks;
+
+namespace
+{
+    bool RecordLog(const std::string& fileName, unsigned int frameCount, unsigned int bodyCount)
+    {
+        PacketLogWriter log(fileName.c_str());
+        if (!log.IsOpen())
+        {
+            std::printf("Failed to create packet log: %s\n", log.GetErrorString());
+            return false;
+        }
+        CRTPacket packet;
+        for (unsigned int frame = 1; frame <= frameCount; frame++)
+        {
+            auto data = Create6DOFPacket(frame, bodyCount, frame * 1000ull);
+            packet.SetData(data.data());
+            log.Append(packet);
+        }
+        if (!log.Close() || log.GetDroppedCount() > 0)
+        {
+            std::printf("Failed to record packet log: %s\n", log.GetErrorString());
+            return false;
+        }
+        return true;
+    }
+
+    bool RunBenchmark(const std::string& fileName, bool zeroCopy, unsigned int frameCount)
+    {
+        auto* playback = new PacketLogNetwork(fileName.c_str());
+        CRTProtocol protocol;
+        protocol.OverrideNetwork(playback);
+        if (!protocol.Connect("127.0.0.1") || !protocol.StreamFrames(CRTProtocol::cComponent6d))
+        {
+            std::printf("Playback failed: %s\n", protocol.GetErrorString());
+            return false;
+        }
+
+        unsigned int   frames = 0;
+        volatile float sum = 0.0f; // Keeps the reads
+        auto readFrame = [&](CRTPacket::EPacketType type, CRTPacket* packet)
+        {
+            if (type != CRTPacket::PacketData)
+            {
+                return;
+            }
+            float x, y, z, rotation[9];
+            for (unsigned int body = 0; body < packet->Get6DOFBodyCount(); body++)
+            {
+                packet->Get6DOFBody(body, x, y, z, rotation);
+                sum = sum + x;
+            }
+            frames++;
+        };
+
+        const auto start = NowMicroseconds();
+        while (!playback->IsFinished())
+        {
+            if (zeroCopy)
+            {
+                CRTPacket::EPacketType type;
+                if (protocol.Receive(type, true, 0) != CNetwork::ResponseType::success)
+                {
+                    break;
+                }
+                readFrame(type, protocol.GetRTPacket());
+            }
+            else if (protocol.ProcessReadable(readFrame) != CNetwork::ResponseType::success)
+            {
+                break;
+            }
+        }
+        const auto elapsed = static_cast<double>(NowMicroseconds() - start);
+
+        std::printf("  %-16s %8u frames  %8.0f ms  %10.0f frames/s\n", zeroCopy ? "Receive" : "ProcessReadable",
+            frames, elapsed / 1000.0, frames * 1000000.0 / elapsed);
+        return frames == frameCount;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const unsigned int frameCount = argc > 1 ? static_cast<unsigned int>(std::atoi(argv[1])) : 200000;
+    const unsigned int bodyCount = argc > 2 ? static_cast<unsigned int>(std::atoi(argv[2])) : 10;
+    const auto fileName = (std::filesystem::temp_directory_path() / "qualisys_cpp_sdk_packet_log_benchmark.qpl").string();
+
+    if (!RecordLog(fileName, frameCount, bodyCount))
+    {
+        return 1;
+    }
+    std::printf("%u frames with %u rigid bodies, as fast as possible.\n\n", frameCount, bodyCount);
+
+    bool result = true;
+    for (bool zeroCopy : { true, false })
+    {
+        result &= RunBenchmark(fileName, zeroCopy, frameCount);
+    }
+
+    for (unsigned int index = 0; std::filesystem::remove(PacketLogWriter::GetSegmentFileName(fileName, index)); index++)
+    {
+    }
+    return result ? 0 : 1;
+}
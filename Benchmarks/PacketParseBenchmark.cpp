@@ -0,0 +1,276 @@
+// Measures CRTPacket::SetData and reading the packet, for packets with 6DOF only and for packets that also
+// carry 2D from many cameras, analog, force and skeletons. A consumer that only reads 6DOF doesn't pay for
+// indexing the cameras and devices of the other components, IndexComponents shows the cost when it does.
+// The camera count varies between the packets, and the heap allocations while parsing are counted.
+
+#include "BenchmarkServer.h"
+
+#include <RTPacket.h>
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <new>
+#include <vector>
+
+using namespace qualisys_cpp_sdk::benchmarks;
+
+namespace
+{
+    std::atomic<unsigned long long> allocationCount(0);
+}
+
+void* operator new(std::size_t size)
+{
+    allocationCount++;
+    if (void* memory = std::malloc(size > 0 ? size : 1))
+    {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+namespace
+{
+    struct MixedPacketOptions
+    {
+        unsigned int bodyCount = 10;
+        unsigned int cameraCount = 0;
+        unsigned int markersPerCamera = 20;
+        unsigned int analogDeviceCount = 0;
+        unsigned int forcePlateCount = 0;
+        unsigned int skeletonCount = 0;
+    };
+
+    void BeginComponent(PacketWriter& writer, std::size_t& start, CRTPacket::EComponentType type, unsigned int count, bool rates)
+    {
+        start = writer.Size();
+        writer.Put<std::uint32_t>(0);
+        writer.Put<std::uint32_t>(type);
+        writer.Put<std::uint32_t>(count);
+        if (rates)
+        {
+            writer.Put<std::uint16_t>(0); // Drop rate
+            writer.Put<std::uint16_t>(0); // Out of sync rate
+        }
+    }
+
+    std::vector<char> CreateMixedPacket(unsigned int frameNumber, const MixedPacketOptions& options)
+    {
+        PacketWriter writer(CRTPacket::PacketData);
+        writer.Put<std::uint64_t>(frameNumber * 1000ull);
+        writer.Put<std::uint32_t>(frameNumber);
+        writer.Put<std::uint32_t>(0); // Component count, patched below
+        std::uint32_t componentCount = 0;
+        std::size_t   start;
+        auto endComponent = [&]()
+        {
+            writer.Patch(start, static_cast<std::uint32_t>(writer.Size() - start));
+            componentCount++;
+        };
+
+        BeginComponent(writer, start, CRTPacket::Component6d, options.bodyCount, true);
+        for (unsigned int body = 0; body < options.bodyCount; body++)
+        {
+            for (int i = 0; i < 12; i++)
+            {
+                writer.Put<float>(i < 3 ? 100.0f * body : (i - 3) % 4 == 0 ? 1.0f : 0.0f);
+            }
+        }
+        endComponent();
+
+        if (options.cameraCount > 0)
+        {
+            BeginComponent(writer, start, CRTPacket::Component2d, options.cameraCount, true);
+            for (unsigned int camera = 0; camera < options.cameraCount; camera++)
+            {
+                writer.Put<std::uint32_t>(options.markersPerCamera);
+                writer.Put<std::uint8_t>(0); // Status flags
+                for (unsigned int marker = 0; marker < options.markersPerCamera; marker++)
+                {
+                    writer.Put<std::uint32_t>(marker * 1000);
+                    writer.Put<std::uint32_t>(camera * 1000);
+                    writer.Put<std::uint16_t>(100);
+                    writer.Put<std::uint16_t>(100);
+                }
+            }
+            endComponent();
+        }
+
+        if (options.analogDeviceCount > 0)
+        {
+            BeginComponent(writer, start, CRTPacket::ComponentAnalog, options.analogDeviceCount, false);
+            for (unsigned int device = 0; device < options.analogDeviceCount; device++)
+            {
+                const unsigned int channelCount = 16;
+                const unsigned int sampleCount = 10;
+                writer.Put<std::uint32_t>(device + 1);
+                writer.Put<std::uint32_t>(channelCount);
+                writer.Put<std::uint32_t>(sampleCount);
+                writer.Put<std::uint32_t>(frameNumber * sampleCount);
+                for (unsigned int i = 0; i < channelCount * sampleCount; i++)
+                {
+                    writer.Put<float>(0.5f);
+                }
+            }
+            endComponent();
+        }
+
+        if (options.forcePlateCount > 0)
+        {
+            BeginComponent(writer, start, CRTPacket::ComponentForce, options.forcePlateCount, false);
+            for (unsigned int plate = 0; plate < options.forcePlateCount; plate++)
+            {
+                const unsigned int forceCount = 5;
+                writer.Put<std::uint32_t>(plate + 1);
+                writer.Put<std::uint32_t>(forceCount);
+                writer.Put<std::uint32_t>(frameNumber * forceCount);
+                for (unsigned int i = 0; i < forceCount * 9; i++)
+                {
+                    writer.Put<float>(1.0f);
+                }
+            }
+            endComponent();
+        }
+
+        if (options.skeletonCount > 0)
+        {
+            BeginComponent(writer, start, CRTPacket::ComponentSkeleton, options.skeletonCount, false);
+            for (unsigned int skeleton = 0; skeleton < options.skeletonCount; skeleton++)
+            {
+                const unsigned int segmentCount = 22;
+                writer.Put<std::uint32_t>(segmentCount);
+                for (unsigned int segment = 0; segment < segmentCount; segment++)
+                {
+                    writer.Put<std::uint32_t>(segment + 1);
+                    for (int i = 0; i < 7; i++)
+                    {
+                        writer.Put<float>(i == 6 ? 1.0f : 0.0f);
+                    }
+                }
+            }
+            endComponent();
+        }
+
+        writer.Patch(20, componentCount);
+        return writer.Finish();
+    }
+
+    float Read6DOF(CRTPacket& packet)
+    {
+        float sum = 0.0f;
+        float x, y, z, rotation[9];
+        for (unsigned int body = 0; body < packet.Get6DOFBodyCount(); body++)
+        {
+            packet.Get6DOFBody(body, x, y, z, rotation);
+            sum += x;
+        }
+        return sum;
+    }
+
+    float ReadAll(CRTPacket& packet)
+    {
+        float sum = Read6DOF(packet);
+        unsigned int x, y;
+        unsigned short xDiameter, yDiameter;
+        for (unsigned int camera = 0; camera < packet.Get2DCameraCount(); camera++)
+        {
+            for (unsigned int marker = 0; marker < packet.Get2DMarkerCount(camera); marker++)
+            {
+                packet.Get2DMarker(camera, marker, x, y, xDiameter, yDiameter);
+                sum += static_cast<float>(x);
+            }
+        }
+        float analog[160];
+        for (unsigned int device = 0; device < packet.GetAnalogDeviceCount(); device++)
+        {
+            if (packet.GetAnalogData(device, analog, 160) > 0)
+            {
+                sum += analog[0];
+            }
+        }
+        CRTPacket::SForce forces[5];
+        for (unsigned int plate = 0; plate < packet.GetForcePlateCount(); plate++)
+        {
+            if (packet.GetForceData(plate, forces, 5) > 0)
+            {
+                sum += forces[0].fForceX;
+            }
+        }
+        CRTPacket::SSkeletonSegment segments[22];
+        for (unsigned int skeleton = 0; skeleton < packet.GetSkeletonCount(); skeleton++)
+        {
+            if (packet.GetSkeletonSegments(skeleton, segments, 22))
+            {
+                sum += segments[0].rotationW;
+            }
+        }
+        return sum;
+    }
+
+    volatile float sink; // Keeps the reads
+
+    void RunBenchmark(const char* name, const MixedPacketOptions& options, unsigned int packetCount,
+                      const std::function<float(CRTPacket&)>& read)
+    {
+        // A few different packets, like consecutive frames where cameras see a varying number of markers.
+        std::vector<std::vector<char>> packets;
+        for (unsigned int frame = 1; frame <= 16; frame++)
+        {
+            auto frameOptions = options;
+            frameOptions.cameraCount = options.cameraCount > 0 ? options.cameraCount - frame % 4 : 0;
+            packets.push_back(CreateMixedPacket(frame, frameOptions));
+        }
+
+        CRTPacket packet;
+        float sum = 0.0f;
+        const auto allocations = allocationCount.load();
+        const auto start = NowMicroseconds();
+        for (unsigned int i = 0; i < packetCount; i++)
+        {
+            packet.SetData(packets[i % packets.size()].data());
+            sum += read(packet);
+        }
+        const auto elapsed = static_cast<double>(NowMicroseconds() - start);
+        sink = sum;
+
+        std::printf("  %-34s %6zu bytes  %8.1f ns/packet  %llu allocations\n", name, packets[0].size(),
+            elapsed * 1000.0 / packetCount, allocationCount.load() - allocations);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const unsigned int packetCount = argc > 1 ? static_cast<unsigned int>(std::atoi(argv[1])) : 1000000;
+    const unsigned int cameraCount = argc > 2 ? static_cast<unsigned int>(std::atoi(argv[2])) : 48;
+
+    MixedPacketOptions sixDofOnly;
+    MixedPacketOptions mixed;
+    mixed.cameraCount = cameraCount;
+    mixed.analogDeviceCount = 4;
+    mixed.forcePlateCount = 4;
+    mixed.skeletonCount = 4;
+
+    std::printf("%u packets, 10 rigid bodies, mixed packets with %u 2D cameras.\n\n", packetCount, cameraCount);
+
+    RunBenchmark("6DOF packet, read 6DOF", sixDofOnly, packetCount, Read6DOF);
+    RunBenchmark("Mixed packet, read 6DOF", mixed, packetCount, Read6DOF);
+    RunBenchmark("Mixed packet, index all, read 6DOF", mixed, packetCount, [](CRTPacket& packet)
+    {
+        packet.IndexComponents();
+        return Read6DOF(packet);
+    });
+    RunBenchmark("Mixed packet, read all", mixed, packetCount, ReadAll);
+    return 0;
+}
@@ -0,0 +1,144 @@
+// Measures frame delivery latency with the blocking, hybrid (spin then block) and spinning receive modes
+// of CNetwork. A loopback server streams small 6DOF frames at a fixed rate. For every frame two latencies
+// are recorded:
+//   send:   server send time (in the QTM timestamp field) until CRTProtocol::Receive returns.
+//   wakeup: kernel receive timestamp until CRTProtocol::Receive returns.
+
+#include "BenchmarkServer.h"
+
+#include <RTProtocol.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace qualisys_cpp_sdk::benchmarks;
+
+namespace
+{
+    struct ReceiveMode
+    {
+        const char* name;
+        int spinTime;
+        int busyPoll;
+    };
+
+    std::uint64_t NowRealtimeNanoseconds()
+    {
+        return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count());
+    }
+
+    void PrintHistogram(const char* name, std::vector<double>& latencies)
+    {
+        if (latencies.empty())
+        {
+            std::printf("  %-7s no frames\n", name);
+            return;
+        }
+        std::sort(latencies.begin(), latencies.end());
+        auto percentile = [&latencies](double p)
+        {
+            return latencies[std::min(latencies.size() - 1, static_cast<std::size_t>(p * latencies.size()))];
+        };
+        std::printf("  %-7s p50 %7.1f us  p90 %7.1f us  p99 %7.1f us  p99.9 %7.1f us  max %8.1f us\n",
+            name, percentile(0.5), percentile(0.9), percentile(0.99), percentile(0.999), latencies.back());
+
+        const double limits[] = { 5, 10, 20, 50, 100, 200, 500, 1000 };
+        std::printf("  %-7s", "");
+        std::size_t begin = 0;
+        for (double limit : limits)
+        {
+            auto end = static_cast<std::size_t>(std::lower_bound(latencies.begin(), latencies.end(), limit) - latencies.begin());
+            std::printf(" <%-4.0f %5.1f%%", limit, 100.0 * (end - begin) / latencies.size());
+            begin = end;
+        }
+        std::printf("  >=1000 %5.1f%%\n", 100.0 * (latencies.size() - begin) / latencies.size());
+    }
+
+    bool RunBenchmark(const ReceiveMode& mode, const StreamOptions& options, bool udp, int receiveBufferSize)
+    {
+        BenchmarkServer server(options);
+
+        auto network = new CNetwork();
+        network->SetSpinTime(mode.spinTime);
+        network->SetBusyPoll(mode.busyPoll);
+        network->SetReceiveBufferSize(receiveBufferSize);
+
+        CRTProtocol protocol;
+        protocol.OverrideNetwork(network);
+
+        unsigned short udpPort = 0;
+        if (!protocol.Connect("127.0.0.1", server.GetBasePort(), udp ? &udpPort : nullptr))
+        {
+            std::printf("%s: Connect failed. %s\n", mode.name, protocol.GetErrorString());
+            return false;
+        }
+        if (!protocol.StreamFrames(CRTProtocol::EStreamRate::RateAllFrames, 0, udpPort, nullptr, CRTProtocol::cComponent6d))
+        {
+            std::printf("%s: StreamFrames failed. %s\n", mode.name, protocol.GetErrorString());
+            return false;
+        }
+
+        std::vector<double> sendLatencies;
+        std::vector<double> wakeupLatencies;
+        sendLatencies.reserve(options.frameCount);
+        wakeupLatencies.reserve(options.frameCount);
+
+        CRTPacket::EPacketType type;
+        while (sendLatencies.size() < options.frameCount)
+        {
+            if (protocol.Receive(type, true, 500000) != CNetwork::ResponseType::success)
+            {
+                break;
+            }
+            const auto now = NowMicroseconds();
+            const auto nowRealtime = NowRealtimeNanoseconds();
+            if (type != CRTPacket::PacketData)
+            {
+                continue;
+            }
+            auto packet = protocol.GetRTPacket();
+            sendLatencies.push_back(static_cast<double>(now - packet->GetTimeStamp()));
+            if (packet->GetReceiveTimestamp() != 0)
+            {
+                wakeupLatencies.push_back((static_cast<double>(nowRealtime) - static_cast<double>(packet->GetReceiveTimestamp())) / 1000.0);
+            }
+        }
+        protocol.Disconnect();
+
+        std::printf("%s %s, %zu frames\n", mode.name, udp ? "UDP" : "TCP", sendLatencies.size());
+        PrintHistogram("send", sendLatencies);
+        PrintHistogram("wakeup", wakeupLatencies);
+        return true;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    StreamOptions options;
+    options.frameCount = argc > 1 ? static_cast<unsigned int>(std::atoi(argv[1])) : 5000;
+    options.frequency = argc > 2 ? static_cast<unsigned int>(std::atoi(argv[2])) : 1000;
+    options.bodyCount = 1;
+    const int receiveBufferSize = argc > 3 ? std::atoi(argv[3]) : 0;
+
+    std::printf("Streaming %u frames at %u Hz.\n\n", options.frameCount, options.frequency);
+
+    const ReceiveMode modes[] = {
+        { "Blocking", 0, 0 },
+        { "Hybrid (spin 200 us)", 200, 50 },
+        { "Spinning", -1, 50 },
+    };
+
+    bool result = true;
+    for (bool udp : { false, true })
+    {
+        for (const auto& mode : modes)
+        {
+            result &= RunBenchmark(mode, options, udp, receiveBufferSize);
+        }
+    }
+    return result ? 0 : 1;
+}
@@ -0,0 +1,369 @@
+#define _CRT_SECURE_NO_WARNINGS
+
+#include "CaptureSink.h"
+
+#include <algorithm>
+#include <cstring>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+using namespace qualisys_cpp_sdk;
+
+
+CaptureFileSink::CaptureFileSink(const char* fileName, unsigned int chunkSize, bool mapFile) :
+    mFile(nullptr),
+    mFileDescriptor(-1),
+    mMapping(nullptr),
+    mSize(0),
+    mWritten(0),
+    mChunkSize(std::max(1u, chunkSize)),
+    mChunk(0),
+    mChunkFill(0),
+    mPendingChunk(-1),
+    mPendingSize(0),
+    mStopWriter(false),
+    mFailed(false)
+{
+#ifndef _WIN32
+    if (mapFile)
+    {
+        mFileDescriptor = open(fileName, O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (mFileDescriptor == -1)
+        {
+            SetError("Failed to open file.");
+        }
+        return;
+    }
+#else
+    (void)mapFile;
+#endif
+    mFile = std::fopen(fileName, "wb");
+    if (mFile == nullptr)
+    {
+        SetError("Failed to open file.");
+        return;
+    }
+    // Whole chunks are written, stdio buffering would only add a copy.
+    std::setvbuf(mFile, nullptr, _IONBF, 0);
+}
+
+
+CaptureFileSink::~CaptureFileSink()
+{
+    End(false);
+}
+
+
+bool CaptureFileSink::IsOpen() const
+{
+    return mFile != nullptr || mFileDescriptor != -1;
+}
+
+
+bool CaptureFileSink::Begin(unsigned int size)
+{
+    if (!IsOpen())
+    {
+        return false;
+    }
+    mSize    = size;
+    mWritten = 0;
+
+#ifndef _WIN32
+    if (mFileDescriptor != -1)
+    {
+        if (size == 0)
+        {
+            return true;
+        }
+#ifdef __linux__
+        // Reserve the blocks up front, so the file isn't fragmented and the disk can't fill up halfway.
+        const bool allocated = posix_fallocate(mFileDescriptor, 0, size) == 0;
+#else
+        const bool allocated = false;
+#endif
+        if (!allocated && ftruncate(mFileDescriptor, size) != 0)
+        {
+            SetError("Failed to allocate file.");
+            return false;
+        }
+        void* mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, mFileDescriptor, 0);
+        if (mapping == MAP_FAILED)
+        {
+            SetError("Failed to map file.");
+            return false;
+        }
+        mMapping = static_cast<char*>(mapping);
+        return true;
+    }
+#endif
+
+    const unsigned int chunkSize = std::min(mChunkSize, std::max(size, 1u));
+    mChunks[0].resize(chunkSize);
+    mChunks[1].resize(chunkSize);
+    mChunkSize    = chunkSize;
+    mChunk        = 0;
+    mChunkFill    = 0;
+    mPendingChunk = -1;
+    mStopWriter   = false;
+    mWriter       = std::thread([this]() { WriterThread(); });
+    return true;
+}
+
+
+char* CaptureFileSink::GetWriteBuffer(unsigned int& size)
+{
+    if (mFailed || mWritten >= mSize)
+    {
+        return nullptr;
+    }
+    if (mMapping != nullptr)
+    {
+        size = std::min(mChunkSize, mSize - mWritten);
+        return mMapping + mWritten;
+    }
+    size = std::min(mChunkSize - mChunkFill, mSize - mWritten);
+    return mChunks[mChunk].data() + mChunkFill;
+}
+
+
+bool CaptureFileSink::Commit(unsigned int size)
+{
+    mWritten += size;
+    if (mMapping == nullptr)
+    {
+        mChunkFill += size;
+        if (mChunkFill == mChunkSize || mWritten == mSize)
+        {
+            SubmitChunk();
+        }
+    }
+    return !mFailed;
+}
+
+
+bool CaptureFileSink::End(bool success)
+{
+    if (mWriter.joinable())
+    {
+        if (success && mChunkFill > 0)
+        {
+            SubmitChunk();
+        }
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mStopWriter = true;
+        }
+        mCondition.notify_all();
+        mWriter.join();
+    }
+    if (mFile != nullptr)
+    {
+        std::fclose(mFile);
+        mFile = nullptr;
+    }
+#ifndef _WIN32
+    if (mMapping != nullptr)
+    {
+        munmap(mMapping, mSize);
+        mMapping = nullptr;
+    }
+    if (mFileDescriptor != -1)
+    {
+        close(mFileDescriptor);
+        mFileDescriptor = -1;
+    }
+#endif
+    return success && !mFailed;
+}
+
+
+const char* CaptureFileSink::GetErrorString() const
+{
+    return mErrorStr.c_str();
+}
+
+
+// Hand the current chunk to the I/O thread and continue with the other one, once that has been written.
+void CaptureFileSink::SubmitChunk()
+{
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mCondition.wait(lock, [this]() { return mPendingChunk == -1; });
+        if (mFailed)
+        {
+            return;
+        }
+        mPendingChunk = static_cast<int>(mChunk);
+        mPendingSize  = mChunkFill;
+    }
+    mCondition.notify_all();
+    mChunk ^= 1;
+    mChunkFill = 0;
+}
+
+
+void CaptureFileSink::WriterThread()
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    while (true)
+    {
+        mCondition.wait(lock, [this]() { return mPendingChunk != -1 || mStopWriter; });
+        if (mPendingChunk == -1)
+        {
+            return;
+        }
+
+        const char*        data = mChunks[mPendingChunk].data();
+        const unsigned int size = mPendingSize;
+        lock.unlock();
+        const bool written = std::fwrite(data, 1, size, mFile) == size;
+        lock.lock();
+
+        if (!written)
+        {
+            mFailed   = true;
+            mErrorStr = "Failed to write file to disk.";
+        }
+        mPendingChunk = -1;
+        mCondition.notify_all();
+    }
+}
+
+
+void CaptureFileSink::SetError(const char* error)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mFailed   = true;
+    mErrorStr = error;
+}
+
+
+CaptureMemorySink::CaptureMemorySink(std::vector<char>& buffer) :
+    mBuffer(&buffer),
+    mMapping(nullptr),
+    mData(nullptr),
+    mSize(0),
+    mWritten(0)
+{
+}
+
+
+CaptureMemorySink::CaptureMemorySink() :
+    mBuffer(nullptr),
+    mMapping(nullptr),
+    mData(nullptr),
+    mSize(0),
+    mWritten(0)
+{
+}
+
+
+CaptureMemorySink::~CaptureMemorySink()
+{
+    ReleaseMapping();
+}
+
+
+const char* CaptureMemorySink::GetData() const
+{
+    return mData;
+}
+
+
+unsigned int CaptureMemorySink::GetSize() const
+{
+    return mWritten;
+}
+
+
+bool CaptureMemorySink::Begin(unsigned int size)
+{
+    ReleaseMapping();
+    mSize    = size;
+    mWritten = 0;
+    mData    = nullptr;
+
+    if (mBuffer != nullptr)
+    {
+        mBuffer->resize(size);
+        mData = mBuffer->data();
+        return true;
+    }
+
+    if (size == 0)
+    {
+        return true;
+    }
+#ifdef _WIN32
+    void* mapping = VirtualAlloc(nullptr, size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+    if (mapping == nullptr)
+#else
+    void* mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapping == MAP_FAILED)
+#endif
+    {
+        mErrorStr = "Failed to allocate memory for the capture.";
+        return false;
+    }
+    mMapping = static_cast<char*>(mapping);
+    mData    = mMapping;
+    return true;
+}
+
+
+char* CaptureMemorySink::GetWriteBuffer(unsigned int& size)
+{
+    if (mWritten >= mSize)
+    {
+        return nullptr;
+    }
+    size = mSize - mWritten;
+    return mData + mWritten;
+}
+
+
+bool CaptureMemorySink::Commit(unsigned int size)
+{
+    mWritten += size;
+    return true;
+}
+
+
+bool CaptureMemorySink::End(bool success)
+{
+    if (!success)
+    {
+        mErrorStr = "Capture transfer failed.";
+    }
+    return success;
+}
+
+
+const char* CaptureMemorySink::GetErrorString() const
+{
+    return mErrorStr.c_str();
+}
+
+
+void CaptureMemorySink::ReleaseMapping()
+{
+    if (mMapping != nullptr)
+    {
+#ifdef _WIN32
+        VirtualFree(mMapping, 0, MEM_RELEASE);
+#else
+        munmap(mMapping, mSize);
+#endif
+        mMapping = nullptr;
+    }
+}
@@ -0,0 +1,117 @@
+#ifndef CAPTURE_SINK_H
+#define CAPTURE_SINK_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace qualisys_cpp_sdk
+{
+    // Destination of the C3D or QTM file received by CRTProtocol::GetCapture. The file is received straight
+    // into the buffers that the sink hands out, so the sink decides where the bytes end up without an
+    // extra copy.
+    class ICaptureSink
+    {
+    public:
+        virtual ~ICaptureSink() = default;
+
+        // Called once, with the size of the file, before any data.
+        virtual bool  Begin(unsigned int size) = 0;
+        // Buffer for the next bytes of the file, size is set to its size. nullptr on error.
+        virtual char* GetWriteBuffer(unsigned int& size) = 0;
+        // size bytes have been written to the start of the last write buffer.
+        virtual bool  Commit(unsigned int size) = 0;
+        // Called once at the end, also when the transfer failed. Returns false if the file couldn't be stored.
+        virtual bool  End(bool success) = 0;
+        virtual const char* GetErrorString() const = 0;
+    };
+
+    // Writes the capture to a file while it is being received. Data is received into one of two chunk
+    // buffers while the other one is written to disk on a separate I/O thread, so network receive and disk
+    // writes overlap. With mapFile, the file is instead preallocated at full size and memory mapped, and
+    // the data is received straight into the mapping (not on Windows, where the I/O thread is used).
+    class CaptureFileSink : public ICaptureSink
+    {
+    public:
+        static const unsigned int cDefaultChunkSize = 4 * 1024 * 1024;
+
+        CaptureFileSink(const char* fileName, unsigned int chunkSize = cDefaultChunkSize, bool mapFile = false);
+        ~CaptureFileSink() override;
+
+        CaptureFileSink(const CaptureFileSink&) = delete;
+        CaptureFileSink& operator=(const CaptureFileSink&) = delete;
+
+        bool  IsOpen() const;
+
+        bool  Begin(unsigned int size) override;
+        char* GetWriteBuffer(unsigned int& size) override;
+        bool  Commit(unsigned int size) override;
+        bool  End(bool success) override;
+        const char* GetErrorString() const override;
+
+    private:
+        void  SubmitChunk();
+        void  WriterThread();
+        void  SetError(const char* error);
+
+        std::FILE*              mFile;
+        int                     mFileDescriptor; // Only with a mapped file
+        char*                   mMapping;
+        unsigned int            mSize;
+        unsigned int            mWritten;        // Committed bytes
+        unsigned int            mChunkSize;
+        std::vector<char>       mChunks[2];
+        unsigned int            mChunk;          // The chunk being received into
+        unsigned int            mChunkFill;
+        std::thread             mWriter;
+        std::mutex              mMutex;
+        std::condition_variable mCondition;
+        int                     mPendingChunk;   // Chunk waiting for, or being written by, the I/O thread. -1 if none.
+        unsigned int            mPendingSize;
+        bool                    mStopWriter;
+        std::atomic<bool>       mFailed;
+        std::string             mErrorStr;
+    };
+
+    // Receives the capture into memory. The buffer is sized once, from the file size in the packet header,
+    // and the file is received straight into it, so it never touches the file system.
+    class CaptureMemorySink : public ICaptureSink
+    {
+    public:
+        // Receive into a caller provided buffer, which is resized to the file size.
+        explicit CaptureMemorySink(std::vector<char>& buffer);
+        // Receive into an anonymous memory mapping owned by the sink. Unlike a vector, its pages are not
+        // written until the file data arrives.
+        CaptureMemorySink();
+        ~CaptureMemorySink() override;
+
+        CaptureMemorySink(const CaptureMemorySink&) = delete;
+        CaptureMemorySink& operator=(const CaptureMemorySink&) = delete;
+
+        // The received file. Valid until the sink is destroyed or used for another capture.
+        const char*  GetData() const;
+        unsigned int GetSize() const;
+
+        bool  Begin(unsigned int size) override;
+        char* GetWriteBuffer(unsigned int& size) override;
+        bool  Commit(unsigned int size) override;
+        bool  End(bool success) override;
+        const char* GetErrorString() const override;
+
+    private:
+        void  ReleaseMapping();
+
+        std::vector<char>* mBuffer;
+        char*              mMapping;
+        char*              mData;
+        unsigned int       mSize;
+        unsigned int       mWritten;
+        std::string        mErrorStr;
+    };
+}
+
+#endif // CAPTURE_SINK_H
@@ -0,0 +1,314 @@
+#define _CRT_SECURE_NO_WARNINGS
+
+#include "DiscoveryService.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+using namespace qualisys_cpp_sdk;
+
+namespace
+{
+    // The discovery thread checks for Stop and Refresh at least this often.
+    constexpr unsigned long long cMaxWaitMicroseconds = 50000;
+
+    constexpr int cDiscoverPacketSize = 10;
+
+    unsigned long long NowMicroseconds()
+    {
+        return static_cast<unsigned long long>(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+}
+
+
+std::string DiscoveredServer::GetAddressString() const
+{
+    const auto* bytes = reinterpret_cast<const unsigned char*>(&address);
+    char text[16];
+    std::snprintf(text, sizeof(text), "%u.%u.%u.%u", bytes[0], bytes[1], bytes[2], bytes[3]);
+    return text;
+}
+
+
+std::string DiscoveredServer::GetHostName() const
+{
+    return message.substr(0, message.find(','));
+}
+
+
+DiscoveryService::DiscoveryService(unsigned short discoverPort, unsigned long long broadcastInterval, unsigned long long expiry) :
+    mNetwork(new CNetwork()),
+    mDiscoverPort(discoverPort),
+    mServerPort(0),
+    mBroadcastInterval(std::max(1ull, broadcastInterval)),
+    mExpiry(expiry),
+    mNoLocalResponses(false),
+    mReceiveBuffer(65536),
+    mStopThread(false),
+    mBroadcastNow(false)
+{
+}
+
+
+DiscoveryService::~DiscoveryService()
+{
+    Stop();
+    delete mNetwork;
+}
+
+
+void DiscoveryService::OverrideNetwork(INetwork* network)
+{
+    Stop();
+    delete mNetwork;
+    mNetwork = network;
+}
+
+
+bool DiscoveryService::Start(const ServerCallback& callback, bool noLocalResponses)
+{
+    Stop();
+
+    unsigned short serverPort = 0;
+    if (!mNetwork->CreateUDPSocket(serverPort, true))
+    {
+        mErrorStr = mNetwork->GetErrorString();
+        return false;
+    }
+    mServerPort       = serverPort;
+    mCallback         = callback;
+    mNoLocalResponses = noLocalResponses;
+    mStopThread       = false;
+    mBroadcastNow     = false;
+    mThread           = std::thread([this]() { DiscoveryThread(); });
+    return true;
+}
+
+
+void DiscoveryService::Stop()
+{
+    mStopThread = true;
+    if (mThread.joinable())
+    {
+        mThread.join();
+        mNetwork->Disconnect();
+    }
+}
+
+
+bool DiscoveryService::IsRunning() const
+{
+    return mThread.joinable() && !mStopThread;
+}
+
+
+void DiscoveryService::Refresh()
+{
+    mBroadcastNow = true;
+}
+
+
+std::vector<DiscoveredServer> DiscoveryService::GetServers() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mServers;
+}
+
+
+bool DiscoveryService::FindServer(const std::string& name, DiscoveredServer& server) const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return FindServerLocked(name, server);
+}
+
+
+bool DiscoveryService::WaitForServers(unsigned int count, int timeoutMicroseconds) const
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    auto enough = [&]() { return mServers.size() >= count; };
+    if (timeoutMicroseconds < 0)
+    {
+        mServersChanged.wait(lock, enough);
+        return true;
+    }
+    return mServersChanged.wait_for(lock, std::chrono::microseconds(timeoutMicroseconds), enough);
+}
+
+
+bool DiscoveryService::Connect(CRTProtocol& protocol, const std::string& name, int timeoutMicroseconds, unsigned short* udpServerPort)
+{
+    DiscoveredServer server;
+    if (!FindServer(name, server))
+    {
+        if (timeoutMicroseconds == 0 || !IsRunning())
+        {
+            mErrorStr = "Server " + name + " has not been discovered.";
+            return false;
+        }
+        Refresh();
+
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(timeoutMicroseconds);
+        std::unique_lock<std::mutex> lock(mMutex);
+        auto found = [&]() { return FindServerLocked(name, server); };
+        if (timeoutMicroseconds < 0)
+        {
+            mServersChanged.wait(lock, found);
+        }
+        else if (!mServersChanged.wait_until(lock, deadline, found))
+        {
+            mErrorStr = "Server " + name + " has not been discovered.";
+            return false;
+        }
+    }
+
+    if (!protocol.Connect(server.GetAddressString().c_str(), server.basePort, udpServerPort))
+    {
+        mErrorStr = protocol.GetErrorString();
+        return false;
+    }
+    return true;
+} // Connect
+
+
+const char* DiscoveryService::GetErrorString() const
+{
+    return mErrorStr.c_str();
+}
+
+
+void DiscoveryService::DiscoveryThread()
+{
+    unsigned long long nextBroadcast = 0;
+    unsigned long long nextInterfaceRefresh = 0;
+    std::vector<Notification> notifications;
+
+    while (!mStopThread)
+    {
+        auto now = NowMicroseconds();
+        if (mBroadcastNow.exchange(false) || now >= nextBroadcast)
+        {
+            if (now >= nextInterfaceRefresh)
+            {
+                mNetwork->RefreshInterfaces();
+                nextInterfaceRefresh = now + cInterfaceRefreshInterval;
+            }
+            Broadcast();
+            nextBroadcast = now + mBroadcastInterval;
+        }
+
+        const auto wait = std::min(nextBroadcast - now, cMaxWaitMicroseconds);
+        unsigned int address = 0;
+        auto response = mNetwork->ReceiveUdpBroadcast(mReceiveBuffer.data(), (int)mReceiveBuffer.size(), (int)wait, &address);
+
+        now = NowMicroseconds();
+        if (response && response.received > 8)
+        {
+            HandleResponse(address, now, notifications);
+        }
+        else if (response.type == CNetwork::ResponseType::error)
+        {
+            // E.g. the network went down. Don't spin, wait for the next broadcast.
+            std::this_thread::sleep_for(std::chrono::microseconds(wait));
+        }
+        Expire(now, notifications);
+
+        if (!notifications.empty())
+        {
+            if (mCallback)
+            {
+                for (const auto& notification : notifications)
+                {
+                    mCallback(notification.event, notification.server);
+                }
+            }
+            notifications.clear();
+        }
+    }
+} // DiscoveryThread
+
+
+bool DiscoveryService::FindServerLocked(const std::string& name, DiscoveredServer& server) const
+{
+    for (const auto& candidate : mServers)
+    {
+        if (candidate.GetAddressString() == name || candidate.GetHostName() == name)
+        {
+            server = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+
+// Send the discover packet on all interfaces at once. The responses are collected by the discovery thread.
+bool DiscoveryService::Broadcast()
+{
+    char data[cDiscoverPacketSize];
+    *((unsigned int*)data)         = (unsigned int)cDiscoverPacketSize;
+    *((unsigned int*)(data + 4))   = (unsigned int)CRTPacket::PacketDiscover;
+    *((unsigned short*)(data + 8)) = htons(mServerPort);
+
+    return mNetwork->SendUDPBroadcast(data, cDiscoverPacketSize, mDiscoverPort);
+}
+
+
+void DiscoveryService::HandleResponse(unsigned int address, unsigned long long now, std::vector<Notification>& notifications)
+{
+    char* data = mReceiveBuffer.data();
+    if (CRTPacket::GetType(data) != CRTPacket::PacketCommand)
+    {
+        return;
+    }
+    const char* message = CRTPacket::GetCommandString(data);
+    if (message == nullptr)
+    {
+        return;
+    }
+    const bool local = mNetwork->IsLocalAddress(address);
+    if (local && mNoLocalResponses)
+    {
+        return;
+    }
+    const unsigned short basePort = static_cast<unsigned short>(CRTPacket::GetDiscoverResponseBasePort(data));
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto server = std::find_if(mServers.begin(), mServers.end(), [&](const DiscoveredServer& candidate)
+    {
+        return candidate.address == address && candidate.basePort == basePort;
+    });
+    if (server == mServers.end())
+    {
+        mServers.push_back({ address, basePort, message, local, now });
+        notifications.push_back({ EEvent::Found, mServers.back() });
+        mServersChanged.notify_all();
+        return;
+    }
+    server->lastSeen = now;
+    if (server->message != message)
+    {
+        server->message = message;
+        notifications.push_back({ EEvent::Changed, *server });
+    }
+} // HandleResponse
+
+
+void DiscoveryService::Expire(unsigned long long now, std::vector<Notification>& notifications)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    for (auto server = mServers.begin(); server != mServers.end();)
+    {
+        if (server->lastSeen + mExpiry < now)
+        {
+            notifications.push_back({ EEvent::Lost, *server });
+            server = mServers.erase(server);
+            mServersChanged.notify_all();
+        }
+        else
+        {
+            ++server;
+        }
+    }
+}
@@ -0,0 +1,107 @@
+#ifndef DISCOVERY_SERVICE_H
+#define DISCOVERY_SERVICE_H
+
+#include "RTProtocol.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace qualisys_cpp_sdk
+{
+    struct DiscoveredServer
+    {
+        unsigned int       address;  // IPv4 address, network byte order
+        unsigned short     basePort;
+        std::string        message;  // Host name, QTM version and number of cameras, separated by commas
+        bool               local;    // Response from an interface of this computer
+        unsigned long long lastSeen; // Microseconds, steady clock
+
+        std::string GetAddressString() const;
+        std::string GetHostName() const;
+    };
+
+    // Keeps a table of the QTM servers on the network, so that they can be listed and connected to without
+    // waiting for a discovery. A background thread broadcasts a discover packet on all interfaces every
+    // broadcast interval and handles the responses as they arrive, instead of waiting for the network to
+    // go quiet like CRTProtocol::DiscoverRTServer. The interface table is read at start and then only every
+    // cInterfaceRefreshInterval.
+    // Servers that haven't responded for expiry microseconds are removed from the table.
+    class DiscoveryService
+    {
+    public:
+        static const unsigned long long cInterfaceRefreshInterval = 10000000; // 10 s
+
+        enum class EEvent
+        {
+            Found,   // New server
+            Changed, // The response message of a server changed, e.g. the number of cameras
+            Lost     // Server expired
+        };
+        // Called on the discovery thread, without any lock held.
+        using ServerCallback = std::function<void(EEvent event, const DiscoveredServer& server)>;
+
+        DiscoveryService(unsigned short discoverPort = CRTProtocol::cDefaultAutoDiscoverPort,
+                         unsigned long long broadcastInterval = 1000000, unsigned long long expiry = 3500000);
+        ~DiscoveryService();
+
+        DiscoveryService(const DiscoveryService&) = delete;
+        DiscoveryService& operator=(const DiscoveryService&) = delete;
+
+        // Replace the network, only while the service isn't running. The service takes ownership.
+        void OverrideNetwork(INetwork* network);
+
+        bool Start(const ServerCallback& callback = nullptr, bool noLocalResponses = false);
+        void Stop();
+        bool IsRunning() const;
+        // Broadcast now instead of at the next interval, e.g. when a server is expected to have started.
+        void Refresh();
+
+        std::vector<DiscoveredServer> GetServers() const;
+        // Find a server by address ("192.168.1.10") or host name.
+        bool FindServer(const std::string& name, DiscoveredServer& server) const;
+        // Wait up to timeoutMicroseconds (< 0 : no limit) for the table to hold at least count servers.
+        bool WaitForServers(unsigned int count, int timeoutMicroseconds) const;
+        // Connect protocol to a server in the table. If it isn't there yet, a broadcast is sent and
+        // the server is waited for up to timeoutMicroseconds.
+        bool Connect(CRTProtocol& protocol, const std::string& name, int timeoutMicroseconds = 0,
+                     unsigned short* udpServerPort = nullptr);
+
+        const char* GetErrorString() const;
+
+    private:
+        struct Notification
+        {
+            EEvent           event;
+            DiscoveredServer server;
+        };
+
+        void DiscoveryThread();
+        bool Broadcast();
+        bool FindServerLocked(const std::string& name, DiscoveredServer& server) const;
+        void HandleResponse(unsigned int address, unsigned long long now, std::vector<Notification>& notifications);
+        void Expire(unsigned long long now, std::vector<Notification>& notifications);
+
+        INetwork*                     mNetwork;
+        unsigned short                mDiscoverPort;
+        unsigned short                mServerPort;   // Port that the servers respond to
+        unsigned long long            mBroadcastInterval;
+        unsigned long long            mExpiry;
+        ServerCallback                mCallback;
+        bool                          mNoLocalResponses;
+        std::vector<char>             mReceiveBuffer;
+        std::thread                   mThread;
+        std::atomic<bool>             mStopThread;
+        std::atomic<bool>             mBroadcastNow;
+        mutable std::mutex            mMutex;        // Server table
+        mutable std::condition_variable mServersChanged;
+        std::vector<DiscoveredServer> mServers;
+        std::string                   mErrorStr;
+    };
+}
+
+#endif // DISCOVERY_SERVICE_H
@@ -0,0 +1,262 @@
+#define _CRT_SECURE_NO_WARNINGS
+#define NOMINMAX
+
+#include "EpollNetwork.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+
+#ifndef _WIN32
+#include <errno.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define closesocket close
+#endif
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#endif
+
+namespace
+{
+#ifdef __linux__
+    // epoll has millisecond resolution. Round up so that a short timeout never becomes a busy poll.
+    int ToEpollTimeout(int timeoutMicroseconds)
+    {
+        if (timeoutMicroseconds < 0)
+        {
+            return -1;
+        }
+        return (timeoutMicroseconds + 999) / 1000;
+    }
+
+    // epoll_wait that first polls without blocking for spinTime microseconds, see CNetwork::SetSpinTime.
+    int EpollWait(int epollFd, epoll_event* events, int maxEvents, int timeoutMicroseconds, int spinTime)
+    {
+        if (spinTime != 0)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            while (true)
+            {
+                int eventCount = epoll_wait(epollFd, events, maxEvents, 0);
+                if (eventCount != 0)
+                {
+                    return eventCount;
+                }
+                const int elapsed = (int)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+                if (spinTime > 0 && elapsed >= spinTime)
+                {
+                    if (timeoutMicroseconds > 0)
+                    {
+                        timeoutMicroseconds = std::max(0, timeoutMicroseconds - elapsed);
+                    }
+                    break;
+                }
+            }
+        }
+        return epoll_wait(epollFd, events, maxEvents, ToEpollTimeout(timeoutMicroseconds));
+    }
+#endif
+}
+
+CEpollNetwork::CEpollNetwork()
+{
+#ifdef __linux__
+    mEpollFd          = epoll_create1(EPOLL_CLOEXEC);
+    mBroadcastEpollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (mEpollFd == -1 || mBroadcastEpollFd == -1)
+    {
+        SetErrorString();
+    }
+#else
+    mEpollFd          = -1;
+    mBroadcastEpollFd = -1;
+#endif
+}
+
+
+CEpollNetwork::~CEpollNetwork()
+{
+#ifdef __linux__
+    if (mEpollFd != -1)
+    {
+        close(mEpollFd);
+    }
+    if (mBroadcastEpollFd != -1)
+    {
+        close(mBroadcastEpollFd);
+    }
+#endif
+}
+
+
+bool CEpollNetwork::Register(int epollFd, SOCKET socket)
+{
+#ifdef __linux__
+    epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events  = EPOLLIN;
+    event.data.fd = socket;
+
+    if (epoll_ctl(epollFd, EPOLL_CTL_ADD, socket, &event) != 0)
+    {
+        SetErrorString();
+        return false;
+    }
+#else
+    (void)epollFd;
+    (void)socket;
+#endif
+    return true;
+}
+
+
+bool CEpollNetwork::Connect(const char* serverAddr, unsigned short nPort)
+{
+    if (!CNetwork::Connect(serverAddr, nPort))
+    {
+        return false;
+    }
+    if (!Register(mEpollFd, mSocket))
+    {
+        closesocket(mSocket);
+        mSocket = INVALID_SOCKET;
+        return false;
+    }
+    return true;
+} // Connect
+
+
+bool CEpollNetwork::CreateUDPSocket(unsigned short &nUDPPort, bool bBroadcast)
+{
+    if (!CNetwork::CreateUDPSocket(nUDPPort, bBroadcast))
+    {
+        return false;
+    }
+
+    SOCKET& udpSocket = bBroadcast ? mUDPBroadcastSocket : mUDPSocket;
+    if (!Register(bBroadcast ? mBroadcastEpollFd : mEpollFd, udpSocket))
+    {
+        closesocket(udpSocket);
+        udpSocket = INVALID_SOCKET;
+        return false;
+    }
+    return true;
+}
+
+
+CNetwork::Response CEpollNetwork::Receive(char* rtDataBuff, int dataBufSize, bool header, int timeoutMicroseconds, unsigned int *ipAddr)
+{
+#ifdef __linux__
+    if (mEpollFd == -1)
+    {
+        return CNetwork::Receive(rtDataBuff, dataBufSize, header, timeoutMicroseconds, ipAddr);
+    }
+
+    epoll_event events[2];
+    int eventCount = EpollWait(mEpollFd, events, 2, timeoutMicroseconds, GetSpinTime(timeoutMicroseconds));
+
+    if (eventCount == -1)
+    {
+        SetErrorString();
+        return Response(CNetwork::ResponseType::error, 0);
+    }
+    if (eventCount == 0)
+    {
+        return Response(CNetwork::ResponseType::timeout, 0);
+    }
+
+    // TCP has priority over UDP, same as the select based receive.
+    const epoll_event* ready = &events[0];
+    if (eventCount > 1 && events[1].data.fd == mSocket)
+    {
+        ready = &events[1];
+    }
+
+    if (ready->data.fd == mSocket)
+    {
+        if ((ready->events & EPOLLERR) != 0)
+        {
+            SetSocketErrorString(mSocket);
+            return Response(CNetwork::ResponseType::error, 0);
+        }
+        return ReadSocket(mSocket, rtDataBuff, dataBufSize, header);
+    }
+    if (ready->data.fd == mUDPSocket)
+    {
+        if ((ready->events & EPOLLERR) != 0)
+        {
+            SetSocketErrorString(mUDPSocket);
+            return Response(CNetwork::ResponseType::error, 0);
+        }
+        return ReadUdpSocket(mUDPSocket, rtDataBuff, dataBufSize, ipAddr);
+    }
+    return Response(CNetwork::ResponseType::error, 0);
+#else
+    return CNetwork::Receive(rtDataBuff, dataBufSize, header, timeoutMicroseconds, ipAddr);
+#endif
+}
+
+
+CNetwork::Response CEpollNetwork::ReceiveRest(char* rtDataBuff, int dataBufSize, int timeoutMicroseconds)
+{
+#ifdef __linux__
+    if (mEpollFd != -1 && mSocket != INVALID_SOCKET)
+    {
+        // The rest of a packet is almost always already queued. Try to read it before waiting.
+        unsigned long long timestamp;
+        int received = RecvTimestamped(mSocket, rtDataBuff, dataBufSize, MSG_DONTWAIT, timestamp);
+        if (received > 0)
+        {
+            Response response(CNetwork::ResponseType::success, received);
+            response.timestamp = timestamp;
+            return response;
+        }
+        if (received == 0)
+        {
+            return Response(CNetwork::ResponseType::disconnect, 0);
+        }
+        if (errno != EAGAIN && errno != EWOULDBLOCK)
+        {
+            SetErrorString();
+            return Response(CNetwork::ResponseType::error, 0);
+        }
+    }
+#endif
+    return Receive(rtDataBuff, dataBufSize, false, timeoutMicroseconds);
+}
+
+
+CNetwork::Response CEpollNetwork::ReceiveUdpBroadcast(char* rtDataBuff, int dataBufSize, int timeoutMicroseconds, unsigned int *ipAddr)
+{
+#ifdef __linux__
+    if (mBroadcastEpollFd == -1)
+    {
+        return CNetwork::ReceiveUdpBroadcast(rtDataBuff, dataBufSize, timeoutMicroseconds, ipAddr);
+    }
+
+    epoll_event event;
+    int eventCount = EpollWait(mBroadcastEpollFd, &event, 1, timeoutMicroseconds, GetSpinTime(timeoutMicroseconds));
+
+    if (eventCount == -1)
+    {
+        SetErrorString();
+        return Response(CNetwork::ResponseType::error, 0);
+    }
+    if (eventCount == 0)
+    {
+        return Response(CNetwork::ResponseType::timeout, 0);
+    }
+    if ((event.events & EPOLLERR) != 0)
+    {
+        SetSocketErrorString(mUDPBroadcastSocket);
+        return Response(CNetwork::ResponseType::error, 0);
+    }
+    return ReadUdpSocket(mUDPBroadcastSocket, rtDataBuff, dataBufSize, ipAddr);
+#else
+    return CNetwork::ReceiveUdpBroadcast(rtDataBuff, dataBufSize, timeoutMicroseconds, ipAddr);
+#endif
+}
@@ -0,0 +1,34 @@
+#ifndef EPOLL_NETWORK_H
+#define EPOLL_NETWORK_H
+
+#include "Network.h"
+
+// CNetwork variant that waits for data with epoll instead of select.
+// The TCP, UDP and UDP broadcast sockets are registered once when they are created (closing a
+// socket removes it again), so a receive call does not have to rebuild any descriptor sets.
+// Reads that continue a partially received packet (ReceiveRest) are first attempted without waiting at all.
+// On platforms without epoll the class behaves exactly like CNetwork.
+//
+// Use it with CRTProtocol::OverrideNetwork(new CEpollNetwork()).
+class CEpollNetwork : public CNetwork
+{
+public:
+    CEpollNetwork();
+    ~CEpollNetwork() override;
+    bool  Connect(const char* pServerAddr, unsigned short nPort) override;
+    bool  CreateUDPSocket(unsigned short &nUDPPort, bool bBroadcast = false) override;
+
+    Response Receive(char* rtDataBuff, int nDataBufSize, bool bHeader, int timeoutMicroseconds, unsigned int *ipAddr = nullptr) override;
+    Response ReceiveRest(char* rtDataBuff, int nDataBufSize, int timeoutMicroseconds) override;
+    Response ReceiveUdpBroadcast(char* rtDataBuff, int nDataBufSize, int timeoutMicroseconds, unsigned int *ipAddr = nullptr) override;
+
+private:
+    bool Register(int epollFd, SOCKET socket);
+
+private:
+    int mEpollFd;          // TCP and UDP data sockets.
+    int mBroadcastEpollFd; // UDP broadcast socket.
+};
+
+
+#endif
@@ -0,0 +1,175 @@
+#include "FramePool.h"
+
+using namespace qualisys_cpp_sdk;
+
+// The buffers of a pool. Shared by the pool and the blocks in use, so that handles can outlive the pool.
+struct qualisys_cpp_sdk::FramePoolStorage
+{
+    std::unique_ptr<FramePoolBlock[]> blocks;
+    unsigned int                      blockCount;
+    unsigned int                      maxRetainedSize;
+    std::mutex                        mutex;
+    std::vector<FramePoolBlock*>      freeBlocks;
+};
+
+namespace
+{
+    void ReleaseBlock(FramePoolBlock* block)
+    {
+        // The last block of a destroyed pool frees the storage, and the block with it, on return.
+        std::shared_ptr<FramePoolStorage> storage = std::move(block->storage);
+
+        block->slot.packet.ClearData();
+        if (block->slot.data.size() > storage->maxRetainedSize)
+        {
+            std::vector<char>().swap(block->slot.data);
+        }
+
+        std::lock_guard<std::mutex> lock(storage->mutex);
+        storage->freeBlocks.push_back(block);
+    }
+}
+
+FrameHandle::FrameHandle() : mBlock(nullptr)
+{
+}
+
+
+FrameHandle::FrameHandle(FramePoolBlock* block) : mBlock(block)
+{
+}
+
+
+FrameHandle::FrameHandle(const FrameHandle& other) : mBlock(other.mBlock)
+{
+    if (mBlock)
+    {
+        mBlock->refCount.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+
+FrameHandle::FrameHandle(FrameHandle&& other) noexcept : mBlock(other.mBlock)
+{
+    other.mBlock = nullptr;
+}
+
+
+FrameHandle& FrameHandle::operator=(const FrameHandle& other)
+{
+    if (mBlock != other.mBlock)
+    {
+        FrameHandle copy(other);
+        std::swap(mBlock, copy.mBlock);
+    }
+    return *this;
+}
+
+
+FrameHandle& FrameHandle::operator=(FrameHandle&& other) noexcept
+{
+    if (this != &other)
+    {
+        Reset();
+        mBlock = other.mBlock;
+        other.mBlock = nullptr;
+    }
+    return *this;
+}
+
+
+FrameHandle::~FrameHandle()
+{
+    Reset();
+}
+
+
+void FrameHandle::Reset()
+{
+    if (mBlock)
+    {
+        if (mBlock->refCount.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            ReleaseBlock(mBlock);
+        }
+        mBlock = nullptr;
+    }
+}
+
+
+unsigned int FrameHandle::GetUseCount() const
+{
+    return mBlock ? mBlock->refCount.load(std::memory_order_relaxed) : 0;
+}
+
+
+void FrameHandle::Parse(unsigned int majorVersion, unsigned int minorVersion, bool bigEndian)
+{
+    if (mBlock)
+    {
+        mBlock->slot.Parse(majorVersion, minorVersion, bigEndian);
+    }
+}
+
+
+FramePool::FramePool(unsigned int blockCount, unsigned int maxRetainedSize) :
+    mStorage(std::make_shared<FramePoolStorage>())
+{
+    mStorage->blocks.reset(new FramePoolBlock[blockCount]);
+    mStorage->blockCount = blockCount;
+    mStorage->maxRetainedSize = maxRetainedSize;
+    mStorage->freeBlocks.reserve(blockCount);
+    for (unsigned int i = 0; i < blockCount; i++)
+    {
+        mStorage->blocks[i].refCount = 0;
+        mStorage->freeBlocks.push_back(&mStorage->blocks[i]);
+    }
+}
+
+
+FrameHandle FramePool::Acquire(unsigned int size)
+{
+    FramePoolBlock* block;
+    {
+        std::lock_guard<std::mutex> lock(mStorage->mutex);
+        if (mStorage->freeBlocks.empty())
+        {
+            return FrameHandle();
+        }
+        block = mStorage->freeBlocks.back();
+        mStorage->freeBlocks.pop_back();
+    }
+    block->storage = mStorage;
+
+    if (block->slot.data.size() < size)
+    {
+        block->slot.data.resize(size);
+    }
+    block->refCount.store(1, std::memory_order_relaxed);
+    return FrameHandle(block);
+}
+
+
+FrameHandle FramePool::Copy(CRTPacket& packet)
+{
+    FrameHandle handle = Acquire(packet.GetSize());
+    if (handle)
+    {
+        handle.mBlock->slot.Assign(packet);
+    }
+    return handle;
+}
+
+
+unsigned int FramePool::GetBlockCount() const
+{
+    return mStorage->blockCount;
+}
+
+
+unsigned int FramePool::GetFreeBlockCount() const
+{
+    std::lock_guard<std::mutex> lock(mStorage->mutex);
+    return static_cast<unsigned int>(mStorage->freeBlocks.size());
+}
+
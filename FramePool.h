@@ -0,0 +1,80 @@
+#ifndef FRAME_POOL_H
+#define FRAME_POOL_H
+
+#include "FrameQueue.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace qualisys_cpp_sdk
+{
+    struct FramePoolStorage;
+
+    struct FramePoolBlock
+    {
+        FrameSlot                         slot;
+        std::atomic<unsigned int>         refCount;
+        std::shared_ptr<FramePoolStorage> storage; // Set while the block is in use, keeps the blocks alive
+    };
+
+    // Reference counted handle to a pooled packet, its bytes and its parsed CRTPacket.
+    // Copying a handle shares the packet without copying any data. The block goes back to its pool when the
+    // last handle is released. Handles may be passed between threads and the packet may be read from several
+    // threads at once, but it must not be modified while it is shared. A handle stays valid after its pool is
+    // destroyed, the buffers are freed with the last handle.
+    class FrameHandle
+    {
+    public:
+        FrameHandle();
+        FrameHandle(const FrameHandle& other);
+        FrameHandle(FrameHandle&& other) noexcept;
+        FrameHandle& operator=(const FrameHandle& other);
+        FrameHandle& operator=(FrameHandle&& other) noexcept;
+        ~FrameHandle();
+
+        void Reset();
+        explicit operator bool() const { return mBlock != nullptr; }
+        CRTPacket* Get() const { return mBlock ? &mBlock->slot.packet : nullptr; }
+        CRTPacket* operator->() const { return Get(); }
+        CRTPacket& operator*() const { return *Get(); }
+        unsigned int GetUseCount() const;
+
+        // Raw packet bytes, at least the size passed to FramePool::Acquire.
+        char* GetData() const { return mBlock ? mBlock->slot.data.data() : nullptr; }
+        // Index the packet after the bytes have been written with GetData.
+        void  Parse(unsigned int majorVersion, unsigned int minorVersion, bool bigEndian);
+
+    private:
+        friend class FramePool;
+        explicit FrameHandle(FramePoolBlock* block); // Takes over a reference
+
+        FramePoolBlock* mBlock;
+    };
+
+    // Fixed number of packet buffers, allocated once. Acquiring and releasing a buffer doesn't allocate,
+    // except when a buffer has to grow for a larger packet than it has held before. To bound memory use,
+    // buffers that have grown larger than maxRetainedSize are freed when they are released.
+    class FramePool
+    {
+    public:
+        FramePool(unsigned int blockCount, unsigned int maxRetainedSize);
+
+        FramePool(const FramePool&) = delete;
+        FramePool& operator=(const FramePool&) = delete;
+
+        // Get a buffer of at least size bytes. Returns an empty handle if all buffers are in use.
+        FrameHandle Acquire(unsigned int size);
+        // Get a buffer holding a parsed copy of a packet. Returns an empty handle if all buffers are in use.
+        FrameHandle Copy(CRTPacket& packet);
+
+        unsigned int GetBlockCount() const;
+        unsigned int GetFreeBlockCount() const;
+
+    private:
+        std::shared_ptr<FramePoolStorage> mStorage;
+    };
+}
+
+#endif // FRAME_POOL_H
@@ -0,0 +1,139 @@
+#include "FrameQueue.h"
+
+#include <cstring>
+
+using namespace qualisys_cpp_sdk;
+
+void FrameSlot::Assign(CRTPacket& source)
+{
+    char*        sourceData = nullptr;
+    unsigned int size = 0;
+    source.GetData(sourceData, size);
+    if (data.size() < size)
+    {
+        data.resize(size);
+    }
+    if (size > 0)
+    {
+        memcpy(data.data(), sourceData, size);
+    }
+
+    unsigned int majorVersion;
+    unsigned int minorVersion;
+    source.GetVersion(majorVersion, minorVersion);
+    Parse(majorVersion, minorVersion, source.GetEndianness());
+    packet.SetReceiveTimestamp(source.GetReceiveTimestamp());
+}
+
+
+void FrameSlot::Parse(unsigned int majorVersion, unsigned int minorVersion, bool bigEndian)
+{
+    packet.SetVersion(majorVersion, minorVersion);
+    packet.SetEndianness(bigEndian);
+    packet.SetData(data.data());
+}
+
+
+FrameQueue::FrameQueue(unsigned int capacity)
+{
+    unsigned int size = 1;
+    while (size < capacity)
+    {
+        size <<= 1;
+    }
+    mSlots = std::vector<FrameSlot>(size);
+    mMask  = size - 1;
+    mHead  = 0;
+    mTail  = 0;
+    mHoldingSlot = false;
+    mDropped = 0;
+}
+
+
+bool FrameQueue::Push(CRTPacket& packet)
+{
+    const unsigned int head = mHead.load(std::memory_order_relaxed);
+
+    // The tail counts a slot that the consumer still holds, so it is never written to.
+    if (head - mTail.load(std::memory_order_acquire) > mMask)
+    {
+        mDropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    mSlots[head & mMask].Assign(packet);
+
+    mHead.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+
+CRTPacket* FrameQueue::Pop()
+{
+    unsigned int tail = mTail.load(std::memory_order_relaxed);
+    if (mHoldingSlot)
+    {
+        mTail.store(++tail, std::memory_order_release);
+        mHoldingSlot = false;
+    }
+
+    if (tail == mHead.load(std::memory_order_acquire))
+    {
+        return nullptr;
+    }
+    mHoldingSlot = true;
+    return &mSlots[tail & mMask].packet;
+}
+
+
+unsigned int FrameQueue::GetCapacity() const
+{
+    return mMask + 1;
+}
+
+
+unsigned int FrameQueue::GetDroppedCount() const
+{
+    return mDropped.load(std::memory_order_relaxed);
+}
+
+
+FrameMailbox::FrameMailbox()
+{
+    mBack       = 0;
+    mMiddle     = 1;
+    mFront      = 2;
+    mFrontValid = false;
+    mSkipped    = 0;
+}
+
+
+void FrameMailbox::Write(CRTPacket& packet)
+{
+    mSlots[mBack].Assign(packet);
+
+    const unsigned int previous = mMiddle.exchange(mBack | cNewData, std::memory_order_acq_rel);
+    if ((previous & cNewData) != 0)
+    {
+        mSkipped.fetch_add(1, std::memory_order_relaxed);
+    }
+    mBack = previous & ~cNewData;
+}
+
+
+CRTPacket* FrameMailbox::Read()
+{
+    if ((mMiddle.load(std::memory_order_relaxed) & cNewData) != 0)
+    {
+        const unsigned int previous = mMiddle.exchange(mFront, std::memory_order_acq_rel);
+        mFront      = previous & ~cNewData;
+        mFrontValid = true;
+    }
+    return mFrontValid ? &mSlots[mFront].packet : nullptr;
+}
+
+
+unsigned int FrameMailbox::GetSkippedCount() const
+{
+    return mSkipped.load(std::memory_order_relaxed);
+}
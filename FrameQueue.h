@@ -0,0 +1,86 @@
+#ifndef FRAME_QUEUE_H
+#define FRAME_QUEUE_H
+
+#include "RTPacket.h"
+
+#include <atomic>
+#include <vector>
+
+namespace qualisys_cpp_sdk
+{
+    // Packet bytes and a CRTPacket parsed over them.
+    struct FrameSlot
+    {
+        std::vector<char> data;
+        CRTPacket         packet;
+
+        // Copy the bytes of source and index them with the same version, byte order and receive timestamp.
+        void Assign(CRTPacket& source);
+        void Parse(unsigned int majorVersion, unsigned int minorVersion, bool bigEndian);
+    };
+
+    // Bounded single producer, single consumer queue of received packets.
+    // The producer copies each packet into a preallocated slot and parses it there, the consumer gets the
+    // parsed packet in place. Neither side locks or makes system calls. When the queue is full the new
+    // packet is dropped and counted, so a slow consumer never stalls the producer.
+    class FrameQueue
+    {
+    public:
+        // The capacity is rounded up to a power of two.
+        explicit FrameQueue(unsigned int capacity);
+
+        FrameQueue(const FrameQueue&) = delete;
+        FrameQueue& operator=(const FrameQueue&) = delete;
+
+        // Producer side. Returns false if the queue was full and the packet was dropped.
+        bool Push(CRTPacket& packet);
+
+        // Consumer side. Returns the oldest packet, or nullptr if the queue is empty. The packet stays valid
+        // until the next call, which hands its slot back to the producer.
+        CRTPacket* Pop();
+
+        unsigned int GetCapacity() const;
+        unsigned int GetDroppedCount() const;
+
+    private:
+        std::vector<FrameSlot>    mSlots;
+        unsigned int              mMask;
+        alignas(64) std::atomic<unsigned int> mHead;    // Written by the producer
+        alignas(64) std::atomic<unsigned int> mTail;    // Written by the consumer
+        bool                      mHoldingSlot;         // Consumer has not released slot mTail yet
+        std::atomic<unsigned int> mDropped;
+    };
+
+    // Latest value wins mailbox, a triple buffer. The writer always has a free slot to write to and the
+    // reader always gets the newest completely written packet. Neither side ever waits or locks.
+    // Packets that are replaced before the reader got them are counted as skipped.
+    class FrameMailbox
+    {
+    public:
+        FrameMailbox();
+
+        FrameMailbox(const FrameMailbox&) = delete;
+        FrameMailbox& operator=(const FrameMailbox&) = delete;
+
+        // Writer side.
+        void Write(CRTPacket& packet);
+
+        // Reader side. Returns the newest packet, or nullptr if nothing has been written yet. The packet stays
+        // valid until the next call.
+        CRTPacket* Read();
+
+        unsigned int GetSkippedCount() const;
+
+    private:
+        static const unsigned int cNewData = 4;     // Flag in mMiddle, the middle slot hasn't been read
+
+        FrameSlot                 mSlots[3];
+        unsigned int              mBack;            // Owned by the writer
+        alignas(64) std::atomic<unsigned int> mMiddle;
+        alignas(64) unsigned int  mFront;           // Owned by the reader
+        bool                      mFrontValid;
+        std::atomic<unsigned int> mSkipped;
+    };
+}
+
+#endif // FRAME_QUEUE_H
@@ -9,6 +9,7 @@
 #include <stdlib.h>
 #include <iostream>
 #include <algorithm>
+#include <chrono>
 
 #ifdef _WIN32
 #include <iphlpapi.h>
@@ -44,6 +45,26 @@
 
 #endif
 
+#ifdef __linux__
+namespace
+{
+    // SO_TIMESTAMPNS receive time from a received message, 0 if there is none.
+    unsigned long long ControlMessageTimestamp(msghdr& message)
+    {
+        for (cmsghdr* cmsg = CMSG_FIRSTHDR(&message); cmsg != nullptr; cmsg = CMSG_NXTHDR(&message, cmsg))
+        {
+            if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPNS)
+            {
+                timespec time;
+                memcpy(&time, CMSG_DATA(cmsg), sizeof(time));
+                return (unsigned long long)time.tv_sec * 1000000000ull + (unsigned long long)time.tv_nsec;
+            }
+        }
+        return 0;
+    }
+}
+#endif
+
 CNetwork::CNetwork()
 {
     mSocket             = INVALID_SOCKET;
@@ -51,6 +72,11 @@ CNetwork::CNetwork()
     mUDPBroadcastSocket = INVALID_SOCKET;
     mLastError          = 0;
     mErrorStr[0]        = 0;
+    mReceiveBufferSize    = 0;
+    mBusyPollMicroseconds = 0;
+    mSpinMicroseconds     = 0;
+    mReuseUdpAddress      = false;
+    mInterfacesRead       = false;
 
     InitWinsock();
 }
@@ -99,10 +125,12 @@ bool CNetwork::Connect(const char* serverAddr, unsigned short nPort)
     // Connect to QTM RT server.
 
     mSocket = socket(AF_INET, SOCK_STREAM, 0);
-    if (mSocket == -1)
+    if (mSocket == INVALID_SOCKET)
     {
         strcpy(mErrorStr, "Socket could not be created.");
+        return false;
     }
+    ApplyReceiveOptions(mSocket); // Before connect, so that the TCP window matches the buffer size.
 
     sockaddr_in sAddr;
 
@@ -157,6 +185,8 @@ bool CNetwork::Connect(const char* serverAddr, unsigned short nPort)
         return false;
     }
 
+    EnableReceiveTimestamps(mSocket);
+
     return true;
 } // Connect
 
@@ -199,6 +229,10 @@ bool CNetwork::CreateUDPSocket(unsigned short &nUDPPort, bool bBroadcast)
             // Make socket unblocking.
             if (ioctlsocket(tempSocket, FIONBIO, &argp) == 0)
             {
+                if (!bBroadcast && mReuseUdpAddress)
+                {
+                    EnableAddressReuse(tempSocket);
+                }
                 if (bind(tempSocket, (SOCKADDR *) &recvAddr, sizeof(recvAddr)) != -1)
                 {
                     nUDPPort = GetUdpServerPort(tempSocket);
@@ -221,6 +255,8 @@ bool CNetwork::CreateUDPSocket(unsigned short &nUDPPort, bool bBroadcast)
                     }
                     else
                     {
+                        EnableReceiveTimestamps(tempSocket);
+                        ApplyReceiveOptions(tempSocket);
                         mUDPSocket = tempSocket;
                         return true;
                     }
@@ -268,14 +304,49 @@ unsigned short CNetwork::GetUdpBroadcastServerPort()
     return GetUdpServerPort(mUDPBroadcastSocket);
 }
 
+SOCKET CNetwork::GetSocket() const
+{
+    return mSocket;
+}
+
+SOCKET CNetwork::GetUdpSocket() const
+{
+    return mUDPSocket;
+}
+
 
 // Receive a data packet. Data is stored in a local static buffer
 CNetwork::Response CNetwork::Receive(SOCKET socket, SOCKET udpSocket, char* rtDataBuff, int dataBufSize, bool header, int timeoutMicroseconds, unsigned int *ipAddr)
 {
-    int received = 0;
-    sockaddr_in source_addr;
-    socklen_t fromlen = sizeof(source_addr);
+    const int spinTime = GetSpinTime(timeoutMicroseconds);
+    if (spinTime != 0)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        while (true)
+        {
+            auto response = WaitAndRead(socket, udpSocket, rtDataBuff, dataBufSize, header, 0, ipAddr);
+            if (response.type != CNetwork::ResponseType::timeout)
+            {
+                return response;
+            }
+            const int elapsed = (int)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+            if (spinTime > 0 && elapsed >= spinTime)
+            {
+                if (timeoutMicroseconds > 0)
+                {
+                    timeoutMicroseconds = std::max(0, timeoutMicroseconds - elapsed);
+                }
+                break;
+            }
+        }
+    }
+    return WaitAndRead(socket, udpSocket, rtDataBuff, dataBufSize, header, timeoutMicroseconds, ipAddr);
+}
+
 
+// Wait with select for data on the TCP or UDP socket, and read it.
+CNetwork::Response CNetwork::WaitAndRead(SOCKET socket, SOCKET udpSocket, char* rtDataBuff, int dataBufSize, bool header, int timeoutMicroseconds, unsigned int *ipAddr)
+{
     fd_set readFDs, exceptFDs;
     FD_ZERO(&readFDs);
     FD_ZERO(&exceptFDs);
@@ -324,55 +395,284 @@ CNetwork::Response CNetwork::Receive(SOCKET socket, SOCKET udpSocket, char* rtDa
         return Response(CNetwork::ResponseType::timeout, 0);
     }
 
-    if (FD_ISSET(socket, &exceptFDs))
+    // FD_ISSET is undefined for INVALID_SOCKET, when only one of the sockets is waited for.
+    if (socket != INVALID_SOCKET && FD_ISSET(socket, &exceptFDs))
     {
         // General socket error
         FD_CLR(socket, &exceptFDs);
         SetErrorString();
         return Response(CNetwork::ResponseType::error, 0);
     }
-    else if (FD_ISSET(socket, &readFDs))
+    else if (socket != INVALID_SOCKET && FD_ISSET(socket, &readFDs))
     {
-        received = recv(socket, rtDataBuff, header ? 8 : dataBufSize, 0);
         FD_CLR(socket, &readFDs);
-        if (selectRes == SOCKET_ERROR)
-        {
-            SetErrorString();
-            return Response(CNetwork::ResponseType::error, 0);
-        }
-        if (received == 0)
-        {
-            return Response(CNetwork::ResponseType::disconnect, 0);
-        }
-        return Response(CNetwork::ResponseType::success, received);
+        return ReadSocket(socket, rtDataBuff, dataBufSize, header);
     }
-    else if (FD_ISSET(udpSocket, &exceptFDs))
+    else if (udpSocket != INVALID_SOCKET && FD_ISSET(udpSocket, &exceptFDs))
     {
         // General socket error
         FD_CLR(udpSocket, &exceptFDs);
         SetErrorString();
         return Response(CNetwork::ResponseType::error, 0);
     }
-    else if (FD_ISSET(udpSocket, &readFDs))
+    else if (udpSocket != INVALID_SOCKET && FD_ISSET(udpSocket, &readFDs))
     {
-        received = recvfrom(udpSocket, rtDataBuff, dataBufSize, 0, (sockaddr*)&source_addr, &fromlen);
         FD_CLR(udpSocket, &readFDs);
-        if (ipAddr)
+        return ReadUdpSocket(udpSocket, rtDataBuff, dataBufSize, ipAddr);
+    }
+    return Response(CNetwork::ResponseType::error, 0);
+}
+
+
+// Read from a TCP socket that is known to be readable.
+CNetwork::Response CNetwork::ReadSocket(SOCKET socket, char* rtDataBuff, int dataBufSize, bool header)
+{
+    unsigned long long timestamp;
+    int received = RecvTimestamped(socket, rtDataBuff, header ? 8 : dataBufSize, 0, timestamp);
+    if (received == SOCKET_ERROR)
+    {
+        SetErrorString();
+        return Response(CNetwork::ResponseType::error, 0);
+    }
+    if (received == 0)
+    {
+        return Response(CNetwork::ResponseType::disconnect, 0);
+    }
+    Response response(CNetwork::ResponseType::success, received);
+    response.timestamp = timestamp;
+    return response;
+}
+
+
+// Read one datagram from a UDP socket that is known to be readable.
+CNetwork::Response CNetwork::ReadUdpSocket(SOCKET udpSocket, char* rtDataBuff, int dataBufSize, unsigned int *ipAddr)
+{
+    sockaddr_in source_addr;
+    unsigned long long timestamp;
+
+    int received = RecvTimestamped(udpSocket, rtDataBuff, dataBufSize, 0, timestamp, &source_addr);
+    if (received == SOCKET_ERROR)
+    {
+        SetErrorString();
+        return Response(CNetwork::ResponseType::error, 0);
+    }
+    if (ipAddr)
+    {
+        *ipAddr = source_addr.sin_addr.s_addr;
+    }
+    if (received == 0)
+    {
+        return Response(CNetwork::ResponseType::disconnect, 0);
+    }
+    Response response(CNetwork::ResponseType::success, received);
+    response.timestamp = timestamp;
+    response.datagram  = true;
+    return response;
+}
+
+
+// recv/recvfrom that also returns the time the data was received. On Linux this is the kernel receive
+// timestamp (SO_TIMESTAMPNS, see EnableReceiveTimestamps), elsewhere timestamp is set to 0.
+// For TCP, the timestamp is that of the last segment read.
+int CNetwork::RecvTimestamped(SOCKET socket, char* rtDataBuff, int dataBufSize, int flags, unsigned long long& timestamp, sockaddr_in* sourceAddr)
+{
+    timestamp = 0;
+
+#ifdef __linux__
+    iovec iov;
+    iov.iov_base = rtDataBuff;
+    iov.iov_len  = dataBufSize;
+
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(timespec))];
+
+    msghdr message;
+    memset(&message, 0, sizeof(message));
+    message.msg_name       = sourceAddr;
+    message.msg_namelen    = sourceAddr ? sizeof(sockaddr_in) : 0;
+    message.msg_iov        = &iov;
+    message.msg_iovlen     = 1;
+    message.msg_control    = control;
+    message.msg_controllen = sizeof(control);
+
+    int received = recvmsg(socket, &message, flags);
+    if (received > 0)
+    {
+        timestamp = ControlMessageTimestamp(message);
+    }
+    return received;
+#else
+    socklen_t fromlen = sizeof(sockaddr_in);
+    return recvfrom(socket, rtDataBuff, dataBufSize, flags, (sockaddr*)sourceAddr, sourceAddr ? &fromlen : nullptr);
+#endif
+}
+
+
+void CNetwork::SetReceiveBufferSize(int bytes)
+{
+    mReceiveBufferSize = bytes;
+}
+
+
+void CNetwork::SetBusyPoll(int microseconds)
+{
+    mBusyPollMicroseconds = microseconds;
+}
+
+
+void CNetwork::SetSpinTime(int microseconds)
+{
+    mSpinMicroseconds = microseconds;
+}
+
+
+// Time to poll without blocking, before a receive with the given timeout starts waiting.
+// -1 means for the whole (infinite) timeout.
+int CNetwork::GetSpinTime(int timeoutMicroseconds) const
+{
+    if (mSpinMicroseconds == 0 || timeoutMicroseconds == 0)
+    {
+        return 0;
+    }
+    if (mSpinMicroseconds < 0)
+    {
+        return timeoutMicroseconds;
+    }
+    if (timeoutMicroseconds < 0)
+    {
+        return mSpinMicroseconds;
+    }
+    return std::min(mSpinMicroseconds, timeoutMicroseconds);
+}
+
+
+// Socket options from SetReceiveBufferSize and SetBusyPoll. Failures are not fatal, the socket then just
+// keeps the system defaults.
+void CNetwork::ApplyReceiveOptions(SOCKET socket)
+{
+    if (mReceiveBufferSize > 0)
+    {
+        setsockopt(socket, SOL_SOCKET, SO_RCVBUF, (const char*)&mReceiveBufferSize, sizeof(mReceiveBufferSize));
+    }
+#ifdef SO_BUSY_POLL
+    if (mBusyPollMicroseconds > 0)
+    {
+        setsockopt(socket, SOL_SOCKET, SO_BUSY_POLL, (const char*)&mBusyPollMicroseconds, sizeof(mBusyPollMicroseconds));
+    }
+#endif
+}
+
+
+// Let other sockets bind the same UDP port, to receive the same multicast groups.
+void CNetwork::EnableAddressReuse(SOCKET socket)
+{
+    int enable = 1;
+    setsockopt(socket, SOL_SOCKET, SO_REUSEADDR, (const char*)&enable, sizeof(enable));
+#ifdef SO_REUSEPORT
+    setsockopt(socket, SOL_SOCKET, SO_REUSEPORT, (const char*)&enable, sizeof(enable));
+#endif
+}
+
+
+bool CNetwork::JoinMulticastGroup(const char* groupAddr, unsigned short udpPort, const char* interfaceAddr)
+{
+    if (mUDPSocket == INVALID_SOCKET)
+    {
+        if (udpPort == 0)
         {
-            *ipAddr = source_addr.sin_addr.s_addr;
+            strcpy(mErrorStr, "A multicast group needs a fixed UDP port.");
+            return false;
         }
-        if (selectRes == SOCKET_ERROR)
+        if (!CreateReusableUDPSocket(udpPort))
         {
-            SetErrorString();
-            return Response(CNetwork::ResponseType::error, 0);
+            return false;
+        }
+    }
+    else
+    {
+        const unsigned short boundPort = GetUdpServerPort(mUDPSocket);
+        if (udpPort != 0 && boundPort != udpPort)
+        {
+            strcpy(mErrorStr, "The UDP data socket is bound to another port.");
+            return false;
         }
-        if (received == 0)
+        if (!HasAddressReuse(mUDPSocket))
         {
-            return Response(CNetwork::ResponseType::disconnect, 0);
+            // The options only apply to a bind, so the socket is replaced by one that is bound with them.
+            closesocket(mUDPSocket);
+            mUDPSocket = INVALID_SOCKET;
+            if (!CreateReusableUDPSocket(boundPort))
+            {
+                strcpy(mErrorStr, "Failed to bind the UDP data socket again with address reuse.");
+                return false;
+            }
         }
-        return Response(CNetwork::ResponseType::success, received);
     }
-    return Response(CNetwork::ResponseType::error, 0);
+    return SetMulticastMembership(IP_ADD_MEMBERSHIP, groupAddr, interfaceAddr);
+}
+
+
+bool CNetwork::CreateReusableUDPSocket(unsigned short udpPort)
+{
+    mReuseUdpAddress = true;
+    const bool created = CreateUDPSocket(udpPort);
+    mReuseUdpAddress = false;
+    return created;
+}
+
+
+bool CNetwork::HasAddressReuse(SOCKET socket)
+{
+    int enabled = 0;
+    socklen_t size = sizeof(enabled);
+    return getsockopt(socket, SOL_SOCKET, SO_REUSEADDR, (char*)&enabled, &size) == 0 && enabled != 0;
+}
+
+
+bool CNetwork::LeaveMulticastGroup(const char* groupAddr, const char* interfaceAddr)
+{
+    if (mUDPSocket == INVALID_SOCKET)
+    {
+        strcpy(mErrorStr, "No UDP data socket.");
+        return false;
+    }
+    return SetMulticastMembership(IP_DROP_MEMBERSHIP, groupAddr, interfaceAddr);
+}
+
+
+bool CNetwork::SetMulticastMembership(int option, const char* groupAddr, const char* interfaceAddr)
+{
+    ip_mreq request;
+    memset(&request, 0, sizeof(request));
+    if (groupAddr == nullptr || inet_pton(AF_INET, groupAddr, &request.imr_multiaddr) != 1 ||
+        !IN_MULTICAST(ntohl(request.imr_multiaddr.s_addr)))
+    {
+        strcpy(mErrorStr, "Invalid multicast group address.");
+        return false;
+    }
+    request.imr_interface.s_addr = htonl(INADDR_ANY);
+    if (interfaceAddr != nullptr && inet_pton(AF_INET, interfaceAddr, &request.imr_interface) != 1)
+    {
+        strcpy(mErrorStr, "Invalid multicast interface address.");
+        return false;
+    }
+    if (setsockopt(mUDPSocket, IPPROTO_IP, option, (const char*)&request, sizeof(request)) != 0)
+    {
+        SetErrorString();
+        return false;
+    }
+    return true;
+}
+
+
+void CNetwork::EnableReceiveTimestamps(SOCKET socket)
+{
+#ifdef __linux__
+    // Not fatal, packets just get no receive timestamp.
+    int enable = 1;
+    setsockopt(socket, SOL_SOCKET, SO_TIMESTAMPNS, &enable, sizeof(enable));
+#else
+    (void)socket;
+#endif
 }
 
 
@@ -384,7 +684,125 @@ CNetwork::Response CNetwork::Receive(char* rtDataBuff, int dataBufSize, bool hea
 
 CNetwork::Response CNetwork::ReceiveUdpBroadcast(char* rtDataBuff, int dataBufSize, int timeoutMicroseconds, unsigned int *ipAddr)
 {
-    return Receive(static_cast<SOCKET>(SOCKET_ERROR), mUDPBroadcastSocket, rtDataBuff, dataBufSize, false, timeoutMicroseconds, ipAddr);
+    return Receive(INVALID_SOCKET, mUDPBroadcastSocket, rtDataBuff, dataBufSize, false, timeoutMicroseconds, ipAddr);
+}
+
+
+CNetwork::Response CNetwork::ReceiveUdpBatch(char* const* buffers, int bufferSize, int* sizes, int maxCount, int timeoutMicroseconds, unsigned long long* timestamps)
+{
+    if (mUDPSocket == INVALID_SOCKET)
+    {
+        strcpy(mErrorStr, "No UDP socket created.");
+        return Response(CNetwork::ResponseType::error, 0);
+    }
+    if (maxCount <= 0)
+    {
+        return Response(CNetwork::ResponseType::success, 0);
+    }
+
+    // Drain whatever is already queued before waiting.
+    int count = ReadUdpBatch(mUDPSocket, buffers, bufferSize, sizes, maxCount, timestamps);
+    if (count < 0)
+    {
+        return Response(CNetwork::ResponseType::error, 0);
+    }
+    if (count == 0)
+    {
+        Response response = Receive(INVALID_SOCKET, mUDPSocket, buffers[0], bufferSize, false, timeoutMicroseconds);
+        if (response.type != CNetwork::ResponseType::success)
+        {
+            return response;
+        }
+        sizes[0] = response.received;
+        if (timestamps)
+        {
+            timestamps[0] = response.timestamp;
+        }
+        count = 1 + std::max(0, ReadUdpBatch(mUDPSocket, buffers + 1, bufferSize, sizes + 1, maxCount - 1, timestamps ? timestamps + 1 : nullptr));
+    }
+    return Response(CNetwork::ResponseType::success, count);
+}
+
+
+// Read queued datagrams from a non-blocking UDP socket without waiting.
+// Returns the number of datagrams read or -1 on error.
+int CNetwork::ReadUdpBatch(SOCKET udpSocket, char* const* buffers, int bufferSize, int* sizes, int maxCount, unsigned long long* timestamps)
+{
+    int total = 0;
+
+#ifdef __linux__
+    const int maxMessagesPerCall = 64;
+    mmsghdr   messages[maxMessagesPerCall];
+    iovec     iovecs[maxMessagesPerCall];
+    alignas(cmsghdr) char control[maxMessagesPerCall][CMSG_SPACE(sizeof(timespec))];
+
+    while (total < maxCount)
+    {
+        const int count = std::min(maxCount - total, maxMessagesPerCall);
+
+        memset(messages, 0, sizeof(mmsghdr) * count);
+        for (int i = 0; i < count; i++)
+        {
+            iovecs[i].iov_base = buffers[total + i];
+            iovecs[i].iov_len  = bufferSize;
+            messages[i].msg_hdr.msg_iov    = &iovecs[i];
+            messages[i].msg_hdr.msg_iovlen = 1;
+            messages[i].msg_hdr.msg_control    = control[i];
+            messages[i].msg_hdr.msg_controllen = sizeof(control[i]);
+        }
+
+        int received = recvmmsg(udpSocket, messages, count, MSG_DONTWAIT, nullptr);
+        if (received < 0)
+        {
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+            {
+                break;
+            }
+            SetErrorString();
+            return total > 0 ? total : -1;
+        }
+        for (int i = 0; i < received; i++)
+        {
+            sizes[total + i] = (int)messages[i].msg_len;
+            if (timestamps)
+            {
+                timestamps[total + i] = ControlMessageTimestamp(messages[i].msg_hdr);
+            }
+        }
+        total += received;
+        if (received < count)
+        {
+            break;
+        }
+    }
+#else
+    // The UDP socket is non-blocking, see CreateUDPSocket.
+    while (total < maxCount)
+    {
+        unsigned long long timestamp;
+        int received = RecvTimestamped(udpSocket, buffers[total], bufferSize, 0, timestamp);
+        if (received == SOCKET_ERROR)
+        {
+#ifdef _WIN32
+            if (WSAGetLastError() == WSAEWOULDBLOCK)
+#else
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+#endif
+            {
+                break;
+            }
+            SetErrorString();
+            return total > 0 ? total : -1;
+        }
+        if (timestamps)
+        {
+            timestamps[total] = timestamp;
+        }
+        sizes[total++] = received;
+    }
+#endif
+
+    return total;
 }
 
 
@@ -413,90 +831,24 @@ bool CNetwork::SendUDPBroadcast(const char* sendBuf, int size, short port, unsig
 
     if (mUDPBroadcastSocket != INVALID_SOCKET)
     {
-#ifdef _WIN32
-        IP_ADAPTER_INFO* ifap = nullptr;
-        IP_ADAPTER_INFO* ifa = nullptr;
-        ULONG ulLen = 0;
-        DWORD erradapt;
-        
-        // Find all network interfaces.
-        erradapt = ::GetAdaptersInfo(ifap, &ulLen);
-        if (erradapt == ERROR_BUFFER_OVERFLOW)
-        {
-            ifap = (IP_ADAPTER_INFO*)malloc(ulLen);
-            erradapt = ::GetAdaptersInfo(ifap, &ulLen);      
-        }
+        ReadInterfaces();
 
-        if (erradapt == ERROR_SUCCESS)
+        sockaddr_in recvAddr;
+        recvAddr.sin_family = AF_INET;
+        recvAddr.sin_port = htons(port);
+
+        // Send broadcast on all interfaces, without waiting in between.
+        for (const auto& netInterface : mInterfaces)
         {
-            sockaddr_in recvAddr;
-            recvAddr.sin_family = AF_INET;
-            recvAddr.sin_port = htons(port);
-            recvAddr.sin_addr.s_addr = 0xffffffff;
-
-            // Send broadcast on all Ethernet interfaces.
-            ifa = ifap;
-            while (ifa)
+            recvAddr.sin_addr.s_addr = netInterface.addr | (~netInterface.mask);
+            if (recvAddr.sin_addr.s_addr != (filterAddr | (~netInterface.mask)))
             {
-                if (ifa->Type == MIB_IF_TYPE_ETHERNET)
+                if (sendto(mUDPBroadcastSocket, sendBuf, size, 0, (sockaddr*)&recvAddr, sizeof(recvAddr)) == size)
                 {
-                    unsigned int nIPaddr;
-                    unsigned int nIPmask;
-                    
-                    if (inet_pton(AF_INET, ifa->IpAddressList.IpAddress.String, &nIPaddr) == 0 ||
-                        inet_pton(AF_INET, ifa->IpAddressList.IpMask.String, &nIPmask) == 0)
-                    {
-                        return false;
-                    }
-                    recvAddr.sin_addr.s_addr = nIPaddr | (~nIPmask);
-                    if (recvAddr.sin_addr.s_addr != (filterAddr | (~nIPmask)))
-                    {
-                        if (sendto(mUDPBroadcastSocket, sendBuf, size, 0, (sockaddr*)&recvAddr, sizeof(recvAddr)) == size)
-                        {
-                            broadCastSent = true;
-                        }
-                    }
+                    broadCastSent = true;
                 }
-                ifa = ifa->Next;
             }
         }
-        free(ifap);
-#else
-        // Find all network interfaces.
-        struct ifaddrs* ifap = nullptr;
-		if (getifaddrs(&ifap) == 0)
-		{
-			sockaddr_in recvAddr;
-			recvAddr.sin_family = AF_INET;
-			recvAddr.sin_port = htons(port);
-			recvAddr.sin_addr.s_addr = 0xffffffff;
-
-			// Send broadcast on all Ethernet interfaces.
-			auto* ifa = ifap;
-			while (ifa)
-			{
-				if (ifa->ifa_addr->sa_family == AF_INET)
-				{
-                    auto* sa = (struct sockaddr_in *) ifa->ifa_addr;
-                    auto ipAddr = sa->sin_addr.s_addr;
-
-                    auto* saMask = (struct sockaddr_in *) ifa->ifa_netmask;
-                    auto ipMask = saMask->sin_addr.s_addr;
-
-                    recvAddr.sin_addr.s_addr = ipAddr | (~ipMask);
-                    if (recvAddr.sin_addr.s_addr != (filterAddr | (~ipMask)))
-                    {
-                        if (sendto(mUDPBroadcastSocket, sendBuf, size, 0, (sockaddr*)&recvAddr, sizeof(recvAddr)) == size)
-                        {
-                            broadCastSent = true;
-                        }
-                    }
-				}
-				ifa = ifa->ifa_next;
-			}
-		}
-		freeifaddrs(ifap);
-#endif
     }
 
     return broadCastSent;
@@ -522,6 +874,23 @@ void CNetwork::SetErrorString()
 }
 
 
+// Set error string from the pending error of a socket, e.g. after select or epoll reported an error condition.
+void CNetwork::SetSocketErrorString(SOCKET socket)
+{
+    int socketError = 0;
+    socklen_t length = sizeof(socketError);
+    if (getsockopt(socket, SOL_SOCKET, SO_ERROR, (char*)&socketError, &length) == 0 && socketError != 0)
+    {
+#ifdef _WIN32
+        WSASetLastError(socketError);
+#else
+        errno = socketError;
+#endif
+    }
+    SetErrorString();
+}
+
+
 char* CNetwork::GetErrorString()
 {
     return mErrorStr;
@@ -536,58 +905,77 @@ int CNetwork::GetError() const
 
 bool CNetwork::IsLocalAddress(unsigned int nAddr) const
 {
+    ReadInterfaces();
+    for (const auto& netInterface : mInterfaces)
+    {
+        if (netInterface.addr == nAddr)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+
+void CNetwork::RefreshInterfaces()
+{
+    mInterfacesRead = false;
+    ReadInterfaces();
+}
+
+
+// Read the IPv4 addresses of the network interfaces, unless they have already been read. Enumerating the
+// interfaces is slow, so it isn't done for every broadcast or discovery response.
+void CNetwork::ReadInterfaces() const
+{
+    if (mInterfacesRead)
+    {
+        return;
+    }
+    mInterfacesRead = true;
+    mInterfaces.clear();
+
 #ifdef _WIN32
-    IP_ADAPTER_INFO* pAdptInfo = nullptr;
-    IP_ADAPTER_INFO* pNextAd = nullptr;
-    DWORD            erradapt;
-    ULONG            ulLen = 0;
+    IP_ADAPTER_INFO* ifap = nullptr;
+    ULONG ulLen = 0;
 
-    // Find all network interfaces.
-    erradapt = ::GetAdaptersInfo(pAdptInfo, &ulLen);
+    // Find all Ethernet interfaces.
+    DWORD erradapt = ::GetAdaptersInfo(ifap, &ulLen);
     if (erradapt == ERROR_BUFFER_OVERFLOW)
     {
-        pAdptInfo = (IP_ADAPTER_INFO*)malloc(ulLen);
-        erradapt = ::GetAdaptersInfo(pAdptInfo, &ulLen);      
+        ifap = (IP_ADAPTER_INFO*)malloc(ulLen);
+        erradapt = ::GetAdaptersInfo(ifap, &ulLen);
     }
 
     if (erradapt == ERROR_SUCCESS)
     {
-        pNextAd = pAdptInfo;
-        while(pNextAd)
+        for (auto* ifa = ifap; ifa != nullptr; ifa = ifa->Next)
         {
-            if (pNextAd->Type == MIB_IF_TYPE_ETHERNET)
+            SInterface netInterface;
+            if (ifa->Type == MIB_IF_TYPE_ETHERNET &&
+                inet_pton(AF_INET, ifa->IpAddressList.IpAddress.String, &netInterface.addr) == 1 &&
+                inet_pton(AF_INET, ifa->IpAddressList.IpMask.String, &netInterface.mask) == 1)
             {
-                // Check if it's a response from a local interface.
-                unsigned int addr;
-                if (inet_pton(AF_INET, pNextAd->IpAddressList.IpAddress.String, &addr) != 0)
-                {
-                    return addr == nAddr;
-                }
+                mInterfaces.push_back(netInterface);
             }
-            pNextAd = pNextAd->Next;
         }
     }
-	free(pAdptInfo);
+    free(ifap);
 #else
-	struct ifaddrs* pAdptInfo = nullptr;
-	struct ifaddrs* pNextAd = nullptr;
-	if (getifaddrs(&pAdptInfo) == 0)
-	{
-		pNextAd = pAdptInfo;
-		while (pNextAd)
-		{
-			if (pNextAd->ifa_addr->sa_family == AF_INET)
-			{
-				struct sockaddr_in* pNextAd_in = (struct sockaddr_in *)pNextAd->ifa_addr;
-				if (pNextAd_in->sin_addr.s_addr == nAddr)
-				{
-					return true;
-				}
-			}
-			pNextAd = pNextAd->ifa_next;
-		}
-	}
-	freeifaddrs(pAdptInfo);
+    struct ifaddrs* ifap = nullptr;
+    if (getifaddrs(&ifap) == 0)
+    {
+        for (auto* ifa = ifap; ifa != nullptr; ifa = ifa->ifa_next)
+        {
+            if (ifa->ifa_addr != nullptr && ifa->ifa_netmask != nullptr && ifa->ifa_addr->sa_family == AF_INET)
+            {
+                SInterface netInterface;
+                netInterface.addr = ((struct sockaddr_in*)ifa->ifa_addr)->sin_addr.s_addr;
+                netInterface.mask = ((struct sockaddr_in*)ifa->ifa_netmask)->sin_addr.s_addr;
+                mInterfaces.push_back(netInterface);
+            }
+        }
+        freeifaddrs(ifap);
+    }
 #endif
-    return false;
-}
\ No newline at end of file
+} // ReadInterfaces
\ No newline at end of file
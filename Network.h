@@ -8,6 +8,8 @@
 
     #include <winsock2.h>
 #else
+    #include <netinet/in.h>
+
     #define INVALID_SOCKET -1
     #define SOCKET int
 #endif
@@ -28,8 +30,10 @@ public:
     {
         int received;
         ResponseType type;
+        unsigned long long timestamp; // Receive time, ns since 1970-01-01 UTC. Kernel time when available, else 0.
+        bool datagram;                // One whole datagram, read from a UDP socket. Else TCP stream data.
 
-        Response(ResponseType type_, int received_) : received(received_), type(type_) {}
+        Response(ResponseType type_, int received_) : received(received_), type(type_), timestamp(0), datagram(false) {}
         operator bool() { return type == ResponseType::success; }
         operator ResponseType() { return type; }
     };
@@ -39,15 +43,58 @@ public:
     virtual bool  Connected() const = 0;
     virtual bool  CreateUDPSocket(unsigned short& nUDPPort, bool bBroadcast = false) = 0;
 
+    // Read from the TCP connection or, when it has data first, a datagram from the UDP data socket. A
+    // datagram must be returned with Response::datagram set, so that it isn't taken as part of the TCP
+    // stream. ipAddr, when given, gets the source address of a datagram.
     virtual Response Receive(char* rtDataBuff, int nDataBufSize, bool bHeader, int timeoutMicroseconds, unsigned int* ipAddr = nullptr) = 0;
+    // Receive, called when the start of a TCP packet has been read and the rest is expected. The rest is
+    // usually queued already, so networks may try to read it before waiting.
+    virtual Response ReceiveRest(char* rtDataBuff, int nDataBufSize, int timeoutMicroseconds)
+    {
+        return Receive(rtDataBuff, nDataBufSize, false, timeoutMicroseconds);
+    }
     virtual Response ReceiveUdpBroadcast(char* rtDataBuff, int nDataBufSize, int timeoutMicroseconds, unsigned int* ipAddr = nullptr) = 0;
+    // Receive up to maxCount datagrams from the UDP data socket. Datagram i is stored in buffers[i], which holds
+    // nBufferSize bytes, and its size in sizes[i]. Response::received is the number of datagrams.
+    // If timestamps is given, it gets the receive time of each datagram, see Response::timestamp.
+    virtual Response ReceiveUdpBatch(char* const* buffers, int nBufferSize, int* sizes, int maxCount, int timeoutMicroseconds, unsigned long long* timestamps = nullptr)
+    {
+        (void)buffers; (void)nBufferSize; (void)sizes; (void)maxCount; (void)timeoutMicroseconds; (void)timestamps;
+        return Response(ResponseType::error, 0);
+    }
+    // Join or leave a multicast group on the UDP data socket, see CNetwork::JoinMulticastGroup.
+    virtual bool  JoinMulticastGroup(const char* groupAddr, unsigned short udpPort, const char* interfaceAddr = nullptr)
+    {
+        (void)groupAddr; (void)udpPort; (void)interfaceAddr;
+        return false;
+    }
+    virtual bool  LeaveMulticastGroup(const char* groupAddr, const char* interfaceAddr = nullptr)
+    {
+        (void)groupAddr; (void)interfaceAddr;
+        return false;
+    }
     virtual bool  Send(const char* pSendBuf, int nSize) = 0;
     virtual bool  SendUDPBroadcast(const char* pSendBuf, int nSize, short nPort, unsigned int nFilterAddr = 0) = 0;
     virtual char* GetErrorString() = 0;
     virtual int   GetError() const = 0;
     virtual bool  IsLocalAddress(unsigned int nAddr) const = 0;
+    // Re-read the network interfaces. They are read once and cached for SendUDPBroadcast and IsLocalAddress.
+    virtual void  RefreshInterfaces() {}
     virtual unsigned short GetUdpServerPort() = 0;
     virtual unsigned short GetUdpBroadcastServerPort() = 0;
+    // Networks that hold whole packets in memory, e.g. PacketLogNetwork, hand them to CRTProtocol in place
+    // instead of copying them into its receive buffer. packetData gets the next whole packet, which stays
+    // valid until the next call, and Response::received its size.
+    virtual bool  HasPacketReceive() const { return false; }
+    virtual Response ReceivePacket(char*& packetData, int timeoutMicroseconds)
+    {
+        (void)packetData; (void)timeoutMicroseconds;
+        return Response(ResponseType::error, 0);
+    }
+    // Socket descriptors, for waiting on them in an external event loop (see CRTProtocol::ProcessReadable).
+    // INVALID_SOCKET when the socket isn't open, or when the network isn't socket based.
+    virtual SOCKET GetSocket() const { return INVALID_SOCKET; }
+    virtual SOCKET GetUdpSocket() const { return INVALID_SOCKET; }
     virtual ~INetwork() = default;
 };
 
@@ -63,26 +110,78 @@ public:
 
     Response Receive(char* rtDataBuff, int nDataBufSize, bool bHeader, int timeoutMicroseconds, unsigned int *ipAddr = nullptr) override;
     Response ReceiveUdpBroadcast(char* rtDataBuff, int nDataBufSize, int timeoutMicroseconds, unsigned int *ipAddr = nullptr) override;
+    Response ReceiveUdpBatch(char* const* buffers, int nBufferSize, int* sizes, int maxCount, int timeoutMicroseconds, unsigned long long* timestamps = nullptr) override;
+    // Multicast reception. The UDP data socket is bound to udpPort with SO_REUSEADDR (and SO_REUSEPORT
+    // where available), so that several processes on the host can receive the same stream. If it isn't
+    // open, it is created. If it is already bound without the options, e.g. by Connect or StreamFrames
+    // with a UDP port, it is replaced by a socket bound again to the same port with them, and GetUdpSocket
+    // changes. udpPort 0 keeps the port of an open socket. The group is joined on the interface with
+    // address interfaceAddr, nullptr for the default one. Groups are left when the socket is closed on
+    // Disconnect.
+    bool  JoinMulticastGroup(const char* groupAddr, unsigned short udpPort, const char* interfaceAddr = nullptr) override;
+    bool  LeaveMulticastGroup(const char* groupAddr, const char* interfaceAddr = nullptr) override;
     bool  Send(const char* pSendBuf, int nSize) override;
     bool  SendUDPBroadcast(const char* pSendBuf, int nSize, short nPort, unsigned int nFilterAddr = 0) override;
     char* GetErrorString() override;
     int   GetError() const override;
     bool  IsLocalAddress(unsigned int nAddr) const override;
+    void  RefreshInterfaces() override;
     unsigned short GetUdpServerPort() override;
     unsigned short GetUdpBroadcastServerPort() override;
+    SOCKET GetSocket() const override;
+    SOCKET GetUdpSocket() const override;
 
-private:
+    // Low latency receive tuning. The socket options are applied when the sockets are created, so set them
+    // before connecting.
+    // SO_RCVBUF of the TCP and UDP data sockets in bytes. 0 keeps the system default.
+    void  SetReceiveBufferSize(int bytes);
+    // SO_BUSY_POLL of the TCP and UDP data sockets in microseconds (Linux only). 0 disables busy polling.
+    void  SetBusyPoll(int microseconds);
+    // Poll the sockets without blocking for up to this long before waiting for data, trading CPU time for a
+    // lower and more even wakeup latency. 0 always waits at once, -1 never waits (spins for the whole timeout).
+    void  SetSpinTime(int microseconds);
+
+protected:
     Response Receive(SOCKET socket, SOCKET udpSocket, char* rtDataBuff, int nDataBufSize, bool bHeader, int timeoutMicroseconds, unsigned int *ipAddr = nullptr);
-    bool InitWinsock();
+    Response WaitAndRead(SOCKET socket, SOCKET udpSocket, char* rtDataBuff, int nDataBufSize, bool bHeader, int timeoutMicroseconds, unsigned int *ipAddr);
+    int   GetSpinTime(int timeoutMicroseconds) const;
+    Response ReadSocket(SOCKET socket, char* rtDataBuff, int nDataBufSize, bool bHeader);
+    Response ReadUdpSocket(SOCKET udpSocket, char* rtDataBuff, int nDataBufSize, unsigned int *ipAddr);
+    int   ReadUdpBatch(SOCKET udpSocket, char* const* buffers, int nBufferSize, int* sizes, int maxCount, unsigned long long* timestamps);
+    int   RecvTimestamped(SOCKET socket, char* rtDataBuff, int nDataBufSize, int flags, unsigned long long& timestamp, sockaddr_in* sourceAddr = nullptr);
     void SetErrorString();
-    unsigned short GetUdpServerPort(SOCKET nSocket);
+    void SetSocketErrorString(SOCKET socket);
 
 private:
+    bool InitWinsock();
+    void EnableReceiveTimestamps(SOCKET socket);
+    void ApplyReceiveOptions(SOCKET socket);
+    void EnableAddressReuse(SOCKET socket);
+    bool HasAddressReuse(SOCKET socket);
+    bool CreateReusableUDPSocket(unsigned short udpPort);
+    bool SetMulticastMembership(int option, const char* groupAddr, const char* interfaceAddr);
+    unsigned short GetUdpServerPort(SOCKET nSocket);
+    void ReadInterfaces() const;
+
+protected:
     SOCKET     mSocket;
     SOCKET     mUDPSocket;
     SOCKET     mUDPBroadcastSocket;
     char       mErrorStr[256];
     unsigned long mLastError;
+    int        mReceiveBufferSize;
+    int        mBusyPollMicroseconds;
+    int        mSpinMicroseconds;
+    bool       mReuseUdpAddress;
+
+private:
+    struct SInterface
+    {
+        unsigned int addr; // Network byte order
+        unsigned int mask;
+    };
+    mutable std::vector<SInterface> mInterfaces;
+    mutable bool                    mInterfacesRead;
 };
 
 
@@ -0,0 +1,218 @@
+#ifndef PACKET_DECODER_H
+#define PACKET_DECODER_H
+
+#include <cstdint>
+#include <cstring>
+
+namespace qualisys_cpp_sdk
+{
+    // Layout generation of the 3D and 6D components. Up to protocol version 1.7, coordinates and rotations are
+    // doubles and items with a residual or id are padded to a multiple of 8 bytes.
+    enum class PacketLayout
+    {
+        Double, // 1.0 - 1.7
+        Float   // 1.8 and later
+    };
+
+    inline PacketLayout GetPacketLayout(unsigned int majorVersion, unsigned int minorVersion)
+    {
+        return (majorVersion > 1 || minorVersion > 7) ? PacketLayout::Float : PacketLayout::Double;
+    }
+
+    // Size of an item with realCount coordinates or angles followed by extraSize bytes of residual or id.
+    constexpr unsigned int PacketItemSize(unsigned int realSize, unsigned int realCount, unsigned int extraSize)
+    {
+        return (realCount * realSize + extraSize + realSize - 1) / realSize * realSize;
+    }
+
+    // Reads the components of a data packet with the byte order and layout resolved at compile time, so that
+    // reading an item or a run of items has no branches. The functions take the start of a component, see
+    // CRTPacket::GetComponentSize for how to find it. They don't check indexes against the component count.
+    template <bool BigEndian, PacketLayout Layout>
+    struct PacketDecoder
+    {
+        static const bool         cBigEndian = BigEndian;
+        static const PacketLayout cLayout    = Layout;
+
+        static const unsigned int cRealSize = Layout == PacketLayout::Float ? 4 : 8;
+        // Items start after size, type, count, drop rate and out of sync rate.
+        static const unsigned int cComponentHeaderSize = 16;
+
+        static const unsigned int c3dMarkerSize                 = PacketItemSize(cRealSize, 3, 0);
+        static const unsigned int c3dResidualMarkerSize         = PacketItemSize(cRealSize, 3, 4);
+        static const unsigned int c3dNoLabelsMarkerSize         = PacketItemSize(cRealSize, 3, 4);
+        static const unsigned int c3dNoLabelsResidualMarkerSize = PacketItemSize(cRealSize, 3, 8);
+        static const unsigned int c6dBodySize                   = PacketItemSize(cRealSize, 12, 0);
+        static const unsigned int c6dResidualBodySize           = PacketItemSize(cRealSize, 12, 4);
+        static const unsigned int c6dEulerBodySize              = PacketItemSize(cRealSize, 6, 0);
+        static const unsigned int c6dEulerResidualBodySize      = PacketItemSize(cRealSize, 6, 4);
+
+        static std::uint32_t ReadUInt32(const char* data)
+        {
+            std::uint32_t value;
+            std::memcpy(&value, data, sizeof(value));
+            return BigEndian ? ByteSwap(value) : value;
+        }
+
+        static float ReadFloat(const char* data)
+        {
+            const std::uint32_t bits = ReadUInt32(data);
+            float value;
+            std::memcpy(&value, &bits, sizeof(value));
+            return value;
+        }
+
+        static double ReadDouble(const char* data)
+        {
+            std::uint64_t bits;
+            std::memcpy(&bits, data, sizeof(bits));
+            bits = BigEndian ? ByteSwap(bits) : bits;
+            double value;
+            std::memcpy(&value, &bits, sizeof(value));
+            return value;
+        }
+
+        // A coordinate or angle, a float or a double depending on the layout.
+        static float ReadReal(const char* data)
+        {
+            return Layout == PacketLayout::Float ? ReadFloat(data) : static_cast<float>(ReadDouble(data));
+        }
+
+        static unsigned int GetCount(const char* component)
+        {
+            return ReadUInt32(component + 8);
+        }
+
+        static const char* GetItem(const char* component, unsigned int index, unsigned int itemSize)
+        {
+            return component + cComponentHeaderSize + index * itemSize;
+        }
+
+        static void Get3DMarker(const char* component, unsigned int index, float& x, float& y, float& z)
+        {
+            ReadPosition(GetItem(component, index, c3dMarkerSize), x, y, z);
+        }
+
+        static void Get3DResidualMarker(const char* component, unsigned int index, float& x, float& y, float& z, float& residual)
+        {
+            const char* marker = GetItem(component, index, c3dResidualMarkerSize);
+            ReadPosition(marker, x, y, z);
+            residual = ReadFloat(marker + 3 * cRealSize);
+        }
+
+        static void Get3DNoLabelsMarker(const char* component, unsigned int index, float& x, float& y, float& z, unsigned int& id)
+        {
+            const char* marker = GetItem(component, index, c3dNoLabelsMarkerSize);
+            ReadPosition(marker, x, y, z);
+            id = ReadUInt32(marker + 3 * cRealSize);
+        }
+
+        static void Get3DNoLabelsResidualMarker(const char* component, unsigned int index, float& x, float& y, float& z,
+                                                unsigned int& id, float& residual)
+        {
+            const char* marker = GetItem(component, index, c3dNoLabelsResidualMarkerSize);
+            ReadPosition(marker, x, y, z);
+            id = ReadUInt32(marker + 3 * cRealSize);
+            residual = ReadFloat(marker + 3 * cRealSize + 4);
+        }
+
+        static void Get6DOFBody(const char* component, unsigned int index, float& x, float& y, float& z, float rotation[9])
+        {
+            ReadPose(GetItem(component, index, c6dBodySize), x, y, z, rotation);
+        }
+
+        static void Get6DOFResidualBody(const char* component, unsigned int index, float& x, float& y, float& z,
+                                        float rotation[9], float& residual)
+        {
+            const char* body = GetItem(component, index, c6dResidualBodySize);
+            ReadPose(body, x, y, z, rotation);
+            residual = ReadFloat(body + 12 * cRealSize);
+        }
+
+        static void Get6DOFEulerBody(const char* component, unsigned int index, float& x, float& y, float& z,
+                                     float& angle1, float& angle2, float& angle3)
+        {
+            const char* body = GetItem(component, index, c6dEulerBodySize);
+            ReadPosition(body, x, y, z);
+            ReadPosition(body + 3 * cRealSize, angle1, angle2, angle3);
+        }
+
+        static void Get6DOFEulerResidualBody(const char* component, unsigned int index, float& x, float& y, float& z,
+                                             float& angle1, float& angle2, float& angle3, float& residual)
+        {
+            const char* body = GetItem(component, index, c6dEulerResidualBodySize);
+            ReadPosition(body, x, y, z);
+            ReadPosition(body + 3 * cRealSize, angle1, angle2, angle3);
+            residual = ReadFloat(body + 6 * cRealSize);
+        }
+
+    private:
+        static void ReadPosition(const char* data, float& x, float& y, float& z)
+        {
+            x = ReadReal(data);
+            y = ReadReal(data + cRealSize);
+            z = ReadReal(data + 2 * cRealSize);
+        }
+
+        static void ReadPose(const char* data, float& x, float& y, float& z, float rotation[9])
+        {
+            ReadPosition(data, x, y, z);
+            for (unsigned int i = 0; i < 9; i++)
+            {
+                rotation[i] = ReadReal(data + (3 + i) * cRealSize);
+            }
+        }
+
+        // Written out so that it compiles to a single bswap or movbe without compiler specific intrinsics.
+        static std::uint32_t ByteSwap(std::uint32_t value)
+        {
+            return (value >> 24) | ((value >> 8) & 0x0000ff00u) | ((value << 8) & 0x00ff0000u) | (value << 24);
+        }
+
+        static std::uint64_t ByteSwap(std::uint64_t value)
+        {
+            return (static_cast<std::uint64_t>(ByteSwap(static_cast<std::uint32_t>(value))) << 32) |
+                   ByteSwap(static_cast<std::uint32_t>(value >> 32));
+        }
+    }; // PacketDecoder
+
+    enum class PacketDecoderType : unsigned char
+    {
+        LittleEndianFloat,
+        LittleEndianDouble,
+        BigEndianFloat,
+        BigEndianDouble
+    };
+
+    inline PacketDecoderType GetPacketDecoderType(bool bigEndian, unsigned int majorVersion, unsigned int minorVersion)
+    {
+        const bool floatLayout = GetPacketLayout(majorVersion, minorVersion) == PacketLayout::Float;
+        if (bigEndian)
+        {
+            return floatLayout ? PacketDecoderType::BigEndianFloat : PacketDecoderType::BigEndianDouble;
+        }
+        return floatLayout ? PacketDecoderType::LittleEndianFloat : PacketDecoderType::LittleEndianDouble;
+    }
+
+    // Calls visitor(PacketDecoder<...>()) with the decoder of the type. Branch on the type once and do all the
+    // reading of a packet inside the visitor, so that only this switch depends on the byte order and version.
+    template <typename TVisitor>
+    auto VisitPacketDecoder(PacketDecoderType type, TVisitor&& visitor)
+        -> decltype(visitor(PacketDecoder<false, PacketLayout::Float>()))
+    {
+        switch (type)
+        {
+            case PacketDecoderType::LittleEndianDouble:
+                return visitor(PacketDecoder<false, PacketLayout::Double>());
+            case PacketDecoderType::BigEndianFloat:
+                return visitor(PacketDecoder<true, PacketLayout::Float>());
+            case PacketDecoderType::BigEndianDouble:
+                return visitor(PacketDecoder<true, PacketLayout::Double>());
+            case PacketDecoderType::LittleEndianFloat:
+            default:
+                return visitor(PacketDecoder<false, PacketLayout::Float>());
+        }
+    }
+}
+
+#endif // PACKET_DECODER_H
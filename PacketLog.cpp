@@ -0,0 +1,908 @@
+#define _CRT_SECURE_NO_WARNINGS
+
+#include "PacketLog.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace qualisys_cpp_sdk;
+
+namespace
+{
+    constexpr std::uint32_t cRecordAlignment = 8;
+
+    std::uint64_t NowNanoseconds()
+    {
+        return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count());
+    }
+
+    bool StartsWith(const char* str, const char* prefix)
+    {
+        return std::strncmp(str, prefix, std::strlen(prefix)) == 0;
+    }
+
+    const char* GetPacket(const PacketLogRecord* record)
+    {
+        return reinterpret_cast<const char*>(record + 1);
+    }
+
+    std::uint32_t GetFrameNumber(const PacketLogRecord* record)
+    {
+        std::uint32_t frameNumber;
+        std::memcpy(&frameNumber, GetPacket(record) + 16, sizeof(frameNumber));
+        return frameNumber;
+    }
+}
+
+
+PacketLogWriter::PacketLogWriter(const char* fileName, unsigned int segmentSize) :
+    mFileName(fileName),
+    mSegmentSize((segmentSize < cMinSegmentSize ? cMinSegmentSize : segmentSize) & ~(cRecordAlignment - 1)),
+    mPreparedReady(false),
+    mFullPending(false),
+    mStopThread(false),
+    mRecordCount(0),
+    mDroppedCount(0),
+    mSegmentCount(0),
+    mFailed(false)
+{
+#ifdef _WIN32
+    SetError("Packet logs are not supported on Windows.");
+#else
+    mThread = std::thread([this]() { LogThread(); });
+
+    // Wait for the first segment, so that Append can use it right away and IsOpen reports file errors.
+    std::unique_lock<std::mutex> lock(mMutex);
+    mCondition.wait(lock, [this]() { return mPreparedReady || mFailed; });
+#endif
+}
+
+
+PacketLogWriter::~PacketLogWriter()
+{
+    Close();
+}
+
+
+bool PacketLogWriter::IsOpen() const
+{
+    return mThread.joinable() && !mFailed;
+}
+
+
+bool PacketLogWriter::Append(CRTPacket& packet)
+{
+    if (packet.GetType() != CRTPacket::PacketData)
+    {
+        return false;
+    }
+    char*        data;
+    unsigned int size;
+    packet.GetData(data, size);
+    const std::uint32_t recordSize = (static_cast<std::uint32_t>(sizeof(PacketLogRecord)) + size + cRecordAlignment - 1) & ~(cRecordAlignment - 1);
+
+    if (mCurrent.mapping == nullptr || !Fits(mCurrent, recordSize))
+    {
+        // Packets that don't fit in an empty segment are never recorded.
+        if (!Fits(Segment(), recordSize) || !NextSegment())
+        {
+            mDroppedCount++;
+            return false;
+        }
+    }
+
+    char* mapping = mCurrent.mapping;
+    if (mCurrent.recordCount == 0)
+    {
+        unsigned int majorVersion;
+        unsigned int minorVersion;
+        packet.GetVersion(majorVersion, minorVersion);
+        auto* header = reinterpret_cast<PacketLogHeader*>(mapping);
+        header->majorVersion = majorVersion;
+        header->minorVersion = minorVersion;
+        header->bigEndian    = packet.GetEndianness() ? 1 : 0;
+    }
+
+    PacketLogRecord record;
+    record.size             = recordSize;
+    record.packetSize       = size;
+    record.receiveTimestamp = packet.GetReceiveTimestamp();
+    if (record.receiveTimestamp == 0)
+    {
+        record.receiveTimestamp = NowNanoseconds();
+    }
+    std::memcpy(mapping + mCurrent.used + sizeof(record), data, size);
+    std::memcpy(mapping + mCurrent.used, &record, sizeof(record));
+
+    PacketLogIndexEntry entry;
+    entry.receiveTimestamp = record.receiveTimestamp;
+    entry.timestamp        = packet.GetTimeStamp();
+    entry.frameNumber      = packet.GetFrameNumber();
+    entry.recordOffset     = mCurrent.used;
+    std::memcpy(mapping + mSegmentSize - (mCurrent.recordCount + 1) * sizeof(entry), &entry, sizeof(entry));
+
+    mCurrent.used += recordSize;
+    mCurrent.recordCount++;
+    mRecordCount++;
+    return true;
+} // Append
+
+
+bool PacketLogWriter::Close()
+{
+    if (!mThread.joinable())
+    {
+        return !mFailed;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStopThread = true;
+    }
+    mCondition.notify_all();
+    mThread.join();
+
+    if (mCurrent.mapping != nullptr)
+    {
+        if (mCurrent.recordCount > 0)
+        {
+            FinishSegment(mCurrent);
+        }
+        else
+        {
+            DiscardSegment(mCurrent);
+        }
+    }
+    if (mPreparedReady)
+    {
+        DiscardSegment(mPrepared);
+        mPreparedReady = false;
+    }
+    return !mFailed;
+} // Close
+
+
+unsigned int PacketLogWriter::GetRecordCount() const
+{
+    return mRecordCount;
+}
+
+
+unsigned int PacketLogWriter::GetDroppedCount() const
+{
+    return mDroppedCount;
+}
+
+
+unsigned int PacketLogWriter::GetSegmentCount() const
+{
+    return mSegmentCount;
+}
+
+
+const char* PacketLogWriter::GetErrorString() const
+{
+    return mErrorStr.c_str();
+}
+
+
+std::string PacketLogWriter::GetSegmentFileName(const std::string& fileName, unsigned int segmentIndex)
+{
+    char suffix[16];
+    std::snprintf(suffix, sizeof(suffix), ".%04u", segmentIndex);
+    return fileName + suffix;
+}
+
+
+// Room for the record, its index entry and the footer.
+bool PacketLogWriter::Fits(const Segment& segment, std::uint32_t recordSize) const
+{
+    const std::uint64_t used = std::max<std::uint64_t>(segment.used, sizeof(PacketLogHeader));
+    return used + recordSize + (segment.recordCount + 1ull) * sizeof(PacketLogIndexEntry) + sizeof(PacketLogFooter) <= mSegmentSize;
+}
+
+
+// Switch to the prepared segment and hand the current one to the log thread.
+bool PacketLogWriter::NextSegment()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (!mPreparedReady || mFullPending)
+        {
+            return false;
+        }
+        if (mCurrent.mapping != nullptr)
+        {
+            mFull        = mCurrent;
+            mFullPending = true;
+        }
+        mCurrent       = mPrepared;
+        mPreparedReady = false;
+    }
+    mCondition.notify_all();
+    return true;
+}
+
+
+void PacketLogWriter::LogThread()
+{
+    unsigned int nextIndex = 0;
+
+    std::unique_lock<std::mutex> lock(mMutex);
+    while (true)
+    {
+        if (mFullPending)
+        {
+            Segment full = mFull;
+            lock.unlock();
+            FinishSegment(full);
+            lock.lock();
+            mFullPending = false;
+            continue;
+        }
+        if (mStopThread)
+        {
+            return;
+        }
+        if (!mPreparedReady && !mFailed)
+        {
+            Segment segment;
+            lock.unlock();
+            const bool prepared = PrepareSegment(segment, nextIndex++);
+            lock.lock();
+            if (prepared)
+            {
+                mPrepared      = segment;
+                mPreparedReady = true;
+            }
+            mCondition.notify_all();
+            continue;
+        }
+        mCondition.wait(lock);
+    }
+} // LogThread
+
+
+bool PacketLogWriter::PrepareSegment(Segment& segment, unsigned int index)
+{
+#ifdef _WIN32
+    (void)segment;
+    (void)index;
+    return false;
+#else
+    segment = Segment();
+    segment.index = index;
+    segment.used  = sizeof(PacketLogHeader);
+
+    const auto fileName = GetSegmentFileName(mFileName, index);
+    segment.fileDescriptor = open(fileName.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (segment.fileDescriptor == -1)
+    {
+        SetError("Failed to open packet log segment.");
+        return false;
+    }
+    mSegmentCount++;
+#ifdef __linux__
+    const bool allocated = posix_fallocate(segment.fileDescriptor, 0, mSegmentSize) == 0;
+    // Fault the pages in now, so Append doesn't.
+    const int mapFlags = MAP_SHARED | MAP_POPULATE;
+#else
+    const bool allocated = false;
+    const int mapFlags = MAP_SHARED;
+#endif
+    if (!allocated && ftruncate(segment.fileDescriptor, mSegmentSize) != 0)
+    {
+        SetError("Failed to allocate packet log segment.");
+        DiscardSegment(segment);
+        return false;
+    }
+    void* mapping = mmap(nullptr, mSegmentSize, PROT_READ | PROT_WRITE, mapFlags, segment.fileDescriptor, 0);
+    if (mapping == MAP_FAILED)
+    {
+        SetError("Failed to map packet log segment.");
+        DiscardSegment(segment);
+        return false;
+    }
+    segment.mapping = static_cast<char*>(mapping);
+
+    PacketLogHeader header = {};
+    std::memcpy(header.magic, cPacketLogMagic, sizeof(header.magic));
+    header.segmentIndex = index;
+    std::memcpy(segment.mapping, &header, sizeof(header));
+    return true;
+#endif
+} // PrepareSegment
+
+
+// Move the index from the end of the mapping to after the records, add the footer and cut the file to size.
+bool PacketLogWriter::FinishSegment(Segment& segment)
+{
+#ifdef _WIN32
+    (void)segment;
+    return false;
+#else
+    const auto entrySize = sizeof(PacketLogIndexEntry);
+    std::vector<PacketLogIndexEntry> index(segment.recordCount);
+    for (std::uint32_t i = 0; i < segment.recordCount; i++)
+    {
+        std::memcpy(&index[i], segment.mapping + mSegmentSize - (i + 1) * entrySize, entrySize);
+    }
+    std::memcpy(segment.mapping + segment.used, index.data(), index.size() * entrySize);
+
+    PacketLogFooter footer = {};
+    footer.indexOffset = segment.used;
+    footer.recordCount = segment.recordCount;
+    std::memcpy(footer.magic, cPacketLogIndexMagic, sizeof(footer.magic));
+    const auto footerOffset = segment.used + index.size() * entrySize;
+    std::memcpy(segment.mapping + footerOffset, &footer, sizeof(footer));
+
+    munmap(segment.mapping, mSegmentSize);
+    segment.mapping = nullptr;
+    bool success = ftruncate(segment.fileDescriptor, static_cast<off_t>(footerOffset + sizeof(footer))) == 0;
+    success = close(segment.fileDescriptor) == 0 && success;
+    segment.fileDescriptor = -1;
+    if (!success)
+    {
+        SetError("Failed to write packet log segment.");
+    }
+    return success;
+#endif
+} // FinishSegment
+
+
+// Remove a segment that holds no records.
+void PacketLogWriter::DiscardSegment(Segment& segment)
+{
+#ifndef _WIN32
+    if (segment.mapping != nullptr)
+    {
+        munmap(segment.mapping, mSegmentSize);
+        segment.mapping = nullptr;
+    }
+    if (segment.fileDescriptor != -1)
+    {
+        close(segment.fileDescriptor);
+        segment.fileDescriptor = -1;
+        unlink(GetSegmentFileName(mFileName, segment.index).c_str());
+        mSegmentCount--;
+    }
+#else
+    (void)segment;
+#endif
+}
+
+
+void PacketLogWriter::SetError(const char* error)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mFailed   = true;
+    mErrorStr = error;
+}
+
+
+PacketLogNetwork::PacketLogNetwork(const char* fileName, double speed) :
+    mSpeed(speed),
+    mPosition(0),
+    mConnected(false),
+    mStreaming(false),
+    mSingleFrames(0),
+    mFinished(false),
+    mPacingFirstTimestamp(0),
+    mPartialPacket(nullptr),
+    mPartialSize(0),
+    mPartialTimestamp(0),
+    mOpen(false),
+    mMajorVersion(0),
+    mMinorVersion(0)
+{
+    mErrorStr[0] = 0;
+#ifdef _WIN32
+    (void)fileName;
+    SetError("Packet logs are not supported on Windows.");
+#else
+    for (unsigned int index = 0; ; index++)
+    {
+        const auto segmentFileName = PacketLogWriter::GetSegmentFileName(fileName, index);
+        struct stat fileStatus;
+        if (stat(segmentFileName.c_str(), &fileStatus) != 0)
+        {
+            break;
+        }
+        if (!OpenSegment(segmentFileName))
+        {
+            return;
+        }
+    }
+    if (mMappings.empty())
+    {
+        SetError("Packet log not found.");
+        return;
+    }
+    mOpen = true;
+#endif
+} // PacketLogNetwork
+
+
+PacketLogNetwork::~PacketLogNetwork()
+{
+#ifndef _WIN32
+    for (const auto& mapping : mMappings)
+    {
+        munmap(mapping.data, mapping.size);
+    }
+#endif
+}
+
+
+bool PacketLogNetwork::IsOpen() const
+{
+    return mOpen;
+}
+
+
+void PacketLogNetwork::SetSpeed(double speed)
+{
+    mSpeed = speed;
+    RestartPacing();
+}
+
+
+unsigned int PacketLogNetwork::GetFrameCount() const
+{
+    return static_cast<unsigned int>(mRecords.size());
+}
+
+
+unsigned int PacketLogNetwork::GetPosition() const
+{
+    return static_cast<unsigned int>(mPosition);
+}
+
+
+bool PacketLogNetwork::SeekFrame(unsigned int frameNumber)
+{
+    const auto record = std::lower_bound(mRecords.begin(), mRecords.end(), frameNumber,
+        [](const PacketLogRecord* record, unsigned int frame) { return GetFrameNumber(record) < frame; });
+    if (record == mRecords.end())
+    {
+        return false;
+    }
+    mPosition = record - mRecords.begin();
+    mFinished = false;
+    RestartPacing();
+    return true;
+}
+
+
+bool PacketLogNetwork::IsFinished() const
+{
+    return mFinished;
+}
+
+
+bool PacketLogNetwork::Connect(const char* serverAddr, unsigned short port)
+{
+    (void)serverAddr;
+    (void)port;
+    if (!IsOpen())
+    {
+        return false;
+    }
+    mConnected     = true;
+    mStreaming     = false;
+    mSingleFrames  = 0;
+    mPartialSize   = 0;
+    mResponses.clear();
+    QueueString(CRTPacket::PacketCommand, "QTM RT Interface connected");
+    return true;
+}
+
+
+void PacketLogNetwork::Disconnect()
+{
+    mConnected = false;
+    mStreaming = false;
+}
+
+
+bool PacketLogNetwork::Connected() const
+{
+    return mConnected;
+}
+
+
+bool PacketLogNetwork::CreateUDPSocket(unsigned short& udpPort, bool broadcast)
+{
+    (void)udpPort;
+    (void)broadcast;
+    return true;
+}
+
+
+// Copies the packets that ReceivePacket hands out, for callers that read into their own buffer.
+INetwork::Response PacketLogNetwork::Receive(char* rtDataBuff, int dataBufSize, bool header, int timeoutMicroseconds, unsigned int* ipAddr)
+{
+    if (ipAddr != nullptr)
+    {
+        *ipAddr = 0;
+    }
+    if (mPartialSize == 0)
+    {
+        char* packetData;
+        auto response = ReceivePacket(packetData, timeoutMicroseconds);
+        if (response.type != ResponseType::success)
+        {
+            return response;
+        }
+        mPartialPacket    = packetData;
+        mPartialSize      = response.received;
+        mPartialTimestamp = response.timestamp;
+    }
+    int size = std::min(mPartialSize, header ? std::min(dataBufSize, 8) : dataBufSize);
+    std::memcpy(rtDataBuff, mPartialPacket, size);
+    mPartialPacket += size;
+    mPartialSize   -= size;
+
+    Response response(ResponseType::success, size);
+    response.timestamp = mPartialTimestamp;
+    return response;
+} // Receive
+
+
+INetwork::Response PacketLogNetwork::ReceiveUdpBroadcast(char* rtDataBuff, int dataBufSize, int timeoutMicroseconds, unsigned int* ipAddr)
+{
+    (void)rtDataBuff;
+    (void)dataBufSize;
+    (void)ipAddr;
+    if (timeoutMicroseconds > 0)
+    {
+        std::this_thread::sleep_for(std::chrono::microseconds(timeoutMicroseconds));
+    }
+    return Response(ResponseType::timeout, 0);
+}
+
+
+bool PacketLogNetwork::HasPacketReceive() const
+{
+    return true;
+}
+
+
+// Command responses first, then the next data packet when it is due.
+INetwork::Response PacketLogNetwork::ReceivePacket(char*& packetData, int timeoutMicroseconds)
+{
+    if (!mConnected)
+    {
+        return Response(ResponseType::disconnect, 0);
+    }
+
+    // The previous packet has been used by now, so the response handed out last can be replaced.
+    if (!mResponses.empty())
+    {
+        mResponse = std::move(mResponses.front());
+        mResponses.pop_front();
+        packetData = mResponse.data();
+        return Response(ResponseType::success, static_cast<int>(mResponse.size()));
+    }
+
+    if ((mStreaming || mSingleFrames > 0) && mPosition < mRecords.size())
+    {
+        const PacketLogRecord* record = mRecords[mPosition];
+        if (mStreaming && mSpeed > 0)
+        {
+            // The receive timestamps are from the system clock, which may have been set back while recording.
+            const long long recorded = static_cast<long long>(record->receiveTimestamp) - static_cast<long long>(mPacingFirstTimestamp);
+            const auto due = mPacingStart + std::chrono::nanoseconds(
+                static_cast<long long>(std::max(recorded, 0LL) / mSpeed));
+            const auto wait = due - std::chrono::steady_clock::now();
+            if (timeoutMicroseconds >= 0 && wait > std::chrono::microseconds(timeoutMicroseconds))
+            {
+                std::this_thread::sleep_for(std::chrono::microseconds(timeoutMicroseconds));
+                return Response(ResponseType::timeout, 0);
+            }
+            if (wait.count() > 0)
+            {
+                std::this_thread::sleep_until(due);
+            }
+        }
+        if (!mStreaming)
+        {
+            mSingleFrames--;
+        }
+        mPosition++;
+        if (mPosition == mRecords.size())
+        {
+            mFinished  = true;
+            mStreaming = false;
+            QueueEvent(CRTPacket::EventRTfromFileStopped);
+        }
+
+        packetData = const_cast<char*>(GetPacket(record));
+        Response response(ResponseType::success, static_cast<int>(record->packetSize));
+        response.timestamp = record->receiveTimestamp;
+        return response;
+    }
+
+    // Nothing more to deliver. Blocking forever would hang the caller.
+    if (timeoutMicroseconds < 0)
+    {
+        SetError("End of packet log.");
+        return Response(ResponseType::disconnect, 0);
+    }
+    if (timeoutMicroseconds > 0)
+    {
+        std::this_thread::sleep_for(std::chrono::microseconds(timeoutMicroseconds));
+    }
+    return Response(ResponseType::timeout, 0);
+} // ReceivePacket
+
+
+bool PacketLogNetwork::Send(const char* sendBuf, int size)
+{
+    if (!mConnected)
+    {
+        SetError("Not connected.");
+        return false;
+    }
+    // One or more command packets, little endian since the byte order follows the port.
+    while (size >= 8)
+    {
+        std::uint32_t packetSize;
+        std::uint32_t type;
+        std::memcpy(&packetSize, sendBuf, sizeof(packetSize));
+        std::memcpy(&type, sendBuf + 4, sizeof(type));
+        if (packetSize < 8 || packetSize > static_cast<std::uint32_t>(size))
+        {
+            break;
+        }
+        if (type == CRTPacket::PacketCommand)
+        {
+            HandleCommand(std::string(sendBuf + 8, packetSize - 8).c_str());
+        }
+        else
+        {
+            QueueString(CRTPacket::PacketError, "Only commands are available in packet log playback.");
+        }
+        sendBuf += packetSize;
+        size    -= static_cast<int>(packetSize);
+    }
+    return true;
+} // Send
+
+
+bool PacketLogNetwork::SendUDPBroadcast(const char* sendBuf, int size, short port, unsigned int filterAddr)
+{
+    (void)sendBuf;
+    (void)size;
+    (void)port;
+    (void)filterAddr;
+    return false;
+}
+
+
+char* PacketLogNetwork::GetErrorString()
+{
+    return mErrorStr;
+}
+
+
+int PacketLogNetwork::GetError() const
+{
+    return 0;
+}
+
+
+bool PacketLogNetwork::IsLocalAddress(unsigned int addr) const
+{
+    (void)addr;
+    return false;
+}
+
+
+unsigned short PacketLogNetwork::GetUdpServerPort()
+{
+    return 0;
+}
+
+
+unsigned short PacketLogNetwork::GetUdpBroadcastServerPort()
+{
+    return 0;
+}
+
+
+// Map a segment and add its records, from the index when the segment is complete, else by walking them.
+bool PacketLogNetwork::OpenSegment(const std::string& fileName)
+{
+#ifdef _WIN32
+    (void)fileName;
+    return false;
+#else
+    const int fileDescriptor = open(fileName.c_str(), O_RDONLY);
+    struct stat fileStatus;
+    if (fileDescriptor == -1 || fstat(fileDescriptor, &fileStatus) != 0)
+    {
+        if (fileDescriptor != -1)
+        {
+            close(fileDescriptor);
+        }
+        SetError("Failed to open packet log segment.");
+        return false;
+    }
+    const auto size = static_cast<std::size_t>(fileStatus.st_size);
+    if (size < sizeof(PacketLogHeader))
+    {
+        close(fileDescriptor);
+        SetError("Invalid packet log segment.");
+        return false;
+    }
+    // Private and writable, so that packets can be handed out as char*. They are never written to.
+    void* mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fileDescriptor, 0);
+    close(fileDescriptor);
+    if (mapping == MAP_FAILED)
+    {
+        SetError("Failed to map packet log segment.");
+        return false;
+    }
+    madvise(mapping, size, MADV_SEQUENTIAL);
+    char* data = static_cast<char*>(mapping);
+    mMappings.push_back({ data, size });
+
+    PacketLogHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, cPacketLogMagic, sizeof(header.magic)) != 0)
+    {
+        SetError("Invalid packet log segment.");
+        return false;
+    }
+    if (header.bigEndian != 0)
+    {
+        SetError("Big endian packet logs are not supported.");
+        return false;
+    }
+
+    PacketLogFooter footer;
+    bool indexed = false;
+    if (size >= sizeof(PacketLogHeader) + sizeof(footer))
+    {
+        std::memcpy(&footer, data + size - sizeof(footer), sizeof(footer));
+        indexed = std::memcmp(footer.magic, cPacketLogIndexMagic, sizeof(footer.magic)) == 0 &&
+                  footer.indexOffset + footer.recordCount * sizeof(PacketLogIndexEntry) + sizeof(footer) == size;
+    }
+    if (indexed)
+    {
+        for (std::uint32_t i = 0; i < footer.recordCount; i++)
+        {
+            PacketLogIndexEntry entry;
+            std::memcpy(&entry, data + footer.indexOffset + i * sizeof(entry), sizeof(entry));
+            mRecords.push_back(reinterpret_cast<const PacketLogRecord*>(data + entry.recordOffset));
+        }
+    }
+    else
+    {
+        std::size_t offset = sizeof(PacketLogHeader);
+        while (offset + sizeof(PacketLogRecord) <= size)
+        {
+            const auto* record = reinterpret_cast<const PacketLogRecord*>(data + offset);
+            if (record->size < sizeof(PacketLogRecord) || record->size > size - offset ||
+                record->packetSize > record->size - sizeof(PacketLogRecord))
+            {
+                break;
+            }
+            mRecords.push_back(record);
+            offset += record->size;
+        }
+    }
+    if (header.majorVersion != 0)
+    {
+        mMajorVersion = header.majorVersion;
+        mMinorVersion = header.minorVersion;
+    }
+    return true;
+#endif
+} // OpenSegment
+
+
+// The commands a streaming client needs. The log holds no settings.
+void PacketLogNetwork::HandleCommand(const char* command)
+{
+    if (StartsWith(command, "Version "))
+    {
+        unsigned int majorVersion = 0;
+        unsigned int minorVersion = 0;
+        if (std::sscanf(command + 8, "%u.%u", &majorVersion, &minorVersion) == 2 &&
+            majorVersion == mMajorVersion && minorVersion == mMinorVersion)
+        {
+            QueueString(CRTPacket::PacketCommand, "Version set to " + std::to_string(majorVersion) + "." + std::to_string(minorVersion));
+        }
+        else
+        {
+            QueueString(CRTPacket::PacketError, "Version NOT supported");
+        }
+    }
+    else if (StartsWith(command, "ByteOrder"))
+    {
+        QueueString(CRTPacket::PacketCommand, "Byte order is little endian");
+    }
+    else if (StartsWith(command, "GetState") || StartsWith(command, "GetLastEvent"))
+    {
+        QueueEvent(mFinished ? CRTPacket::EventRTfromFileStopped : CRTPacket::EventRTfromFileStarted);
+    }
+    else if (StartsWith(command, "StreamFrames Stop"))
+    {
+        mStreaming = false;
+    }
+    else if (StartsWith(command, "StreamFrames"))
+    {
+        if (mPosition == mRecords.size())
+        {
+            QueuePacket(CRTPacket::PacketNoMoreData, nullptr, 0);
+        }
+        mStreaming = mPosition < mRecords.size();
+        RestartPacing();
+    }
+    else if (StartsWith(command, "GetCurrentFrame"))
+    {
+        if (mPosition + mSingleFrames < mRecords.size())
+        {
+            mSingleFrames++;
+        }
+        else
+        {
+            QueuePacket(CRTPacket::PacketNoMoreData, nullptr, 0);
+        }
+    }
+    else
+    {
+        QueueString(CRTPacket::PacketError, std::string(command) + " is not available in packet log playback.");
+    }
+} // HandleCommand
+
+
+void PacketLogNetwork::QueuePacket(CRTPacket::EPacketType type, const void* data, std::uint32_t size)
+{
+    const std::uint32_t header[2] = { 8 + size, static_cast<std::uint32_t>(type) };
+    const char* headerData = reinterpret_cast<const char*>(header);
+    // A buffer of its own, the response that CRTProtocol may still hold stays where it is.
+    std::vector<char> response(headerData, headerData + sizeof(header));
+    response.insert(response.end(), static_cast<const char*>(data), static_cast<const char*>(data) + size);
+    mResponses.push_back(std::move(response));
+}
+
+
+void PacketLogNetwork::QueueString(CRTPacket::EPacketType type, const std::string& str)
+{
+    QueuePacket(type, str.c_str(), static_cast<std::uint32_t>(str.size() + 1));
+}
+
+
+void PacketLogNetwork::QueueEvent(CRTPacket::EEvent event)
+{
+    const char eventData = static_cast<char>(event);
+    QueuePacket(CRTPacket::PacketEvent, &eventData, 1);
+}
+
+
+void PacketLogNetwork::RestartPacing()
+{
+    mPacingStart          = std::chrono::steady_clock::now();
+    mPacingFirstTimestamp = mPosition < mRecords.size() ? mRecords[mPosition]->receiveTimestamp : 0;
+}
+
+
+void PacketLogNetwork::SetError(const char* error)
+{
+    std::snprintf(mErrorStr, sizeof(mErrorStr), "%s", error);
+}
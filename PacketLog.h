@@ -0,0 +1,208 @@
+#ifndef PACKET_LOG_H
+#define PACKET_LOG_H
+
+#include "RTPacket.h"
+#include "Network.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace qualisys_cpp_sdk
+{
+    // A packet log is a sequence of segment files, see PacketLogWriter::GetSegmentFileName. A segment starts
+    // with a PacketLogHeader, followed by one record per packet and, once the segment is complete, an index
+    // with one entry per record and a PacketLogFooter at the end of the file. The log structures are in host
+    // byte order, the packets are stored as received. A segment that was never completed, e.g. when the
+    // recording process crashed, has no index. Its records end at the first record with size 0.
+    constexpr char cPacketLogMagic[]      = "QRTLOG01";
+    constexpr char cPacketLogIndexMagic[] = "QRTIDX01";
+
+    struct PacketLogHeader
+    {
+        char          magic[8];          // cPacketLogMagic
+        std::uint32_t segmentIndex;
+        std::uint32_t majorVersion;      // RT protocol version and byte order of the packets
+        std::uint32_t minorVersion;
+        std::uint32_t bigEndian;
+        std::uint64_t reserved;
+    };
+
+    struct PacketLogRecord
+    {
+        std::uint32_t size;              // Bytes, header and padding included. A multiple of 8.
+        std::uint32_t packetSize;
+        std::uint64_t receiveTimestamp;  // Nanoseconds since 1970-01-01 UTC
+        // Followed by the packet.
+    };
+
+    struct PacketLogIndexEntry
+    {
+        std::uint64_t receiveTimestamp;
+        std::uint64_t timestamp;         // QTM capture time, microseconds
+        std::uint32_t frameNumber;
+        std::uint32_t recordOffset;      // From the start of the segment file
+    };
+
+    struct PacketLogFooter
+    {
+        std::uint64_t indexOffset;
+        std::uint32_t recordCount;
+        std::uint32_t reserved;
+        char          magic[8];          // cPacketLogIndexMagic
+    };
+
+    // Records data packets into a packet log, see CRTProtocol::SetPacketLog. Segments are created at full
+    // size and memory mapped ahead of use by a separate log thread, which also writes the index of every full
+    // segment and closes it. Append only copies the packet into the mapping, it never allocates memory,
+    // calls a file function or waits for disk I/O. The index entries are collected at the end of the mapping
+    // until the segment is complete. If the next segment isn't ready when the current one is full, packets are
+    // dropped and counted (not on Windows, where packet logs are not supported).
+    class PacketLogWriter
+    {
+    public:
+        static const unsigned int cDefaultSegmentSize = 64 * 1024 * 1024;
+        static const unsigned int cMinSegmentSize     = 4096;
+
+        explicit PacketLogWriter(const char* fileName, unsigned int segmentSize = cDefaultSegmentSize);
+        ~PacketLogWriter();
+
+        PacketLogWriter(const PacketLogWriter&) = delete;
+        PacketLogWriter& operator=(const PacketLogWriter&) = delete;
+
+        bool IsOpen() const;
+        // Record the packet, if it is a data packet. Must not be called from several threads at once.
+        bool Append(CRTPacket& packet);
+        // Complete the last segment and stop the log thread. Returns false if any segment couldn't be written.
+        bool Close();
+
+        unsigned int GetRecordCount() const;
+        unsigned int GetDroppedCount() const;
+        unsigned int GetSegmentCount() const;
+        const char*  GetErrorString() const;
+
+        // <fileName>.0000, <fileName>.0001, ...
+        static std::string GetSegmentFileName(const std::string& fileName, unsigned int segmentIndex);
+
+    private:
+        struct Segment
+        {
+            int           fileDescriptor = -1;
+            char*         mapping = nullptr;
+            std::uint32_t index = 0;
+            std::uint32_t used = 0;        // End of the records
+            std::uint32_t recordCount = 0;
+        };
+
+        bool Fits(const Segment& segment, std::uint32_t recordSize) const;
+        bool NextSegment();
+        void LogThread();
+        bool PrepareSegment(Segment& segment, unsigned int index);
+        bool FinishSegment(Segment& segment);
+        void DiscardSegment(Segment& segment);
+        void SetError(const char* error);
+
+        std::string               mFileName;
+        std::uint32_t             mSegmentSize;
+        Segment                   mCurrent;       // Only used by Append
+        Segment                   mPrepared;      // Next segment, when mPreparedReady
+        Segment                   mFull;          // Waiting for the log thread to complete it, when mFullPending
+        bool                      mPreparedReady;
+        bool                      mFullPending;
+        bool                      mStopThread;
+        std::thread               mThread;
+        std::mutex                mMutex;
+        std::condition_variable   mCondition;
+        std::atomic<unsigned int> mRecordCount;
+        std::atomic<unsigned int> mDroppedCount;
+        std::atomic<unsigned int> mSegmentCount;
+        std::atomic<bool>         mFailed;
+        std::string               mErrorStr;
+    };
+
+    // Plays a packet log back in place of the network connection to QTM, see CRTProtocol::OverrideNetwork,
+    // so that the application code that processes a live stream can process a recorded session. The segments
+    // are memory mapped and CRTProtocol receives the packets straight from the mapping, without a copy.
+    // Connect and the commands of a streaming client (Version, ByteOrder, GetState, StreamFrames,
+    // GetCurrentFrame) are answered locally, other commands get an error response. The data packets are
+    // delivered after StreamFrames, paced as recorded. After the last one, an EventRTfromFileStopped event
+    // is sent and IsFinished returns true. Only little endian logs are supported, and not on Windows.
+    class PacketLogNetwork : public INetwork
+    {
+    public:
+        // Playback speed factor. 1 is real time, 2 twice as fast and 0 as fast as possible.
+        explicit PacketLogNetwork(const char* fileName, double speed = 0.0);
+        ~PacketLogNetwork() override;
+
+        PacketLogNetwork(const PacketLogNetwork&) = delete;
+        PacketLogNetwork& operator=(const PacketLogNetwork&) = delete;
+
+        bool         IsOpen() const;
+        void         SetSpeed(double speed);
+        unsigned int GetFrameCount() const;
+        // Index of the next data packet.
+        unsigned int GetPosition() const;
+        // Continue from the first data packet with at least this frame number. The frame numbers must ascend.
+        bool         SeekFrame(unsigned int frameNumber);
+        bool         IsFinished() const;
+
+        bool  Connect(const char* serverAddr, unsigned short port) override;
+        void  Disconnect() override;
+        bool  Connected() const override;
+        bool  CreateUDPSocket(unsigned short& udpPort, bool broadcast = false) override;
+        Response Receive(char* rtDataBuff, int dataBufSize, bool header, int timeoutMicroseconds, unsigned int* ipAddr = nullptr) override;
+        Response ReceiveUdpBroadcast(char* rtDataBuff, int dataBufSize, int timeoutMicroseconds, unsigned int* ipAddr = nullptr) override;
+        bool  HasPacketReceive() const override;
+        Response ReceivePacket(char*& packetData, int timeoutMicroseconds) override;
+        bool  Send(const char* sendBuf, int size) override;
+        bool  SendUDPBroadcast(const char* sendBuf, int size, short port, unsigned int filterAddr = 0) override;
+        char* GetErrorString() override;
+        int   GetError() const override;
+        bool  IsLocalAddress(unsigned int addr) const override;
+        unsigned short GetUdpServerPort() override;
+        unsigned short GetUdpBroadcastServerPort() override;
+
+    private:
+        struct Mapping
+        {
+            char*       data;
+            std::size_t size;
+        };
+
+        bool OpenSegment(const std::string& fileName);
+        void HandleCommand(const char* command);
+        void QueuePacket(CRTPacket::EPacketType type, const void* data, std::uint32_t size);
+        void QueueString(CRTPacket::EPacketType type, const std::string& str);
+        void QueueEvent(CRTPacket::EEvent event);
+        void RestartPacing();
+        void SetError(const char* error);
+
+        std::vector<Mapping>                  mMappings;
+        std::vector<const PacketLogRecord*>   mRecords;      // All data packets, in order
+        double                                mSpeed;
+        std::size_t                           mPosition;
+        bool                                  mConnected;
+        bool                                  mStreaming;
+        unsigned int                          mSingleFrames; // Requested by GetCurrentFrame
+        bool                                  mFinished;
+        std::chrono::steady_clock::time_point mPacingStart;
+        std::uint64_t                         mPacingFirstTimestamp;
+        std::deque<std::vector<char>>         mResponses;     // Packets answering commands, delivered before data
+        std::vector<char>                     mResponse;      // The response handed out last by ReceivePacket
+        char*                                 mPartialPacket; // Rest of a packet not yet read by Receive
+        int                                   mPartialSize;
+        std::uint64_t                         mPartialTimestamp;
+        bool                                  mOpen;
+        unsigned int                          mMajorVersion;  // Of the recorded packets
+        unsigned int                          mMinorVersion;
+        char                                  mErrorStr[256];
+    };
+}
+
+#endif // PACKET_LOG_H
@@ -0,0 +1,525 @@
+#ifndef RTCOROUTINE_H
+#define RTCOROUTINE_H
+
+// Optional C++20 coroutine layer on top of CRTProtocol. It is header only, so the library itself still
+// builds as C++14. Include it from code that is compiled as C++20.
+//
+// One RTReactor runs on one thread and drives any number of RTConnections. It waits for the sockets of
+// all connections (see CRTProtocol::ProcessReadable) and resumes the coroutines whose frames or command
+// responses have arrived. Example:
+//
+//     Task<> Stream(RTConnection& connection)
+//     {
+//         auto response = co_await connection.SendCommandAsync("GetState");
+//         std::vector<SSettings6DOFBody> bodies;
+//         SSettingsGeneral general;
+//         bool dataAvailable;
+//         if (co_await connection.Read6DOFSettingsAsync(bodies, general, dataAvailable))
+//         {
+//             while (auto frame = co_await connection.ReceiveFrame())
+//             {
+//                 ...
+//             }
+//         }
+//     }
+//
+//     RTReactor reactor;
+//     RTConnection connection(reactor, protocol); // protocol is connected and streaming
+//     reactor.Spawn(Stream(connection));
+//     reactor.Run();
+
+#include "RTProtocol.h"
+#include "SettingsDeserializer.h"
+
+#include <algorithm>
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/select.h>
+#endif
+
+namespace qualisys_cpp_sdk
+{
+    template<typename T = void>
+    class Task;
+
+    namespace detail
+    {
+        struct TaskPromiseBase
+        {
+            struct FinalAwaiter
+            {
+                bool await_ready() noexcept { return false; }
+                template<typename Promise>
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept
+                {
+                    auto continuation = handle.promise().continuation;
+                    return continuation ? continuation : std::noop_coroutine();
+                }
+                void await_resume() noexcept {}
+            };
+
+            std::suspend_always initial_suspend() noexcept { return {}; }
+            FinalAwaiter final_suspend() noexcept { return {}; }
+            void unhandled_exception() noexcept { std::terminate(); }
+
+            std::coroutine_handle<> continuation;
+        };
+
+        template<typename T>
+        struct TaskPromise : TaskPromiseBase
+        {
+            Task<T> get_return_object();
+            void return_value(T result) { value = std::move(result); }
+
+            T value{};
+        };
+
+        template<>
+        struct TaskPromise<void> : TaskPromiseBase
+        {
+            Task<void> get_return_object();
+            void return_void() {}
+        };
+    }
+
+    // Lazily started coroutine. It runs when it is awaited, or when it is passed to RTReactor::Spawn.
+    template<typename T>
+    class Task
+    {
+    public:
+        using promise_type = detail::TaskPromise<T>;
+
+        Task() = default;
+        explicit Task(std::coroutine_handle<promise_type> handle) : mHandle(handle) {}
+        Task(Task&& other) noexcept : mHandle(std::exchange(other.mHandle, nullptr)) {}
+        Task& operator=(Task&& other) noexcept
+        {
+            if (this != &other)
+            {
+                if (mHandle)
+                {
+                    mHandle.destroy();
+                }
+                mHandle = std::exchange(other.mHandle, nullptr);
+            }
+            return *this;
+        }
+        ~Task()
+        {
+            if (mHandle)
+            {
+                mHandle.destroy();
+            }
+        }
+
+        bool IsDone() const { return !mHandle || mHandle.done(); }
+
+        auto operator co_await() && noexcept
+        {
+            struct Awaiter
+            {
+                std::coroutine_handle<promise_type> handle;
+
+                bool await_ready() const noexcept { return !handle || handle.done(); }
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<> continuation) noexcept
+                {
+                    handle.promise().continuation = continuation;
+                    return handle;
+                }
+                T await_resume()
+                {
+                    if constexpr (!std::is_void<T>::value)
+                    {
+                        return std::move(handle.promise().value);
+                    }
+                }
+            };
+            return Awaiter{ mHandle };
+        }
+
+    private:
+        friend class RTReactor;
+
+        std::coroutine_handle<promise_type> mHandle;
+    };
+
+    namespace detail
+    {
+        template<typename T>
+        Task<T> TaskPromise<T>::get_return_object()
+        {
+            return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+        }
+
+        inline Task<void> TaskPromise<void>::get_return_object()
+        {
+            return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+        }
+    }
+
+    class RTConnection;
+
+    // Single threaded event loop for RTConnections. All connections and tasks of a reactor must be used
+    // from the thread that runs it.
+    class RTReactor
+    {
+    public:
+        RTReactor() = default;
+        RTReactor(const RTReactor&) = delete;
+        RTReactor& operator=(const RTReactor&) = delete;
+
+        // Start a task. The reactor owns it until it has finished.
+        void Spawn(Task<> task)
+        {
+            mReady.push_back(task.mHandle);
+            mTasks.push_back(std::move(task));
+        }
+
+        // Wait up to timeoutMicroseconds (< 0 : no limit) for data on any connection, process it and resume
+        // the coroutines it completes. Connections whose network has no sockets are polled without waiting.
+        // Returns false if waiting for the sockets failed.
+        bool RunOnce(int timeoutMicroseconds);
+
+        // Run until all spawned tasks have finished.
+        bool Run()
+        {
+            while (!mTasks.empty())
+            {
+                if (!RunOnce(CRTProtocol::cWaitForDataTimeout))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        bool HasTasks() const { return !mTasks.empty(); }
+
+    private:
+        friend class RTConnection;
+
+        void Schedule(std::coroutine_handle<> handle) { mReady.push_back(handle); }
+        void ResumeReady()
+        {
+            while (!mReady.empty())
+            {
+                auto handle = mReady.front();
+                mReady.pop_front();
+                handle.resume();
+            }
+            mTasks.erase(std::remove_if(mTasks.begin(), mTasks.end(), [](const Task<>& task) { return task.IsDone(); }), mTasks.end());
+        }
+
+        std::vector<RTConnection*>          mConnections;
+        std::deque<std::coroutine_handle<>> mReady;
+        std::vector<Task<>>                 mTasks;
+    };
+
+    // Coroutine interface to a connected CRTProtocol. While the connection exists, the protocol must not be
+    // used for anything that reads from the server, and no receive thread may run. The connection must not
+    // be destroyed while a coroutine is suspended in one of its functions.
+    class RTConnection
+    {
+    public:
+        struct CommandResponse
+        {
+            CRTPacket::EPacketType type = CRTPacket::PacketNone; // PacketNone if the connection was lost
+            std::string            text;                         // Command response, XML or error string
+
+            explicit operator bool() const { return type == CRTPacket::PacketCommand || type == CRTPacket::PacketXML; }
+        };
+
+        class FrameAwaiter
+        {
+        public:
+            explicit FrameAwaiter(RTConnection& connection) : mConnection(connection) {}
+
+            bool await_ready() const noexcept { return !mConnection.mFrames.empty() || !mConnection.mConnected; }
+            void await_suspend(std::coroutine_handle<> handle)
+            {
+                mHandle = handle;
+                mConnection.mFrameWaiters.push_back(this);
+            }
+            FrameHandle await_resume()
+            {
+                if (!mFrame && !mConnection.mFrames.empty())
+                {
+                    mFrame = std::move(mConnection.mFrames.front());
+                    mConnection.mFrames.pop_front();
+                }
+                return std::move(mFrame);
+            }
+
+        private:
+            friend class RTConnection;
+
+            RTConnection&           mConnection;
+            std::coroutine_handle<> mHandle;
+            FrameHandle             mFrame;
+        };
+
+        class CommandAwaiter
+        {
+        public:
+            CommandAwaiter(RTConnection& connection, std::string command) : mConnection(connection), mCommand(std::move(command)) {}
+
+            bool await_ready() const noexcept { return false; }
+            bool await_suspend(std::coroutine_handle<> handle)
+            {
+                if (!mConnection.mConnected)
+                {
+                    return false;
+                }
+                if (!mConnection.mProtocol.PostCommand(mCommand.c_str()))
+                {
+                    mResponse.type = CRTPacket::PacketError;
+                    mResponse.text = mConnection.mProtocol.GetErrorString();
+                    return false;
+                }
+                mHandle = handle;
+                mConnection.mCommandWaiters.push_back(this);
+                return true;
+            }
+            CommandResponse await_resume() { return std::move(mResponse); }
+
+        private:
+            friend class RTConnection;
+
+            RTConnection&           mConnection;
+            std::string             mCommand;
+            std::coroutine_handle<> mHandle;
+            CommandResponse         mResponse;
+        };
+
+        // Data packets that arrive while no coroutine waits in ReceiveFrame are queued, up to frameQueueSize.
+        // The frames are held as FrameHandles, so the protocol's frame pool must be larger than the queue.
+        RTConnection(RTReactor& reactor, CRTProtocol& protocol, unsigned int frameQueueSize = 8) :
+            mReactor(reactor),
+            mProtocol(protocol),
+            mFrameQueueSize(frameQueueSize),
+            mDroppedFrames(0),
+            mConnected(protocol.Connected())
+        {
+            mReactor.mConnections.push_back(this);
+        }
+
+        RTConnection(const RTConnection&) = delete;
+        RTConnection& operator=(const RTConnection&) = delete;
+
+        ~RTConnection()
+        {
+            auto& connections = mReactor.mConnections;
+            connections.erase(std::remove(connections.begin(), connections.end(), this), connections.end());
+        }
+
+        // Next data packet. Empty handle if the connection has been lost.
+        FrameAwaiter ReceiveFrame() { return FrameAwaiter(*this); }
+
+        // Send a command and wait for its response. Only use it for commands that the server responds to.
+        // Responses are matched to commands in order, so several commands may be in flight at once.
+        CommandAwaiter SendCommandAsync(std::string command) { return CommandAwaiter(*this, std::move(command)); }
+
+        // GetParameters, the XML is in the text of the response.
+        Task<CommandResponse> ReadSettingsAsync(std::string settingsType)
+        {
+            co_return co_await SendCommandAsync("GetParameters " + settingsType);
+        }
+
+        // Read and parse settings. The out parameters must stay valid until the task has finished.
+        Task<bool> ReadGeneralSettingsAsync(SSettingsGeneral& generalSettings)
+        {
+            auto response = co_await SendCommandAsync("GetParameters General");
+            co_return response && CreateDeserializer(response).DeserializeGeneralSettings(generalSettings);
+        }
+
+        Task<bool> Read3DSettingsAsync(SSettings3D& settings3D, bool& dataAvailable)
+        {
+            auto response = co_await SendCommandAsync("GetParameters 3D");
+            co_return response && CreateDeserializer(response).Deserialize3DSettings(settings3D, dataAvailable);
+        }
+
+        // Before version 1.21 the 6D settings hold the Euler rotation definitions. They are stored in
+        // generalSettings.eulerRotations, the rest of generalSettings is not changed.
+        Task<bool> Read6DOFSettingsAsync(std::vector<SSettings6DOFBody>& settings6DOF, SSettingsGeneral& generalSettings, bool& dataAvailable)
+        {
+            auto response = co_await SendCommandAsync("GetParameters 6D");
+            co_return response && CreateDeserializer(response).Deserialize6DOFSettings(settings6DOF, generalSettings, dataAvailable);
+        }
+
+        Task<bool> ReadSkeletonSettingsAsync(std::vector<SSettingsSkeletonHierarchical>& skeletonSettings, bool& dataAvailable, bool skeletonGlobalData = false)
+        {
+            auto response = co_await SendCommandAsync(skeletonGlobalData ? "GetParameters Skeleton:global" : "GetParameters Skeleton");
+            std::vector<SSettingsSkeleton> flatSettings;
+            co_return response && CreateDeserializer(response).DeserializeSkeletonSettings(skeletonGlobalData, skeletonSettings, flatSettings, dataAvailable);
+        }
+
+        bool IsConnected() const { return mConnected; }
+        unsigned int GetDroppedFrameCount() const { return mDroppedFrames; }
+
+    private:
+        friend class RTReactor;
+
+        SettingsDeserializer CreateDeserializer(const CommandResponse& response)
+        {
+            unsigned int majorVersion = 0;
+            unsigned int minorVersion = 0;
+            mProtocol.GetVersion(majorVersion, minorVersion);
+            return SettingsDeserializer(response.text.c_str(), majorVersion, minorVersion);
+        }
+
+        // Read what is available and hand the packets to the waiting coroutines.
+        void Process()
+        {
+            if (!mConnected)
+            {
+                return;
+            }
+
+            auto result = mProtocol.ProcessReadable([this](CRTPacket::EPacketType type, CRTPacket* packet)
+            {
+                switch (type)
+                {
+                case CRTPacket::PacketData:
+                {
+                    auto frame = mProtocol.GetFrameHandle();
+                    if (frame && !mFrameWaiters.empty())
+                    {
+                        auto waiter = mFrameWaiters.front();
+                        mFrameWaiters.pop_front();
+                        waiter->mFrame = std::move(frame);
+                        mReactor.Schedule(waiter->mHandle);
+                    }
+                    else if (frame && mFrames.size() < mFrameQueueSize)
+                    {
+                        mFrames.push_back(std::move(frame));
+                    }
+                    else
+                    {
+                        mDroppedFrames++;
+                    }
+                    break;
+                }
+                case CRTPacket::PacketCommand:
+                case CRTPacket::PacketXML:
+                case CRTPacket::PacketError:
+                    if (!mCommandWaiters.empty())
+                    {
+                        auto waiter = mCommandWaiters.front();
+                        mCommandWaiters.pop_front();
+                        waiter->mResponse.type = type;
+                        waiter->mResponse.text = type == CRTPacket::PacketCommand ? packet->GetCommandString() :
+                                                 type == CRTPacket::PacketXML ? packet->GetXMLString() : packet->GetErrorString();
+                        mReactor.Schedule(waiter->mHandle);
+                    }
+                    break;
+                default:
+                    break; // Events update the protocol state, see CRTProtocol::GetState
+                }
+            });
+
+            if (result != CNetwork::ResponseType::success)
+            {
+                // Wake everyone up, they get an empty frame or a PacketNone response.
+                mConnected = false;
+                for (auto waiter : mFrameWaiters)
+                {
+                    mReactor.Schedule(waiter->mHandle);
+                }
+                for (auto waiter : mCommandWaiters)
+                {
+                    mReactor.Schedule(waiter->mHandle);
+                }
+                mFrameWaiters.clear();
+                mCommandWaiters.clear();
+            }
+        }
+
+        RTReactor&                  mReactor;
+        CRTProtocol&                mProtocol;
+        unsigned int                mFrameQueueSize;
+        unsigned int                mDroppedFrames;
+        bool                        mConnected;
+        std::deque<FrameHandle>     mFrames;
+        std::deque<FrameAwaiter*>   mFrameWaiters;
+        std::deque<CommandAwaiter*> mCommandWaiters;
+    };
+
+    inline bool RTReactor::RunOnce(int timeoutMicroseconds)
+    {
+        ResumeReady();
+
+        fd_set readFDs;
+        FD_ZERO(&readFDs);
+        SOCKET maxSocket = 0;
+        bool   waitForSockets = false;
+        bool   pollNetworks = false;
+
+        for (auto connection : mConnections)
+        {
+            if (!connection->mConnected)
+            {
+                continue;
+            }
+            auto network = connection->mProtocol.GetNetwork();
+            const SOCKET sockets[] = { network->GetSocket(), network->GetUdpSocket() };
+            if (sockets[0] == INVALID_SOCKET)
+            {
+                pollNetworks = true;
+                continue;
+            }
+            for (auto socket : sockets)
+            {
+                if (socket != INVALID_SOCKET)
+                {
+                    FD_SET(socket, &readFDs);
+                    maxSocket = std::max(maxSocket, socket);
+                    waitForSockets = true;
+                }
+            }
+        }
+
+        if (waitForSockets)
+        {
+            timeval timeout;
+            timeval* timeoutPtr = nullptr;
+            if (pollNetworks || !mReady.empty())
+            {
+                timeoutMicroseconds = 0;
+            }
+            if (timeoutMicroseconds >= 0)
+            {
+                timeout.tv_sec  = timeoutMicroseconds / 1000000;
+                timeout.tv_usec = timeoutMicroseconds % 1000000;
+                timeoutPtr = &timeout;
+            }
+            if (select((int)maxSocket + 1, &readFDs, nullptr, nullptr, timeoutPtr) < 0)
+            {
+                return false;
+            }
+        }
+
+        // Connections may be added or removed by the resumed coroutines, so resume them afterwards.
+        for (auto connection : mConnections)
+        {
+            auto network = connection->mProtocol.GetNetwork();
+            const SOCKET socket = network->GetSocket();
+            const SOCKET udpSocket = network->GetUdpSocket();
+            if (socket == INVALID_SOCKET || FD_ISSET(socket, &readFDs) || (udpSocket != INVALID_SOCKET && FD_ISSET(udpSocket, &readFDs)))
+            {
+                connection->Process();
+            }
+        }
+
+        ResumeReady();
+        return true;
+    }
+}
+
+#endif // RTCOROUTINE_H
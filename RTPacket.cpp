@@ -7,19 +7,340 @@
 #include <float.h>
 #include <math.h>
 
+#include <cmath>
+#include <thread>
+
 #ifdef _WIN32
 #include <Winsock2.h>
 #else
 #include <arpa/inet.h>
 #endif
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define RTPACKET_SSE2
+#if defined(__AVX__)
+#include <immintrin.h>
+#define RTPACKET_AVX
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define RTPACKET_NEON
+#endif
+
+using namespace qualisys_cpp_sdk;
+
+namespace
+{
+    // The bulk reads copy float layout items straight into these.
+    static_assert(sizeof(CRTPacket::SPosition) == PacketDecoder<false, PacketLayout::Float>::c3dMarkerSize, "3D marker size");
+    static_assert(sizeof(CRTPacket::S3DResidualMarker) == PacketDecoder<false, PacketLayout::Float>::c3dResidualMarkerSize, "3D residual marker size");
+    static_assert(sizeof(CRTPacket::S3DNoLabelsMarker) == PacketDecoder<false, PacketLayout::Float>::c3dNoLabelsMarkerSize, "3D no labels marker size");
+    static_assert(sizeof(CRTPacket::S3DNoLabelsResidualMarker) == PacketDecoder<false, PacketLayout::Float>::c3dNoLabelsResidualMarkerSize, "3D no labels residual marker size");
+    static_assert(sizeof(CRTPacket::S6DOFBody) == PacketDecoder<false, PacketLayout::Float>::c6dBodySize, "6DOF body size");
+    static_assert(sizeof(CRTPacket::S6DOFResidualBody) == PacketDecoder<false, PacketLayout::Float>::c6dResidualBodySize, "6DOF residual body size");
+
+    // Copies 32-bit words and reverses their byte order, four words at a time with SSE2 or NEON.
+    void CopyByteSwapped(const char* pSource, char* pTarget, unsigned int nWordCount)
+    {
+        unsigned int i = 0;
+#if defined(RTPACKET_SSE2)
+        for (; i + 4 <= nWordCount; i += 4)
+        {
+            __m128i words = _mm_loadu_si128((const __m128i*)(pSource + i * 4));
+            words = _mm_or_si128(_mm_slli_epi16(words, 8), _mm_srli_epi16(words, 8)); // Swap the bytes of each half
+            words = _mm_shufflehi_epi16(_mm_shufflelo_epi16(words, 0xb1), 0xb1);     // Swap the halves
+            _mm_storeu_si128((__m128i*)(pTarget + i * 4), words);
+        }
+#elif defined(RTPACKET_NEON)
+        for (; i + 4 <= nWordCount; i += 4)
+        {
+            vst1q_u8((uint8_t*)(pTarget + i * 4), vrev32q_u8(vld1q_u8((const uint8_t*)(pSource + i * 4))));
+        }
+#endif
+        for (; i < nWordCount; i++)
+        {
+            unsigned int nWord;
+            memcpy(&nWord, pSource + i * 4, sizeof(nWord));
+            nWord = (nWord >> 24) | ((nWord >> 8) & 0xff00) | ((nWord << 8) & 0xff0000) | (nWord << 24);
+            memcpy(pTarget + i * 4, &nWord, sizeof(nWord));
+        }
+    }
+
+    // Reads the items of a component into pItemBuf. Items in the float layout are stored as in the packet and
+    // are copied, byte swapped if needed. Items in the double layout are read one at a time by readItem.
+    template <typename TDecoder, typename TItem, typename TReadItem>
+    void ReadItems(const char* pComponent, unsigned int nItemSize, TItem* pItemBuf, unsigned int nCount, TReadItem readItem)
+    {
+        if (TDecoder::cLayout == PacketLayout::Float)
+        {
+            const char* pItems = TDecoder::GetItem(pComponent, 0, nItemSize);
+            if (TDecoder::cBigEndian)
+            {
+                CopyByteSwapped(pItems, (char*)pItemBuf, nCount * nItemSize / 4);
+            }
+            else
+            {
+                memcpy(pItemBuf, pItems, nCount * nItemSize);
+            }
+        }
+        else
+        {
+            for (unsigned int i = 0; i < nCount; i++)
+            {
+                readItem(i, pItemBuf[i]);
+            }
+        }
+    }
+
+    // Sets bit i % 32 of pValidMask[i / 32] when pX[i * nStride] isn't NaN.
+    void SetValidMask(const float* pX, unsigned int nStride, unsigned int nCount, unsigned int* pValidMask)
+    {
+        if (pValidMask == nullptr)
+        {
+            return;
+        }
+        for (unsigned int nWord = 0; nWord * 32 < nCount; nWord++)
+        {
+            const float*       pWordX = pX + nWord * 32 * nStride;
+            const unsigned int nBits  = nCount - nWord * 32 < 32 ? nCount - nWord * 32 : 32;
+            unsigned int       nMask  = 0;
+            unsigned int       i      = 0;
+#if defined(RTPACKET_SSE2)
+            for (; i + 4 <= nBits; i += 4)
+            {
+                const float* p = pWordX + i * nStride;
+                const __m128 x = _mm_setr_ps(p[0], p[nStride], p[2 * nStride], p[3 * nStride]);
+                nMask |= (unsigned int)_mm_movemask_ps(_mm_cmpord_ps(x, x)) << i;
+            }
+#endif
+            for (; i < nBits; i++)
+            {
+                const float x = pWordX[i * nStride];
+                nMask |= (unsigned int)(x == x) << i;
+            }
+            pValidMask[nWord] = nMask;
+        }
+    }
+
+    // Operations on one float or on the lanes of a SIMD register, for MatrixToQuaternion.
+    struct ScalarOps
+    {
+        using Type = float;
+        static const unsigned int cWidth = 1;
+
+        static float Set(float f) { return f; }
+        static float Gather(const float* p, unsigned int) { return *p; }
+        static void  Store(float* p, float f) { *p = f; }
+        static float Add(float a, float b) { return a + b; }
+        static float Sub(float a, float b) { return a - b; }
+        static float Mul(float a, float b) { return a * b; }
+        static float Div(float a, float b) { return a / b; }
+        static float Sqrt(float a) { return std::sqrt(a); }
+        static bool  Greater(float a, float b) { return a > b; } // False if either is NaN
+        static float Select(bool mask, float a, float b) { return mask ? a : b; }
+        static float CopySign(float a, float b) { return std::copysign(a, b); }
+    };
+
+#if defined(RTPACKET_SSE2)
+    struct Sse2Ops
+    {
+        using Type = __m128;
+        static const unsigned int cWidth = 4;
+
+        static __m128 Set(float f) { return _mm_set1_ps(f); }
+        static __m128 Gather(const float* p, unsigned int n) { return _mm_setr_ps(p[0], p[n], p[2 * n], p[3 * n]); }
+        static void   Store(float* p, __m128 v) { _mm_storeu_ps(p, v); }
+        static __m128 Add(__m128 a, __m128 b) { return _mm_add_ps(a, b); }
+        static __m128 Sub(__m128 a, __m128 b) { return _mm_sub_ps(a, b); }
+        static __m128 Mul(__m128 a, __m128 b) { return _mm_mul_ps(a, b); }
+        static __m128 Div(__m128 a, __m128 b) { return _mm_div_ps(a, b); }
+        static __m128 Sqrt(__m128 a) { return _mm_sqrt_ps(a); }
+        static __m128 Greater(__m128 a, __m128 b) { return _mm_cmpgt_ps(a, b); }
+        static __m128 Select(__m128 mask, __m128 a, __m128 b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+        // a must not be negative.
+        static __m128 CopySign(__m128 a, __m128 b) { return _mm_or_ps(a, _mm_and_ps(_mm_set1_ps(-0.0f), b)); }
+    };
+#endif
+
+#if defined(RTPACKET_AVX)
+    struct AvxOps
+    {
+        using Type = __m256;
+        static const unsigned int cWidth = 8;
+
+        static __m256 Set(float f) { return _mm256_set1_ps(f); }
+        static __m256 Gather(const float* p, unsigned int n)
+        {
+            return _mm256_setr_ps(p[0], p[n], p[2 * n], p[3 * n], p[4 * n], p[5 * n], p[6 * n], p[7 * n]);
+        }
+        static void   Store(float* p, __m256 v) { _mm256_storeu_ps(p, v); }
+        static __m256 Add(__m256 a, __m256 b) { return _mm256_add_ps(a, b); }
+        static __m256 Sub(__m256 a, __m256 b) { return _mm256_sub_ps(a, b); }
+        static __m256 Mul(__m256 a, __m256 b) { return _mm256_mul_ps(a, b); }
+        static __m256 Div(__m256 a, __m256 b) { return _mm256_div_ps(a, b); }
+        static __m256 Sqrt(__m256 a) { return _mm256_sqrt_ps(a); }
+        static __m256 Greater(__m256 a, __m256 b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+        static __m256 Select(__m256 mask, __m256 a, __m256 b) { return _mm256_blendv_ps(b, a, mask); }
+        static __m256 CopySign(__m256 a, __m256 b) { return _mm256_or_ps(a, _mm256_and_ps(_mm256_set1_ps(-0.0f), b)); }
+    };
+    using RotationBatchOps = AvxOps;
+#elif defined(RTPACKET_SSE2)
+    using RotationBatchOps = Sse2Ops;
+#elif defined(RTPACKET_NEON)
+    struct NeonOps
+    {
+        using Type = float32x4_t;
+        static const unsigned int cWidth = 4;
+
+        static float32x4_t Set(float f) { return vdupq_n_f32(f); }
+        static float32x4_t Gather(const float* p, unsigned int n)
+        {
+            const float af[4] = { p[0], p[n], p[2 * n], p[3 * n] };
+            return vld1q_f32(af);
+        }
+        static void        Store(float* p, float32x4_t v) { vst1q_f32(p, v); }
+        static float32x4_t Add(float32x4_t a, float32x4_t b) { return vaddq_f32(a, b); }
+        static float32x4_t Sub(float32x4_t a, float32x4_t b) { return vsubq_f32(a, b); }
+        static float32x4_t Mul(float32x4_t a, float32x4_t b) { return vmulq_f32(a, b); }
+        static float32x4_t Div(float32x4_t a, float32x4_t b) { return vdivq_f32(a, b); }
+        static float32x4_t Sqrt(float32x4_t a) { return vsqrtq_f32(a); }
+        static uint32x4_t  Greater(float32x4_t a, float32x4_t b) { return vcgtq_f32(a, b); }
+        static float32x4_t Select(uint32x4_t mask, float32x4_t a, float32x4_t b) { return vbslq_f32(mask, a, b); }
+        static float32x4_t CopySign(float32x4_t a, float32x4_t b)
+        {
+            return vreinterpretq_f32_u32(vorrq_u32(vreinterpretq_u32_f32(a), vandq_u32(vreinterpretq_u32_f32(b), vdupq_n_u32(0x80000000))));
+        }
+    };
+    using RotationBatchOps = NeonOps;
+#else
+    using RotationBatchOps = ScalarOps;
+#endif
+
+    // Normalized quaternions x, y, z, w of column major rotation matrices, one per lane, with w >= 0. Shepperd's
+    // method: 4 * w^2, x^2, y^2 and z^2 follow from the diagonal, and each row of the table below is the
+    // quaternion scaled by 4 * w, x, y or z. The row with the largest diagonal term is chosen by lane, so
+    // that the normalization never divides by a value near 0, also for half turns. A NaN matrix gives a NaN
+    // quaternion.
+    template <typename TOps, typename T = typename TOps::Type>
+    void MatrixToQuaternion(const T m[9], T q[4])
+    {
+        const T one = TOps::Set(1.0f);
+        const T a   = TOps::Add(one, m[0]); // 1 + r11
+        const T b   = TOps::Sub(one, m[0]); // 1 - r11
+        const T c   = TOps::Add(m[4], m[8]); // r22 + r33
+        const T d   = TOps::Sub(m[4], m[8]); // r22 - r33
+        const T t[4] = { TOps::Add(a, c), TOps::Sub(a, c), TOps::Add(b, d), TOps::Sub(b, d) };
+        const T dx  = TOps::Sub(m[5], m[7]); // r32 - r23
+        const T dy  = TOps::Sub(m[6], m[2]); // r13 - r31
+        const T dz  = TOps::Sub(m[1], m[3]); // r21 - r12
+        const T sxy = TOps::Add(m[1], m[3]); // r21 + r12
+        const T sxz = TOps::Add(m[6], m[2]); // r13 + r31
+        const T syz = TOps::Add(m[5], m[7]); // r32 + r23
+        const T rows[4][4] = {   // w, x, y, z
+            { t[0], dx,   dy,   dz   },
+            { dx,   t[1], sxy,  sxz  },
+            { dy,   sxy,  t[2], syz  },
+            { dz,   sxz,  syz,  t[3] }
+        };
+
+        T largest = t[0];
+        T v[4] = { rows[0][0], rows[0][1], rows[0][2], rows[0][3] };
+        for (int k = 1; k < 4; k++)
+        {
+            const auto mask = TOps::Greater(t[k], largest);
+            largest = TOps::Select(mask, t[k], largest);
+            for (int i = 0; i < 4; i++)
+            {
+                v[i] = TOps::Select(mask, rows[k][i], v[i]);
+            }
+        }
+
+        const T squared = TOps::Add(TOps::Add(TOps::Mul(v[0], v[0]), TOps::Mul(v[1], v[1])),
+                                    TOps::Add(TOps::Mul(v[2], v[2]), TOps::Mul(v[3], v[3])));
+        const T norm = TOps::CopySign(TOps::Div(one, TOps::Sqrt(squared)), v[0]);
+        q[0] = TOps::Mul(v[1], norm);
+        q[1] = TOps::Mul(v[2], norm);
+        q[2] = TOps::Mul(v[3], norm);
+        q[3] = TOps::Mul(v[0], norm);
+    }
+
+    const unsigned int cRotationBatchSize = RotationBatchOps::cWidth < 4 ? 4 : RotationBatchOps::cWidth;
+
+    // Positions and rotation matrices of a batch of bodies, and their quaternions by element.
+    struct SRotationBatch
+    {
+        float afBody[cRotationBatchSize][12];
+        float afQuaternion[4][cRotationBatchSize];
+    };
+
+    void ConvertRotationBatch(SRotationBatch& sBatch)
+    {
+        using T = RotationBatchOps::Type;
+        for (unsigned int nLane = 0; nLane < cRotationBatchSize; nLane += RotationBatchOps::cWidth)
+        {
+            T m[9];
+            T q[4];
+            for (unsigned int k = 0; k < 9; k++)
+            {
+                m[k] = RotationBatchOps::Gather(&sBatch.afBody[nLane][3 + k], 12);
+            }
+            MatrixToQuaternion<RotationBatchOps>(m, q);
+            for (unsigned int k = 0; k < 4; k++)
+            {
+                RotationBatchOps::Store(&sBatch.afQuaternion[k][nLane], q[k]);
+            }
+        }
+    }
+
+    // Reads nCount bodies into pPoseBuf, readBody(i, afBody) reads the position and rotation matrix of body i,
+    // and converts their rotation matrices a batch at a time.
+    template <typename TReadBody>
+    void ReadPoses(unsigned int nCount, CRTPacket::SPose* pPoseBuf, TReadBody readBody)
+    {
+        SRotationBatch sBatch;
+        for (unsigned int nFirst = 0; nFirst < nCount; nFirst += cRotationBatchSize)
+        {
+            const unsigned int nBatchCount = nCount - nFirst < cRotationBatchSize ? nCount - nFirst : cRotationBatchSize;
+            for (unsigned int nLane = 0; nLane < cRotationBatchSize; nLane++)
+            {
+                if (nLane < nBatchCount)
+                {
+                    readBody(nFirst + nLane, sBatch.afBody[nLane]);
+                }
+                else
+                {
+                    const float afIdentity[12] = { 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f };
+                    memcpy(sBatch.afBody[nLane], afIdentity, sizeof(afIdentity));
+                }
+            }
+            ConvertRotationBatch(sBatch);
+            for (unsigned int nLane = 0; nLane < nBatchCount; nLane++)
+            {
+                CRTPacket::SPose& sPose = pPoseBuf[nFirst + nLane];
+                sPose.position.x = sBatch.afBody[nLane][0];
+                sPose.position.y = sBatch.afBody[nLane][1];
+                sPose.position.z = sBatch.afBody[nLane][2];
+                CRTPacket::SRotation& sRotation = sPose.rotation;
+                sRotation.x = sBatch.afQuaternion[0][nLane];
+                sRotation.y = sBatch.afQuaternion[1][nLane];
+                sRotation.z = sBatch.afQuaternion[2][nLane];
+                sRotation.w = sBatch.afQuaternion[3][nLane];
+            }
+        }
+    }
+}
+
 
 CRTPacket::CRTPacket(int nMajorVersion, int nMinorVersion, bool bBigEndian)
 {
     mnMajorVersion = nMajorVersion;
     mnMinorVersion = nMinorVersion;
     mbBigEndian    = bBigEndian;
+    meDecoderType  = GetPacketDecoderType(mbBigEndian, mnMajorVersion, mnMinorVersion);
 
+    memset(mnIndexStart, 0, sizeof(mnIndexStart));
+    memset(mnIndexInline, 0, sizeof(mnIndexInline));
     ClearData();
 }
 
@@ -33,6 +354,7 @@ void CRTPacket::SetVersion(unsigned int nMajorVersion, unsigned int nMinorVersio
 {
     mnMajorVersion = nMajorVersion;
     mnMinorVersion = nMinorVersion;
+    meDecoderType  = GetPacketDecoderType(mbBigEndian, mnMajorVersion, mnMinorVersion);
 }
 
 bool CRTPacket::GetEndianness()
@@ -42,12 +364,14 @@ bool CRTPacket::GetEndianness()
 
 void CRTPacket::SetEndianness(bool bBigEndian)
 {
-    mbBigEndian = bBigEndian;
+    mbBigEndian   = bBigEndian;
+    meDecoderType = GetPacketDecoderType(mbBigEndian, mnMajorVersion, mnMinorVersion);
 }
 
 void CRTPacket::ClearData()
 {
     mpData                    = nullptr;
+    mnReceiveTimestamp        = 0;
     mnComponentCount          = 0;
     mn2DCameraCount           = 0;
     mn2DLinCameraCount        = 0;
@@ -60,13 +384,14 @@ void CRTPacket::ClearData()
     mnEyeTrackerCount         = 0;
     mnTimecodeCount           = 0;
     mSkeletonCount            = 0;
-    mpComponentData.resize(ComponentNone);
+    mnIndexedComponents.nBits.store(~0u, std::memory_order_relaxed);
+    mnIndexUsed               = 0;
+    memset(mnComponentOffset, 0, sizeof(mnComponentOffset));
 }
 
 void CRTPacket::SetData(char* ptr)
 {
     unsigned int nComponent;
-    unsigned int nCamera, nDevice;
 
     mpData = ptr;
 
@@ -81,249 +406,237 @@ void CRTPacket::SetData(char* ptr)
     mnGazeVectorCount         = 0;
     mnEyeTrackerCount         = 0;
     mnTimecodeCount           = 0;
-    mSkeletonCount           = 0;
+    mSkeletonCount            = 0;
+    mnIndexedComponents.nBits.store(~0u, std::memory_order_relaxed);
+    mnIndexUsed               = 0;
+
+    // Reset all component offsets
+    memset(mnComponentOffset, 0, sizeof(mnComponentOffset));
 
     // Check if it's a data packet
     if (GetType() == PacketData)
     {
-        // Reset all component data pointers
-        for (nComponent = 1; nComponent < ComponentNone; nComponent++)
+        char*       pCurrentComponent = mpData + 24;
+        const char* pEnd              = mpData + GetSize();
+
+        mnComponentCount = SetByteOrder((unsigned int*)(mpData + 20));
+
+        // Only the components and their device counts are read here. The cameras and devices of a component are
+        // found the first time they are used, see IndexComponent.
+        for (nComponent = 1; nComponent <= mnComponentCount && pCurrentComponent + 12 <= pEnd; nComponent++)
         {
-            mpComponentData[nComponent - 1] = nullptr;
+            const unsigned int nComponentType = SetByteOrder((unsigned int*)(pCurrentComponent + 4));
+            if (nComponentType == 0 || nComponentType >= ComponentNone)
+            {
+                break;
+            }
+            mnComponentOffset[nComponentType - 1] = (unsigned int)(pCurrentComponent - mpData);
+
+            const unsigned int nCount = SetByteOrder((unsigned int*)(pCurrentComponent + 8));
+            switch (nComponentType)
+            {
+                case Component2d:           mn2DCameraCount = nCount; break;
+                case Component2dLin:        mn2DLinCameraCount = nCount; break;
+                case ComponentImage:        mnImageCameraCount = nCount; break;
+                case ComponentAnalog:       mnAnalogDeviceCount = (mnMajorVersion == 1 && mnMinorVersion == 0) ? 1 : nCount; break;
+                case ComponentAnalogSingle: mnAnalogSingleDeviceCount = nCount; break;
+                case ComponentForce:        mnForcePlateCount = nCount; break;
+                case ComponentForceSingle:  mnForceSinglePlateCount = nCount; break;
+                case ComponentGazeVector:   mnGazeVectorCount = nCount; break;
+                case ComponentEyeTracker:   mnEyeTrackerCount = nCount; break;
+                case ComponentTimecode:     mnTimecodeCount = nCount; break;
+                case ComponentSkeleton:     mSkeletonCount = nCount; break;
+                default: break;
+            }
+            pCurrentComponent += SetByteOrder((int*)pCurrentComponent);
         }
 
-        char*        pCurrentComponent = mpData + 24;
-        unsigned int nComponentType    = SetByteOrder((unsigned int*)(pCurrentComponent + 4));
+        // One entry per camera or device. Sized for all components now, so that indexing never moves the index
+        // while other threads read it.
+        const unsigned int nIndexSize = mn2DCameraCount + mn2DLinCameraCount + mnImageCameraCount + mnAnalogDeviceCount +
+            mnAnalogSingleDeviceCount + mnForcePlateCount + mnForceSinglePlateCount + mnGazeVectorCount + mnEyeTrackerCount +
+            mnTimecodeCount + mSkeletonCount;
+        if (nIndexSize > GetIndexCapacity())
+        {
+            const unsigned int nCapacity = GetIndexCapacity() * 2;
+            ReserveIndex(nIndexSize > nCapacity ? nIndexSize : nCapacity);
+        }
+        mnIndexedComponents.nBits.store(0, std::memory_order_relaxed);
+    }
+} // SetData
 
-        mnComponentCount = SetByteOrder((unsigned int*)(mpData + 20));
 
-        for (nComponent = 1; nComponent <= mnComponentCount && nComponentType > 0 && nComponentType < ComponentNone; nComponent++)
+void CRTPacket::ReserveIndex(unsigned int nEntryCount)
+{
+    if (nEntryCount > cInlineIndexSize && nEntryCount > mIndexHeap.size())
+    {
+        if (mIndexHeap.empty())
+        {
+            mIndexHeap.resize(nEntryCount);
+            memcpy(mIndexHeap.data(), mnIndexInline, mnIndexUsed * sizeof(unsigned int));
+        }
+        else
         {
-            mpComponentData[nComponentType - 1] = pCurrentComponent;
+            mIndexHeap.resize(nEntryCount);
+        }
+    }
+}
 
-            if (nComponentType == Component2d)
-            {
-                mn2DCameraCount = SetByteOrder((unsigned int*)(pCurrentComponent + 8));
-                mp2DData.resize(mn2DCameraCount);
 
-                if (!mp2DData.empty())
-                {
-                    mp2DData[0] = pCurrentComponent + 16;
-                    for (nCamera = 1; nCamera < mn2DCameraCount; nCamera++)
-                    {
-                        if (mnMajorVersion > 1 || mnMinorVersion > 7)
-                        {
-                            mp2DData[nCamera] = mp2DData[nCamera - 1] + 5 + Get2DMarkerCount(nCamera - 1) * 12;
-                        }
-                        else
-                        {
-                            mp2DData[nCamera] = mp2DData[nCamera - 1] + 4 + Get2DMarkerCount(nCamera - 1) * 12;
-                        }
-                    }
-                }
-            }
-            if (nComponentType == Component2dLin)
-            {
-                mn2DLinCameraCount = SetByteOrder((unsigned int*)(pCurrentComponent + 8));
-                mp2DLinData.resize(mn2DLinCameraCount);
+unsigned int CRTPacket::GetIndexCapacity() const
+{
+    return mIndexHeap.empty() ? cInlineIndexSize : (unsigned int)mIndexHeap.size();
+}
 
-                if (!mp2DLinData.empty())
-                {
-                    mp2DLinData[0] = pCurrentComponent + 16;
-                    for (nCamera = 1; nCamera < mn2DLinCameraCount; nCamera++)
-                    {
-                        if (mnMajorVersion > 1 || mnMinorVersion > 7)
-                        {
-                            mp2DLinData[nCamera] = mp2DLinData[nCamera - 1] + 5 + Get2DLinMarkerCount(nCamera - 1) * 12;
-                        }
-                        else
-                        {
-                            mp2DLinData[nCamera] = mp2DLinData[nCamera - 1] + 4 + Get2DLinMarkerCount(nCamera - 1) * 12;
-                        }
-                    }
-                }
-            }
-            if (nComponentType == ComponentImage)
-            {
-                mnImageCameraCount = SetByteOrder((unsigned int*)(pCurrentComponent + 8));
-                mpImageData.resize(mnImageCameraCount);
 
-                if (!mpImageData.empty())
-                {
-                    mpImageData[0] = pCurrentComponent + 12;
-                    for (nCamera = 1; nCamera < mnImageCameraCount; nCamera++)
-                    {
-                        mpImageData[nCamera] = mpImageData[nCamera - 1] + 36 + SetByteOrder((unsigned int*)(mpImageData[nCamera - 1] + 32));
-                    }
-                }
-            }
-            if (nComponentType == ComponentAnalog)
-            {
-                if ((mnMajorVersion == 1) && (mnMinorVersion == 0))
-                {
-                    mnAnalogDeviceCount = 1;
-                }
-                else
-                {
-                    mnAnalogDeviceCount = SetByteOrder((unsigned int*)(pCurrentComponent + 8));
-                }
-                mpAnalogData.resize(mnAnalogDeviceCount);
+void CRTPacket::IndexComponents()
+{
+    for (unsigned int nComponent = 1; nComponent < ComponentNone; nComponent++)
+    {
+        EnsureIndexed((EComponentType)nComponent);
+    }
+}
 
-                if (!mpAnalogData.empty())
-                {
-                    if ((mnMajorVersion > 1) || (mnMinorVersion > 7))
-                    {
-                        mpAnalogData[0] = pCurrentComponent + 12;
-                    }
-                    else
-                    {
-                        mpAnalogData[0] = pCurrentComponent + 16;
-                    }
-                    for (nDevice = 1; nDevice < mnAnalogDeviceCount; nDevice++)
-                    {
-                        mpAnalogData[nDevice] = mpAnalogData[nDevice - 1] + 16 +
-                            (SetByteOrder((unsigned int*)(mpAnalogData[nDevice - 1] + 4)) *
-                                SetByteOrder((unsigned int*)(mpAnalogData[nDevice - 1] + 8)) * 4);
-                    }
-                }
-            }
-            if (nComponentType == ComponentAnalogSingle)
-            {
-                mnAnalogSingleDeviceCount = SetByteOrder((unsigned int*)(pCurrentComponent + 8));
-                mpAnalogSingleData.resize(mnAnalogSingleDeviceCount);
 
-                if (!mpAnalogSingleData.empty())
-                {
-                    if (mnMajorVersion > 1 || mnMinorVersion > 7)
-                    {
-                        mpAnalogSingleData[0] = pCurrentComponent + 12;
-                    }
-                    else
-                    {
-                        mpAnalogSingleData[0] = pCurrentComponent + 16;
-                    }
+inline char* CRTPacket::GetComponentData(EComponentType eComponent)
+{
+    const unsigned int nOffset = mnComponentOffset[eComponent - 1];
+    return nOffset == 0 ? nullptr : mpData + nOffset;
+}
 
-                    for (nDevice = 1; nDevice < mnAnalogSingleDeviceCount; nDevice++)
-                    {
-                        mpAnalogSingleData[nDevice] = mpAnalogSingleData[nDevice - 1] + 8 +
-                            SetByteOrder((unsigned int*)(mpAnalogSingleData[nDevice - 1] + 4)) * 4;
-                    }
-                }
-            }
-            if (nComponentType == ComponentForce)
-            {
-                mnForcePlateCount = SetByteOrder((unsigned int*)(pCurrentComponent + 8));
-                mpForceData.resize(mnForcePlateCount);
 
-                if (!mpForceData.empty())
-                {
-                    if (mnMajorVersion > 1 || mnMinorVersion > 7)
-                    {
-                        mpForceData[0] = pCurrentComponent + 12;
-                    }
-                    else
-                    {
-                        mpForceData[0] = pCurrentComponent + 16;
-                    }
-                    for (nDevice = 1; nDevice < mnForcePlateCount; nDevice++)
-                    {
-                        if ((mnMajorVersion == 1) && (mnMinorVersion == 0))
-                        {
-                            mpForceData[nDevice] = mpForceData[nDevice - 1] + 72;
-                        }
-                        else
-                        {
-                            mpForceData[nDevice] = mpForceData[nDevice - 1] + 12 +
-                                SetByteOrder((unsigned int*)(mpForceData[nDevice - 1] + 4)) * 36;
-                        }
-                    }
-                }
-            }
-            if (nComponentType == ComponentForceSingle)
-            {
-                mnForceSinglePlateCount = SetByteOrder((unsigned int*)(pCurrentComponent + 8));
-                mpForceSingleData.resize(mnForceSinglePlateCount);
+inline void CRTPacket::EnsureIndexed(EComponentType eComponent)
+{
+    // Acquire, so that the index of the component, built by another thread, is visible.
+    if ((mnIndexedComponents.nBits.load(std::memory_order_acquire) & (1u << eComponent)) == 0)
+    {
+        IndexComponent(eComponent);
+    }
+}
 
-                if (!mpForceSingleData.empty())
-                {
-                    mpForceSingleData[0] = pCurrentComponent + 12;
 
-                    for (nDevice = 1; nDevice < mnForceSinglePlateCount; nDevice++)
-                    {
-                        mpForceSingleData[nDevice] = mpForceSingleData[nDevice - 1] + 4 + 36;
-                    }
-                }
-            }
-            if (nComponentType == ComponentGazeVector)
-            {
-                mnGazeVectorCount = SetByteOrder((unsigned int*)(pCurrentComponent + 8));
-                mpGazeVectorData.resize(mnGazeVectorCount);
+inline char* CRTPacket::GetItem(EComponentType eComponent, unsigned int nItemIndex)
+{
+    const unsigned int* pIndex = mIndexHeap.empty() ? mnIndexInline : mIndexHeap.data();
+    return mpData + pIndex[mnIndexStart[eComponent - 1] + nItemIndex];
+}
 
-                if (!mpGazeVectorData.empty())
-                {
-                    mpGazeVectorData[0] = pCurrentComponent + 12;
 
-                    for (nDevice = 1; nDevice < mnGazeVectorCount; nDevice++)
-                    {
-                        unsigned int nPrevSampleCount = SetByteOrder((unsigned int*)(mpGazeVectorData[nDevice - 1]));
-                        mpGazeVectorData[nDevice] = mpGazeVectorData[nDevice - 1] + 4 + ((nPrevSampleCount == 0) ? 0 : 4) +
-                            nPrevSampleCount * 24;
-                    }
-                }
-            }
-            if (nComponentType == ComponentEyeTracker)
-            {
-                mnEyeTrackerCount = SetByteOrder((unsigned int*)(pCurrentComponent + 8));
-                mpEyeTrackerData.resize(mnEyeTrackerCount);
+// Index a component once, also when several threads read the packet. The thread that sets cIndexLockBit
+// builds the index, the others wait until its bit is published.
+void CRTPacket::IndexComponent(EComponentType eComponent)
+{
+    static_assert(ComponentNone < 31, "A component bit would be the lock bit.");
 
-                if (!mpEyeTrackerData.empty())
-                {
-                    mpEyeTrackerData[0] = pCurrentComponent + 12;
+    const unsigned int nBit  = 1u << eComponent;
+    unsigned int       nBits = mnIndexedComponents.nBits.load(std::memory_order_acquire);
+    while (true)
+    {
+        if ((nBits & nBit) != 0)
+        {
+            return;
+        }
+        if ((nBits & cIndexLockBit) != 0)
+        {
+            std::this_thread::yield();
+            nBits = mnIndexedComponents.nBits.load(std::memory_order_acquire);
+        }
+        else if (mnIndexedComponents.nBits.compare_exchange_weak(nBits, nBits | cIndexLockBit, std::memory_order_acquire))
+        {
+            break;
+        }
+    }
 
-                    for (nDevice = 1; nDevice < mnEyeTrackerCount; nDevice++)
-                    {
-                        unsigned int nPrevSampleCount = SetByteOrder((unsigned int*)(mpEyeTrackerData[nDevice - 1]));
-                        mpEyeTrackerData[nDevice] = mpEyeTrackerData[nDevice - 1] + 4 + ((nPrevSampleCount == 0) ? 0 : 4) +
-                            nPrevSampleCount * 28;
-                    }
-                }
-            }
-            if (nComponentType == ComponentTimecode)
-            {
-                mnTimecodeCount = SetByteOrder((unsigned int*)(pCurrentComponent + 8));
-                mpTimecodeData.resize(mnTimecodeCount);
+    BuildComponentIndex(eComponent);
+    mnIndexedComponents.nBits.store(nBits | nBit, std::memory_order_release);
+}
 
-                if (!mpTimecodeData.empty())
-                {
-                    mpTimecodeData[0] = pCurrentComponent + 12;
 
-                    for (nDevice = 1; nDevice < mnTimecodeCount; nDevice++)
-                    {
-                        mpTimecodeData[nDevice] = mpTimecodeData[nDevice - 1] + 12;
-                    }
-                }
-            }
-            if (nComponentType == ComponentSkeleton)
-            {
-                mSkeletonCount = SetByteOrder((unsigned int*)(pCurrentComponent + 8));
-                mpSkeletonData.resize(mSkeletonCount);
+// Find the start of each camera or device of a component, which depends on the sizes of the ones before it,
+// and add their offsets to the index.
+void CRTPacket::BuildComponentIndex(EComponentType eComponent)
+{
+    char* pItem = GetComponentData(eComponent);
+    if (pItem == nullptr)
+    {
+        return;
+    }
 
-                if (!mpSkeletonData.empty())
-                {
-                    mpSkeletonData[0] = pCurrentComponent + 12;
+    const bool   bNewLayout = mnMajorVersion > 1 || mnMinorVersion > 7;
+    unsigned int nItemCount;
+    switch (eComponent)
+    {
+        case Component2d:           nItemCount = mn2DCameraCount;           pItem += 16; break;
+        case Component2dLin:        nItemCount = mn2DLinCameraCount;        pItem += 16; break;
+        case ComponentImage:        nItemCount = mnImageCameraCount;        pItem += 12; break;
+        case ComponentAnalog:       nItemCount = mnAnalogDeviceCount;       pItem += bNewLayout ? 12 : 16; break;
+        case ComponentAnalogSingle: nItemCount = mnAnalogSingleDeviceCount; pItem += bNewLayout ? 12 : 16; break;
+        case ComponentForce:        nItemCount = mnForcePlateCount;         pItem += bNewLayout ? 12 : 16; break;
+        case ComponentForceSingle:  nItemCount = mnForceSinglePlateCount;   pItem += 12; break;
+        case ComponentGazeVector:   nItemCount = mnGazeVectorCount;         pItem += 12; break;
+        case ComponentEyeTracker:   nItemCount = mnEyeTrackerCount;         pItem += 12; break;
+        case ComponentTimecode:     nItemCount = mnTimecodeCount;           pItem += 12; break;
+        case ComponentSkeleton:     nItemCount = mSkeletonCount;            pItem += 12; break;
+        default: return;
+    }
 
-                    for (nDevice = 1; nDevice < mSkeletonCount; nDevice++)
-                    {
-                        unsigned int prevSegmentCount = SetByteOrder((unsigned int*)(mpSkeletonData[nDevice - 1]));
-                        mpSkeletonData[nDevice] = mpSkeletonData[nDevice - 1] + 4 + prevSegmentCount * 32;
-                    }
+    // Tables are added in the order the components are first read, into the capacity SetData made sure of.
+    mnIndexStart[eComponent - 1] = mnIndexUsed;
+    unsigned int* pIndex = (mIndexHeap.empty() ? mnIndexInline : mIndexHeap.data()) + mnIndexUsed;
+    mnIndexUsed += nItemCount;
+
+    for (unsigned int nItem = 0; nItem < nItemCount; nItem++)
+    {
+        pIndex[nItem] = (unsigned int)(pItem - mpData);
+
+        unsigned int nSampleCount;
+        switch (eComponent)
+        {
+            case Component2d:
+            case Component2dLin:
+                pItem += (bNewLayout ? 5 : 4) + SetByteOrder((unsigned int*)pItem) * 12;
+                break;
+            case ComponentImage:
+                pItem += 36 + SetByteOrder((unsigned int*)(pItem + 32));
+                break;
+            case ComponentAnalog:
+                pItem += 16 + SetByteOrder((unsigned int*)(pItem + 4)) * SetByteOrder((unsigned int*)(pItem + 8)) * 4;
+                break;
+            case ComponentAnalogSingle:
+                pItem += 8 + SetByteOrder((unsigned int*)(pItem + 4)) * 4;
+                break;
+            case ComponentForce:
+                if ((mnMajorVersion == 1) && (mnMinorVersion == 0))
+                {
+                    pItem += 72;
                 }
-            }
-            pCurrentComponent += SetByteOrder((int*)pCurrentComponent);
-            nComponentType     = SetByteOrder((unsigned int*)(pCurrentComponent + 4));
+                else
+                {
+                    pItem += 12 + SetByteOrder((unsigned int*)(pItem + 4)) * 36;
+                }
+                break;
+            case ComponentForceSingle:
+                pItem += 4 + 36;
+                break;
+            case ComponentGazeVector:
+                nSampleCount = SetByteOrder((unsigned int*)pItem);
+                pItem += 4 + ((nSampleCount == 0) ? 0 : 4) + nSampleCount * 24;
+                break;
+            case ComponentEyeTracker:
+                nSampleCount = SetByteOrder((unsigned int*)pItem);
+                pItem += 4 + ((nSampleCount == 0) ? 0 : 4) + nSampleCount * 28;
+                break;
+            case ComponentTimecode:
+                pItem += 12;
+                break;
+            case ComponentSkeleton:
+                pItem += 4 + SetByteOrder((unsigned int*)pItem) * 32;
+                break;
+            default:
+                break;
         }
     }
-} // SetData
+} // BuildComponentIndex
 
 
 void CRTPacket::GetData(char* &ptr, unsigned int& nSize)
@@ -374,6 +687,16 @@ unsigned long long CRTPacket::GetTimeStamp()
     return 0;
 }
 
+unsigned long long CRTPacket::GetReceiveTimestamp()
+{
+    return mnReceiveTimestamp;
+}
+
+void CRTPacket::SetReceiveTimestamp(unsigned long long timestamp)
+{
+    mnReceiveTimestamp = timestamp;
+}
+
 unsigned int CRTPacket::GetFrameNumber()
 {
     if (GetType() == PacketData)
@@ -442,11 +765,11 @@ unsigned int CRTPacket::GetComponentSize(EComponentType eComponent)
     {
         return 0;
     }
-    if (mpComponentData[eComponent - 1] == nullptr)
+    if (GetComponentData(eComponent) == nullptr)
     {
         return 0;
     }
-    return SetByteOrder((unsigned int*)(mpComponentData[eComponent - 1]));
+    return SetByteOrder((unsigned int*)(GetComponentData(eComponent)));
 }
 
 char* CRTPacket::GetErrorString()
@@ -537,16 +860,16 @@ unsigned short CRTPacket::GetDropRate()
 {
     for (int i = 0; i <= 1; i++)
     {
-        if (mpComponentData[i] != nullptr)
+        if (GetComponentData((EComponentType)(i + 1)) != nullptr)
         {
-            return SetByteOrder((unsigned short*)(mpComponentData[i] + 12));
+            return SetByteOrder((unsigned short*)(GetComponentData((EComponentType)(i + 1)) + 12));
         }
     }
     for (int i = 4; i <= 11; i++)
     {
-        if (mpComponentData[i] != nullptr)
+        if (GetComponentData((EComponentType)(i + 1)) != nullptr)
         {
-            return SetByteOrder((unsigned short*)(mpComponentData[i] + 12));
+            return SetByteOrder((unsigned short*)(GetComponentData((EComponentType)(i + 1)) + 12));
         }
     }
     return 0;
@@ -556,16 +879,16 @@ unsigned short CRTPacket::GetOutOfSyncRate()
 {
     for (int i = 0; i <= 1; i++)
     {
-        if (mpComponentData[i] != nullptr)
+        if (GetComponentData((EComponentType)(i + 1)) != nullptr)
         {
-            return SetByteOrder((unsigned short*)(mpComponentData[i] + 14));
+            return SetByteOrder((unsigned short*)(GetComponentData((EComponentType)(i + 1)) + 14));
         }
     }
     for (int i = 4; i <= 11; i++)
     {
-        if (mpComponentData[i] != nullptr)
+        if (GetComponentData((EComponentType)(i + 1)) != nullptr)
         {
-            return SetByteOrder((unsigned short*)(mpComponentData[i] + 14));
+            return SetByteOrder((unsigned short*)(GetComponentData((EComponentType)(i + 1)) + 14));
         }
     }
     return 0;
@@ -583,18 +906,22 @@ unsigned int CRTPacket::Get2DCameraCount()
 
 unsigned int CRTPacket::Get2DMarkerCount(unsigned int nCameraIndex)
 {
+    EnsureIndexed(Component2d);
+
     if (mn2DCameraCount <= nCameraIndex)
     {
         return 0;
     }
-    return SetByteOrder((unsigned int*)(mp2DData[nCameraIndex]));
+    return SetByteOrder((unsigned int*)(GetItem(Component2d, nCameraIndex)));
 }
 
 unsigned char CRTPacket::Get2DStatusFlags(unsigned int nCameraIndex)
 {
+    EnsureIndexed(Component2d);
+
     if (mn2DCameraCount > nCameraIndex && ((mnMajorVersion > 1) || (mnMinorVersion > 7)))
     {
-        return *((unsigned char*)(mp2DData[nCameraIndex] + 4));
+        return *((unsigned char*)(GetItem(Component2d, nCameraIndex) + 4));
     }
     return 0;
 }
@@ -602,6 +929,8 @@ unsigned char CRTPacket::Get2DStatusFlags(unsigned int nCameraIndex)
 bool CRTPacket::Get2DMarker(unsigned int nCameraIndex, unsigned int nMarkerIndex, unsigned int& nX, unsigned int& nY,
                             unsigned short &nXDiameter, unsigned short &nYDiameter)
 {
+    EnsureIndexed(Component2d);
+
     int nOffset;
 
     if (mn2DCameraCount <= nCameraIndex || Get2DMarkerCount(nCameraIndex) <= nMarkerIndex)
@@ -617,10 +946,10 @@ bool CRTPacket::Get2DMarker(unsigned int nCameraIndex, unsigned int nMarkerIndex
     {
         nOffset = 4;
     }
-    nX         = SetByteOrder((unsigned int*)(mp2DData[nCameraIndex]   + nOffset +      nMarkerIndex * 12));
-    nY         = SetByteOrder((unsigned int*)(mp2DData[nCameraIndex]   + nOffset + 4  + nMarkerIndex * 12));
-    nXDiameter = SetByteOrder((unsigned short*)(mp2DData[nCameraIndex] + nOffset + 8  + nMarkerIndex * 12));
-    nYDiameter = SetByteOrder((unsigned short*)(mp2DData[nCameraIndex] + nOffset + 10 + nMarkerIndex * 12));
+    nX         = SetByteOrder((unsigned int*)(GetItem(Component2d, nCameraIndex)   + nOffset +      nMarkerIndex * 12));
+    nY         = SetByteOrder((unsigned int*)(GetItem(Component2d, nCameraIndex)   + nOffset + 4  + nMarkerIndex * 12));
+    nXDiameter = SetByteOrder((unsigned short*)(GetItem(Component2d, nCameraIndex) + nOffset + 8  + nMarkerIndex * 12));
+    nYDiameter = SetByteOrder((unsigned short*)(GetItem(Component2d, nCameraIndex) + nOffset + 10 + nMarkerIndex * 12));
 
     return true;
 }
@@ -636,18 +965,22 @@ unsigned int CRTPacket::Get2DLinCameraCount()
 
 unsigned int CRTPacket::Get2DLinMarkerCount(unsigned int nCameraIndex)
 {
+    EnsureIndexed(Component2dLin);
+
     if (mn2DLinCameraCount <= nCameraIndex)
     {
         return 0;
     }
-    return SetByteOrder((unsigned int*)(mp2DLinData[nCameraIndex]));
+    return SetByteOrder((unsigned int*)(GetItem(Component2dLin, nCameraIndex)));
 }
 
 unsigned char CRTPacket::Get2DLinStatusFlags(unsigned int nCameraIndex)
 {
+    EnsureIndexed(Component2dLin);
+
     if (mn2DLinCameraCount > nCameraIndex && ((mnMajorVersion > 1) || (mnMinorVersion > 7)))
     {
-        return *((unsigned char*)(mp2DLinData[nCameraIndex] + 4));
+        return *((unsigned char*)(GetItem(Component2dLin, nCameraIndex) + 4));
     }
     return 0;
 }
@@ -655,6 +988,8 @@ unsigned char CRTPacket::Get2DLinStatusFlags(unsigned int nCameraIndex)
 bool CRTPacket::Get2DLinMarker(unsigned int nCameraIndex, unsigned int nMarkerIndex, unsigned int& nX, unsigned int& nY,
                                unsigned short &nXDiameter, unsigned short &nYDiameter)
 {
+    EnsureIndexed(Component2dLin);
+
     int nOffset;
 
     if (mn2DLinCameraCount <= nCameraIndex || Get2DLinMarkerCount(nCameraIndex) <= nMarkerIndex)
@@ -670,10 +1005,10 @@ bool CRTPacket::Get2DLinMarker(unsigned int nCameraIndex, unsigned int nMarkerIn
     {
         nOffset = 4;
     }
-    nX         = SetByteOrder((unsigned int*)(mp2DLinData[nCameraIndex]   + nOffset +      nMarkerIndex * 12));
-    nY         = SetByteOrder((unsigned int*)(mp2DLinData[nCameraIndex]   + nOffset + 4  + nMarkerIndex * 12));
-    nXDiameter = SetByteOrder((unsigned short*)(mp2DLinData[nCameraIndex] + nOffset + 8  + nMarkerIndex * 12));
-    nYDiameter = SetByteOrder((unsigned short*)(mp2DLinData[nCameraIndex] + nOffset + 10 + nMarkerIndex * 12));
+    nX         = SetByteOrder((unsigned int*)(GetItem(Component2dLin, nCameraIndex)   + nOffset +      nMarkerIndex * 12));
+    nY         = SetByteOrder((unsigned int*)(GetItem(Component2dLin, nCameraIndex)   + nOffset + 4  + nMarkerIndex * 12));
+    nXDiameter = SetByteOrder((unsigned short*)(GetItem(Component2dLin, nCameraIndex) + nOffset + 8  + nMarkerIndex * 12));
+    nYDiameter = SetByteOrder((unsigned short*)(GetItem(Component2dLin, nCameraIndex) + nOffset + 10 + nMarkerIndex * 12));
 
     return true;
 }
@@ -689,7 +1024,7 @@ unsigned int CRTPacket::Get3DMarkerCount()
         return 0;
     }
     
-    char* pData = mpComponentData[Component3d - 1];
+    char* pData = GetComponentData(Component3d);
 
     if (pData == nullptr)
     {
@@ -700,26 +1035,21 @@ unsigned int CRTPacket::Get3DMarkerCount()
 
 bool CRTPacket::Get3DMarker(unsigned int nMarkerIndex, float &fX, float &fY, float &fZ)
 {
-    char* pData = mpComponentData[Component3d - 1];
+    const char* pData = GetComponentData(Component3d);
 
-    if (Get3DMarkerCount() <= nMarkerIndex)
+    if (pData == nullptr)
     {
         return false;
     }
-
-    if (mnMajorVersion > 1 || mnMinorVersion > 7)
+    return VisitPacketDecoder(meDecoderType, [&](auto decoder)
     {
-        fX = SetByteOrder((float*)(pData + 16 + nMarkerIndex * 12));
-        fY = SetByteOrder((float*)(pData + 20 + nMarkerIndex * 12));
-        fZ = SetByteOrder((float*)(pData + 24 + nMarkerIndex * 12));
-    }
-    else
-    {
-        fX = (float)SetByteOrder((double*)(pData + 16 + nMarkerIndex * 24));
-        fY = (float)SetByteOrder((double*)(pData + 24 + nMarkerIndex * 24));
-        fZ = (float)SetByteOrder((double*)(pData + 32 + nMarkerIndex * 24));
-    }
-    return (isnan(fX) == 0);
+        if (decoder.GetCount(pData) <= nMarkerIndex)
+        {
+            return false;
+        }
+        decoder.Get3DMarker(pData, nMarkerIndex, fX, fY, fZ);
+        return (isnan(fX) == 0);
+    });
 }
 
 
@@ -728,7 +1058,7 @@ bool CRTPacket::Get3DMarker(unsigned int nMarkerIndex, float &fX, float &fY, flo
 //-----------------------------------------------------------
 unsigned int CRTPacket::Get3DResidualMarkerCount()
 {
-    char* pData = mpComponentData[Component3dRes - 1];
+    char* pData = GetComponentData(Component3dRes);
 
     if (pData == nullptr)
     {
@@ -739,28 +1069,21 @@ unsigned int CRTPacket::Get3DResidualMarkerCount()
 
 bool CRTPacket::Get3DResidualMarker(unsigned int nMarkerIndex, float &fX, float &fY, float &fZ, float &fResidual)
 {
-    char* pData = mpComponentData[Component3dRes - 1];
+    const char* pData = GetComponentData(Component3dRes);
 
-    if (Get3DResidualMarkerCount() <= nMarkerIndex)
+    if (pData == nullptr)
     {
         return false;
     }
-
-    if (mnMajorVersion > 1 || mnMinorVersion > 7)
-    {
-        fX        = SetByteOrder((float*)(pData + 16 + nMarkerIndex * 16));
-        fY        = SetByteOrder((float*)(pData + 20 + nMarkerIndex * 16));
-        fZ        = SetByteOrder((float*)(pData + 24 + nMarkerIndex * 16));
-        fResidual = SetByteOrder((float*)(pData + 28 + nMarkerIndex * 16));
-    }
-    else
+    return VisitPacketDecoder(meDecoderType, [&](auto decoder)
     {
-        fX        = (float)SetByteOrder((double*)(pData + 16 + nMarkerIndex * 32));
-        fY        = (float)SetByteOrder((double*)(pData + 24 + nMarkerIndex * 32));
-        fZ        = (float)SetByteOrder((double*)(pData + 32 + nMarkerIndex * 32));
-        fResidual =        SetByteOrder((float*) (pData + 40 + nMarkerIndex * 32));
-    }
-    return (isnan(fX) == 0);
+        if (decoder.GetCount(pData) <= nMarkerIndex)
+        {
+            return false;
+        }
+        decoder.Get3DResidualMarker(pData, nMarkerIndex, fX, fY, fZ, fResidual);
+        return (isnan(fX) == 0);
+    });
 }
 
 
@@ -769,7 +1092,7 @@ bool CRTPacket::Get3DResidualMarker(unsigned int nMarkerIndex, float &fX, float
 //-----------------------------------------------------------
 unsigned int CRTPacket::Get3DNoLabelsMarkerCount()
 {
-    char* pData = mpComponentData[Component3dNoLabels - 1];
+    char* pData = GetComponentData(Component3dNoLabels);
 
     if (pData == nullptr)
     {
@@ -780,28 +1103,21 @@ unsigned int CRTPacket::Get3DNoLabelsMarkerCount()
 
 bool CRTPacket::Get3DNoLabelsMarker(unsigned int nMarkerIndex, float &fX, float &fY, float &fZ, unsigned int& nId)
 {
-    char* pData = mpComponentData[Component3dNoLabels - 1];
+    const char* pData = GetComponentData(Component3dNoLabels);
 
-    if (Get3DNoLabelsMarkerCount() <= nMarkerIndex)
+    if (pData == nullptr)
     {
         return false;
     }
-
-    if (mnMajorVersion > 1 || mnMinorVersion > 7)
-    {
-        fX  = SetByteOrder((float*)(pData + 16 + nMarkerIndex * 16));
-        fY  = SetByteOrder((float*)(pData + 20 + nMarkerIndex * 16));
-        fZ  = SetByteOrder((float*)(pData + 24 + nMarkerIndex * 16));
-        nId = SetByteOrder((unsigned int*)(pData + 28 + nMarkerIndex * 16));
-    }
-    else
+    return VisitPacketDecoder(meDecoderType, [&](auto decoder)
     {
-        fX  = (float)SetByteOrder((double*)(pData + 16 + nMarkerIndex * 32));
-        fY  = (float)SetByteOrder((double*)(pData + 24 + nMarkerIndex * 32));
-        fZ  = (float)SetByteOrder((double*)(pData + 32 + nMarkerIndex * 32));
-        nId =  SetByteOrder((unsigned int*)(pData + 40 + nMarkerIndex * 32));
-    }
-    return true;
+        if (decoder.GetCount(pData) <= nMarkerIndex)
+        {
+            return false;
+        }
+        decoder.Get3DNoLabelsMarker(pData, nMarkerIndex, fX, fY, fZ, nId);
+        return true;
+    });
 }
 
 
@@ -810,7 +1126,7 @@ bool CRTPacket::Get3DNoLabelsMarker(unsigned int nMarkerIndex, float &fX, float
 //-----------------------------------------------------------
 unsigned int CRTPacket::Get3DNoLabelsResidualMarkerCount()
 {
-    char* pData = mpComponentData[Component3dNoLabelsRes - 1];
+    char* pData = GetComponentData(Component3dNoLabelsRes);
 
     if (pData == nullptr)
     {
@@ -822,30 +1138,244 @@ unsigned int CRTPacket::Get3DNoLabelsResidualMarkerCount()
 bool CRTPacket::Get3DNoLabelsResidualMarker(unsigned int nMarkerIndex, float &fX, float &fY, float &fZ,
                                             unsigned int& nId, float &fResidual)
 {
-    char* pData = mpComponentData[Component3dNoLabelsRes - 1];
+    const char* pData = GetComponentData(Component3dNoLabelsRes);
 
-    if (Get3DNoLabelsResidualMarkerCount() <= nMarkerIndex)
+    if (pData == nullptr)
     {
         return false;
     }
+    return VisitPacketDecoder(meDecoderType, [&](auto decoder)
+    {
+        if (decoder.GetCount(pData) <= nMarkerIndex)
+        {
+            return false;
+        }
+        decoder.Get3DNoLabelsResidualMarker(pData, nMarkerIndex, fX, fY, fZ, nId, fResidual);
+        return true;
+    });
+}
 
-    if (mnMajorVersion > 1 || mnMinorVersion > 7)
+
+//-----------------------------------------------------------
+//                        3D Bulk
+//-----------------------------------------------------------
+unsigned int CRTPacket::Get3DMarkers(SPosition* pMarkerBuf, unsigned int nBufSize, unsigned int* pValidMask)
+{
+    const char* pData = GetComponentData(Component3d);
+
+    if (pData == nullptr || pMarkerBuf == nullptr)
     {
-        fX        = SetByteOrder((float*)(pData + 16 + nMarkerIndex * 20));
-        fY        = SetByteOrder((float*)(pData + 20 + nMarkerIndex * 20));
-        fZ        = SetByteOrder((float*)(pData + 24 + nMarkerIndex * 20));
-        nId       = SetByteOrder((unsigned int*)(pData + 28 + nMarkerIndex * 20));
-        fResidual = SetByteOrder((float*)(pData + 32 + nMarkerIndex * 20));
+        return 0;
     }
-    else
+    return VisitPacketDecoder(meDecoderType, [&](auto decoder)
+    {
+        using TDecoder = decltype(decoder);
+        const unsigned int nCount = decoder.GetCount(pData);
+        if (nBufSize < nCount)
+        {
+            return 0u;
+        }
+        ReadItems<TDecoder>(pData, TDecoder::c3dMarkerSize, pMarkerBuf, nCount, [&](unsigned int i, SPosition& sMarker)
+        {
+            decoder.Get3DMarker(pData, i, sMarker.x, sMarker.y, sMarker.z);
+        });
+        SetValidMask(&pMarkerBuf->x, 3, nCount, pValidMask);
+        return nCount;
+    });
+}
+
+unsigned int CRTPacket::Get3DMarkers(const S3DMarkerArrays& sArrays, unsigned int nBufSize, unsigned int* pValidMask)
+{
+    const char* pData = GetComponentData(Component3d);
+
+    if (pData == nullptr || sArrays.x == nullptr || sArrays.y == nullptr || sArrays.z == nullptr)
     {
-        fX        = (float)SetByteOrder((double*)(pData + 16 + nMarkerIndex * 32));
-        fY        = (float)SetByteOrder((double*)(pData + 24 + nMarkerIndex * 32));
-        fZ        = (float)SetByteOrder((double*)(pData + 32 + nMarkerIndex * 32));
-        nId       =  SetByteOrder((unsigned int*)(pData + 40 + nMarkerIndex * 32));
-        fResidual =        SetByteOrder((float*) (pData + 44 + nMarkerIndex * 32));
+        return 0;
     }
-    return true;
+    return VisitPacketDecoder(meDecoderType, [&](auto decoder)
+    {
+        const unsigned int nCount = decoder.GetCount(pData);
+        if (nBufSize < nCount)
+        {
+            return 0u;
+        }
+        for (unsigned int i = 0; i < nCount; i++)
+        {
+            decoder.Get3DMarker(pData, i, sArrays.x[i], sArrays.y[i], sArrays.z[i]);
+        }
+        SetValidMask(sArrays.x, 1, nCount, pValidMask);
+        return nCount;
+    });
+}
+
+unsigned int CRTPacket::Get3DResidualMarkers(S3DResidualMarker* pMarkerBuf, unsigned int nBufSize, unsigned int* pValidMask)
+{
+    const char* pData = GetComponentData(Component3dRes);
+
+    if (pData == nullptr || pMarkerBuf == nullptr)
+    {
+        return 0;
+    }
+    return VisitPacketDecoder(meDecoderType, [&](auto decoder)
+    {
+        using TDecoder = decltype(decoder);
+        const unsigned int nCount = decoder.GetCount(pData);
+        if (nBufSize < nCount)
+        {
+            return 0u;
+        }
+        ReadItems<TDecoder>(pData, TDecoder::c3dResidualMarkerSize, pMarkerBuf, nCount, [&](unsigned int i, S3DResidualMarker& sMarker)
+        {
+            decoder.Get3DResidualMarker(pData, i, sMarker.x, sMarker.y, sMarker.z, sMarker.residual);
+        });
+        SetValidMask(&pMarkerBuf->x, 4, nCount, pValidMask);
+        return nCount;
+    });
+}
+
+unsigned int CRTPacket::Get3DResidualMarkers(const S3DMarkerArrays& sArrays, unsigned int nBufSize, unsigned int* pValidMask)
+{
+    const char* pData = GetComponentData(Component3dRes);
+
+    if (pData == nullptr || sArrays.x == nullptr || sArrays.y == nullptr || sArrays.z == nullptr)
+    {
+        return 0;
+    }
+    return VisitPacketDecoder(meDecoderType, [&](auto decoder)
+    {
+        const unsigned int nCount = decoder.GetCount(pData);
+        if (nBufSize < nCount)
+        {
+            return 0u;
+        }
+        float fResidual;
+        for (unsigned int i = 0; i < nCount; i++)
+        {
+            decoder.Get3DResidualMarker(pData, i, sArrays.x[i], sArrays.y[i], sArrays.z[i], fResidual);
+            if (sArrays.residual != nullptr)
+            {
+                sArrays.residual[i] = fResidual;
+            }
+        }
+        SetValidMask(sArrays.x, 1, nCount, pValidMask);
+        return nCount;
+    });
+}
+
+unsigned int CRTPacket::Get3DNoLabelsMarkers(S3DNoLabelsMarker* pMarkerBuf, unsigned int nBufSize, unsigned int* pValidMask)
+{
+    const char* pData = GetComponentData(Component3dNoLabels);
+
+    if (pData == nullptr || pMarkerBuf == nullptr)
+    {
+        return 0;
+    }
+    return VisitPacketDecoder(meDecoderType, [&](auto decoder)
+    {
+        using TDecoder = decltype(decoder);
+        const unsigned int nCount = decoder.GetCount(pData);
+        if (nBufSize < nCount)
+        {
+            return 0u;
+        }
+        ReadItems<TDecoder>(pData, TDecoder::c3dNoLabelsMarkerSize, pMarkerBuf, nCount, [&](unsigned int i, S3DNoLabelsMarker& sMarker)
+        {
+            decoder.Get3DNoLabelsMarker(pData, i, sMarker.x, sMarker.y, sMarker.z, sMarker.id);
+        });
+        SetValidMask(&pMarkerBuf->x, 4, nCount, pValidMask);
+        return nCount;
+    });
+}
+
+unsigned int CRTPacket::Get3DNoLabelsMarkers(const S3DMarkerArrays& sArrays, unsigned int nBufSize, unsigned int* pValidMask)
+{
+    const char* pData = GetComponentData(Component3dNoLabels);
+
+    if (pData == nullptr || sArrays.x == nullptr || sArrays.y == nullptr || sArrays.z == nullptr)
+    {
+        return 0;
+    }
+    return VisitPacketDecoder(meDecoderType, [&](auto decoder)
+    {
+        const unsigned int nCount = decoder.GetCount(pData);
+        if (nBufSize < nCount)
+        {
+            return 0u;
+        }
+        unsigned int nId;
+        for (unsigned int i = 0; i < nCount; i++)
+        {
+            decoder.Get3DNoLabelsMarker(pData, i, sArrays.x[i], sArrays.y[i], sArrays.z[i], nId);
+            if (sArrays.id != nullptr)
+            {
+                sArrays.id[i] = nId;
+            }
+        }
+        SetValidMask(sArrays.x, 1, nCount, pValidMask);
+        return nCount;
+    });
+}
+
+unsigned int CRTPacket::Get3DNoLabelsResidualMarkers(S3DNoLabelsResidualMarker* pMarkerBuf, unsigned int nBufSize,
+                                                     unsigned int* pValidMask)
+{
+    const char* pData = GetComponentData(Component3dNoLabelsRes);
+
+    if (pData == nullptr || pMarkerBuf == nullptr)
+    {
+        return 0;
+    }
+    return VisitPacketDecoder(meDecoderType, [&](auto decoder)
+    {
+        using TDecoder = decltype(decoder);
+        const unsigned int nCount = decoder.GetCount(pData);
+        if (nBufSize < nCount)
+        {
+            return 0u;
+        }
+        ReadItems<TDecoder>(pData, TDecoder::c3dNoLabelsResidualMarkerSize, pMarkerBuf, nCount,
+            [&](unsigned int i, S3DNoLabelsResidualMarker& sMarker)
+            {
+                decoder.Get3DNoLabelsResidualMarker(pData, i, sMarker.x, sMarker.y, sMarker.z, sMarker.id, sMarker.residual);
+            });
+        SetValidMask(&pMarkerBuf->x, 5, nCount, pValidMask);
+        return nCount;
+    });
+}
+
+unsigned int CRTPacket::Get3DNoLabelsResidualMarkers(const S3DMarkerArrays& sArrays, unsigned int nBufSize,
+                                                     unsigned int* pValidMask)
+{
+    const char* pData = GetComponentData(Component3dNoLabelsRes);
+
+    if (pData == nullptr || sArrays.x == nullptr || sArrays.y == nullptr || sArrays.z == nullptr)
+    {
+        return 0;
+    }
+    return VisitPacketDecoder(meDecoderType, [&](auto decoder)
+    {
+        const unsigned int nCount = decoder.GetCount(pData);
+        if (nBufSize < nCount)
+        {
+            return 0u;
+        }
+        unsigned int nId;
+        float        fResidual;
+        for (unsigned int i = 0; i < nCount; i++)
+        {
+            decoder.Get3DNoLabelsResidualMarker(pData, i, sArrays.x[i], sArrays.y[i], sArrays.z[i], nId, fResidual);
+            if (sArrays.id != nullptr)
+            {
+                sArrays.id[i] = nId;
+            }
+            if (sArrays.residual != nullptr)
+            {
+                sArrays.residual[i] = fResidual;
+            }
+        }
+        SetValidMask(sArrays.x, 1, nCount, pValidMask);
+        return nCount;
+    });
 }
 
 
@@ -854,7 +1384,7 @@ bool CRTPacket::Get3DNoLabelsResidualMarker(unsigned int nMarkerIndex, float &fX
 //-----------------------------------------------------------
 unsigned int CRTPacket::Get6DOFBodyCount()
 {
-    char* pData = mpComponentData[Component6d - 1];
+    char* pData = GetComponentData(Component6d);
 
     if (pData == nullptr)
     {
@@ -865,34 +1395,21 @@ unsigned int CRTPacket::Get6DOFBodyCount()
 
 bool CRTPacket::Get6DOFBody(unsigned int nBodyIndex, float &fX, float &fY, float &fZ, float afRotMatrix[9])
 {
-    char* pData = mpComponentData[Component6d - 1];
+    const char* pData = GetComponentData(Component6d);
 
-    if (Get6DOFBodyCount() <= nBodyIndex)
+    if (pData == nullptr)
     {
         return false;
     }
-
-    if (mnMajorVersion > 1 || mnMinorVersion > 7)
-    {
-        fX = SetByteOrder((float*)(pData + 16 + nBodyIndex * 48));
-        fY = SetByteOrder((float*)(pData + 20 + nBodyIndex * 48));
-        fZ = SetByteOrder((float*)(pData + 24 + nBodyIndex * 48));
-        for (int i = 0; i < 9; i++)
-        {
-            afRotMatrix[i] = SetByteOrder((float*)(pData + 28 + (i * 4) + nBodyIndex * 48));
-        }
-    }
-    else
+    return VisitPacketDecoder(meDecoderType, [&](auto decoder)
     {
-        fX = (float)SetByteOrder((double*)(pData + 16 + nBodyIndex * 96));
-        fY = (float)SetByteOrder((double*)(pData + 24 + nBodyIndex * 96));
-        fZ = (float)SetByteOrder((double*)(pData + 32 + nBodyIndex * 96));
-        for (int i = 0; i < 9; i++)
+        if (decoder.GetCount(pData) <= nBodyIndex)
         {
-            afRotMatrix[i] = (float)SetByteOrder((double*)(pData + 40 + (i * 8) + nBodyIndex * 96));
+            return false;
         }
-    }
-    return true;
+        decoder.Get6DOFBody(pData, nBodyIndex, fX, fY, fZ, afRotMatrix);
+        return true;
+    });
 }
 
 
@@ -901,7 +1418,7 @@ bool CRTPacket::Get6DOFBody(unsigned int nBodyIndex, float &fX, float &fY, float
 //-----------------------------------------------------------
 unsigned int CRTPacket::Get6DOFResidualBodyCount()
 {
-    char* pData = mpComponentData[Component6dRes - 1];
+    char* pData = GetComponentData(Component6dRes);
 
     if (pData == nullptr)
     {
@@ -913,36 +1430,134 @@ unsigned int CRTPacket::Get6DOFResidualBodyCount()
 bool CRTPacket::Get6DOFResidualBody(unsigned int nBodyIndex, float &fX, float &fY, float &fZ,
                                     float afRotMatrix[9], float &fResidual)
 {
-    char* pData = mpComponentData[Component6dRes - 1];
+    const char* pData = GetComponentData(Component6dRes);
 
-    if (Get6DOFResidualBodyCount() <= nBodyIndex)
+    if (pData == nullptr)
     {
         return false;
     }
+    return VisitPacketDecoder(meDecoderType, [&](auto decoder)
+    {
+        if (decoder.GetCount(pData) <= nBodyIndex)
+        {
+            return false;
+        }
+        decoder.Get6DOFResidualBody(pData, nBodyIndex, fX, fY, fZ, afRotMatrix, fResidual);
+        return true;
+    });
+}
 
-    if (mnMajorVersion > 1 || mnMinorVersion > 7)
+
+//-----------------------------------------------------------
+//                        6DOF Bulk
+//-----------------------------------------------------------
+unsigned int CRTPacket::Get6DOFBodies(S6DOFBody* pBodyBuf, unsigned int nBufSize)
+{
+    const char* pData = GetComponentData(Component6d);
+
+    if (pData == nullptr || pBodyBuf == nullptr)
+    {
+        return 0;
+    }
+    return VisitPacketDecoder(meDecoderType, [&](auto decoder)
+    {
+        using TDecoder = decltype(decoder);
+        const unsigned int nCount = decoder.GetCount(pData);
+        if (nBufSize < nCount)
+        {
+            return 0u;
+        }
+        ReadItems<TDecoder>(pData, TDecoder::c6dBodySize, pBodyBuf, nCount, [&](unsigned int i, S6DOFBody& sBody)
+        {
+            decoder.Get6DOFBody(pData, i, sBody.x, sBody.y, sBody.z, sBody.rotation);
+        });
+        return nCount;
+    });
+}
+
+unsigned int CRTPacket::Get6DOFBodies(SPose* pPoseBuf, unsigned int nBufSize)
+{
+    const char* pData = GetComponentData(Component6d);
+
+    if (pData == nullptr || pPoseBuf == nullptr)
+    {
+        return 0;
+    }
+    return VisitPacketDecoder(meDecoderType, [&](auto decoder)
     {
-        fX = SetByteOrder((float*)(pData + 16 + nBodyIndex * 52));
-        fY = SetByteOrder((float*)(pData + 20 + nBodyIndex * 52));
-        fZ = SetByteOrder((float*)(pData + 24 + nBodyIndex * 52));
-        for (int i = 0; i < 9; i++)
+        const unsigned int nCount = decoder.GetCount(pData);
+        if (nBufSize < nCount)
         {
-            afRotMatrix[i] = SetByteOrder((float*)(pData + 28 + (i * 4) + nBodyIndex * 52));
+            return 0u;
         }
-        fResidual = SetByteOrder((float*)(pData + 64 + nBodyIndex * 52));
+        ReadPoses(nCount, pPoseBuf, [&](unsigned int i, float afBody[12])
+        {
+            decoder.Get6DOFBody(pData, i, afBody[0], afBody[1], afBody[2], afBody + 3);
+        });
+        return nCount;
+    });
+}
+
+unsigned int CRTPacket::Get6DOFResidualBodies(S6DOFResidualBody* pBodyBuf, unsigned int nBufSize)
+{
+    const char* pData = GetComponentData(Component6dRes);
+
+    if (pData == nullptr || pBodyBuf == nullptr)
+    {
+        return 0;
     }
-    else
+    return VisitPacketDecoder(meDecoderType, [&](auto decoder)
     {
-        fX = (float)SetByteOrder((double*)(pData + 16 + nBodyIndex * 104));
-        fY = (float)SetByteOrder((double*)(pData + 24 + nBodyIndex * 104));
-        fZ = (float)SetByteOrder((double*)(pData + 32 + nBodyIndex * 104));
-        for (int i = 0; i < 9; i++)
+        using TDecoder = decltype(decoder);
+        const unsigned int nCount = decoder.GetCount(pData);
+        if (nBufSize < nCount)
         {
-            afRotMatrix[i] = (float)SetByteOrder((double*)(pData + 40 + (i * 8) + nBodyIndex * 104));
+            return 0u;
         }
-        fResidual = SetByteOrder((float*)(pData + 112 + nBodyIndex * 104));
+        ReadItems<TDecoder>(pData, TDecoder::c6dResidualBodySize, pBodyBuf, nCount, [&](unsigned int i, S6DOFResidualBody& sBody)
+        {
+            decoder.Get6DOFResidualBody(pData, i, sBody.x, sBody.y, sBody.z, sBody.rotation, sBody.residual);
+        });
+        return nCount;
+    });
+}
+
+unsigned int CRTPacket::Get6DOFResidualBodies(SPose* pPoseBuf, unsigned int nBufSize, float* pResidualBuf)
+{
+    const char* pData = GetComponentData(Component6dRes);
+
+    if (pData == nullptr || pPoseBuf == nullptr)
+    {
+        return 0;
     }
-    return true;
+    return VisitPacketDecoder(meDecoderType, [&](auto decoder)
+    {
+        const unsigned int nCount = decoder.GetCount(pData);
+        if (nBufSize < nCount)
+        {
+            return 0u;
+        }
+        ReadPoses(nCount, pPoseBuf, [&](unsigned int i, float afBody[12])
+        {
+            float fResidual;
+            decoder.Get6DOFResidualBody(pData, i, afBody[0], afBody[1], afBody[2], afBody + 3, fResidual);
+            if (pResidualBuf != nullptr)
+            {
+                pResidualBuf[i] = fResidual;
+            }
+        });
+        return nCount;
+    });
+}
+
+void CRTPacket::RotationMatrixToQuaternion(const float afRotMatrix[9], SRotation& sRotation)
+{
+    float afQuaternion[4];
+    MatrixToQuaternion<ScalarOps>(afRotMatrix, afQuaternion);
+    sRotation.x = afQuaternion[0];
+    sRotation.y = afQuaternion[1];
+    sRotation.z = afQuaternion[2];
+    sRotation.w = afQuaternion[3];
 }
 
 
@@ -951,7 +1566,7 @@ bool CRTPacket::Get6DOFResidualBody(unsigned int nBodyIndex, float &fX, float &f
 //-----------------------------------------------------------
 unsigned int CRTPacket::Get6DOFEulerBodyCount()
 {
-    char* pData = mpComponentData[Component6dEuler - 1];
+    char* pData = GetComponentData(Component6dEuler);
 
     if (pData == nullptr)
     {
@@ -963,32 +1578,21 @@ unsigned int CRTPacket::Get6DOFEulerBodyCount()
 bool CRTPacket::Get6DOFEulerBody(unsigned int nBodyIndex, float &fX, float &fY, float &fZ,
                                  float &fAng1, float &fAng2, float &fAng3)
 {
-    char* pData = mpComponentData[Component6dEuler - 1];
+    const char* pData = GetComponentData(Component6dEuler);
 
-    if (Get6DOFEulerBodyCount() <= nBodyIndex)
+    if (pData == nullptr)
     {
         return false;
     }
-
-    if (mnMajorVersion > 1 || mnMinorVersion > 7)
-    {
-        fX    = SetByteOrder((float*)(pData + 16 + nBodyIndex * 24));
-        fY    = SetByteOrder((float*)(pData + 20 + nBodyIndex * 24));
-        fZ    = SetByteOrder((float*)(pData + 24 + nBodyIndex * 24));
-        fAng1 = SetByteOrder((float*)(pData + 28 + nBodyIndex * 24));
-        fAng2 = SetByteOrder((float*)(pData + 32 + nBodyIndex * 24));
-        fAng3 = SetByteOrder((float*)(pData + 36 + nBodyIndex * 24));
-    }
-    else
+    return VisitPacketDecoder(meDecoderType, [&](auto decoder)
     {
-        fX    = (float)SetByteOrder((double*)(pData + 16 + nBodyIndex * 48));
-        fY    = (float)SetByteOrder((double*)(pData + 24 + nBodyIndex * 48));
-        fZ    = (float)SetByteOrder((double*)(pData + 32 + nBodyIndex * 48));
-        fAng1 = (float)SetByteOrder((double*)(pData + 40 + nBodyIndex * 48));
-        fAng2 = (float)SetByteOrder((double*)(pData + 48 + nBodyIndex * 48));
-        fAng3 = (float)SetByteOrder((double*)(pData + 56 + nBodyIndex * 48));
-    }
-    return true;
+        if (decoder.GetCount(pData) <= nBodyIndex)
+        {
+            return false;
+        }
+        decoder.Get6DOFEulerBody(pData, nBodyIndex, fX, fY, fZ, fAng1, fAng2, fAng3);
+        return true;
+    });
 }
 
 
@@ -997,7 +1601,7 @@ bool CRTPacket::Get6DOFEulerBody(unsigned int nBodyIndex, float &fX, float &fY,
 //-----------------------------------------------------------
 unsigned int CRTPacket::Get6DOFEulerResidualBodyCount()
 {
-    char* pData = mpComponentData[Component6dEulerRes - 1];
+    char* pData = GetComponentData(Component6dEulerRes);
 
     if (pData == nullptr)
     {
@@ -1009,34 +1613,21 @@ unsigned int CRTPacket::Get6DOFEulerResidualBodyCount()
 bool CRTPacket::Get6DOFEulerResidualBody(unsigned int nBodyIndex, float &fX, float &fY, float &fZ,
                                          float &fAng1, float &fAng2, float &fAng3, float &fResidual)
 {
-    char* pData = mpComponentData[Component6dEulerRes - 1];
+    const char* pData = GetComponentData(Component6dEulerRes);
 
-    if (Get6DOFEulerResidualBodyCount() <= nBodyIndex)
+    if (pData == nullptr)
     {
         return false;
     }
-
-    if (mnMajorVersion > 1 || mnMinorVersion > 7)
-    {
-        fX        = SetByteOrder((float*)(pData + 16 + nBodyIndex * 28));
-        fY        = SetByteOrder((float*)(pData + 20 + nBodyIndex * 28));
-        fZ        = SetByteOrder((float*)(pData + 24 + nBodyIndex * 28));
-        fAng1     = SetByteOrder((float*)(pData + 28 + nBodyIndex * 28));
-        fAng2     = SetByteOrder((float*)(pData + 32 + nBodyIndex * 28));
-        fAng3     = SetByteOrder((float*)(pData + 36 + nBodyIndex * 28));
-        fResidual = SetByteOrder((float*)(pData + 40 + nBodyIndex * 28));
-    }
-    else
+    return VisitPacketDecoder(meDecoderType, [&](auto decoder)
     {
-        fX        = (float)SetByteOrder((double*)(pData + 16 + nBodyIndex * 56));
-        fY        = (float)SetByteOrder((double*)(pData + 24 + nBodyIndex * 56));
-        fZ        = (float)SetByteOrder((double*)(pData + 32 + nBodyIndex * 56));
-        fAng1     = (float)SetByteOrder((double*)(pData + 40 + nBodyIndex * 56));
-        fAng2     = (float)SetByteOrder((double*)(pData + 48 + nBodyIndex * 56));
-        fAng3     = (float)SetByteOrder((double*)(pData + 56 + nBodyIndex * 56));
-        fResidual =        SetByteOrder( (float*)(pData + 64 + nBodyIndex * 56));
-    }
-    return true;
+        if (decoder.GetCount(pData) <= nBodyIndex)
+        {
+            return false;
+        }
+        decoder.Get6DOFEulerResidualBody(pData, nBodyIndex, fX, fY, fZ, fAng1, fAng2, fAng3, fResidual);
+        return true;
+    });
 }
 
 
@@ -1050,26 +1641,32 @@ unsigned int CRTPacket::GetGazeVectorCount()
 
 unsigned int CRTPacket::GetGazeVectorSampleCount(unsigned int nVectorIndex)
 {
+    EnsureIndexed(ComponentGazeVector);
+
     if (mnGazeVectorCount <= nVectorIndex)
     {
         return 0;
     }
-    return SetByteOrder((unsigned int*)(mpGazeVectorData[nVectorIndex]));
+    return SetByteOrder((unsigned int*)(GetItem(ComponentGazeVector, nVectorIndex)));
 }
 
 unsigned int CRTPacket::GetGazeVectorSampleNumber(unsigned int nVectorIndex)
 {
+    EnsureIndexed(ComponentGazeVector);
+
     unsigned int nSampleCount = GetGazeVectorSampleCount(nVectorIndex);
 
     if (nSampleCount == 0)
     {
         return 0;
     }
-    return SetByteOrder((unsigned int*)(mpGazeVectorData[nVectorIndex] + 4));
+    return SetByteOrder((unsigned int*)(GetItem(ComponentGazeVector, nVectorIndex) + 4));
 }
 
 bool CRTPacket::GetGazeVector(unsigned int nVectorIndex, unsigned int nSampleIndex, SGazeVector &sGazeVector)
 {
+    EnsureIndexed(ComponentGazeVector);
+
     unsigned int nSampleCount = GetGazeVectorSampleCount(nVectorIndex);
 
     if (nSampleCount == 0 || nSampleIndex >= nSampleCount)
@@ -1080,7 +1677,7 @@ bool CRTPacket::GetGazeVector(unsigned int nVectorIndex, unsigned int nSampleInd
     for (unsigned int k = 0; k < 6; k++)
     {
         *(((float*)&sGazeVector) + k) =
-            (float)SetByteOrder((float*)(mpGazeVectorData[nVectorIndex] + 8 + k * sizeof(float) + nSampleIndex * 24));
+            (float)SetByteOrder((float*)(GetItem(ComponentGazeVector, nVectorIndex) + 8 + k * sizeof(float) + nSampleIndex * 24));
     }
 
     return (isnan(sGazeVector.fPosX) == 0);
@@ -1088,6 +1685,8 @@ bool CRTPacket::GetGazeVector(unsigned int nVectorIndex, unsigned int nSampleInd
 
 bool CRTPacket::GetGazeVector(unsigned int nVectorIndex, SGazeVector* pGazeVectorBuf, unsigned int nBufSize)
 {
+    EnsureIndexed(ComponentGazeVector);
+
     unsigned int nSampleCount = GetGazeVectorSampleCount(nVectorIndex);
 
     if (nSampleCount == 0 || (nBufSize < nSampleCount * sizeof(SGazeVector)))
@@ -1100,7 +1699,7 @@ bool CRTPacket::GetGazeVector(unsigned int nVectorIndex, SGazeVector* pGazeVecto
         for (unsigned int k = 0; k < 6; k++)
         {
             *(((float*)pGazeVectorBuf) + k + (nSample * sizeof(SGazeVector))) =
-                (float)SetByteOrder((float*)(mpGazeVectorData[nVectorIndex] + 8 + k * sizeof(float) + nSample * 24));
+                (float)SetByteOrder((float*)(GetItem(ComponentGazeVector, nVectorIndex) + 8 + k * sizeof(float) + nSample * 24));
         }
     }
 
@@ -1118,26 +1717,32 @@ unsigned int CRTPacket::GetEyeTrackerCount()
 
 unsigned int CRTPacket::GetEyeTrackerSampleCount(unsigned int nVectorIndex)
 {
+    EnsureIndexed(ComponentEyeTracker);
+
     if (mnEyeTrackerCount <= nVectorIndex)
     {
         return 0;
     }
-    return SetByteOrder((unsigned int*)(mpEyeTrackerData[nVectorIndex]));
+    return SetByteOrder((unsigned int*)(GetItem(ComponentEyeTracker, nVectorIndex)));
 }
 
 unsigned int CRTPacket::GetEyeTrackerSampleNumber(unsigned int nVectorIndex)
 {
+    EnsureIndexed(ComponentEyeTracker);
+
     unsigned int nSampleCount = GetEyeTrackerSampleCount(nVectorIndex);
 
     if (nSampleCount == 0)
     {
         return 0;
     }
-    return SetByteOrder((unsigned int*)(mpEyeTrackerData[nVectorIndex] + 4));
+    return SetByteOrder((unsigned int*)(GetItem(ComponentEyeTracker, nVectorIndex) + 4));
 }
 
 bool CRTPacket::GetEyeTrackerData(unsigned int eyeTrackerIndex, unsigned int nSampleIndex, SEyeTracker &sEyeTracker)
 {
+    EnsureIndexed(ComponentEyeTracker);
+
     unsigned int nSampleCount = GetEyeTrackerSampleCount(eyeTrackerIndex);
 
     if (nSampleCount == 0 || nSampleIndex >= nSampleCount)
@@ -1148,7 +1753,7 @@ bool CRTPacket::GetEyeTrackerData(unsigned int eyeTrackerIndex, unsigned int nSa
     for (unsigned int k = 0; k < (sizeof(SEyeTracker) / sizeof(float)); k++)
     {
         *(((float*)&sEyeTracker) + k) =
-            (float)SetByteOrder((float*)(mpEyeTrackerData[eyeTrackerIndex] + 8 + k * sizeof(float) + nSampleIndex * sizeof(SEyeTracker)));
+            (float)SetByteOrder((float*)(GetItem(ComponentEyeTracker, eyeTrackerIndex) + 8 + k * sizeof(float) + nSampleIndex * sizeof(SEyeTracker)));
     }
 
     return true;
@@ -1156,6 +1761,8 @@ bool CRTPacket::GetEyeTrackerData(unsigned int eyeTrackerIndex, unsigned int nSa
 
 bool CRTPacket::GetEyeTrackerData(unsigned int eyeTrackerIndex, SEyeTracker* pEyeTrackerBuf, unsigned int nBufSize)
 {
+    EnsureIndexed(ComponentEyeTracker);
+
     unsigned int nSampleCount = GetEyeTrackerSampleCount(eyeTrackerIndex);
 
     if (nSampleCount == 0 || (nBufSize < nSampleCount * sizeof(SEyeTracker)))
@@ -1168,7 +1775,7 @@ bool CRTPacket::GetEyeTrackerData(unsigned int eyeTrackerIndex, SEyeTracker* pEy
         for (unsigned int k = 0; k < (sizeof(SEyeTracker) / sizeof(float)); k++)
         {
             *(((float*)pEyeTrackerBuf) + k + (nSample * sizeof(SEyeTracker))) =
-                (float)SetByteOrder((float*)(mpEyeTrackerData[eyeTrackerIndex] + 8 + k * sizeof(float) + nSample * sizeof(SEyeTracker)));
+                (float)SetByteOrder((float*)(GetItem(ComponentEyeTracker, eyeTrackerIndex) + 8 + k * sizeof(float) + nSample * sizeof(SEyeTracker)));
         }
     }
 
@@ -1186,16 +1793,20 @@ bool CRTPacket::IsTimeCodeAvailable() const
 
 bool CRTPacket::GetTimecodeType(CRTPacket::ETimecodeType &timecodeType)
 {
+    EnsureIndexed(ComponentTimecode);
+
     if (mnTimecodeCount <= 0)
     {
         return false;
     }
-    timecodeType = (CRTPacket::ETimecodeType)SetByteOrder((unsigned int*)(mpTimecodeData[0]));
+    timecodeType = (CRTPacket::ETimecodeType)SetByteOrder((unsigned int*)(GetItem(ComponentTimecode, 0)));
     return true;
 }
 
 bool CRTPacket::GetTimecodeSMPTE(int& hours, int& minutes, int& seconds, int& frames)
 {
+    EnsureIndexed(ComponentTimecode);
+
     if (mnTimecodeCount <= 0)
     {
         return false;
@@ -1205,10 +1816,10 @@ bool CRTPacket::GetTimecodeSMPTE(int& hours, int& minutes, int& seconds, int& fr
     {
         if (timecodeType == TimecodeSMPTE)
         {
-            hours   = 0x1f & SetByteOrder((unsigned int*)(mpTimecodeData[0] + 8));
-            minutes = 0x3f & (SetByteOrder((unsigned int*)(mpTimecodeData[0] + 8)) >> 5);
-            seconds = 0x3f & (SetByteOrder((unsigned int*)(mpTimecodeData[0] + 8)) >> 11);
-            frames  = 0x1f & (SetByteOrder((unsigned int*)(mpTimecodeData[0] + 8)) >> 17);
+            hours   = 0x1f & SetByteOrder((unsigned int*)(GetItem(ComponentTimecode, 0) + 8));
+            minutes = 0x3f & (SetByteOrder((unsigned int*)(GetItem(ComponentTimecode, 0) + 8)) >> 5);
+            seconds = 0x3f & (SetByteOrder((unsigned int*)(GetItem(ComponentTimecode, 0) + 8)) >> 11);
+            frames  = 0x1f & (SetByteOrder((unsigned int*)(GetItem(ComponentTimecode, 0) + 8)) >> 17);
             return true;
         }
     }
@@ -1217,6 +1828,8 @@ bool CRTPacket::GetTimecodeSMPTE(int& hours, int& minutes, int& seconds, int& fr
 
 bool CRTPacket::GetTimecodeSMPTE(int& hours, int& minutes, int& seconds, int& frames, int& subFrames)
 {
+    EnsureIndexed(ComponentTimecode);
+
     if (mnMajorVersion <= 1 && mnMinorVersion < 27)
     {
         return false;
@@ -1224,7 +1837,7 @@ bool CRTPacket::GetTimecodeSMPTE(int& hours, int& minutes, int& seconds, int& fr
 
     if (GetTimecodeSMPTE(hours, minutes, seconds, frames))
     {
-        subFrames = 0x1FF & (SetByteOrder((unsigned int*)(mpTimecodeData[0] + 8)) >> 22);
+        subFrames = 0x1FF & (SetByteOrder((unsigned int*)(GetItem(ComponentTimecode, 0) + 8)) >> 22);
         return true;
     }
     return false;
@@ -1232,6 +1845,8 @@ bool CRTPacket::GetTimecodeSMPTE(int& hours, int& minutes, int& seconds, int& fr
 
 bool CRTPacket::GetTimecodeIRIG(int& years, int& days, int& hours, int& minutes, int& seconds, int& tenths)
 {
+    EnsureIndexed(ComponentTimecode);
+
     if (mnTimecodeCount <= 0)
     {
         return false;
@@ -1241,12 +1856,12 @@ bool CRTPacket::GetTimecodeIRIG(int& years, int& days, int& hours, int& minutes,
     {
         if (timecodeType == TimecodeIRIG)
         {
-            years       = 0x007f & SetByteOrder((unsigned int*)(mpTimecodeData[0] + 4));
-            days        = 0x01ff & (SetByteOrder((unsigned int*)(mpTimecodeData[0] + 4)) >> 7);
-            hours       = 0x001f & SetByteOrder((unsigned int*)(mpTimecodeData[0] + 8));
-            minutes     = 0x003f & (SetByteOrder((unsigned int*)(mpTimecodeData[0] + 8)) >> 5);
-            seconds     = 0x003f & (SetByteOrder((unsigned int*)(mpTimecodeData[0] + 8)) >> 11);
-            tenths      = 0x000f & (SetByteOrder((unsigned int*)(mpTimecodeData[0] + 8)) >> 17);
+            years       = 0x007f & SetByteOrder((unsigned int*)(GetItem(ComponentTimecode, 0) + 4));
+            days        = 0x01ff & (SetByteOrder((unsigned int*)(GetItem(ComponentTimecode, 0) + 4)) >> 7);
+            hours       = 0x001f & SetByteOrder((unsigned int*)(GetItem(ComponentTimecode, 0) + 8));
+            minutes     = 0x003f & (SetByteOrder((unsigned int*)(GetItem(ComponentTimecode, 0) + 8)) >> 5);
+            seconds     = 0x003f & (SetByteOrder((unsigned int*)(GetItem(ComponentTimecode, 0) + 8)) >> 11);
+            tenths      = 0x000f & (SetByteOrder((unsigned int*)(GetItem(ComponentTimecode, 0) + 8)) >> 17);
             return true;
         }
     }
@@ -1255,6 +1870,8 @@ bool CRTPacket::GetTimecodeIRIG(int& years, int& days, int& hours, int& minutes,
 
 bool CRTPacket::GetTimecodeCameraTime(unsigned long long &cameraTime)
 {
+    EnsureIndexed(ComponentTimecode);
+
     if (mnTimecodeCount <= 0)
     {
         return false;
@@ -1264,8 +1881,8 @@ bool CRTPacket::GetTimecodeCameraTime(unsigned long long &cameraTime)
     {
         if (timecodeType == TimecodeCamerTime)
         {
-            cameraTime = ((long long)SetByteOrder((unsigned int*)(mpTimecodeData[0] + 4))) << 32 |
-                          (long long)SetByteOrder((unsigned int*)(mpTimecodeData[0] + 8));
+            cameraTime = ((long long)SetByteOrder((unsigned int*)(GetItem(ComponentTimecode, 0) + 4))) << 32 |
+                          (long long)SetByteOrder((unsigned int*)(GetItem(ComponentTimecode, 0) + 8));
             return true;
         }
     }
@@ -1283,32 +1900,38 @@ unsigned int CRTPacket::GetImageCameraCount()
 
 unsigned int CRTPacket::GetImageCameraId(unsigned int nCameraIndex)
 {
+    EnsureIndexed(ComponentImage);
+
     if (mnImageCameraCount <= nCameraIndex)
     {
         return 0;
     }
-    return SetByteOrder((unsigned int*)(mpImageData[nCameraIndex]));
+    return SetByteOrder((unsigned int*)(GetItem(ComponentImage, nCameraIndex)));
 }
 
 bool CRTPacket::GetImageFormat(unsigned int nCameraIndex, EImageFormat &eImageFormat)
 {
+    EnsureIndexed(ComponentImage);
+
     if (mnImageCameraCount <= nCameraIndex)
     {
         return false;
     }
-    eImageFormat = (EImageFormat)SetByteOrder((unsigned int*)(mpImageData[nCameraIndex] + 4));
+    eImageFormat = (EImageFormat)SetByteOrder((unsigned int*)(GetItem(ComponentImage, nCameraIndex) + 4));
 
     return true;
 }
 
 bool CRTPacket::GetImageSize(unsigned int nCameraIndex, unsigned int& nWidth, unsigned int& nHeight)
 {
+    EnsureIndexed(ComponentImage);
+
     if (mnImageCameraCount <= nCameraIndex)
     {
         return false;
     }
-    nWidth  = SetByteOrder((unsigned int*)(mpImageData[nCameraIndex] + 8));
-    nHeight = SetByteOrder((unsigned int*)(mpImageData[nCameraIndex] + 12));
+    nWidth  = SetByteOrder((unsigned int*)(GetItem(ComponentImage, nCameraIndex) + 8));
+    nHeight = SetByteOrder((unsigned int*)(GetItem(ComponentImage, nCameraIndex) + 12));
 
     return true;
 }
@@ -1316,42 +1939,48 @@ bool CRTPacket::GetImageSize(unsigned int nCameraIndex, unsigned int& nWidth, un
 bool CRTPacket::GetImageCrop(unsigned int nCameraIndex, float &fCropLeft, float &fCropTop,
                              float &fCropRight, float &fCropBottom)
 {
+    EnsureIndexed(ComponentImage);
+
     if (mnImageCameraCount <= nCameraIndex)
     {
         return false;
     }
-    fCropLeft   = SetByteOrder((float*)(mpImageData[nCameraIndex] + 16));
-    fCropTop    = SetByteOrder((float*)(mpImageData[nCameraIndex] + 20));
-    fCropRight  = SetByteOrder((float*)(mpImageData[nCameraIndex] + 24));
-    fCropBottom = SetByteOrder((float*)(mpImageData[nCameraIndex] + 28));
+    fCropLeft   = SetByteOrder((float*)(GetItem(ComponentImage, nCameraIndex) + 16));
+    fCropTop    = SetByteOrder((float*)(GetItem(ComponentImage, nCameraIndex) + 20));
+    fCropRight  = SetByteOrder((float*)(GetItem(ComponentImage, nCameraIndex) + 24));
+    fCropBottom = SetByteOrder((float*)(GetItem(ComponentImage, nCameraIndex) + 28));
 
     return true;
 }
 
 unsigned int CRTPacket::GetImageSize(unsigned int nCameraIndex)
 {
+    EnsureIndexed(ComponentImage);
+
     if (((mnMajorVersion == 1) && (mnMinorVersion < 8)) || mnImageCameraCount <= nCameraIndex)
     {
         return 0;
     }
 
-    return SetByteOrder((unsigned int*)(mpImageData[nCameraIndex] + 32));
+    return SetByteOrder((unsigned int*)(GetItem(ComponentImage, nCameraIndex) + 32));
 }
 
 unsigned int CRTPacket::GetImage(unsigned int nCameraIndex, char* pDataBuf, unsigned int nBufSize)
 {
+    EnsureIndexed(ComponentImage);
+
     if (((mnMajorVersion == 1) && (mnMinorVersion < 8)) || mnImageCameraCount <= nCameraIndex)
     {
         return 0;
     }
 
-    unsigned int nSize = SetByteOrder((unsigned int*)(mpImageData[nCameraIndex] + 32));
+    unsigned int nSize = SetByteOrder((unsigned int*)(GetItem(ComponentImage, nCameraIndex) + 32));
 
     if (nBufSize < nSize)
     {
         return 0;
     }
-    memcpy(pDataBuf, mpImageData[nCameraIndex] + 36, nSize);
+    memcpy(pDataBuf, GetItem(ComponentImage, nCameraIndex) + 36, nSize);
 
     return nSize;
 }
@@ -1367,6 +1996,8 @@ unsigned int CRTPacket::GetAnalogDeviceCount()
 
 unsigned int CRTPacket::GetAnalogDeviceId(unsigned int nDeviceIndex)
 {
+    EnsureIndexed(ComponentAnalog);
+
     if ((mnMajorVersion == 1) && (mnMinorVersion == 0))
     {
         return 1;
@@ -1375,12 +2006,14 @@ unsigned int CRTPacket::GetAnalogDeviceId(unsigned int nDeviceIndex)
     {
         return 0;
     }
-    return SetByteOrder((unsigned int*)(mpAnalogData[nDeviceIndex]));
+    return SetByteOrder((unsigned int*)(GetItem(ComponentAnalog, nDeviceIndex)));
 }
 
 unsigned int CRTPacket::GetAnalogChannelCount(unsigned int nDeviceIndex)
 {
-    char* pData = mpComponentData[ComponentAnalog - 1];
+    EnsureIndexed(ComponentAnalog);
+
+    char* pData = GetComponentData(ComponentAnalog);
 
     if ((mnMajorVersion == 1) && (mnMinorVersion == 0))
     {
@@ -1390,11 +2023,13 @@ unsigned int CRTPacket::GetAnalogChannelCount(unsigned int nDeviceIndex)
     {
         return 0;
     }
-    return SetByteOrder((unsigned int*)(mpAnalogData[nDeviceIndex] + 4));
+    return SetByteOrder((unsigned int*)(GetItem(ComponentAnalog, nDeviceIndex) + 4));
 }
 
 unsigned int CRTPacket::GetAnalogSampleCount(unsigned int nDeviceIndex)
 {
+    EnsureIndexed(ComponentAnalog);
+
     if ((mnMajorVersion == 1) && (mnMinorVersion == 0))
     {
         return 1;
@@ -1403,11 +2038,13 @@ unsigned int CRTPacket::GetAnalogSampleCount(unsigned int nDeviceIndex)
     {
         return 0;
     }
-    return SetByteOrder((unsigned int*)(mpAnalogData[nDeviceIndex] + 8));
+    return SetByteOrder((unsigned int*)(GetItem(ComponentAnalog, nDeviceIndex) + 8));
 }
 
 unsigned int CRTPacket::GetAnalogSampleNumber(unsigned int nDeviceIndex)
 {
+    EnsureIndexed(ComponentAnalog);
+
     if ((mnMajorVersion == 1) && (mnMinorVersion == 0))
     {
         return GetFrameNumber();
@@ -1417,11 +2054,13 @@ unsigned int CRTPacket::GetAnalogSampleNumber(unsigned int nDeviceIndex)
     {
         return 0;
     }
-    return SetByteOrder((unsigned int*)(mpAnalogData[nDeviceIndex] + 12));
+    return SetByteOrder((unsigned int*)(GetItem(ComponentAnalog, nDeviceIndex) + 12));
 }
 
 unsigned int CRTPacket::GetAnalogData(unsigned int nDeviceIndex, float* pDataBuf, unsigned int nBufSize)
 {
+    EnsureIndexed(ComponentAnalog);
+
     unsigned int nSize = 0;
 
     if (nDeviceIndex < mnAnalogDeviceCount)
@@ -1437,7 +2076,7 @@ unsigned int CRTPacket::GetAnalogData(unsigned int nDeviceIndex, float* pDataBuf
             }
             for (unsigned int i = 0; i < nSize; i++)
             {
-                pDataBuf[i] = (float)SetByteOrder((double*)(mpAnalogData[nDeviceIndex] + i * sizeof(double)));
+                pDataBuf[i] = (float)SetByteOrder((double*)(GetItem(ComponentAnalog, nDeviceIndex) + i * sizeof(double)));
             }
         }
         else
@@ -1449,7 +2088,7 @@ unsigned int CRTPacket::GetAnalogData(unsigned int nDeviceIndex, float* pDataBuf
             }
             for (unsigned int i = 0; i < nSize; i++)
             {
-                pDataBuf[i] = (float)SetByteOrder((float*)(mpAnalogData[nDeviceIndex] + 16 + i * sizeof(float)));
+                pDataBuf[i] = (float)SetByteOrder((float*)(GetItem(ComponentAnalog, nDeviceIndex) + 16 + i * sizeof(float)));
             }
         }
     }
@@ -1459,6 +2098,8 @@ unsigned int CRTPacket::GetAnalogData(unsigned int nDeviceIndex, float* pDataBuf
 
 unsigned int CRTPacket::GetAnalogData(unsigned int nDeviceIndex, unsigned int nChannelIndex, float* pDataBuf, unsigned int nBufSize)
 {
+    EnsureIndexed(ComponentAnalog);
+
     unsigned int nSampleCount = 0;
     unsigned int nChannelCount = GetAnalogChannelCount(nDeviceIndex);
 
@@ -1473,7 +2114,7 @@ unsigned int CRTPacket::GetAnalogData(unsigned int nDeviceIndex, unsigned int nC
             else
             {
                 nSampleCount = 1;
-                pDataBuf[0] = (float)SetByteOrder((double*)(mpAnalogData[nDeviceIndex] + nChannelIndex * sizeof(double)));
+                pDataBuf[0] = (float)SetByteOrder((double*)(GetItem(ComponentAnalog, nDeviceIndex) + nChannelIndex * sizeof(double)));
             }
         }
         else
@@ -1485,7 +2126,7 @@ unsigned int CRTPacket::GetAnalogData(unsigned int nDeviceIndex, unsigned int nC
             }
             for (unsigned int i = 0; i < nSampleCount; i++)
             {
-                pDataBuf[i] = (float)SetByteOrder((float*)(mpAnalogData[nDeviceIndex] + 16 +
+                pDataBuf[i] = (float)SetByteOrder((float*)(GetItem(ComponentAnalog, nDeviceIndex) + 16 +
                                nChannelIndex * nSampleCount * sizeof(float) + i * sizeof(float)));
             }
         }
@@ -1497,6 +2138,8 @@ unsigned int CRTPacket::GetAnalogData(unsigned int nDeviceIndex, unsigned int nC
 bool CRTPacket::GetAnalogData(unsigned int nDeviceIndex, unsigned int nChannelIndex, unsigned int nSampleIndex,
                               float &fAnalogValue)
 {
+    EnsureIndexed(ComponentAnalog);
+
     if (nDeviceIndex < mnAnalogDeviceCount)
     {
         unsigned int nSampleCount = GetAnalogSampleCount(nDeviceIndex);
@@ -1506,11 +2149,11 @@ bool CRTPacket::GetAnalogData(unsigned int nDeviceIndex, unsigned int nChannelIn
         {
             if ((mnMajorVersion == 1) && (mnMinorVersion == 0))
             {
-                fAnalogValue = (float)SetByteOrder((double*)(mpAnalogData[nDeviceIndex] + nChannelIndex * sizeof(double)));
+                fAnalogValue = (float)SetByteOrder((double*)(GetItem(ComponentAnalog, nDeviceIndex) + nChannelIndex * sizeof(double)));
             }
             else
             {
-                fAnalogValue = SetByteOrder((float*)(mpAnalogData[nDeviceIndex] + 16 +
+                fAnalogValue = SetByteOrder((float*)(GetItem(ComponentAnalog, nDeviceIndex) + 16 +
                                (nChannelIndex * nSampleCount + nSampleIndex) * sizeof(float)));
             }
             if (isnan(fAnalogValue) == 0)
@@ -1533,24 +2176,30 @@ unsigned int CRTPacket::GetAnalogSingleDeviceCount()
 
 unsigned int CRTPacket::GetAnalogSingleDeviceId(unsigned int nDeviceIndex)
 {
+    EnsureIndexed(ComponentAnalogSingle);
+
     if (mnAnalogSingleDeviceCount <= nDeviceIndex)
     {
         return 0;
     }
-    return SetByteOrder((unsigned int*)(mpAnalogSingleData[nDeviceIndex]));
+    return SetByteOrder((unsigned int*)(GetItem(ComponentAnalogSingle, nDeviceIndex)));
 }
 
 unsigned int CRTPacket::GetAnalogSingleChannelCount(unsigned int nDeviceIndex)
 {
+    EnsureIndexed(ComponentAnalogSingle);
+
     if (mnAnalogSingleDeviceCount <= nDeviceIndex)
     {
         return 0;
     }
-    return SetByteOrder((unsigned int*)(mpAnalogSingleData[nDeviceIndex] + 4));
+    return SetByteOrder((unsigned int*)(GetItem(ComponentAnalogSingle, nDeviceIndex) + 4));
 }
 
 unsigned int CRTPacket::GetAnalogSingleData(unsigned int nDeviceIndex, float* pDataBuf, unsigned int nBufSize)
 {
+    EnsureIndexed(ComponentAnalogSingle);
+
     unsigned int nSize = 0;
 
     if (nDeviceIndex < mnAnalogSingleDeviceCount)
@@ -1562,7 +2211,7 @@ unsigned int CRTPacket::GetAnalogSingleData(unsigned int nDeviceIndex, float* pD
         }
         for (unsigned int i = 0; i < nSize; i++)
         {
-            pDataBuf[i] = SetByteOrder((float*)(mpAnalogSingleData[nDeviceIndex] + 8 + i * sizeof(float)));
+            pDataBuf[i] = SetByteOrder((float*)(GetItem(ComponentAnalogSingle, nDeviceIndex) + 8 + i * sizeof(float)));
         }
     }
 
@@ -1571,11 +2220,13 @@ unsigned int CRTPacket::GetAnalogSingleData(unsigned int nDeviceIndex, float* pD
 
 bool CRTPacket::GetAnalogSingleData(unsigned int nDeviceIndex, unsigned int nChannelIndex, float &fValue)
 {
+    EnsureIndexed(ComponentAnalogSingle);
+
     if (nDeviceIndex < mnAnalogSingleDeviceCount)
     {
         if (nChannelIndex < GetAnalogSingleChannelCount(nDeviceIndex))
         {
-            fValue = SetByteOrder(((float*)(mpAnalogSingleData[nDeviceIndex] + 8 + nChannelIndex * sizeof(float))));
+            fValue = SetByteOrder(((float*)(GetItem(ComponentAnalogSingle, nDeviceIndex) + 8 + nChannelIndex * sizeof(float))));
             return (isnan(fValue) == 0);
         }
     }
@@ -1593,15 +2244,19 @@ unsigned int CRTPacket::GetForcePlateCount()
 
 unsigned int CRTPacket::GetForcePlateId(unsigned int nPlateIndex)
 {
+    EnsureIndexed(ComponentForce);
+
     if ((mnMajorVersion == 1 && mnMinorVersion == 0) || mnForcePlateCount <= nPlateIndex)
     {
         return 0;
     }
-    return SetByteOrder((unsigned int*)(mpForceData[nPlateIndex]));
+    return SetByteOrder((unsigned int*)(GetItem(ComponentForce, nPlateIndex)));
 }
 
 unsigned int CRTPacket::GetForceCount(unsigned int nPlateIndex)
 {
+    EnsureIndexed(ComponentForce);
+
     if (mnForcePlateCount <= nPlateIndex)
     {
         return 0;
@@ -1610,11 +2265,13 @@ unsigned int CRTPacket::GetForceCount(unsigned int nPlateIndex)
     {
         return 1;
     }
-    return SetByteOrder((unsigned int*)(mpForceData[nPlateIndex] + 4));
+    return SetByteOrder((unsigned int*)(GetItem(ComponentForce, nPlateIndex) + 4));
 }
 
 unsigned int CRTPacket::GetForceNumber(unsigned int nPlateIndex)
 {
+    EnsureIndexed(ComponentForce);
+
     if (mnForcePlateCount <= nPlateIndex)
     {
         return 0;
@@ -1623,11 +2280,13 @@ unsigned int CRTPacket::GetForceNumber(unsigned int nPlateIndex)
     {
         return GetFrameNumber();
     }
-    return SetByteOrder((unsigned int*)(mpForceData[nPlateIndex] + 8));
+    return SetByteOrder((unsigned int*)(GetItem(ComponentForce, nPlateIndex) + 8));
 }
 
 unsigned int CRTPacket::GetForceData(unsigned int nPlateIndex, SForce* pForceBuf, unsigned int nBufSize)
 {
+    EnsureIndexed(ComponentForce);
+
     unsigned int nSize = 0;
 
     if (nPlateIndex < mnForcePlateCount)
@@ -1639,7 +2298,7 @@ unsigned int CRTPacket::GetForceData(unsigned int nPlateIndex, SForce* pForceBuf
                 for (unsigned int k = 0; k < 9; k++)
                 {
                     *(((float*)pForceBuf) + k) =
-                        (float)SetByteOrder((double*)(mpForceData[nPlateIndex] + k * sizeof(double)));
+                        (float)SetByteOrder((double*)(GetItem(ComponentForce, nPlateIndex) + k * sizeof(double)));
                 }
                 nSize = 1;
             }
@@ -1656,7 +2315,7 @@ unsigned int CRTPacket::GetForceData(unsigned int nPlateIndex, SForce* pForceBuf
                 for (unsigned int k = 0; k < 9; k++)
                 {
                     *(((float*)&pForceBuf[i]) + k) =
-                        SetByteOrder((float*)(mpForceData[nPlateIndex] + 12 + (k * 4) + i * sizeof(SForce)));
+                        SetByteOrder((float*)(GetItem(ComponentForce, nPlateIndex) + 12 + (k * 4) + i * sizeof(SForce)));
                 }
             }
         }
@@ -1666,6 +2325,8 @@ unsigned int CRTPacket::GetForceData(unsigned int nPlateIndex, SForce* pForceBuf
 
 bool CRTPacket::GetForceData(unsigned int nPlateIndex, unsigned int nForceIndex, SForce &sForce)
 {
+    EnsureIndexed(ComponentForce);
+
     if (nPlateIndex < mnForcePlateCount)
     {
         if ((mnMajorVersion == 1) && (mnMinorVersion == 0))
@@ -1675,7 +2336,7 @@ bool CRTPacket::GetForceData(unsigned int nPlateIndex, unsigned int nForceIndex,
                 for (unsigned int k = 0; k < 9; k++)
                 {
                     *(((float*)&sForce) + k) =
-                        (float)SetByteOrder((double*)(mpForceData[nPlateIndex] + k * sizeof(double)));
+                        (float)SetByteOrder((double*)(GetItem(ComponentForce, nPlateIndex) + k * sizeof(double)));
 
                     // Not a valid force if one of the values is not a valid float.
                     if (isnan(*(((float*)&sForce) + k)) != 0)
@@ -1693,7 +2354,7 @@ bool CRTPacket::GetForceData(unsigned int nPlateIndex, unsigned int nForceIndex,
                 for (unsigned int k = 0; k < 9; k++)
                 {
                     *(((float*)&sForce) + k) =
-                        SetByteOrder((float*)(mpForceData[nPlateIndex] + 12 + k * sizeof(float) + nForceIndex * sizeof(SForce)));
+                        SetByteOrder((float*)(GetItem(ComponentForce, nPlateIndex) + 12 + k * sizeof(float) + nForceIndex * sizeof(SForce)));
 
                     // Not a valid force if one of the values is not a valid float.
                     if (isnan(*(((float*)&sForce) + k)) != 0)
@@ -1719,15 +2380,19 @@ unsigned int CRTPacket::GetSkeletonCount()
 
 unsigned int CRTPacket::GetSkeletonSegmentCount(unsigned int nSkeletonIndex)
 {
+    EnsureIndexed(ComponentSkeleton);
+
     if (mSkeletonCount <= nSkeletonIndex)
     {
         return 0;
     }
-    return SetByteOrder((unsigned int*)(mpSkeletonData[nSkeletonIndex]));
+    return SetByteOrder((unsigned int*)(GetItem(ComponentSkeleton, nSkeletonIndex)));
 }
 
 bool CRTPacket::GetSkeletonSegments(unsigned int nSkeletonIndex, SSkeletonSegment* segmentBuffer, unsigned int nBufSize)
 {
+    EnsureIndexed(ComponentSkeleton);
+
     if (mSkeletonCount <= nSkeletonIndex)
     {
         return false;
@@ -1749,25 +2414,27 @@ bool CRTPacket::GetSkeletonSegments(unsigned int nSkeletonIndex, SSkeletonSegmen
     {
         for (unsigned int i = 0; i < segmentCount; i++)
         {
-            segmentBuffer[i].id = SetByteOrder((unsigned int*)(mpSkeletonData[nSkeletonIndex] + 4 + i * 32));
-            segmentBuffer[i].positionX = SetByteOrder((float*)(mpSkeletonData[nSkeletonIndex] + 8 + i * 32));
-            segmentBuffer[i].positionY = SetByteOrder((float*)(mpSkeletonData[nSkeletonIndex] + 12 + i * 32));
-            segmentBuffer[i].positionZ = SetByteOrder((float*)(mpSkeletonData[nSkeletonIndex] + 16 + i * 32));
-            segmentBuffer[i].rotationX = SetByteOrder((float*)(mpSkeletonData[nSkeletonIndex] + 20 + i * 32));
-            segmentBuffer[i].rotationY = SetByteOrder((float*)(mpSkeletonData[nSkeletonIndex] + 24 + i * 32));
-            segmentBuffer[i].rotationZ = SetByteOrder((float*)(mpSkeletonData[nSkeletonIndex] + 28 + i * 32));
-            segmentBuffer[i].rotationW = SetByteOrder((float*)(mpSkeletonData[nSkeletonIndex] + 32 + i * 32));
+            segmentBuffer[i].id = SetByteOrder((unsigned int*)(GetItem(ComponentSkeleton, nSkeletonIndex) + 4 + i * 32));
+            segmentBuffer[i].positionX = SetByteOrder((float*)(GetItem(ComponentSkeleton, nSkeletonIndex) + 8 + i * 32));
+            segmentBuffer[i].positionY = SetByteOrder((float*)(GetItem(ComponentSkeleton, nSkeletonIndex) + 12 + i * 32));
+            segmentBuffer[i].positionZ = SetByteOrder((float*)(GetItem(ComponentSkeleton, nSkeletonIndex) + 16 + i * 32));
+            segmentBuffer[i].rotationX = SetByteOrder((float*)(GetItem(ComponentSkeleton, nSkeletonIndex) + 20 + i * 32));
+            segmentBuffer[i].rotationY = SetByteOrder((float*)(GetItem(ComponentSkeleton, nSkeletonIndex) + 24 + i * 32));
+            segmentBuffer[i].rotationZ = SetByteOrder((float*)(GetItem(ComponentSkeleton, nSkeletonIndex) + 28 + i * 32));
+            segmentBuffer[i].rotationW = SetByteOrder((float*)(GetItem(ComponentSkeleton, nSkeletonIndex) + 32 + i * 32));
         }
     }
     else
     {
-        memcpy(segmentBuffer, mpSkeletonData[nSkeletonIndex] + 4, sizeof(SSkeletonSegment) * segmentCount);
+        memcpy(segmentBuffer, GetItem(ComponentSkeleton, nSkeletonIndex) + 4, sizeof(SSkeletonSegment) * segmentCount);
     }
     return true;
 }
 
 bool CRTPacket::GetSkeletonSegment(unsigned int nSkeletonIndex, unsigned segmentIndex, SSkeletonSegment &segment)
 {
+    EnsureIndexed(ComponentSkeleton);
+
     if (mSkeletonCount <= nSkeletonIndex)
     {
         return false;
@@ -1786,18 +2453,18 @@ bool CRTPacket::GetSkeletonSegment(unsigned int nSkeletonIndex, unsigned segment
 
     if (mbBigEndian)
     {
-        segment.id = SetByteOrder((unsigned int*)(mpSkeletonData[nSkeletonIndex] + 4 + 32 * segmentIndex));
-        segment.positionX = SetByteOrder((float*)(mpSkeletonData[nSkeletonIndex] + 8 + 32 * segmentIndex));
-        segment.positionY = SetByteOrder((float*)(mpSkeletonData[nSkeletonIndex] + 12 + 32 * segmentIndex));
-        segment.positionZ = SetByteOrder((float*)(mpSkeletonData[nSkeletonIndex] + 16 + 32 * segmentIndex));
-        segment.rotationX = SetByteOrder((float*)(mpSkeletonData[nSkeletonIndex] + 20 + 32 * segmentIndex));
-        segment.rotationY = SetByteOrder((float*)(mpSkeletonData[nSkeletonIndex] + 24 + 32 * segmentIndex));
-        segment.rotationZ = SetByteOrder((float*)(mpSkeletonData[nSkeletonIndex] + 28 + 32 * segmentIndex));
-        segment.rotationW = SetByteOrder((float*)(mpSkeletonData[nSkeletonIndex] + 32 + 32 * segmentIndex));
+        segment.id = SetByteOrder((unsigned int*)(GetItem(ComponentSkeleton, nSkeletonIndex) + 4 + 32 * segmentIndex));
+        segment.positionX = SetByteOrder((float*)(GetItem(ComponentSkeleton, nSkeletonIndex) + 8 + 32 * segmentIndex));
+        segment.positionY = SetByteOrder((float*)(GetItem(ComponentSkeleton, nSkeletonIndex) + 12 + 32 * segmentIndex));
+        segment.positionZ = SetByteOrder((float*)(GetItem(ComponentSkeleton, nSkeletonIndex) + 16 + 32 * segmentIndex));
+        segment.rotationX = SetByteOrder((float*)(GetItem(ComponentSkeleton, nSkeletonIndex) + 20 + 32 * segmentIndex));
+        segment.rotationY = SetByteOrder((float*)(GetItem(ComponentSkeleton, nSkeletonIndex) + 24 + 32 * segmentIndex));
+        segment.rotationZ = SetByteOrder((float*)(GetItem(ComponentSkeleton, nSkeletonIndex) + 28 + 32 * segmentIndex));
+        segment.rotationW = SetByteOrder((float*)(GetItem(ComponentSkeleton, nSkeletonIndex) + 32 + 32 * segmentIndex));
     }
     else
     {
-        memcpy(&segment, mpSkeletonData[nSkeletonIndex] + 4 + 32 * segmentIndex, sizeof(SSkeletonSegment));
+        memcpy(&segment, GetItem(ComponentSkeleton, nSkeletonIndex) + 4 + 32 * segmentIndex, sizeof(SSkeletonSegment));
     }
     
     return true;
@@ -1814,21 +2481,25 @@ unsigned int CRTPacket::GetForceSinglePlateCount()
 
 unsigned int CRTPacket::GetForceSinglePlateId(unsigned int nPlateIndex)
 {
+    EnsureIndexed(ComponentForceSingle);
+
     if ((mnMajorVersion == 1 && mnMinorVersion == 0) || mnForceSinglePlateCount <= nPlateIndex)
     {
         return 0;
     }
-    return SetByteOrder((unsigned int*)(mpForceSingleData[nPlateIndex]));
+    return SetByteOrder((unsigned int*)(GetItem(ComponentForceSingle, nPlateIndex)));
 }
 
 bool CRTPacket::GetForceSingleData(unsigned int nPlateIndex, SForce &sForce)
 {
+    EnsureIndexed(ComponentForceSingle);
+
     if (nPlateIndex < mnForceSinglePlateCount)
     {
         for (unsigned int k = 0; k < 9; k++)
         {
             *(((float*)&sForce) + k) =
-                SetByteOrder((float*)(mpForceSingleData[nPlateIndex] + 4 + k * sizeof(float)));
+                SetByteOrder((float*)(GetItem(ComponentForceSingle, nPlateIndex) + 4 + k * sizeof(float)));
 
             // Not a valid force if one of the values is not a valid float.
             if (isnan(*(((float*)&sForce) + k)) != 0)
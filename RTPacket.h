@@ -1,6 +1,9 @@
 #ifndef RTPACKET_H
 #define RTPACKET_H
 
+#include "PacketDecoder.h"
+
+#include <atomic>
 #include <vector>
 
 #ifdef _MSC_VER
@@ -129,6 +132,42 @@ public:
         float z;
     };
 
+    struct S3DResidualMarker
+    {
+        float x;
+        float y;
+        float z;
+        float residual;
+    };
+
+    struct S3DNoLabelsMarker
+    {
+        float x;
+        float y;
+        float z;
+        unsigned int id;
+    };
+
+    struct S3DNoLabelsResidualMarker
+    {
+        float x;
+        float y;
+        float z;
+        unsigned int id;
+        float residual;
+    };
+
+    // One array per field for the bulk 3D reads, each with room for the markers. residual and id are only
+    // written when not null.
+    struct S3DMarkerArrays
+    {
+        float*        x;
+        float*        y;
+        float*        z;
+        float*        residual;
+        unsigned int* id;
+    };
+
     struct SRotation
     {
         float x;
@@ -137,6 +176,31 @@ public:
         float w;
     };
 
+    // A 6DOF body as in the packet. The rotation matrix is column major, r11, r21, r31, r12, ...
+    struct S6DOFBody
+    {
+        float x;
+        float y;
+        float z;
+        float rotation[9];
+    };
+
+    struct S6DOFResidualBody
+    {
+        float x;
+        float y;
+        float z;
+        float rotation[9];
+        float residual;
+    };
+
+    // A 6DOF body with the rotation as a normalized quaternion.
+    struct SPose
+    {
+        SPosition position;
+        SRotation rotation;
+    };
+
     struct SSkeletonSegment
     {
         unsigned int id;
@@ -157,12 +221,25 @@ public:
     void             SetEndianness(bool bBigEndian);
     void             ClearData();
     void             SetData(char* ptr);
+    // SetData only finds the components. Their cameras and devices are indexed when first read, also when
+    // several threads read the packet at once. This indexes all of them up front.
+    void             IndexComponents();
+    // The index holds one entry per camera or device of the indexed components. Up to cInlineIndexSize
+    // entries are stored in the packet itself, more in a heap block that grows as needed and is kept for the
+    // following packets. Reserving the number of cameras and devices in the settings up front means that
+    // parsing packets never allocates memory, see CRTProtocol::ReservePacketIndex.
+    void             ReserveIndex(unsigned int nEntryCount);
+    unsigned int     GetIndexCapacity() const;
     void             GetData(char* &ptr, unsigned int &nSize);
 
     unsigned int     GetSize();
     EPacketType      GetType();
     unsigned long long GetTimeStamp();
     unsigned int     GetFrameNumber();
+    // Local time when the packet was received, in nanoseconds since 1970-01-01 UTC. Taken by the kernel
+    // (SO_TIMESTAMPNS) on Linux, 0 if not available. GetTimeStamp is the QTM capture time.
+    unsigned long long GetReceiveTimestamp();
+    void             SetReceiveTimestamp(unsigned long long timestamp);
     static unsigned int     GetSize(char* pData, bool bBigEndian = false);
     static EPacketType      GetType(char* pData, bool bBigEndian = false);
     static unsigned long long GetTimeStamp(char* pData, bool bBigEndian = false);
@@ -210,6 +287,21 @@ public:
     bool             Get3DNoLabelsResidualMarker(unsigned int nMarkerIndex, float &fX, float &fY, float &fZ,
                                                  unsigned int &nId, float &fResidual);
 
+    // Bulk reads of all markers of a 3D component in one pass, into an array of markers or into one array per
+    // field. nBufSize is the number of markers the buffers have room for. Return the number of markers read,
+    // 0 if the component is missing or the buffers are too small. pValidMask, when not null, gets one bit per
+    // marker, (nBufSize + 31) / 32 words. Bit i % 32 of word i / 32 is set when marker i isn't occluded (NaN).
+    unsigned int     Get3DMarkers(SPosition* pMarkerBuf, unsigned int nBufSize, unsigned int* pValidMask = nullptr);
+    unsigned int     Get3DMarkers(const S3DMarkerArrays& sArrays, unsigned int nBufSize, unsigned int* pValidMask = nullptr);
+    unsigned int     Get3DResidualMarkers(S3DResidualMarker* pMarkerBuf, unsigned int nBufSize, unsigned int* pValidMask = nullptr);
+    unsigned int     Get3DResidualMarkers(const S3DMarkerArrays& sArrays, unsigned int nBufSize, unsigned int* pValidMask = nullptr);
+    unsigned int     Get3DNoLabelsMarkers(S3DNoLabelsMarker* pMarkerBuf, unsigned int nBufSize, unsigned int* pValidMask = nullptr);
+    unsigned int     Get3DNoLabelsMarkers(const S3DMarkerArrays& sArrays, unsigned int nBufSize, unsigned int* pValidMask = nullptr);
+    unsigned int     Get3DNoLabelsResidualMarkers(S3DNoLabelsResidualMarker* pMarkerBuf, unsigned int nBufSize,
+                                                  unsigned int* pValidMask = nullptr);
+    unsigned int     Get3DNoLabelsResidualMarkers(const S3DMarkerArrays& sArrays, unsigned int nBufSize,
+                                                  unsigned int* pValidMask = nullptr);
+
 
     unsigned int     Get6DOFBodyCount();
     bool             Get6DOFBody(unsigned int nBodyIndex, float &fX, float &fY, float &fZ, float afRotMatrix[9]);
@@ -218,6 +310,16 @@ public:
     bool             Get6DOFResidualBody(unsigned int nBodyIndex, float &fX, float &fY, float &fZ,
                                          float afRotMatrix[9], float &fResidual);
 
+    // Bulk reads of all bodies of a 6DOF component, see Get3DMarkers. The poses have the rotation matrices
+    // converted to quaternions, a batch of bodies at a time with SSE2, AVX or NEON. Bodies that aren't tracked
+    // are NaN.
+    unsigned int     Get6DOFBodies(S6DOFBody* pBodyBuf, unsigned int nBufSize);
+    unsigned int     Get6DOFBodies(SPose* pPoseBuf, unsigned int nBufSize);
+    unsigned int     Get6DOFResidualBodies(S6DOFResidualBody* pBodyBuf, unsigned int nBufSize);
+    unsigned int     Get6DOFResidualBodies(SPose* pPoseBuf, unsigned int nBufSize, float* pResidualBuf = nullptr);
+    // Normalized quaternion of a 6DOF rotation matrix, NaN if the matrix is.
+    static void      RotationMatrixToQuaternion(const float afRotMatrix[9], SRotation& sRotation);
+
     unsigned int     Get6DOFEulerBodyCount();
     bool             Get6DOFEulerBody(unsigned int nBodyIndex, float &fX, float &fY, float &fZ,
                                       float &fAng1, float &fAng2, float &fAng3);
@@ -286,7 +388,15 @@ public:
     bool             GetSkeletonSegments(unsigned int nSkeletonIndex, SSkeletonSegment* segmentBuf, unsigned int nBufSize);
     bool             GetSkeletonSegment(unsigned int nSkeletonIndex, unsigned segmentIndex, SSkeletonSegment &segment);
 
+    static const unsigned int cInlineIndexSize = 32;
+
 private:
+    char*            GetComponentData(EComponentType eComponent);
+    void             EnsureIndexed(EComponentType eComponent);
+    void             IndexComponent(EComponentType eComponent);
+    void             BuildComponentIndex(EComponentType eComponent);
+    char*            GetItem(EComponentType eComponent, unsigned int nItemIndex);
+
     float            SetByteOrder(float* pfData);
     double           SetByteOrder(double* pfData);
     short            SetByteOrder(short* pnData);
@@ -299,18 +409,12 @@ private:
 
 private:
     char*          mpData;
-    std::vector<char*> mpComponentData;
-    std::vector<char*> mp2DData;
-    std::vector<char*> mp2DLinData;
-    std::vector<char*> mpImageData;
-    std::vector<char*> mpAnalogData;
-    std::vector<char*> mpAnalogSingleData;
-    std::vector<char*> mpForceData;
-    std::vector<char*> mpForceSingleData;
-    std::vector<char*> mpGazeVectorData;
-    std::vector<char*> mpEyeTrackerData;
-    std::vector<char*> mpTimecodeData;
-    std::vector<char*> mpSkeletonData;
+    // Offsets from mpData, 32-bit so that the whole index fits in a few cache lines.
+    unsigned int   mnComponentOffset[ComponentNone];   // By component type - 1, 0 when not in the packet
+    unsigned int   mnIndexStart[ComponentNone];        // Start of the cameras or devices of a component in the index
+    unsigned int   mnIndexUsed;
+    unsigned int   mnIndexInline[cInlineIndexSize];
+    std::vector<unsigned int> mIndexHeap;              // Replaces mnIndexInline when that is too small
     unsigned int   mnComponentCount;
     unsigned int   mn2DCameraCount;
     unsigned int   mn2DLinCameraCount;
@@ -323,9 +427,27 @@ private:
     unsigned int   mnEyeTrackerCount;
     unsigned int   mnTimecodeCount;
     unsigned int   mSkeletonCount;
+    // Bit per EComponentType, set when its sub tables are built, and cIndexLockBit while one is being built.
+    // Copyable, unlike std::atomic, so that packets still are.
+    struct SIndexedComponents
+    {
+        std::atomic<unsigned int> nBits;
+
+        SIndexedComponents() : nBits(0) {}
+        SIndexedComponents(const SIndexedComponents& other) : nBits(other.nBits.load(std::memory_order_relaxed)) {}
+        SIndexedComponents& operator=(const SIndexedComponents& other)
+        {
+            nBits.store(other.nBits.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            return *this;
+        }
+    };
+    static const unsigned int cIndexLockBit = 1u << 31;
+    SIndexedComponents mnIndexedComponents;
     int            mnMajorVersion;
     int            mnMinorVersion;
     bool           mbBigEndian;
+    qualisys_cpp_sdk::PacketDecoderType meDecoderType; // From the version and byte order
+    unsigned long long mnReceiveTimestamp;
 }; // RTPacket
 
 
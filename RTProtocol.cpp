@@ -12,6 +12,8 @@
 #include <iterator>
 #include <functional>
 #include <cstring>
+#include <map>
+#include <mutex>
 
 #include "Network.h"
 #include "SettingsDeserializer.h"
@@ -32,6 +34,8 @@ using namespace qualisys_cpp_sdk;
 namespace
 {
     const int qtmPacketHeaderSize = 8; // 8 bytes
+    const unsigned int cReceiveBufferMinFree = 65536; // Room for the largest UDP datagram.
+    const unsigned int cReceiveBufferSize    = 4 * cReceiveBufferMinFree;
 
     std::string ToLower(std::string str)
     {
@@ -72,6 +76,17 @@ namespace
             return versions;
         }
     };
+
+    // Protocol version last negotiated with each server, for fast connect.
+    std::mutex                       negotiatedVersionsMutex;
+    std::map<std::string, RTVersion> negotiatedVersions;
+
+    // The negotiated version depends on the requested one, which is the highest version the client accepts.
+    std::string GetServerKey(const char* serverAddr, unsigned short port, bool bigEndian, int majorVersion, int minorVersion)
+    {
+        return std::string(serverAddr) + ":" + std::to_string(port) + (bigEndian ? " big endian" : "") +
+               " version " + std::to_string(majorVersion) + "." + std::to_string(minorVersion);
+    }
 }
 
 unsigned int CRTProtocol::GetSystemFrequency() const
@@ -90,15 +105,31 @@ CRTProtocol::CRTProtocol()
     mBigEndian     = false;
     mErrorStr[0]   = 0;
     mBroadcastPort = 0;
-    mFileBuffer    = nullptr;
+    mCaptureSink   = nullptr;
+    mPacketLog     = nullptr;
+    mPacketIndexSize = 0;
     mIsMaster = false;
+    mFastConnect = false;
     mDataBuff.resize(65535);
+    mReceiveBuffer.resize(cReceiveBufferSize);
+    mReceiveTimestamp = 0;
+    mFramePool.reset(new FramePool(cDefaultFramePoolSize, cDefaultFrameRetainedSize));
+    mReceiveStart  = 0;
+    mReceiveEnd    = 0;
     mSendBuffer.resize(5000);
+    mBatchRingSize = cDefaultBatchRingSize;
+    mBatchHead     = 0;
+    mBatchStart    = 0;
+    mBatchCount    = 0;
+    mBatchDroppedCount = 0;
+    mStopReceiveThread    = false;
+    mReceiveThreadRunning = false;
 } // CRTProtocol
 
 
 CRTProtocol::~CRTProtocol()
 {
+    StopReceiveThread();
     if (mNetwork)
     {
         delete mNetwork;
@@ -111,8 +142,50 @@ CRTProtocol::~CRTProtocol()
     }
 } // ~CRTProtocol
 
-bool CRTProtocol::Connect(const char* pServerAddr, unsigned short nPort, unsigned short* pnUDPServerPort,
-                          int nMajorVersion, int nMinorVersion, bool bBigEndian, bool bNegotiateVersion)
+bool CRTProtocol::Connect(const char* serverAddr, unsigned short port, unsigned short* udpServerPort,
+                          int majorVersion, int minorVersion, bool bigEndian, bool negotiateVersion)
+{
+    const auto serverKey = GetServerKey(serverAddr, port, bigEndian, majorVersion, minorVersion);
+
+    // Protocol version 1.0 uses the legacy port, which doesn't support the GetState command.
+    if (mFastConnect && !(majorVersion == 1 && minorVersion == 0))
+    {
+        RTVersion version{ majorVersion, minorVersion };
+        if (negotiateVersion)
+        {
+            std::lock_guard<std::mutex> lock(negotiatedVersionsMutex);
+            auto negotiated = negotiatedVersions.find(serverKey);
+            if (negotiated != negotiatedVersions.end())
+            {
+                version = negotiated->second;
+            }
+        }
+
+        bool negotiate;
+        if (ConnectPipelined(serverAddr, port, udpServerPort, version.major, version.minor, bigEndian, negotiate))
+        {
+            return true;
+        }
+        if (!negotiate)
+        {
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(negotiatedVersionsMutex);
+        negotiatedVersions.erase(serverKey);
+    }
+
+    if (!ConnectNegotiated(serverAddr, port, udpServerPort, majorVersion, minorVersion, bigEndian, negotiateVersion))
+    {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(negotiatedVersionsMutex);
+    negotiatedVersions[serverKey] = { mMajorVersion, mMinorVersion };
+    return true;
+} // Connect
+
+
+bool CRTProtocol::ConnectNegotiated(const char* pServerAddr, unsigned short nPort, unsigned short* pnUDPServerPort,
+                                    int nMajorVersion, int nMinorVersion, bool bBigEndian, bool bNegotiateVersion)
 {
     CRTPacket::EPacketType eType;
     std::string            tempStr;
@@ -150,6 +223,10 @@ bool CRTProtocol::Connect(const char* pServerAddr, unsigned short nPort, unsigne
         strcpy(mErrorStr, "Could not allocate data packet.");
         return false;
     }
+    mRTPacket->ReserveIndex(mPacketIndexSize);
+
+    mReceiveStart = 0;
+    mReceiveEnd   = 0;
 
     if (mNetwork->Connect(pServerAddr, nPort))
     {
@@ -240,7 +317,114 @@ bool CRTProtocol::Connect(const char* pServerAddr, unsigned short nPort, unsigne
     }
     Disconnect();
     return false;
-} // Connect
+} // ConnectNegotiated
+
+
+// Connect with the given protocol version. All handshake commands are sent before any response is read.
+// negotiate is set if the server is there but didn't accept the version.
+bool CRTProtocol::ConnectPipelined(const char* serverAddr, unsigned short port, unsigned short* udpServerPort,
+                                   int majorVersion, int minorVersion, bool bigEndian, bool& negotiate)
+{
+    CRTPacket::EPacketType type;
+
+    negotiate     = false;
+    mBigEndian    = bigEndian;
+    mIsMaster     = false;
+    mMajorVersion = 1;
+    mMinorVersion = 1;
+    port += bigEndian ? 2 : 1;
+
+    delete mRTPacket;
+    mRTPacket = new CRTPacket(majorVersion, minorVersion, bigEndian);
+    mRTPacket->ReserveIndex(mPacketIndexSize);
+
+    mReceiveStart = 0;
+    mReceiveEnd   = 0;
+
+    if (!mNetwork->Connect(serverAddr, port))
+    {
+        if (mNetwork->GetError() == 10061)
+        {
+            strcpy(mErrorStr, "Check if QTM is running on target machine.");
+        }
+        else
+        {
+            strcpy(mErrorStr, mNetwork->GetErrorString());
+        }
+        Disconnect();
+        return false;
+    }
+    if (udpServerPort != nullptr && !mNetwork->CreateUDPSocket(*udpServerPort))
+    {
+        snprintf(mErrorStr, sizeof(mErrorStr), "CreateUDPSocket failed. %s", mNetwork->GetErrorString());
+        Disconnect();
+        return false;
+    }
+
+    const auto version = std::to_string(majorVersion) + "." + std::to_string(minorVersion);
+    if (!SendCommand(("Version " + version).c_str()) ||
+        !SendCommand((majorVersion > 1 || minorVersion > 9) ? "GetState" : "GetLastEvent"))
+    {
+        Disconnect();
+        return false;
+    }
+
+    // Welcome message
+    if (Receive(type, true) != CNetwork::ResponseType::success)
+    {
+        Disconnect();
+        return false;
+    }
+    if (type == CRTPacket::PacketError)
+    {
+        strcpy(mErrorStr, mRTPacket->GetErrorString());
+        Disconnect();
+        return false;
+    }
+    const std::string welcomeMessage("QTM RT Interface connected");
+    if (type != CRTPacket::PacketCommand || strncmp(welcomeMessage.c_str(), mRTPacket->GetCommandString(), welcomeMessage.size()) != 0)
+    {
+        strcpy(mErrorStr, "Unexpected welcome message.");
+        Disconnect();
+        return false;
+    }
+
+    std::string response;
+    while (Receive(type, true) == CNetwork::ResponseType::success)
+    {
+        if (type == CRTPacket::PacketCommand || type == CRTPacket::PacketError)
+        {
+            const char* text = type == CRTPacket::PacketCommand ? mRTPacket->GetCommandString() : mRTPacket->GetErrorString();
+            response = text != nullptr ? text : "";
+            break;
+        }
+    }
+    if (response != "Version set to " + version)
+    {
+        snprintf(mErrorStr, sizeof(mErrorStr), "Set Version %s failed. %s", version.c_str(), response.c_str());
+        negotiate = !response.empty();
+        Disconnect();
+        return false;
+    }
+    mMajorVersion = majorVersion;
+    mMinorVersion = minorVersion;
+    mRTPacket->SetVersion(mMajorVersion, mMinorVersion);
+
+    // Like the full handshake, a missing state response doesn't fail the connect.
+    CNetwork::ResponseType received;
+    do
+    {
+        received = Receive(type, false);
+    } while (received == CNetwork::ResponseType::success && !mRTPacket->GetEvent(mState));
+
+    return true;
+} // ConnectPipelined
+
+
+void CRTProtocol::SetFastConnect(bool enable)
+{
+    mFastConnect = enable;
+}
 
 
 unsigned short CRTProtocol::GetUdpServerPort()
@@ -255,8 +439,11 @@ unsigned short CRTProtocol::GetUdpServerPort()
 
 void CRTProtocol::Disconnect()
 {
+    StopReceiveThread();
     mNetwork->Disconnect();
     mBroadcastPort = 0;
+    mReceiveStart  = 0;
+    mReceiveEnd    = 0;
     if (mRTPacket)
     {
         delete mRTPacket;
@@ -291,7 +478,7 @@ bool CRTProtocol::SetVersion(int nMajorVersion, int nMinorVersion)
 
         if (!responseStr.empty())
         {
-            sprintf(mErrorStr, "%s.", responseStr.c_str());
+            snprintf(mErrorStr, sizeof(mErrorStr), "%s.", responseStr.c_str());
         }
         else
         {
@@ -301,7 +488,7 @@ bool CRTProtocol::SetVersion(int nMajorVersion, int nMinorVersion)
     else
     {
         tempStr = std::string(mErrorStr);
-        sprintf(mErrorStr, "Send Version failed. %s.", tempStr.c_str());
+        snprintf(mErrorStr, sizeof(mErrorStr), "Send Version failed. %s.", tempStr.c_str());
     }
     return false;
 }
@@ -393,6 +580,8 @@ bool CRTProtocol::DiscoverRTServer(unsigned short nServerPort, bool bNoLocalResp
     *((unsigned int*)(data + 4))   = (unsigned int)CRTPacket::PacketDiscover;
     *((unsigned short*)(data + 8)) = htons(nServerPort);
 
+    // Read the interfaces once for the broadcast and all the responses.
+    mNetwork->RefreshInterfaces();
     if (mNetwork->SendUDPBroadcast(data, 10, nDiscoverPort))
     {
         mDiscoverResponseList.clear();
@@ -559,6 +748,23 @@ bool CRTProtocol::StreamFrames(EStreamRate eRate, unsigned int nRateArg, unsigne
 }
 
 
+bool CRTProtocol::StreamFramesMulticast(EStreamRate eRate, unsigned int nRateArg, const char* groupAddr, unsigned short nUDPPort,
+                                        unsigned int nComponentType, bool requestStream, const SComponentOptions& componentOptions, const char* interfaceAddr)
+{
+    if (!mNetwork->JoinMulticastGroup(groupAddr, nUDPPort, interfaceAddr))
+    {
+        const char* networkError = mNetwork->GetErrorString();
+        snprintf(mErrorStr, sizeof(mErrorStr), "Failed to join multicast group. %s", networkError ? networkError : "");
+        return false;
+    }
+    if (!requestStream)
+    {
+        return true;
+    }
+    return StreamFrames(eRate, nRateArg, nUDPPort, groupAddr, nComponentType, componentOptions);
+}
+
+
 bool CRTProtocol::StreamFramesStop()
 {
     if (SendCommand("StreamFrames Stop"))
@@ -613,100 +819,70 @@ bool CRTProtocol::GetState(CRTPacket::EEvent &eEvent, bool bUpdate, int nTimeout
 
 bool CRTProtocol::GetCapture(const char* pFileName, bool bC3D)
 {
-    CRTPacket::EPacketType eType;
-    std::string            responseStr;
+    return GetCapture(pFileName, bC3D, nullptr);
+}
+
 
-    mFileBuffer = fopen(pFileName, "wb");
-    if (mFileBuffer != nullptr)
+bool CRTProtocol::GetCapture(const char* fileName, bool isC3D, const CaptureProgressCallback& progress, bool mapFile)
+{
+    qualisys_cpp_sdk::CaptureFileSink sink(fileName, qualisys_cpp_sdk::CaptureFileSink::cDefaultChunkSize, mapFile);
+    if (!sink.IsOpen())
     {
-        if (bC3D)
-        {
-            // C3D file
-            if (SendCommand((mMajorVersion > 1 || mMinorVersion > 7) ? "GetCaptureC3D" : "GetCapture", responseStr))
-            {
-                if (responseStr == "Sending capture")
-                {
-                    if (Receive(eType, true, 5000000) == CNetwork::ResponseType::success) // Wait for C3D file in 5 seconds.
-                    {
-                        if (eType == CRTPacket::PacketC3DFile)
-                        {
-                            if (mFileBuffer != nullptr)
-                            {
-                                fclose(mFileBuffer);
-                                return true;
-                            }
-                            strcpy(mErrorStr, "Writing C3D file failed.");
-                        }
-                        else
-                        {
-                            strcpy(mErrorStr, "Wrong packet type received.");
-                        }
-                    }
-                    else
-                    {
-                        strcpy(mErrorStr, "No packet received.");
-                    }
-                }
-                else
-                {
-                    sprintf(mErrorStr, "%s failed.", (mMajorVersion > 1 || mMinorVersion > 7) ? "GetCaptureC3D" : "GetCapture");
-                }
-            }
-            else
-            {
-                sprintf(mErrorStr, "%s failed.", (mMajorVersion > 1 || mMinorVersion > 7) ? "GetCaptureC3D" : "GetCapture");
-            }
-        }
-        else
-        {
-            // QTM file
-            if (SendCommand("GetCaptureQTM", responseStr))
-            {
-                if (responseStr == "Sending capture")
-                {
-                    if (Receive(eType, true, 5000000) == CNetwork::ResponseType::success) // Wait for QTM file in 5 seconds.
-                    {
-                        if (eType == CRTPacket::PacketQTMFile)
-                        {
-                            if (mFileBuffer != nullptr)
-                            {
-                                fclose(mFileBuffer);
-                                return true;
-                            }
-                            strcpy(mErrorStr, "Writing QTM file failed.");
-                        }
-                        else
-                        {
-                            strcpy(mErrorStr, "Wrong packet type received.");
-                        }
-                    }
-                    else
-                    {
-                        std::string tmp = "No packet received. " + std::string(mErrorStr) + ".";
-                        std::strncpy(mErrorStr, tmp.c_str(), sizeof(mErrorStr) - 1);
-                        mErrorStr[sizeof(mErrorStr) - 1] = '\0';
-                    }
-                }
-                else
-                {
-                    strcpy(mErrorStr, "GetCaptureQTM failed.");
-                }
-            }
-            else
-            {
-                strcpy(mErrorStr, "GetCaptureQTM failed.");
-            }
-        }
+        sprintf(mErrorStr, "Failed to open %s.", fileName);
+        return false;
     }
-    if (mFileBuffer)
+    return GetCapture(sink, isC3D, progress);
+}
+
+
+bool CRTProtocol::GetCapture(std::vector<char>& buffer, bool isC3D, const CaptureProgressCallback& progress)
+{
+    qualisys_cpp_sdk::CaptureMemorySink sink(buffer);
+    if (!GetCapture(sink, isC3D, progress))
     {
-        fclose(mFileBuffer);
+        buffer.clear();
+        return false;
     }
-
-    return false;
+    return true;
 }
 
 
+bool CRTProtocol::GetCapture(qualisys_cpp_sdk::ICaptureSink& sink, bool isC3D, const CaptureProgressCallback& progress)
+{
+    const char* command = isC3D ? ((mMajorVersion > 1 || mMinorVersion > 7) ? "GetCaptureC3D" : "GetCapture") : "GetCaptureQTM";
+
+    std::string responseStr;
+    if (!SendCommand(command, responseStr) || responseStr != "Sending capture")
+    {
+        sprintf(mErrorStr, "%s failed.", command);
+        return false;
+    }
+
+    mCaptureSink     = &sink;
+    mCaptureProgress = progress;
+
+    CRTPacket::EPacketType eType;
+    auto response = Receive(eType, true, 5000000); // Wait for the file in 5 seconds.
+
+    mCaptureSink     = nullptr;
+    mCaptureProgress = nullptr;
+
+    if (response != CNetwork::ResponseType::success)
+    {
+        std::string tmp = "No packet received. " + std::string(mErrorStr) + ".";
+        std::strncpy(mErrorStr, tmp.c_str(), sizeof(mErrorStr) - 1);
+        mErrorStr[sizeof(mErrorStr) - 1] = '\0';
+        return false;
+    }
+    if (eType != (isC3D ? CRTPacket::PacketC3DFile : CRTPacket::PacketQTMFile))
+    {
+        strcpy(mErrorStr, "Wrong packet type received.");
+        return false;
+    }
+    return true;
+} // GetCapture
+
+
 bool CRTProtocol::SendTrig()
 {
     std::string responseStr;
@@ -1101,6 +1277,18 @@ void CRTProtocol::OverrideNetwork(INetwork* network)
 }
 
 
+INetwork* CRTProtocol::GetNetwork() const
+{
+    return mNetwork;
+}
+
+
+void CRTProtocol::SetPacketLog(PacketLogWriter* log)
+{
+    mPacketLog = log;
+}
+
+
 bool CRTProtocol::GetEventString(CRTPacket::EEvent eEvent, char* pStr)
 {
     switch (eEvent)
@@ -1474,166 +1662,751 @@ int CRTProtocol::ReceiveRTPacket(CRTPacket::EPacketType &eType, bool bSkipEvents
 
 CNetwork::ResponseType CRTProtocol::Receive(CRTPacket::EPacketType &eType, bool bSkipEvents, int nTimeout)
 {
-    CNetwork::Response response(CNetwork::ResponseType::error, 0);
-    unsigned int nRecvedTotal = 0;
-    unsigned int nFrameSize;
+    const bool bBigEndian = (mBigEndian || (mMajorVersion == 1 && mMinorVersion == 0));
 
     eType = CRTPacket::PacketNone;
 
     do 
     {
-        nRecvedTotal = 0;
-
-        response = mNetwork->Receive(mDataBuff.data(), (int)mDataBuff.size(), true, nTimeout);
-
-        if (response.type == CNetwork::ResponseType::timeout)
-        {
-            // Receive timeout.
-            strcpy(mErrorStr, "Data receive timeout.");
-            return CNetwork::ResponseType::timeout;
-        }
-        if (response.type == CNetwork::ResponseType::error)
-        {
-            strcpy(mErrorStr, "Socket Error.");
-            return CNetwork::ResponseType::error;
-        }
-        if (response.type == CNetwork::ResponseType::disconnect)
-        {
-            strcpy(mErrorStr, "Disconnected from server.");
-            return CNetwork::ResponseType::disconnect;
-        }        
-        if (response.received < qtmPacketHeaderSize)
+        char*              packetData;
+        unsigned long long receiveTimestamp = 0;
+        auto responseType = ReceivePacket(packetData, receiveTimestamp, bBigEndian, nTimeout);
+        if (responseType != CNetwork::ResponseType::success)
         {
-            // QTM header not received.
-            strcpy(mErrorStr, "Couldn't read header bytes.");
-            return CNetwork::ResponseType::error;
+            return responseType;
         }
-        nRecvedTotal += response.received;
 
-        bool bBigEndian = (mBigEndian || (mMajorVersion == 1 && mMinorVersion == 0));
-        nFrameSize = mRTPacket->GetSize(mDataBuff.data(), bBigEndian);
-        eType      = mRTPacket->GetType(mDataBuff.data(), bBigEndian);
-        
-        unsigned int nReadSize;
+        eType = SetPacket(packetData, receiveTimestamp, bBigEndian);
+    } while (bSkipEvents && eType == CRTPacket::PacketEvent);
+
+    return CNetwork::ResponseType::success;
+} // ReceiveRTPacket
+
+
+CNetwork::ResponseType CRTProtocol::ProcessReadable(const PacketCallback& callback, unsigned int maxPackets)
+{
+    if (mRTPacket == nullptr)
+    {
+        strcpy(mErrorStr, "Not connected.");
+        return CNetwork::ResponseType::error;
+    }
+
+    const bool bBigEndian = (mBigEndian || (mMajorVersion == 1 && mMinorVersion == 0));
+
+    mLargePacket.Reset();
 
-        if (eType == CRTPacket::PacketC3DFile || eType == CRTPacket::PacketQTMFile)
+    unsigned int delivered = 0;
+    while (true)
+    {
+        // Deliver all complete packets in the buffer, they were all read already.
+        while (mReceiveEnd - mReceiveStart >= qtmPacketHeaderSize)
         {
-            if (mFileBuffer != nullptr)
+            char* data = mReceiveBuffer.data() + mReceiveStart;
+            const unsigned int frameSize = CRTPacket::GetSize(data, bBigEndian);
+            if (frameSize < qtmPacketHeaderSize)
             {
-                rewind(mFileBuffer); // Start from the beginning
-                if (fwrite(mDataBuff.data() + sizeof(int) * 2, 1, nRecvedTotal - sizeof(int) * 2, mFileBuffer) !=
-                    nRecvedTotal - sizeof(int) * 2)
-                {
-                    strcpy(mErrorStr, "Failed to write file to disk.");
-                    fclose(mFileBuffer);
-                    mFileBuffer = nullptr;
-                    return CNetwork::ResponseType::error;
-                }
-                // Receive more data until we have read the whole packet
-                while (nRecvedTotal < nFrameSize) 
-                {
-                    nReadSize = nFrameSize - nRecvedTotal;
-                    if (nFrameSize > mDataBuff.size())                                                                                                                                                                                                                                                                                             
-                    {
-                        nReadSize = (int)mDataBuff.size();
-                    }
-                    // As long as we haven't received enough data, wait for more
-                    response = mNetwork->Receive(&(mDataBuff.data()[sizeof(int) * 2]), nReadSize, false, cWaitForDataTimeout);
-                    if (response.type == CNetwork::ResponseType::timeout)
-                    {
-                        strcpy(mErrorStr, "Packet truncated.");
-                        return CNetwork::ResponseType::error;
-                    }
-                    if (response.type == CNetwork::ResponseType::error)
-                    {
-                        strcpy(mErrorStr, "Socket Error.");
-                        fclose(mFileBuffer);
-                        mFileBuffer = nullptr;
-                        return CNetwork::ResponseType::error;
-                    }
-                    if (response.type == CNetwork::ResponseType::disconnect)
-                    {
-                        strcpy(mErrorStr, "Disconnected from server.");
-                        return CNetwork::ResponseType::disconnect;
-                    }
-
-                    if (fwrite(mDataBuff.data() + sizeof(int) * 2, 1, response.received, mFileBuffer) != static_cast<std::size_t>(response.received))
-                    {
-                        strcpy(mErrorStr, "Failed to write file to disk.");
-                        fclose(mFileBuffer);
-                        mFileBuffer = nullptr;
-                        return CNetwork::ResponseType::error;
-                    }
-                    nRecvedTotal += response.received;
-                }
+                strcpy(mErrorStr, "Invalid packet size.");
+                mReceiveStart = mReceiveEnd = 0;
+                return CNetwork::ResponseType::error;
             }
-            else
+
+            // Never buffered, see ReceivePacket.
+            const auto type = CRTPacket::GetType(data, bBigEndian);
+            if (type == CRTPacket::PacketC3DFile || type == CRTPacket::PacketQTMFile)
             {
-                strcpy(mErrorStr, "Receive file buffer not opened.");
-                if (mFileBuffer)
+                char* packetData;
+                unsigned long long receiveTimestamp;
+                const auto response = ReceiveFile(packetData, receiveTimestamp, frameSize);
+                if (response != CNetwork::ResponseType::success)
                 {
-                    fclose(mFileBuffer);
+                    return response;
                 }
-                mFileBuffer = nullptr;
-                return CNetwork::ResponseType::error;
-            }
-        }
-        else
-        {
-            if (nFrameSize > mDataBuff.size())
-            {
-                mDataBuff.resize(nFrameSize);
+                callback(SetPacket(packetData, receiveTimestamp, bBigEndian), mRTPacket);
+                delivered++;
+                continue;
             }
 
-            // Receive more data until we have read the whole packet
-            while (nRecvedTotal < nFrameSize) 
+            if (mReceiveEnd - mReceiveStart < frameSize)
             {
-                // As long as we haven't received enough data, wait for more
-                response = mNetwork->Receive(&(mDataBuff.data()[nRecvedTotal]), nFrameSize - nRecvedTotal, false, -1);
-                if (response.type == CNetwork::ResponseType::timeout)
-                {
-                    strcpy(mErrorStr, "Packet truncated.");
-                    return CNetwork::ResponseType::error;
-                }
-                if (response.type == CNetwork::ResponseType::error)
-                {
-                    strcpy(mErrorStr, "Socket Error.");
-                    return CNetwork::ResponseType::error;
-                }
-                if (response.type == CNetwork::ResponseType::disconnect)
-                {
-                    strcpy(mErrorStr, "Disconnected from server.");
-                    return CNetwork::ResponseType::disconnect;
-                }
-                nRecvedTotal += response.received;
+                break;
             }
+            mReceiveStart += frameSize;
+            callback(SetPacket(data, mReceiveTimestamp, bBigEndian), mRTPacket);
+            delivered++;
+        }
+        if (delivered >= maxPackets)
+        {
+            return CNetwork::ResponseType::success;
         }
 
-        mRTPacket->SetData(mDataBuff.data());
-
-        if (mRTPacket->GetEvent(mLastEvent)) // Update last event if there is an event
+        const unsigned int buffered = mReceiveEnd - mReceiveStart;
+        unsigned int frameSize = 0;
+        if (buffered == 0)
         {
-            if (mLastEvent != CRTPacket::EventCameraSettingsChanged)
+            mReceiveStart = mReceiveEnd = 0;
+            if (mReceiveBuffer.size() > cReceiveBufferSize)
             {
-                mState = mLastEvent;
+                std::vector<char>(cReceiveBufferSize).swap(mReceiveBuffer);
             }
         }
-    } while (bSkipEvents && eType == CRTPacket::PacketEvent);
-    
-    if (nRecvedTotal == nFrameSize)
-    {
-        return CNetwork::ResponseType::success;
-    }
-    strcpy(mErrorStr, "Packet truncated.");
-
-    return CNetwork::ResponseType::error;
-} // ReceiveRTPacket
+        else if (buffered >= qtmPacketHeaderSize)
+        {
+            frameSize = CRTPacket::GetSize(mReceiveBuffer.data() + mReceiveStart, bBigEndian);
+        }
+        // Room for the whole partial packet, and for a whole datagram in case UDP data arrives.
+        ReserveReceiveBuffer(std::max(cReceiveBufferMinFree, frameSize > buffered ? frameSize - buffered : 0u));
 
+        char* readPos = mReceiveBuffer.data() + mReceiveEnd;
+        auto response = mNetwork->Receive(readPos, (int)(mReceiveBuffer.size() - mReceiveEnd), false, 0);
 
-CRTPacket* CRTProtocol::GetRTPacket()
-{
-    return mRTPacket;
-}
+        if (response.type == CNetwork::ResponseType::timeout)
+        {
+            return CNetwork::ResponseType::success; // Nothing more to read
+        }
+        if (response.type == CNetwork::ResponseType::error)
+        {
+            strcpy(mErrorStr, "Socket Error.");
+            mReceiveStart = mReceiveEnd = 0;
+            return CNetwork::ResponseType::error;
+        }
+        if (response.type == CNetwork::ResponseType::disconnect)
+        {
+            strcpy(mErrorStr, "Disconnected from server.");
+            mReceiveStart = mReceiveEnd = 0;
+            return CNetwork::ResponseType::disconnect;
+        }
+
+        if (response.datagram)
+        {
+            // UDP datagram, always one whole packet.
+            if (response.received < qtmPacketHeaderSize || CRTPacket::GetSize(readPos, bBigEndian) != (unsigned int)response.received)
+            {
+                strcpy(mErrorStr, "Packet truncated.");
+                return CNetwork::ResponseType::error;
+            }
+            callback(SetPacket(readPos, response.timestamp, bBigEndian), mRTPacket);
+            delivered++;
+            continue;
+        }
+
+        mReceiveEnd += response.received;
+        mReceiveTimestamp = response.timestamp;
+    }
+} // ProcessReadable
+
+
+// Make mRTPacket the received packet, and track the server state from events.
+CRTPacket::EPacketType CRTProtocol::SetPacket(char* packetData, unsigned long long receiveTimestamp, bool bigEndian)
+{
+    const auto type = mRTPacket->GetType(packetData, bigEndian);
+
+    mRTPacket->SetData(packetData);
+    mRTPacket->SetReceiveTimestamp(receiveTimestamp);
+
+    if (mPacketLog != nullptr && type == CRTPacket::PacketData)
+    {
+        mPacketLog->Append(*mRTPacket);
+    }
+
+    if (mRTPacket->GetEvent(mLastEvent)) // Update last event if there is an event
+    {
+        if (mLastEvent != CRTPacket::EventCameraSettingsChanged)
+        {
+            mState = mLastEvent;
+        }
+    }
+    return type;
+} // SetPacket
+
+
+// Make sure there are at least size free bytes after mReceiveEnd. The buffered data is moved to the
+// front of the buffer first, and the buffer only grows if that isn't enough.
+void CRTProtocol::ReserveReceiveBuffer(unsigned int size)
+{
+    if (mReceiveBuffer.size() - mReceiveEnd < size)
+    {
+        if (mReceiveStart > 0)
+        {
+            memmove(mReceiveBuffer.data(), mReceiveBuffer.data() + mReceiveStart, mReceiveEnd - mReceiveStart);
+            mReceiveEnd  -= mReceiveStart;
+            mReceiveStart = 0;
+        }
+        if (mReceiveBuffer.size() - mReceiveEnd < size)
+        {
+            mReceiveBuffer.resize(mReceiveEnd + size);
+        }
+    }
+} // ReserveReceiveBuffer
+
+
+// Get the next complete packet. TCP data is read into mReceiveBuffer, as much as is available per
+// read, and packets are sliced out of it in place. Several back-to-back packets are thereby delivered
+// from one read, and the payload is never copied. Only the start of a partial packet is moved to the
+// front of the buffer when it runs out of space at the end. UDP datagrams are read into the free space
+// after the buffered TCP data and delivered from there, without being added to the TCP stream.
+// Networks with HasPacketReceive, e.g. a packet log, hand out whole packets in place instead.
+// The packet is valid until the next call. receiveTimestamp is the time of the read that completed it.
+CNetwork::ResponseType CRTProtocol::ReceivePacket(char*& packetData, unsigned long long& receiveTimestamp, bool bigEndian, int timeout)
+{
+    mLargePacket.Reset();
+
+    if (mNetwork->HasPacketReceive())
+    {
+        auto response = mNetwork->ReceivePacket(packetData, timeout);
+        if (response.type == CNetwork::ResponseType::timeout)
+        {
+            strcpy(mErrorStr, "Data receive timeout.");
+        }
+        else if (response.type == CNetwork::ResponseType::error)
+        {
+            sprintf(mErrorStr, "%s", mNetwork->GetErrorString());
+        }
+        else if (response.type == CNetwork::ResponseType::disconnect)
+        {
+            strcpy(mErrorStr, "Disconnected from server.");
+        }
+        else if (response.received < qtmPacketHeaderSize || CRTPacket::GetSize(packetData, bigEndian) != (unsigned int)response.received)
+        {
+            strcpy(mErrorStr, "Invalid packet size.");
+            return CNetwork::ResponseType::error;
+        }
+        receiveTimestamp = response.timestamp;
+        return response.type;
+    }
+
+    while (true)
+    {
+        const unsigned int buffered = mReceiveEnd - mReceiveStart;
+        unsigned int frameSize = 0;
+
+        if (buffered >= qtmPacketHeaderSize)
+        {
+            char* data = mReceiveBuffer.data() + mReceiveStart;
+            frameSize = CRTPacket::GetSize(data, bigEndian);
+            if (frameSize < qtmPacketHeaderSize)
+            {
+                strcpy(mErrorStr, "Invalid packet size.");
+                mReceiveStart = mReceiveEnd = 0;
+                return CNetwork::ResponseType::error;
+            }
+
+            const auto type = CRTPacket::GetType(data, bigEndian);
+            if (type == CRTPacket::PacketC3DFile || type == CRTPacket::PacketQTMFile)
+            {
+                return ReceiveFile(packetData, receiveTimestamp, frameSize);
+            }
+
+            if (buffered >= frameSize)
+            {
+                // All complete packets in the buffer were completed by the last read.
+                packetData = data;
+                receiveTimestamp = mReceiveTimestamp;
+                mReceiveStart += frameSize;
+                if (mReceiveStart == mReceiveEnd)
+                {
+                    mReceiveStart = mReceiveEnd = 0;
+                }
+                return CNetwork::ResponseType::success;
+            }
+
+            if (frameSize > cReceiveBufferMinFree)
+            {
+                auto frame = mFramePool->Acquire(frameSize);
+                if (frame)
+                {
+                    return ReceiveLargePacket(packetData, receiveTimestamp, std::move(frame), frameSize);
+                }
+                // All pool buffers are in use, fall back to growing the receive buffer.
+            }
+        }
+        else if (buffered == 0 && mReceiveBuffer.size() > cReceiveBufferSize)
+        {
+            // Give back memory from a fallback above.
+            std::vector<char>(cReceiveBufferSize).swap(mReceiveBuffer);
+        }
+
+        // Make room for the rest of the packet, and for a whole datagram in case UDP data arrives.
+        ReserveReceiveBuffer(std::max(cReceiveBufferMinFree, frameSize > buffered ? frameSize - buffered : 0u));
+
+        // Only the wait for a new packet is limited by the timeout. The rest of a packet is waited for.
+        char* readPos = mReceiveBuffer.data() + mReceiveEnd;
+        const int readSize = (int)(mReceiveBuffer.size() - mReceiveEnd);
+        auto response = buffered == 0 ? mNetwork->Receive(readPos, readSize, false, timeout) : mNetwork->ReceiveRest(readPos, readSize, -1);
+
+        if (response.type == CNetwork::ResponseType::timeout)
+        {
+            if (buffered == 0)
+            {
+                strcpy(mErrorStr, "Data receive timeout.");
+                return CNetwork::ResponseType::timeout;
+            }
+            strcpy(mErrorStr, "Packet truncated.");
+            mReceiveStart = mReceiveEnd = 0;
+            return CNetwork::ResponseType::error;
+        }
+        if (response.type == CNetwork::ResponseType::error)
+        {
+            strcpy(mErrorStr, "Socket Error.");
+            mReceiveStart = mReceiveEnd = 0;
+            return CNetwork::ResponseType::error;
+        }
+        if (response.type == CNetwork::ResponseType::disconnect)
+        {
+            strcpy(mErrorStr, "Disconnected from server.");
+            mReceiveStart = mReceiveEnd = 0;
+            return CNetwork::ResponseType::disconnect;
+        }
+
+        if (response.datagram)
+        {
+            // UDP datagram, always one whole packet.
+            if (response.received < qtmPacketHeaderSize)
+            {
+                strcpy(mErrorStr, "Couldn't read header bytes.");
+                return CNetwork::ResponseType::error;
+            }
+            if (CRTPacket::GetSize(readPos, bigEndian) != (unsigned int)response.received)
+            {
+                strcpy(mErrorStr, "Packet truncated.");
+                return CNetwork::ResponseType::error;
+            }
+            packetData = readPos;
+            receiveTimestamp = response.timestamp;
+            return CNetwork::ResponseType::success;
+        }
+
+        mReceiveEnd += response.received;
+        mReceiveTimestamp = response.timestamp;
+    }
+} // ReceivePacket
+
+
+// Receive the rest of a packet, that starts at mReceiveStart, straight into a pool buffer, so that the
+// receive buffer doesn't have to grow to the size of the largest packet.
+CNetwork::ResponseType CRTProtocol::ReceiveLargePacket(char*& packetData, unsigned long long& receiveTimestamp, FrameHandle frame, unsigned int frameSize)
+{
+    char* data = frame.GetData();
+
+    unsigned int nRecvedTotal = mReceiveEnd - mReceiveStart;
+    memcpy(data, mReceiveBuffer.data() + mReceiveStart, nRecvedTotal);
+    mReceiveStart = mReceiveEnd = 0;
+
+    while (nRecvedTotal < frameSize)
+    {
+        // Read exactly the rest of the packet, any following packets end up in the receive buffer later.
+        auto response = mNetwork->ReceiveRest(data + nRecvedTotal, frameSize - nRecvedTotal, -1);
+        if (response.type == CNetwork::ResponseType::timeout)
+        {
+            strcpy(mErrorStr, "Packet truncated.");
+            return CNetwork::ResponseType::error;
+        }
+        if (response.type == CNetwork::ResponseType::error)
+        {
+            strcpy(mErrorStr, "Socket Error.");
+            return CNetwork::ResponseType::error;
+        }
+        if (response.type == CNetwork::ResponseType::disconnect)
+        {
+            strcpy(mErrorStr, "Disconnected from server.");
+            return CNetwork::ResponseType::disconnect;
+        }
+        if (response.datagram)
+        {
+            continue; // Streamed UDP frame in the middle of a TCP packet. It is overwritten by the next read.
+        }
+        nRecvedTotal += response.received;
+        receiveTimestamp = response.timestamp;
+    }
+
+    mLargePacket = std::move(frame);
+    packetData = data;
+    return CNetwork::ResponseType::success;
+} // ReceiveLargePacket
+
+
+// Receive a C3D or QTM file packet, which starts at mReceiveStart, into mCaptureSink. The file is received
+// straight into the buffers of the sink, so it never has to fit in memory. packetData is set to a copy of
+// the packet header.
+CNetwork::ResponseType CRTProtocol::ReceiveFile(char*& packetData, unsigned long long& receiveTimestamp, unsigned int frameSize)
+{
+    char* data = mReceiveBuffer.data() + mReceiveStart;
+
+    memcpy(mDataBuff.data(), data, qtmPacketHeaderSize);
+    packetData = mDataBuff.data();
+    receiveTimestamp = mReceiveTimestamp;
+
+    if (mCaptureSink == nullptr)
+    {
+        strcpy(mErrorStr, "Receive file buffer not opened.");
+        mReceiveStart = mReceiveEnd = 0;
+        return CNetwork::ResponseType::error;
+    }
+    auto& sink = *mCaptureSink;
+
+    auto fail = [this, &sink](const char* error, CNetwork::ResponseType type)
+    {
+        strcpy(mErrorStr, error);
+        sink.End(false);
+        mReceiveStart = mReceiveEnd = 0;
+        return type;
+    };
+
+    const unsigned int fileSize = frameSize - qtmPacketHeaderSize;
+    if (!sink.Begin(fileSize))
+    {
+        return fail(sink.GetErrorString(), CNetwork::ResponseType::error);
+    }
+
+    // The start of the file that is already in the receive buffer.
+    const unsigned int buffered = std::min(mReceiveEnd - mReceiveStart, frameSize) - qtmPacketHeaderSize;
+    unsigned int nRecvedTotal = 0;
+    while (nRecvedTotal < buffered)
+    {
+        unsigned int size;
+        char* writeBuffer = sink.GetWriteBuffer(size);
+        if (writeBuffer == nullptr)
+        {
+            return fail(sink.GetErrorString(), CNetwork::ResponseType::error);
+        }
+        size = std::min(size, buffered - nRecvedTotal);
+        memcpy(writeBuffer, data + qtmPacketHeaderSize + nRecvedTotal, size);
+        nRecvedTotal += size;
+        if (!sink.Commit(size))
+        {
+            return fail(sink.GetErrorString(), CNetwork::ResponseType::error);
+        }
+    }
+    mReceiveStart += qtmPacketHeaderSize + buffered;
+    if (mReceiveStart == mReceiveEnd)
+    {
+        mReceiveStart = mReceiveEnd = 0;
+    }
+    if (mCaptureProgress && buffered > 0)
+    {
+        mCaptureProgress(nRecvedTotal, fileSize);
+    }
+
+    // Receive the rest. The receive buffer is empty here.
+    while (nRecvedTotal < fileSize)
+    {
+        unsigned int size;
+        char* writeBuffer = sink.GetWriteBuffer(size);
+        if (writeBuffer == nullptr)
+        {
+            return fail(sink.GetErrorString(), CNetwork::ResponseType::error);
+        }
+        size = std::min(size, fileSize - nRecvedTotal);
+
+        auto response = mNetwork->Receive(writeBuffer, (int)size, false, cWaitForDataTimeout);
+        if (response.type == CNetwork::ResponseType::timeout)
+        {
+            return fail("Packet truncated.", CNetwork::ResponseType::error);
+        }
+        if (response.type == CNetwork::ResponseType::error)
+        {
+            return fail("Socket Error.", CNetwork::ResponseType::error);
+        }
+        if (response.type == CNetwork::ResponseType::disconnect)
+        {
+            return fail("Disconnected from server.", CNetwork::ResponseType::disconnect);
+        }
+        if (response.datagram)
+        {
+            continue; // Streamed UDP frame, not part of the file. It is overwritten by the next read.
+        }
+
+        nRecvedTotal += response.received;
+        receiveTimestamp = response.timestamp;
+        if (!sink.Commit(response.received))
+        {
+            return fail(sink.GetErrorString(), CNetwork::ResponseType::error);
+        }
+        if (mCaptureProgress)
+        {
+            mCaptureProgress(nRecvedTotal, fileSize);
+        }
+    }
+
+    if (!sink.End(true))
+    {
+        strcpy(mErrorStr, sink.GetErrorString());
+        return CNetwork::ResponseType::error;
+    }
+    return CNetwork::ResponseType::success;
+} // ReceiveFile
+
+
+CRTPacket* CRTProtocol::GetRTPacket()
+{
+    return mRTPacket;
+}
+
+
+void CRTProtocol::ReservePacketIndex()
+{
+    // 2D, 2D linearized and image per camera, analog and force in both their forms, one timecode.
+    mPacketIndexSize = 3 * GetCameraCount() + 2 * GetAnalogDeviceCount() + 2 * GetForcePlateCount() +
+                       GetGazeVectorCount() + GetEyeTrackerCount() + GetSkeletonCount() + 1;
+    if (mRTPacket != nullptr)
+    {
+        mRTPacket->ReserveIndex(mPacketIndexSize);
+    }
+    for (auto& packet : mBatchPackets)
+    {
+        packet.ReserveIndex(mPacketIndexSize);
+    }
+}
+
+
+FrameHandle CRTProtocol::GetFrameHandle()
+{
+    char*        data = nullptr;
+    unsigned int size = 0;
+    if (mRTPacket != nullptr)
+    {
+        mRTPacket->GetData(data, size);
+    }
+    if (data == nullptr)
+    {
+        strcpy(mErrorStr, "No packet received.");
+        return FrameHandle();
+    }
+
+    unsigned int majorVersion;
+    unsigned int minorVersion;
+    mRTPacket->GetVersion(majorVersion, minorVersion);
+    const bool bigEndian = mRTPacket->GetEndianness();
+
+    if (mLargePacket && mLargePacket.GetData() == data)
+    {
+        if (mLargePacket->GetSize() == 0)
+        {
+            mLargePacket.Parse(majorVersion, minorVersion, bigEndian);
+            mLargePacket->SetReceiveTimestamp(mRTPacket->GetReceiveTimestamp());
+        }
+        return mLargePacket;
+    }
+
+    auto frame = mFramePool->Copy(*mRTPacket);
+    if (!frame)
+    {
+        strcpy(mErrorStr, "All frame pool buffers are in use.");
+    }
+    return frame;
+} // GetFrameHandle
+
+
+void CRTProtocol::SetFramePoolSize(unsigned int blockCount, unsigned int maxRetainedSize)
+{
+    mLargePacket.Reset();
+    mFramePool.reset(new FramePool(blockCount, maxRetainedSize));
+} // SetFramePoolSize
+
+
+void CRTProtocol::SetBatchRingSize(unsigned int frameCount)
+{
+    mBatchRingSize = std::max(frameCount, 1u);
+    mBatchBuffer.clear();
+    mBatchBuffer.shrink_to_fit();
+    mBatchPackets.clear();
+    mBatchHead  = 0;
+    mBatchStart = 0;
+    mBatchCount = 0;
+} // SetBatchRingSize
+
+
+CNetwork::ResponseType CRTProtocol::ReceiveBatch(unsigned int &frameCount, unsigned int maxFrames, int timeout)
+{
+    frameCount  = 0;
+    mBatchCount = 0;
+
+    if (mRTPacket == nullptr)
+    {
+        strcpy(mErrorStr, "Not connected.");
+        return CNetwork::ResponseType::error;
+    }
+
+    // The ring is allocated on first use, so clients that never batch don't pay for it.
+    if (mBatchBuffer.empty())
+    {
+        mBatchBuffer.resize((std::size_t)mBatchRingSize * cBatchSlotSize);
+        mBatchSlots.resize(mBatchRingSize);
+        mBatchSizes.resize(mBatchRingSize);
+        mBatchTimestamps.resize(mBatchRingSize);
+        mBatchPackets.assign(mBatchRingSize, CRTPacket());
+        for (auto& packet : mBatchPackets)
+        {
+            packet.ReserveIndex(mPacketIndexSize);
+        }
+    }
+
+    maxFrames = std::min(maxFrames, mBatchRingSize);
+    for (unsigned int i = 0; i < maxFrames; i++)
+    {
+        mBatchSlots[i] = mBatchBuffer.data() + (std::size_t)((mBatchHead + i) % mBatchRingSize) * cBatchSlotSize;
+    }
+
+    auto response = mNetwork->ReceiveUdpBatch(mBatchSlots.data(), cBatchSlotSize, mBatchSizes.data(), (int)maxFrames, timeout, mBatchTimestamps.data());
+
+    if (response.type == CNetwork::ResponseType::timeout)
+    {
+        strcpy(mErrorStr, "Data receive timeout.");
+        return CNetwork::ResponseType::timeout;
+    }
+    if (response.type == CNetwork::ResponseType::error)
+    {
+        sprintf(mErrorStr, "Socket Error. %s", mNetwork->GetErrorString());
+        return CNetwork::ResponseType::error;
+    }
+    if (response.type == CNetwork::ResponseType::disconnect)
+    {
+        strcpy(mErrorStr, "Disconnected from server.");
+        return CNetwork::ResponseType::disconnect;
+    }
+
+    unsigned int majorVersion;
+    unsigned int minorVersion;
+    mRTPacket->GetVersion(majorVersion, minorVersion);
+    const bool bigEndian = (mBigEndian || (mMajorVersion == 1 && mMinorVersion == 0));
+
+    // Datagrams that don't hold exactly one complete packet are dropped and counted. Valid frames are
+    // kept in consecutive ring slots.
+    mBatchStart = mBatchHead;
+    for (int i = 0; i < response.received; i++)
+    {
+        char* data = mBatchSlots[i];
+        if (mBatchSizes[i] < qtmPacketHeaderSize || CRTPacket::GetSize(data, bigEndian) != (unsigned int)mBatchSizes[i])
+        {
+            mBatchDroppedCount++;
+            continue;
+        }
+        const unsigned int slot = mBatchHead;
+        if (data != mBatchSlots[mBatchCount])
+        {
+            memmove(mBatchSlots[mBatchCount], data, mBatchSizes[i]);
+            data = mBatchSlots[mBatchCount];
+        }
+        CRTPacket& packet = mBatchPackets[slot];
+        packet.SetVersion(majorVersion, minorVersion);
+        packet.SetEndianness(bigEndian);
+        packet.SetData(data);
+        packet.SetReceiveTimestamp(mBatchTimestamps[i]);
+        if (mPacketLog != nullptr)
+        {
+            mPacketLog->Append(packet);
+        }
+        mBatchHead = (mBatchHead + 1) % mBatchRingSize;
+        mBatchCount++;
+    }
+
+    frameCount = mBatchCount;
+    return CNetwork::ResponseType::success;
+} // ReceiveBatch
+
+
+CRTPacket* CRTProtocol::GetBatchPacket(unsigned int index)
+{
+    if (index >= mBatchCount)
+    {
+        return nullptr;
+    }
+    return &mBatchPackets[(mBatchStart + index) % mBatchRingSize];
+} // GetBatchPacket
+
+
+unsigned int CRTProtocol::GetDroppedDatagramCount() const
+{
+    return mBatchDroppedCount;
+}
+
+
+bool CRTProtocol::StartReceiveThread(unsigned int queueSize, EReceiveThreadMode mode)
+{
+    if (mRTPacket == nullptr || !mNetwork->Connected())
+    {
+        strcpy(mErrorStr, "Not connected.");
+        return false;
+    }
+    StopReceiveThread();
+
+    mFrameQueue.reset(new FrameQueue(queueSize));
+    mFrameMailbox.reset(mode == EReceiveThreadMode::ReceiveLatestFrame ? new FrameMailbox() : nullptr);
+    mStopReceiveThread    = false;
+    mReceiveThreadRunning = true;
+    mReceiveThread = std::thread([this]() { ReceiveThread(); });
+    return true;
+} // StartReceiveThread
+
+
+void CRTProtocol::StopReceiveThread()
+{
+    mStopReceiveThread = true;
+    if (mReceiveThread.joinable())
+    {
+        mReceiveThread.join();
+    }
+} // StopReceiveThread
+
+
+bool CRTProtocol::IsReceiveThreadRunning() const
+{
+    return mReceiveThreadRunning;
+}
+
+
+CRTPacket* CRTProtocol::PopFrame()
+{
+    return mFrameQueue ? mFrameQueue->Pop() : nullptr;
+}
+
+
+unsigned int CRTProtocol::GetDroppedFrameCount() const
+{
+    return mFrameQueue ? mFrameQueue->GetDroppedCount() : 0;
+}
+
+
+CRTPacket* CRTProtocol::GetLatestFrame()
+{
+    return mFrameMailbox ? mFrameMailbox->Read() : nullptr;
+}
+
+
+unsigned int CRTProtocol::GetSkippedFrameCount() const
+{
+    return mFrameMailbox ? mFrameMailbox->GetSkippedCount() : 0;
+}
+
+
+void CRTProtocol::ReceiveThread()
+{
+    // Short timeout, so that a stop request is noticed also when no data is streamed.
+    const int pollTimeout = 100000; // 100 ms
+
+    while (!mStopReceiveThread)
+    {
+        CRTPacket::EPacketType type;
+        auto response = Receive(type, false, pollTimeout);
+        if (response == CNetwork::ResponseType::timeout)
+        {
+            continue;
+        }
+        if (response != CNetwork::ResponseType::success)
+        {
+            break;
+        }
+
+        if (mFrameMailbox && type == CRTPacket::PacketData)
+        {
+            mFrameMailbox->Write(*mRTPacket);
+        }
+        else
+        {
+            mFrameQueue->Push(*mRTPacket);
+        }
+    }
+    mReceiveThreadRunning = false;
+} // ReceiveThread
 
 
 const char * CRTProtocol::ReadSettings(const std::string& settingsType)
@@ -1841,6 +2614,129 @@ bool CRTProtocol::ReadSkeletonSettings(bool& bDataAvailable, bool skeletonGlobal
     return deserializer.DeserializeSkeletonSettings(skeletonGlobalData, mSkeletonSettingsHierarchical, mSkeletonSettings, bDataAvailable);
 }
 
+bool CRTProtocol::ReadAllSettings(unsigned int settings, unsigned int* availableSettings)
+{
+    if (availableSettings != nullptr)
+    {
+        *availableSettings = 0;
+    }
+    if (settings & cSettingsSkeletonGlobal)
+    {
+        settings &= ~cSettingsSkeleton;
+    }
+
+    static const struct
+    {
+        unsigned int flag;
+        const char*  name;
+    } sections[] =
+    {
+        { cSettingsGeneral,        "General" },
+        { cSettings3d,             "3D" },
+        { cSettings6d,             "6D" },
+        { cSettingsGazeVector,     "GazeVector" },
+        { cSettingsEyeTracker,     "EyeTracker" },
+        { cSettingsAnalog,         "Analog" },
+        { cSettingsForce,          "Force" },
+        { cSettingsImage,          "Image" },
+        { cSettingsSkeleton,       "Skeleton" },
+        { cSettingsSkeletonGlobal, "Skeleton:global" }
+    };
+
+    std::string settingsTypes;
+    for (const auto& section : sections)
+    {
+        if (settings & section.flag)
+        {
+            settingsTypes += settingsTypes.empty() ? "" : " ";
+            settingsTypes += section.name;
+        }
+    }
+    if (settingsTypes.empty())
+    {
+        return true;
+    }
+
+    const char* data = ReadSettings(settingsTypes);
+    if (!data)
+    {
+        return false;
+    }
+
+    SettingsDeserializer deserializer(data, mMajorVersion, mMinorVersion);
+    bool result = true;
+    bool dataAvailable = false;
+    auto deserialized = [&](unsigned int flag, bool success)
+    {
+        result = result && success;
+        if (success && dataAvailable && availableSettings != nullptr)
+        {
+            *availableSettings |= flag;
+        }
+    };
+
+    // General first, 6DOF settings depend on it.
+    if (settings & cSettingsGeneral)
+    {
+        mGeneralSettings.vsCameras.clear();
+        dataAvailable = true;
+        deserialized(cSettingsGeneral, deserializer.DeserializeGeneralSettings(mGeneralSettings));
+    }
+    if (settings & cSettings3d)
+    {
+        m3DSettings.s3DLabels.clear();
+        m3DSettings.pCalibrationTime[0] = 0;
+        dataAvailable = false;
+        deserialized(cSettings3d, deserializer.Deserialize3DSettings(m3DSettings, dataAvailable));
+    }
+    if (settings & cSettings6d)
+    {
+        m6DOFSettings.clear();
+        dataAvailable = false;
+        deserialized(cSettings6d, deserializer.Deserialize6DOFSettings(m6DOFSettings, mGeneralSettings, dataAvailable));
+    }
+    if (settings & cSettingsGazeVector)
+    {
+        mGazeVectorSettings.clear();
+        dataAvailable = false;
+        deserialized(cSettingsGazeVector, deserializer.DeserializeGazeVectorSettings(mGazeVectorSettings, dataAvailable));
+    }
+    if (settings & cSettingsEyeTracker)
+    {
+        mEyeTrackerSettings.clear();
+        dataAvailable = false;
+        deserialized(cSettingsEyeTracker, deserializer.DeserializeEyeTrackerSettings(mEyeTrackerSettings, dataAvailable));
+    }
+    if (settings & cSettingsAnalog)
+    {
+        mAnalogDeviceSettings.clear();
+        dataAvailable = false;
+        deserialized(cSettingsAnalog, deserializer.DeserializeAnalogSettings(mAnalogDeviceSettings, dataAvailable));
+    }
+    if (settings & cSettingsForce)
+    {
+        mForceSettings.vsForcePlates.clear();
+        dataAvailable = false;
+        deserialized(cSettingsForce, deserializer.DeserializeForceSettings(mForceSettings, dataAvailable));
+    }
+    if (settings & cSettingsImage)
+    {
+        mImageSettings.clear();
+        dataAvailable = false;
+        deserialized(cSettingsImage, deserializer.DeserializeImageSettings(mImageSettings, dataAvailable));
+    }
+    if (settings & (cSettingsSkeleton | cSettingsSkeletonGlobal))
+    {
+        const bool skeletonGlobalData = (settings & cSettingsSkeletonGlobal) != 0;
+        mSkeletonSettings.clear();
+        mSkeletonSettingsHierarchical.clear();
+        dataAvailable = false;
+        deserialized(skeletonGlobalData ? cSettingsSkeletonGlobal : cSettingsSkeleton,
+                     deserializer.DeserializeSkeletonSettings(skeletonGlobalData, mSkeletonSettingsHierarchical, mSkeletonSettings, dataAvailable));
+    }
+    return result;
+} // ReadAllSettings
+
 bool CRTProtocol::ReceiveCalibrationSettings(int timeout)
 {
     CRTPacket::EPacketType  eType;
@@ -2892,6 +3788,12 @@ bool CRTProtocol::SendCommand(const char* pCmdStr)
 } // SendCommand
 
 
+bool CRTProtocol::PostCommand(const char* command)
+{
+    return SendCommand(command);
+} // PostCommand
+
+
 bool CRTProtocol::SendCommand(const std::string& cmdStr, std::string& commandResponseStr, unsigned int timeout)
 {
     if (SendString(cmdStr.c_str(), CRTPacket::PacketCommand))
@@ -5,6 +5,10 @@
 #include "RTPacket.h"
 #include "Network.h"
 #include "Settings.h"
+#include "FrameQueue.h"
+#include "FramePool.h"
+#include "CaptureSink.h"
+#include "PacketLog.h"
 
 #include <vector>
 #include <string>
@@ -12,6 +16,9 @@
 #include <limits>
 #include <cstdint>
 #include <memory>
+#include <atomic>
+#include <thread>
+#include <functional>
 
 #ifdef _MSC_VER
 #pragma warning (disable : 4251)
@@ -38,6 +45,13 @@ public:
     static const unsigned int cWaitForSaveTimeout        = 30000000;  // 30 s
     static const unsigned int cWaitForCalibrationTimeout = 600000000; // 10 min
 
+    static const unsigned int cDefaultBatchRingSize      = 64;        // Frames
+    static const unsigned int cBatchSlotSize             = 65536;     // Bytes, max UDP datagram size
+    static const unsigned int cDefaultReceiveQueueSize   = 256;       // Packets
+    static const unsigned int cDefaultFramePoolSize      = 16;        // Packets
+    static const unsigned int cDefaultFrameRetainedSize  = 4194304;   // Bytes, 4 MB
+    static const unsigned int cDefaultMaxReadablePackets = 64;        // Packets, per ProcessReadable call
+
     static const unsigned int cComponent3d            = 0x000001;
     static const unsigned int cComponent3dNoLabels    = 0x000002;
     static const unsigned int cComponentAnalog        = 0x000004;
@@ -58,6 +72,19 @@ public:
     static const unsigned int cComponentSkeleton      = 0x020000;
     static const unsigned int cComponentEyeTracker    = 0x040000;
 
+    // Settings for ReadAllSettings.
+    static const unsigned int cSettingsGeneral        = 0x0001;
+    static const unsigned int cSettings3d             = 0x0002;
+    static const unsigned int cSettings6d             = 0x0004;
+    static const unsigned int cSettingsGazeVector     = 0x0008;
+    static const unsigned int cSettingsEyeTracker     = 0x0010;
+    static const unsigned int cSettingsAnalog         = 0x0020;
+    static const unsigned int cSettingsForce          = 0x0040;
+    static const unsigned int cSettingsImage          = 0x0080;
+    static const unsigned int cSettingsSkeleton       = 0x0100;
+    static const unsigned int cSettingsSkeletonGlobal = 0x0200; // Skeleton settings with global data, instead of cSettingsSkeleton
+    static const unsigned int cSettingsAll            = 0x01ff;
+
     using SComponentOptions = qualisys_cpp_sdk::SComponentOptions;
     using SPoint = qualisys_cpp_sdk::SPoint;
     using SBodyPoint = qualisys_cpp_sdk::SBodyPoint;
@@ -96,6 +123,8 @@ public:
     using SSettingsSkeleton = qualisys_cpp_sdk::SSettingsSkeleton;
 
     using EStreamRate = qualisys_cpp_sdk::EStreamRate;
+    using EReceiveThreadMode = qualisys_cpp_sdk::EReceiveThreadMode;
+    using FrameHandle = qualisys_cpp_sdk::FrameHandle;
     using ECameraModel = qualisys_cpp_sdk::ECameraModel;
     using ECameraMode = qualisys_cpp_sdk::ECameraMode;
     using EVideoResolution = qualisys_cpp_sdk::EVideoResolution;
@@ -117,6 +146,12 @@ public:
 
     bool       Connect(const char* serverAddr, unsigned short port = cDefaultBasePort, unsigned short* udpServerPort = nullptr,
                        int majorVersion = MAJOR_VERSION, int minorVersion = MINOR_VERSION, bool bigEndian = false, bool negotiateVersion = true);
+    // With fast connect, Connect sends the Version command and the state query at once and reads the
+    // responses afterwards, so the handshake costs one round trip. The version negotiated with every
+    // server (address, port, byte order and requested version) is remembered, and used directly the next
+    // time instead of trying the versions one at a time. Connect falls back to a full negotiation if the server doesn't
+    // accept the version.
+    void       SetFastConnect(bool enable);
     unsigned short GetUdpServerPort();
     void       Disconnect();
     bool       Connected() const;
@@ -135,9 +170,27 @@ public:
     bool       StreamFrames(EStreamRate rate, unsigned int rateArg, unsigned short udpPort, const char* udpAddr, const char* components);
     bool       StreamFrames(EStreamRate rate, unsigned int rateArg, unsigned short udpPort, const char* udpAddr,
                             unsigned int componentType, const SComponentOptions& componentOptions = { });
+    // Stream to a multicast group, e.g. 239.255.0.1, that any number of processes on the host can receive.
+    // The UDP data socket joins groupAddr on udpPort, see CNetwork::JoinMulticastGroup, and frames are then
+    // received as with any UDP stream. QTM only has to send the stream once, so only one of the consumers
+    // should request it from the server. The others pass requestStream = false and only join the group.
+    bool       StreamFramesMulticast(EStreamRate rate, unsigned int rateArg, const char* groupAddr, unsigned short udpPort,
+                                     unsigned int componentType, bool requestStream = true,
+                                     const SComponentOptions& componentOptions = { }, const char* interfaceAddr = nullptr);
     bool       StreamFramesStop();
     bool       GetState(CRTPacket::EEvent &event, bool update = true, int timeout = cWaitForDataTimeout);
     bool       GetCapture(const char* fileName, bool isC3D);
+    // Download the last capture. The file is received in large chunks that are written to disk on a separate
+    // I/O thread while the next chunk is received. With mapFile, the file is preallocated and received
+    // straight into a memory mapping of it instead. progress is called on the calling thread, with the number
+    // of bytes received so far and the file size.
+    using CaptureProgressCallback = std::function<void(unsigned int received, unsigned int size)>;
+    bool       GetCapture(const char* fileName, bool isC3D, const CaptureProgressCallback& progress, bool mapFile = false);
+    // Download the last capture into memory. buffer is resized once, to the file size, and the file is
+    // received straight into it. See CaptureMemorySink for receiving into an anonymous memory mapping.
+    bool       GetCapture(std::vector<char>& buffer, bool isC3D, const CaptureProgressCallback& progress = nullptr);
+    // Download the last capture into any destination.
+    bool       GetCapture(qualisys_cpp_sdk::ICaptureSink& sink, bool isC3D, const CaptureProgressCallback& progress = nullptr);
     bool       SendTrig();
     bool       SetQTMEvent(const std::string& label);
     bool       TakeControl(const std::string& password = "");
@@ -154,6 +207,11 @@ public:
     bool       LoadProject(const std::string& fileName);
     bool       Reprocess();
     void       OverrideNetwork(INetwork* network);
+    // Record every received data packet, as received, into log, also the ones read with ReceiveBatch and
+    // ProcessReadable. nullptr stops recording. The log is not owned and must outlive the recording. Don't
+    // change it while the receive thread is running.
+    void       SetPacketLog(qualisys_cpp_sdk::PacketLogWriter* log);
+    INetwork*  GetNetwork() const;
 
     static double SMPTENormalizedSubFrame(unsigned int captureFrequency, unsigned int timestampFrequency, unsigned int subFrame);
     static bool GetEventString(CRTPacket::EEvent event, char* str);
@@ -166,9 +224,66 @@ public:
     [[deprecated("Replaced by Receive.")]]
     int         ReceiveRTPacket(CRTPacket::EPacketType &type, bool skipEvents = true, int timeout = cWaitForDataTimeout); // timeout < 0 : Blocking receive
     CNetwork::ResponseType Receive(CRTPacket::EPacketType &type, bool skipEvents = true, int timeout = cWaitForDataTimeout); // timeout < 0 : Blocking receive
+
+    // Event loop integration. Wait for INetwork::GetSocket and GetUdpSocket to become readable in your own
+    // loop, then call ProcessReadable. It reads what is available, without ever blocking, and calls
+    // callback once for every complete packet, data as well as events. A partial packet is kept until the
+    // next call. It stops reading once maxPackets packets were delivered, so that a fast stream can't
+    // starve the event loop. The rest stays in the socket, which is then still readable. The packet is the
+    // same as GetRTPacket and is valid during the callback, use GetFrameHandle to keep it. The callback
+    // must not call functions that read from the server. A file packet (GetCaptureC3D, GetCaptureQTM) is
+    // an error, as in Receive outside of GetCapture. Returns success when the connection is still up, also
+    // if no packet was complete.
+    using PacketCallback = std::function<void(CRTPacket::EPacketType type, CRTPacket* packet)>;
+    CNetwork::ResponseType ProcessReadable(const PacketCallback& callback, unsigned int maxPackets = cDefaultMaxReadablePackets);
+    // Send a command without waiting for the response. The response packet is received like any other,
+    // e.g. through ProcessReadable.
+    bool       PostCommand(const char* command);
+
+    // Batched receive of UDP streamed frames (see StreamFrames). Every call drains up to maxFrames queued
+    // datagrams from the UDP data socket, using as few system calls as possible, into a preallocated ring
+    // of frame buffers. The frames of the last batch are read with GetBatchPacket(0 .. frameCount - 1).
+    // A frame stays valid until the ring wraps around onto its slot, so a batch never overwrites itself.
+    // Events and command responses are still sent over TCP and must be read with Receive. Datagrams that
+    // don't hold exactly one complete packet, e.g. truncated ones, are dropped and counted, see
+    // GetDroppedDatagramCount (since the CRTProtocol was created).
+    void       SetBatchRingSize(unsigned int frameCount);
+    CNetwork::ResponseType ReceiveBatch(unsigned int &frameCount, unsigned int maxFrames = cDefaultBatchRingSize, int timeout = cWaitForDataTimeout); // timeout < 0 : Blocking receive
+    CRTPacket* GetBatchPacket(unsigned int index);
+    unsigned int GetDroppedDatagramCount() const;
+
+    // Receive thread. Receives and parses all packets on a separate thread and queues them in a bounded
+    // lock free queue of queueSize packets, so a slow application doesn't make the socket buffers
+    // overflow. Packets, data as well as events, are read with PopFrame without blocking. A popped packet
+    // is valid until the next PopFrame. When the queue is full, new packets are dropped and counted.
+    // While the thread runs, don't call functions that read from the server, such as Receive or the
+    // settings functions. Commands without response, e.g. StreamFramesStop, are fine.
+    // The thread stops by itself on disconnect or error, see IsReceiveThreadRunning and GetErrorString.
+    // With mode ReceiveLatestFrame, data packets bypass the queue. Only the newest one is kept and read with
+    // GetLatestFrame, which never waits. The returned packet may be the same as in the last call and is
+    // valid until the next call. Data packets replaced before they were read are counted as skipped.
+    bool       StartReceiveThread(unsigned int queueSize = cDefaultReceiveQueueSize, EReceiveThreadMode mode = EReceiveThreadMode::ReceiveAllFrames);
+    void       StopReceiveThread();
+    bool       IsReceiveThreadRunning() const;
+    CRTPacket* PopFrame();
+    unsigned int GetDroppedFrameCount() const;
+    CRTPacket* GetLatestFrame();
+    unsigned int GetSkippedFrameCount() const;
     
 
     CRTPacket* GetRTPacket();
+    // Size the index of the received packets for the cameras and devices in the settings read so far, e.g. by
+    // ReadAllSettings, so that parsing packets never allocates memory. See CRTPacket::ReserveIndex.
+    void       ReservePacketIndex();
+
+    // Reference counted handle to the last received packet, taken from a fixed size pool of packet buffers.
+    // Unlike GetRTPacket, the packet stays valid after the next Receive and can be shared between threads.
+    // Packets larger than 64 KB, e.g. images, are received straight into a pool buffer and are handed out
+    // without a copy. Smaller packets share the receive buffer with the packets read along with them, so
+    // every call copies them into a pool buffer. Returns an empty handle if all pool buffers are in use.
+    FrameHandle GetFrameHandle();
+    // Handles of the previous pool stay valid.
+    void       SetFramePoolSize(unsigned int blockCount, unsigned int maxRetainedSize = cDefaultFrameRetainedSize);
 
     bool ReadGeneralSettings();
     [[deprecated("Replaced by ReadGeneralSettings.")]]
@@ -182,6 +297,11 @@ public:
     bool ReadForceSettings(bool &dataAvailable);
     bool ReadImageSettings(bool &dataAvailable);
     bool ReadSkeletonSettings(bool &dataAvailable, bool skeletonGlobalData = false);
+    // Read several settings at once, with one GetParameters command for all of them instead of one
+    // command and round trip per Read*Settings call. The response is parsed once and every requested
+    // section is deserialized from it. settings is a combination of the cSettings flags, availableSettings
+    // gets the ones that had data. Calibration settings are read with ReadCalibrationSettings.
+    bool ReadAllSettings(unsigned int settings = cSettingsAll, unsigned int* availableSettings = nullptr);
 
 
     void Get3DSettings(EAxis& axisUpwards, std::string& calibrationTime, std::vector<SSettings3DLabel>& labels3D, std::vector<SSettingsBone>& bones);
@@ -377,17 +497,33 @@ public:
     char* GetErrorString();
 
 private:
+    bool ConnectNegotiated(const char* serverAddr, unsigned short port, unsigned short* udpServerPort,
+                           int majorVersion, int minorVersion, bool bigEndian, bool negotiateVersion);
+    bool ConnectPipelined(const char* serverAddr, unsigned short port, unsigned short* udpServerPort,
+                          int majorVersion, int minorVersion, bool bigEndian, bool& negotiate);
     bool SendString(const char* cmdStr, int type);
     bool SendCommand(const char* cmdStr);
     bool SendCommand(const std::string& cmdStr, std::string& commandResponseStr, unsigned int timeout = cWaitForDataTimeout);
     bool SendXML(const char* cmdStr);
     const char * ReadSettings(const std::string& settingsType);
     bool ReceiveCalibrationSettings(int timeout = cWaitForDataTimeout);
+    CRTPacket::EPacketType SetPacket(char* packetData, unsigned long long receiveTimestamp, bool bigEndian);
+    void ReserveReceiveBuffer(unsigned int size);
+    CNetwork::ResponseType ReceivePacket(char*& packetData, unsigned long long& receiveTimestamp, bool bigEndian, int timeout);
+    CNetwork::ResponseType ReceiveFile(char*& packetData, unsigned long long& receiveTimestamp, unsigned int frameSize);
+    CNetwork::ResponseType ReceiveLargePacket(char*& packetData, unsigned long long& receiveTimestamp, FrameHandle frame, unsigned int frameSize);
+    void ReceiveThread();
 
 private:
     INetwork*                      mNetwork;
     CRTPacket*                     mRTPacket;
     std::vector<char>              mDataBuff;
+    std::vector<char>              mReceiveBuffer; // TCP stream, see ReceivePacket
+    unsigned int                   mReceiveStart;
+    unsigned int                   mReceiveEnd;
+    unsigned long long             mReceiveTimestamp; // Of the last read into mReceiveBuffer
+    std::unique_ptr<qualisys_cpp_sdk::FramePool> mFramePool;
+    FrameHandle                    mLargePacket;  // Last packet, if it was received into the pool
     std::vector<char>              mSendBuffer;
     CRTPacket::EEvent              mLastEvent;
     CRTPacket::EEvent              mState;  // Same as mLastEvent but without EventCameraSettingsChanged
@@ -395,6 +531,7 @@ private:
     int                            mMajorVersion;
     bool                           mBigEndian;
     bool                           mIsMaster;
+    bool                           mFastConnect;
     SSettingsGeneral               mGeneralSettings;
     SSettings3D                    m3DSettings;
     std::vector<SSettings6DOFBody> m6DOFSettings;
@@ -408,8 +545,26 @@ private:
     SCalibration                   mCalibrationSettings;
     char                           mErrorStr[1024];
     unsigned short                 mBroadcastPort;
-    FILE*                          mFileBuffer;
+    qualisys_cpp_sdk::ICaptureSink* mCaptureSink;     // Destination of file packets during GetCapture
+    qualisys_cpp_sdk::PacketLogWriter* mPacketLog;
+    unsigned int                   mPacketIndexSize;  // See ReservePacketIndex
+    CaptureProgressCallback        mCaptureProgress;
     std::vector<SDiscoverResponse> mDiscoverResponseList;
+    std::vector<char>              mBatchBuffer;  // Ring of cBatchSlotSize byte frame slots
+    std::vector<char*>             mBatchSlots;
+    std::vector<int>               mBatchSizes;
+    std::vector<unsigned long long> mBatchTimestamps;
+    std::vector<CRTPacket>         mBatchPackets;
+    unsigned int                   mBatchRingSize;
+    unsigned int                   mBatchHead;    // Next slot to fill
+    unsigned int                   mBatchStart;   // Slot of the first frame in the last batch
+    unsigned int                   mBatchCount;   // Frames in the last batch
+    unsigned int                   mBatchDroppedCount; // Malformed datagrams
+    std::unique_ptr<qualisys_cpp_sdk::FrameQueue> mFrameQueue;
+    std::unique_ptr<qualisys_cpp_sdk::FrameMailbox> mFrameMailbox;
+    std::thread                    mReceiveThread;
+    std::atomic<bool>              mStopReceiveThread;
+    std::atomic<bool>              mReceiveThreadRunning;
 };
 
 
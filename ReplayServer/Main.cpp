@@ -0,0 +1,112 @@
+#include "ReplayServer.h"
+
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+
+using namespace qualisys_cpp_sdk::replay;
+
+namespace
+{
+    volatile std::sig_atomic_t stopRequested = 0;
+
+    void PrintUsage()
+    {
+        std::printf(
+            "Usage: ReplayServer [options]\n"
+            "  --address <ip>        Listen address (default 127.0.0.1)\n"
+            "  --port <base port>    QTM base port, the server listens on base port + 1 (default 22222)\n"
+            "  --frequency <hz|max>  Stream frequency at AllFrames (default: capture frequency of the settings)\n"
+            "  --frames <count>      Frames per stream (default: until stopped)\n"
+            "  --markers <count>     Synthetic 3D markers (default: labels in the 3D settings)\n"
+            "  --bodies <count>      Synthetic rigid bodies (default: bodies in the 6D settings)\n"
+            "  --recording <file>    Replay the data packets of a recorded packet stream\n"
+            "  --settings <dir>      Read <Type>.xml (General.xml, 3D.xml, ...) instead of the built in settings\n");
+    }
+}
+
+int main(int argc, char** argv)
+{
+    ReplayOptions options;
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string option = argv[i];
+        if (option == "--help" || i + 1 >= argc)
+        {
+            PrintUsage();
+            return option == "--help" ? 0 : 1;
+        }
+        const char* value = argv[++i];
+        if (option == "--address")
+        {
+            options.address = value;
+        }
+        else if (option == "--port")
+        {
+            options.basePort = static_cast<unsigned short>(std::atoi(value));
+        }
+        else if (option == "--frequency")
+        {
+            options.asFastAsPossible = std::strcmp(value, "max") == 0;
+            options.frequency = options.asFastAsPossible ? 0 : static_cast<unsigned int>(std::atoi(value));
+        }
+        else if (option == "--frames")
+        {
+            options.frameCount = static_cast<unsigned int>(std::atoi(value));
+        }
+        else if (option == "--markers")
+        {
+            options.markerCount = static_cast<unsigned int>(std::atoi(value));
+        }
+        else if (option == "--bodies")
+        {
+            options.bodyCount = static_cast<unsigned int>(std::atoi(value));
+        }
+        else if (option == "--recording")
+        {
+            options.recording = value;
+        }
+        else if (option == "--settings")
+        {
+            options.settingsDirectory = value;
+        }
+        else
+        {
+            PrintUsage();
+            return 1;
+        }
+    }
+
+    ReplayServer server(options);
+    if (!server.Start())
+    {
+        std::fprintf(stderr, "ReplayServer: %s\n", server.GetErrorString());
+        return 1;
+    }
+    std::signal(SIGINT, [](int) { stopRequested = 1; });
+    std::signal(SIGTERM, [](int) { stopRequested = 1; });
+
+    const auto frequency = options.asFastAsPossible ? std::string("as fast as possible") : "at " + std::to_string(server.GetFrequency()) + " Hz";
+    std::printf("Replay server on %s, base port %u, %s %s.\n", options.address.c_str(), server.GetBasePort(),
+                options.recording.empty() ? "synthetic frames" : options.recording.c_str(), frequency.c_str());
+    std::fflush(stdout);
+
+    auto sentFrames = server.GetSentFrames();
+    while (!stopRequested)
+    {
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+        const auto sent = server.GetSentFrames();
+        if (sent != sentFrames)
+        {
+            std::printf("%llu frames/s\n", sent - sentFrames);
+            std::fflush(stdout);
+            sentFrames = sent;
+        }
+    }
+    server.Stop();
+    return 0;
+}
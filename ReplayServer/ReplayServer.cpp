@@ -0,0 +1,905 @@
+#include "ReplayServer.h"
+
+#include <RTProtocol.h>
+#include <SettingsDeserializer.h>
+
+#include "Data/3d.h"
+#include "Data/6d.h"
+#include "Data/Analog.h"
+#include "Data/Calibration.h"
+#include "Data/EyeTracker.h"
+#include "Data/Force.h"
+#include "Data/GazeVector.h"
+#include "Data/General.h"
+#include "Data/Image.h"
+#include "Data/Skeleton.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <sstream>
+
+using namespace qualisys_cpp_sdk;
+using namespace qualisys_cpp_sdk::replay;
+
+namespace
+{
+    // Client and accept threads check for Stop at least this often.
+    constexpr int cPollMilliseconds = 50;
+
+    constexpr std::uint32_t cPacketHeaderSize = 8;
+    constexpr std::uint32_t cMaxCommandSize = 1024 * 1024;
+
+    // Synthetic frames use the float 3D and 6DOF layout. Before 1.8 those coordinates are doubles.
+    constexpr unsigned int cMinSyntheticMinorVersion = 8;
+
+    // GetParameters types in the order QTM sends them. All doesn't include Calibration.
+    const char* const cSettingsTypes[] = { "General", "3D", "6D", "Analog", "Force", "Image", "GazeVector", "EyeTracker", "Skeleton", "Calibration" };
+
+    struct ComponentType
+    {
+        unsigned int               flag; // CRTProtocol::cComponent*
+        CRTPacket::EComponentType  type;
+    };
+
+    // The components that synthetic frames can hold, in packet order.
+    const ComponentType cSyntheticComponents[] = {
+        { CRTProtocol::cComponent3d,            CRTPacket::Component3d },
+        { CRTProtocol::cComponent3dNoLabels,    CRTPacket::Component3dNoLabels },
+        { CRTProtocol::cComponent6d,            CRTPacket::Component6d },
+        { CRTProtocol::cComponent6dEuler,       CRTPacket::Component6dEuler },
+        { CRTProtocol::cComponent3dRes,         CRTPacket::Component3dRes },
+        { CRTProtocol::cComponent3dNoLabelsRes, CRTPacket::Component3dNoLabelsRes },
+        { CRTProtocol::cComponent6dRes,         CRTPacket::Component6dRes },
+        { CRTProtocol::cComponent6dEulerRes,    CRTPacket::Component6dEulerRes }
+    };
+
+    std::uint64_t NowMicroseconds()
+    {
+        return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    std::string ToLower(std::string str)
+    {
+        std::transform(str.begin(), str.end(), str.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        return str;
+    }
+
+    // The sections of a settings document, without the root element.
+    std::string GetSections(const std::string& document)
+    {
+        const auto rootStart = document.find('<');
+        const auto end = document.rfind("</");
+        if (rootStart == std::string::npos || end == std::string::npos || end <= rootStart)
+        {
+            return "";
+        }
+        const auto start = document.find('>', rootStart) + 1;
+        return start <= end ? document.substr(start, end - start) : "";
+    }
+
+    // Little endian QTM packet writer, reusing the storage of the packet it writes into.
+    class PacketWriter
+    {
+    public:
+        PacketWriter(std::vector<char>& packet, CRTPacket::EPacketType type) : mData(packet)
+        {
+            mData.clear();
+            Put<std::uint32_t>(0);
+            Put<std::uint32_t>(type);
+        }
+
+        template <typename T>
+        void Put(T value)
+        {
+            const auto offset = mData.size();
+            mData.resize(offset + sizeof(T));
+            std::memcpy(mData.data() + offset, &value, sizeof(T));
+        }
+
+        void PutString(const std::string& str)
+        {
+            mData.insert(mData.end(), str.begin(), str.end());
+            mData.push_back(0);
+        }
+
+        std::size_t Size() const
+        {
+            return mData.size();
+        }
+
+        void Patch(std::size_t offset, std::uint32_t value)
+        {
+            std::memcpy(mData.data() + offset, &value, sizeof(value));
+        }
+
+        void Finish()
+        {
+            Patch(0, static_cast<std::uint32_t>(mData.size()));
+        }
+
+    private:
+        std::vector<char>& mData;
+    };
+
+    // Wait until the socket is ready, checking cancel every cPollMilliseconds.
+    bool WaitReady(int socket, short events, const std::atomic<bool>& cancel)
+    {
+        while (!cancel)
+        {
+            pollfd pfd { socket, events, 0 };
+            const auto result = poll(&pfd, 1, cPollMilliseconds);
+            if (result > 0)
+            {
+                return true;
+            }
+            if (result < 0 && errno != EINTR)
+            {
+                return false;
+            }
+        }
+        return false;
+    }
+
+    bool SendAll(int socket, const char* data, std::size_t size, const std::atomic<bool>& cancel)
+    {
+        while (size > 0)
+        {
+            const auto sent = send(socket, data, size, MSG_NOSIGNAL | MSG_DONTWAIT);
+            if (sent < 0)
+            {
+                if ((errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) && WaitReady(socket, POLLOUT, cancel))
+                {
+                    continue;
+                }
+                return false;
+            }
+            data += sent;
+            size -= static_cast<std::size_t>(sent);
+        }
+        return true;
+    }
+
+    bool ReadAll(int socket, char* data, std::size_t size, const std::atomic<bool>& cancel)
+    {
+        while (size > 0)
+        {
+            if (!WaitReady(socket, POLLIN, cancel))
+            {
+                return false;
+            }
+            const auto received = recv(socket, data, size, 0);
+            if (received <= 0)
+            {
+                if (received < 0 && errno == EINTR)
+                {
+                    continue;
+                }
+                return false;
+            }
+            data += received;
+            size -= static_cast<std::size_t>(received);
+        }
+        return true;
+    }
+}
+
+
+struct ReplayServer::Client
+{
+    int               socket = -1;
+    unsigned int      address = 0;       // Peer IPv4 address, network byte order. Default UDP destination.
+    std::string       version = "1.28";  // Negotiated protocol version, used in the XML root element
+    std::thread       thread;
+    std::thread       streamThread;
+    std::atomic<bool> stopStream { false };
+    std::atomic<bool> done { false };
+    std::mutex        sendMutex;         // Responses and TCP frames are sent from different threads
+    std::vector<char> response;
+};
+
+
+ReplayServer::ReplayServer(const ReplayOptions& options) :
+    mOptions(options),
+    mFrequency(0),
+    mMarkerCount(0),
+    mBodyCount(0),
+    mListenSocket(-1),
+    mPort(0),
+    mStop(false),
+    mSentFrames(0)
+{
+}
+
+
+ReplayServer::~ReplayServer()
+{
+    Stop();
+}
+
+
+bool ReplayServer::Start()
+{
+    Stop();
+    if (!LoadSettings() || !LoadRecording())
+    {
+        return false;
+    }
+
+    mListenSocket = socket(AF_INET, SOCK_STREAM, 0);
+    if (mListenSocket < 0)
+    {
+        mErrorStr = std::string("Failed to create socket: ") + std::strerror(errno);
+        return false;
+    }
+    int reuse = 1;
+    setsockopt(mListenSocket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    sockaddr_in addr {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(mOptions.basePort == 0 ? 0 : static_cast<unsigned short>(mOptions.basePort + 1));
+    if (inet_pton(AF_INET, mOptions.address.c_str(), &addr.sin_addr) != 1)
+    {
+        mErrorStr = "Invalid address " + mOptions.address + ".";
+        Stop();
+        return false;
+    }
+    if (bind(mListenSocket, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || listen(mListenSocket, 8) != 0)
+    {
+        mErrorStr = std::string("Failed to listen: ") + std::strerror(errno);
+        Stop();
+        return false;
+    }
+    socklen_t length = sizeof(addr);
+    getsockname(mListenSocket, reinterpret_cast<sockaddr*>(&addr), &length);
+    mPort = ntohs(addr.sin_port);
+
+    mStop = false;
+    mAcceptThread = std::thread([this]() { AcceptThread(); });
+    return true;
+} // Start
+
+
+void ReplayServer::Stop()
+{
+    mStop = true;
+    if (mAcceptThread.joinable())
+    {
+        mAcceptThread.join();
+    }
+    std::lock_guard<std::mutex> lock(mClientsMutex);
+    for (auto* client : mClients)
+    {
+        client->stopStream = true;
+        client->thread.join();
+        delete client;
+    }
+    mClients.clear();
+    if (mListenSocket != -1)
+    {
+        close(mListenSocket);
+        mListenSocket = -1;
+    }
+}
+
+
+unsigned short ReplayServer::GetBasePort() const
+{
+    return static_cast<unsigned short>(mPort - 1);
+}
+
+
+unsigned long long ReplayServer::GetSentFrames() const
+{
+    return mSentFrames;
+}
+
+
+unsigned int ReplayServer::GetFrequency() const
+{
+    return mFrequency;
+}
+
+
+const char* ReplayServer::GetErrorString() const
+{
+    return mErrorStr.c_str();
+}
+
+
+// Read the settings of each type, from the settings directory if it has a file for the type, otherwise the
+// built in test data. The synthetic frame content and the stream frequency follow the settings.
+bool ReplayServer::LoadSettings()
+{
+    std::map<std::string, const char*> builtIn = {
+        { "General",    tests::data::GetGeneralSettingsTest },
+        { "3D",         tests::data::Get3DSettingsTest },
+        { "6D",         tests::data::Get6DSettingsTest },
+        { "Analog",     tests::data::GetAnalogSettingsTest },
+        { "Force",      tests::data::GetForceSettingsTest },
+        { "Image",      tests::data::GetImageSettingsTest },
+        { "GazeVector", tests::data::GetGazeVectorSettingsTest },
+        { "EyeTracker", tests::data::GetEyeTrackerSettingsTest },
+        { "Skeleton",   tests::data::SkeletonSettingsGet },
+        { "Calibration", tests::data::Calibration }
+    };
+
+    mSettings.clear();
+    for (const char* type : cSettingsTypes)
+    {
+        std::string document = builtIn[type];
+        if (!mOptions.settingsDirectory.empty())
+        {
+            std::ifstream file(mOptions.settingsDirectory + "/" + type + ".xml", std::ios::binary);
+            if (file)
+            {
+                document.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+            }
+        }
+        mSettings[type] = GetSections(document);
+    }
+
+    const auto all = "<QTM_Parameters_Ver_1.25>" + GetParameters("All") + "</QTM_Parameters_Ver_1.25>";
+    SettingsDeserializer deserializer(all.c_str(), MAJOR_VERSION, MINOR_VERSION);
+    SSettingsGeneral general;
+    if (!deserializer.DeserializeGeneralSettings(general))
+    {
+        mErrorStr = "Failed to read the general settings.";
+        return false;
+    }
+    SSettings3D settings3D;
+    std::vector<SSettings6DOFBody> settings6D;
+    bool dataAvailable = false;
+    deserializer.Deserialize3DSettings(settings3D, dataAvailable);
+    deserializer.Deserialize6DOFSettings(settings6D, general, dataAvailable);
+
+    mFrequency = mOptions.frequency != 0 ? mOptions.frequency : general.nCaptureFrequency;
+    if (mFrequency == 0)
+    {
+        mFrequency = 100;
+    }
+    mMarkerCount = mOptions.markerCount != 0 ? mOptions.markerCount : static_cast<unsigned int>(settings3D.s3DLabels.size());
+    mBodyCount = mOptions.bodyCount != 0 ? mOptions.bodyCount : static_cast<unsigned int>(settings6D.size());
+    return true;
+} // LoadSettings
+
+
+// A recording is the little endian packet stream as received from QTM. Only its data packets are replayed.
+bool ReplayServer::LoadRecording()
+{
+    mRecording.clear();
+    mRecordedFrames.clear();
+    if (mOptions.recording.empty())
+    {
+        return true;
+    }
+
+    std::ifstream file(mOptions.recording, std::ios::binary);
+    if (!file)
+    {
+        mErrorStr = "Failed to open " + mOptions.recording + ".";
+        return false;
+    }
+    mRecording.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+
+    std::size_t offset = 0;
+    while (offset + cPacketHeaderSize <= mRecording.size())
+    {
+        std::uint32_t header[2];
+        std::memcpy(header, mRecording.data() + offset, sizeof(header));
+        if (header[0] < cPacketHeaderSize || offset + header[0] > mRecording.size())
+        {
+            break;
+        }
+        // Data packets shorter than the frame header can't be restamped.
+        if (header[1] == CRTPacket::PacketData && header[0] >= 24)
+        {
+            mRecordedFrames.push_back(offset);
+        }
+        offset += header[0];
+    }
+    if (mRecordedFrames.empty())
+    {
+        mErrorStr = mOptions.recording + " holds no data packets.";
+        return false;
+    }
+    return true;
+} // LoadRecording
+
+
+void ReplayServer::AcceptThread()
+{
+    while (!mStop)
+    {
+        {
+            // Reap the clients that have disconnected.
+            std::lock_guard<std::mutex> lock(mClientsMutex);
+            for (auto client = mClients.begin(); client != mClients.end();)
+            {
+                if ((*client)->done)
+                {
+                    (*client)->thread.join();
+                    delete *client;
+                    client = mClients.erase(client);
+                }
+                else
+                {
+                    ++client;
+                }
+            }
+        }
+
+        pollfd pfd { mListenSocket, POLLIN, 0 };
+        if (poll(&pfd, 1, cPollMilliseconds) <= 0)
+        {
+            continue;
+        }
+        sockaddr_in addr {};
+        socklen_t length = sizeof(addr);
+        const int socket = accept(mListenSocket, reinterpret_cast<sockaddr*>(&addr), &length);
+        if (socket < 0)
+        {
+            continue;
+        }
+        int noDelay = 1;
+        setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+        auto* client = new Client();
+        client->socket = socket;
+        client->address = addr.sin_addr.s_addr;
+        std::lock_guard<std::mutex> lock(mClientsMutex);
+        mClients.push_back(client);
+        client->thread = std::thread([this, client]() { ServeClient(*client); });
+    }
+} // AcceptThread
+
+
+void ReplayServer::ServeClient(Client& client)
+{
+    bool connected;
+    {
+        std::lock_guard<std::mutex> lock(client.sendMutex);
+        PacketWriter writer(client.response, CRTPacket::PacketCommand);
+        writer.PutString("QTM RT Interface connected");
+        writer.Finish();
+        connected = SendAll(client.socket, client.response.data(), client.response.size(), mStop);
+    }
+
+    std::vector<char> body;
+    while (connected && !mStop)
+    {
+        std::uint32_t header[2];
+        if (!ReadAll(client.socket, reinterpret_cast<char*>(header), sizeof(header), mStop) ||
+            header[0] < cPacketHeaderSize || header[0] > cMaxCommandSize)
+        {
+            break;
+        }
+        body.resize(header[0] - cPacketHeaderSize);
+        if (!ReadAll(client.socket, body.data(), body.size(), mStop))
+        {
+            break;
+        }
+        if (header[1] == CRTPacket::PacketCommand)
+        {
+            connected = HandleCommand(client, std::string(body.data(), strnlen(body.data(), body.size())));
+        }
+        else if (header[1] == CRTPacket::PacketXML)
+        {
+            // SetParameters. The stored settings are not changed.
+            std::lock_guard<std::mutex> lock(client.sendMutex);
+            PacketWriter writer(client.response, CRTPacket::PacketCommand);
+            writer.PutString("Setting parameters succeeded");
+            writer.Finish();
+            connected = SendAll(client.socket, client.response.data(), client.response.size(), mStop);
+        }
+    }
+
+    StopStreaming(client);
+    close(client.socket);
+    client.done = true;
+} // ServeClient
+
+
+bool ReplayServer::HandleCommand(Client& client, const std::string& command)
+{
+    const auto space = command.find(' ');
+    const auto name = ToLower(command.substr(0, space));
+    const auto arguments = space == std::string::npos ? std::string() : command.substr(space + 1);
+
+    std::string error;
+    if (name == "streamframes")
+    {
+        if (ToLower(arguments) == "stop")
+        {
+            StopStreaming(client);
+            return true;
+        }
+        if (StartStreaming(client, arguments, error))
+        {
+            return true;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(client.sendMutex);
+    auto& response = client.response;
+    auto respond = [&](CRTPacket::EPacketType type, const std::string& str)
+    {
+        PacketWriter writer(response, type);
+        writer.PutString(str);
+        writer.Finish();
+    };
+
+    if (!error.empty())
+    {
+        respond(CRTPacket::PacketError, error);
+    }
+    else if (name == "version")
+    {
+        unsigned int major = 0;
+        unsigned int minor = 0;
+        if (std::sscanf(arguments.c_str(), "%u.%u", &major, &minor) == 2 && major == MAJOR_VERSION && minor <= MINOR_VERSION &&
+            (minor >= cMinSyntheticMinorVersion || !mRecordedFrames.empty()))
+        {
+            client.version = std::to_string(major) + "." + std::to_string(minor);
+            respond(CRTPacket::PacketCommand, "Version set to " + client.version);
+        }
+        else
+        {
+            respond(CRTPacket::PacketCommand, "Version NOT supported");
+        }
+    }
+    else if (name == "byteorder")
+    {
+        if (ToLower(arguments) == "bigendian")
+        {
+            respond(CRTPacket::PacketError, "Big endian byte order is not supported by the replay server");
+        }
+        else
+        {
+            respond(CRTPacket::PacketCommand, "Byte order is little endian");
+        }
+    }
+    else if (name == "qtmversion")
+    {
+        respond(CRTPacket::PacketCommand, "QTM Version is replay server");
+    }
+    else if (name == "getstate" || name == "getlastevent")
+    {
+        PacketWriter writer(response, CRTPacket::PacketEvent);
+        writer.Put<std::uint8_t>(CRTPacket::EventRTfromFileStarted);
+        writer.Finish();
+    }
+    else if (name == "getparameters")
+    {
+        const auto xml = GetParameters(arguments);
+        if (xml.empty())
+        {
+            respond(CRTPacket::PacketError, "Parse error");
+        }
+        else
+        {
+            respond(CRTPacket::PacketXML, "<QTM_Parameters_Ver_" + client.version + ">" + xml + "</QTM_Parameters_Ver_" + client.version + ">");
+        }
+    }
+    else if (name == "getcurrentframe")
+    {
+        const auto components = CRTProtocol::GetComponents(arguments);
+        unsigned int componentFlags = 0;
+        for (const auto& component : components)
+        {
+            componentFlags |= component.first;
+        }
+        BuildFrame(response, componentFlags, 0, NowMicroseconds());
+    }
+    else if (name == "takecontrol")
+    {
+        respond(CRTPacket::PacketCommand, "You are now master");
+    }
+    else if (name == "releasecontrol")
+    {
+        respond(CRTPacket::PacketCommand, "You are now a regular client");
+    }
+    else
+    {
+        respond(CRTPacket::PacketError, command + " is not supported by the replay server");
+    }
+
+    return SendAll(client.socket, response.data(), response.size(), mStop);
+} // HandleCommand
+
+
+// StreamFrames [AllFrames | Frequency:n | FrequencyDivisor:n] [UDP[:address]:port] components
+bool ReplayServer::StartStreaming(Client& client, const std::string& arguments, std::string& error)
+{
+    StopStreaming(client);
+
+    unsigned int frequency = mFrequency;
+    unsigned int udpAddress = 0;
+    unsigned short udpPort = 0;
+    std::string componentsString;
+
+    std::istringstream iss(arguments);
+    std::string item;
+    while (iss >> item)
+    {
+        CRTProtocol::EStreamRate rate;
+        unsigned int rateArgument = 0;
+        const auto lower = ToLower(item);
+        if (CRTProtocol::ConvertRateString(item.c_str(), rate, rateArgument))
+        {
+            if (rate == CRTProtocol::EStreamRate::RateFrequency)
+            {
+                frequency = std::min(rateArgument, mFrequency);
+            }
+            else if (rate == CRTProtocol::EStreamRate::RateFrequencyDivisor)
+            {
+                frequency = std::max(1u, mFrequency / rateArgument);
+            }
+        }
+        else if (lower.rfind("udp", 0) == 0)
+        {
+            // UDP:port or UDP:address:port, the client's address by default.
+            udpAddress = client.address;
+            const auto lastColon = item.rfind(':');
+            if (lastColon != std::string::npos && lastColon > 3 &&
+                inet_pton(AF_INET, item.substr(4, lastColon - 4).c_str(), &udpAddress) != 1)
+            {
+                error = "Invalid UDP address in " + item;
+                return false;
+            }
+            udpPort = lastColon == std::string::npos ? 0 : static_cast<unsigned short>(std::atoi(item.c_str() + lastColon + 1));
+            if (udpPort == 0)
+            {
+                error = "Missing UDP port in " + item;
+                return false;
+            }
+        }
+        else
+        {
+            componentsString += componentsString.empty() ? item : " " + item;
+        }
+    }
+
+    unsigned int componentFlags = 0;
+    for (const auto& component : CRTProtocol::GetComponents(componentsString))
+    {
+        componentFlags |= component.first;
+    }
+
+    client.stopStream = false;
+    client.streamThread = std::thread([=, &client]() { StreamThread(client, frequency, componentFlags, udpAddress, udpPort); });
+    return true;
+} // StartStreaming
+
+
+void ReplayServer::StopStreaming(Client& client)
+{
+    client.stopStream = true;
+    if (client.streamThread.joinable())
+    {
+        client.streamThread.join();
+    }
+}
+
+
+void ReplayServer::StreamThread(Client& client, unsigned int frequency, unsigned int components, unsigned int udpAddress, unsigned short udpPort)
+{
+    int udpSocket = -1;
+    sockaddr_in udpAddr {};
+    if (udpPort != 0)
+    {
+        udpSocket = socket(AF_INET, SOCK_DGRAM, 0);
+        udpAddr.sin_family = AF_INET;
+        udpAddr.sin_port = htons(udpPort);
+        udpAddr.sin_addr.s_addr = udpAddress;
+    }
+
+    // Stop sets stopStream too, so that a blocked send is cancelled.
+    auto stopped = [&]() { return mStop || client.stopStream; };
+
+    std::vector<char> packet;
+    const auto start = std::chrono::steady_clock::now();
+    for (std::uint32_t frame = 1; !stopped() && (mOptions.frameCount == 0 || frame <= mOptions.frameCount); frame++)
+    {
+        if (frequency > 0 && !mOptions.asFastAsPossible)
+        {
+            const auto due = start + std::chrono::microseconds(1000000ull * (frame - 1) / frequency);
+            while (std::chrono::steady_clock::now() < due && !stopped())
+            {
+                std::this_thread::sleep_until(std::min(due, std::chrono::steady_clock::now() + std::chrono::milliseconds(cPollMilliseconds)));
+            }
+            if (stopped())
+            {
+                break;
+            }
+        }
+
+        const auto timestamp = NowMicroseconds();
+        if (!mRecordedFrames.empty())
+        {
+            const char* recorded = mRecording.data() + mRecordedFrames[(frame - 1) % mRecordedFrames.size()];
+            std::uint32_t size;
+            std::memcpy(&size, recorded, sizeof(size));
+            packet.assign(recorded, recorded + size);
+            std::memcpy(packet.data() + 8, &timestamp, sizeof(timestamp));
+            std::memcpy(packet.data() + 16, &frame, sizeof(frame));
+        }
+        else
+        {
+            BuildFrame(packet, components, frame, timestamp);
+        }
+
+        if (udpSocket != -1)
+        {
+            // Back off briefly instead of dropping the frame when the socket buffer is full.
+            while (sendto(udpSocket, packet.data(), packet.size(), 0, reinterpret_cast<sockaddr*>(&udpAddr), sizeof(udpAddr)) < 0 &&
+                   (errno == ENOBUFS || errno == EAGAIN) && !stopped())
+            {
+                std::this_thread::yield();
+            }
+        }
+        else
+        {
+            std::lock_guard<std::mutex> lock(client.sendMutex);
+            if (!SendAll(client.socket, packet.data(), packet.size(), client.stopStream))
+            {
+                break;
+            }
+        }
+        mSentFrames++;
+    }
+
+    if (udpSocket != -1)
+    {
+        close(udpSocket);
+    }
+} // StreamThread
+
+
+// The sections of the requested types, without the root element. Empty if a type is unknown.
+std::string ReplayServer::GetParameters(const std::string& types) const
+{
+    std::string xml;
+    std::istringstream iss(types);
+    std::string type;
+    while (iss >> type)
+    {
+        auto lower = ToLower(type);
+        if (lower == "all")
+        {
+            for (const char* settingsType : cSettingsTypes)
+            {
+                if (std::strcmp(settingsType, "Calibration") != 0)
+                {
+                    xml += mSettings.at(settingsType);
+                }
+            }
+            continue;
+        }
+        if (lower == "skeleton:global")
+        {
+            lower = "skeleton";
+        }
+        auto settings = std::find_if(mSettings.begin(), mSettings.end(), [&](const std::pair<const std::string, std::string>& candidate)
+        {
+            return ToLower(candidate.first) == lower;
+        });
+        if (settings == mSettings.end())
+        {
+            return "";
+        }
+        xml += settings->second;
+    }
+    return xml;
+} // GetParameters
+
+
+// Synthetic data packet with the requested 3D and 6DOF components. The markers circle around the origin,
+// and every tenth marker is occluded (NaN) in turn. The rigid bodies rotate about the z axis.
+void ReplayServer::BuildFrame(std::vector<char>& packet, unsigned int components, std::uint32_t frameNumber, std::uint64_t timestamp) const
+{
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    const float time = static_cast<float>(frameNumber) / static_cast<float>(mFrequency);
+
+    PacketWriter writer(packet, CRTPacket::PacketData);
+    writer.Put<std::uint64_t>(timestamp);
+    writer.Put<std::uint32_t>(frameNumber);
+    const auto componentCountOffset = writer.Size();
+    writer.Put<std::uint32_t>(0);
+
+    std::uint32_t componentCount = 0;
+    for (const auto& component : cSyntheticComponents)
+    {
+        if ((components & component.flag) == 0)
+        {
+            continue;
+        }
+        componentCount++;
+
+        const auto componentStart = writer.Size();
+        writer.Put<std::uint32_t>(0);
+        writer.Put<std::uint32_t>(component.type);
+
+        const bool residual = component.type == CRTPacket::Component3dRes || component.type == CRTPacket::Component3dNoLabelsRes ||
+                              component.type == CRTPacket::Component6dRes || component.type == CRTPacket::Component6dEulerRes;
+        const bool markers = component.type == CRTPacket::Component3d || component.type == CRTPacket::Component3dRes ||
+                             component.type == CRTPacket::Component3dNoLabels || component.type == CRTPacket::Component3dNoLabelsRes;
+        const bool labeled = component.type == CRTPacket::Component3d || component.type == CRTPacket::Component3dRes;
+
+        writer.Put<std::uint32_t>(markers ? mMarkerCount : mBodyCount);
+        writer.Put<std::uint16_t>(0); // Drop rate
+        writer.Put<std::uint16_t>(0); // Out of sync rate
+
+        if (markers)
+        {
+            for (unsigned int marker = 0; marker < mMarkerCount; marker++)
+            {
+                const bool occluded = labeled && (marker + frameNumber / 10) % 10 == 0;
+                const float angle = time + 6.2831853f * marker / mMarkerCount;
+                writer.Put<float>(occluded ? nan : 1000.0f * std::cos(angle));
+                writer.Put<float>(occluded ? nan : 1000.0f * std::sin(angle));
+                writer.Put<float>(occluded ? nan : 10.0f * marker);
+                if (component.type == CRTPacket::Component3dRes)
+                {
+                    writer.Put<float>(occluded ? -1.0f : 0.5f);
+                }
+                else if (component.type == CRTPacket::Component3dNoLabels)
+                {
+                    writer.Put<std::uint32_t>(marker + 1);
+                }
+                else if (component.type == CRTPacket::Component3dNoLabelsRes)
+                {
+                    writer.Put<std::uint32_t>(marker + 1);
+                    writer.Put<float>(0.5f);
+                }
+            }
+        }
+        else
+        {
+            const bool euler = component.type == CRTPacket::Component6dEuler || component.type == CRTPacket::Component6dEulerRes;
+            for (unsigned int body = 0; body < mBodyCount; body++)
+            {
+                const float angle = time + body;
+                writer.Put<float>(200.0f * body);
+                writer.Put<float>(100.0f * std::cos(angle));
+                writer.Put<float>(100.0f * std::sin(angle));
+                if (euler)
+                {
+                    writer.Put<float>(0.0f);
+                    writer.Put<float>(0.0f);
+                    writer.Put<float>(std::remainder(angle, 6.2831853f) * 57.29578f);
+                }
+                else
+                {
+                    const float rotation[9] = { std::cos(angle), std::sin(angle), 0.0f, -std::sin(angle), std::cos(angle), 0.0f, 0.0f, 0.0f, 1.0f };
+                    for (float value : rotation)
+                    {
+                        writer.Put<float>(value);
+                    }
+                }
+                if (residual)
+                {
+                    writer.Put<float>(0.5f);
+                }
+            }
+        }
+        writer.Patch(componentStart, static_cast<std::uint32_t>(writer.Size() - componentStart));
+    }
+    writer.Patch(componentCountOffset, componentCount);
+    writer.Finish();
+} // BuildFrame
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace qualisys_cpp_sdk::replay
+{
+    struct ReplayOptions
+    {
+        std::string    address = "127.0.0.1";
+        unsigned short basePort = 22222;   // The server listens on basePort + 1, the little endian port.
+        unsigned int   frequency = 0;      // Frames per second at AllFrames. 0 uses the capture frequency of the general settings.
+        bool           asFastAsPossible = false; // Send each frame as soon as the previous one is sent, for throughput benchmarks.
+        unsigned int   frameCount = 0;     // Frames per stream, 0 streams until stopped.
+        unsigned int   markerCount = 0;    // Synthetic 3D markers, 0 uses the number of labels in the 3D settings.
+        unsigned int   bodyCount = 0;      // Synthetic rigid bodies, 0 uses the number of bodies in the 6D settings.
+        std::string    recording;          // File of recorded little endian QTM packets. Empty streams synthetic frames.
+        std::string    settingsDirectory;  // <Type>.xml files here (General.xml, 3D.xml, ...) replace the built in settings.
+    };
+
+    // Stand-in for QTM on a real socket, for end-to-end tests and benchmarks of CRTProtocol on one machine.
+    // Answers the connect handshake, and GetParameters from stored settings XML, by default the test data in
+    // Tests/Data. StreamFrames and GetCurrentFrame are answered with synthetic 3D and 6DOF frames built for
+    // the requested components, or with the data packets of a recording, over TCP or UDP. Synthetic frames
+    // use the float layout, so versions before 1.8 are refused unless there is a recording. Every streamed
+    // frame is restamped with a new frame number and the steady clock time in microseconds, so a receiver
+    // on the same machine can measure delivery latency from the packet timestamp.
+    // Each client is served on its own thread and streams on another one.
+    class ReplayServer
+    {
+    public:
+        explicit ReplayServer(const ReplayOptions& options);
+        ~ReplayServer();
+
+        ReplayServer(const ReplayServer&) = delete;
+        ReplayServer& operator=(const ReplayServer&) = delete;
+
+        // Load settings and recording and start listening. basePort 0 picks a free port, see GetBasePort.
+        bool Start();
+        void Stop();
+
+        unsigned short     GetBasePort() const;
+        unsigned long long GetSentFrames() const;
+        unsigned int       GetFrequency() const;
+        const char*        GetErrorString() const;
+
+    private:
+        struct Client;
+
+        bool LoadSettings();
+        bool LoadRecording();
+        void AcceptThread();
+        void ServeClient(Client& client);
+        bool HandleCommand(Client& client, const std::string& command);
+        bool StartStreaming(Client& client, const std::string& arguments, std::string& error);
+        void StopStreaming(Client& client);
+        void StreamThread(Client& client, unsigned int frequency, unsigned int components, unsigned int udpAddress, unsigned short udpPort);
+        std::string GetParameters(const std::string& types) const;
+        void BuildFrame(std::vector<char>& packet, unsigned int components, std::uint32_t frameNumber, std::uint64_t timestamp) const;
+
+        ReplayOptions                      mOptions;
+        std::map<std::string, std::string> mSettings;        // Settings type -> inner XML of the type, without the root element
+        unsigned int                       mFrequency;
+        unsigned int                       mMarkerCount;
+        unsigned int                       mBodyCount;
+        std::vector<char>                  mRecording;
+        std::vector<std::size_t>           mRecordedFrames;  // Offsets of the data packets in mRecording
+        int                                mListenSocket;
+        unsigned short                     mPort;
+        std::thread                        mAcceptThread;
+        std::atomic<bool>                  mStop;
+        std::atomic<unsigned long long>    mSentFrames;
+        std::mutex                         mClientsMutex;
+        std::vector<Client*>               mClients;
+        std::string                        mErrorStr;
+    };
+}
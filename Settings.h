@@ -36,6 +36,12 @@ namespace qualisys_cpp_sdk
         RateFrequencyDivisor = 3
     };
 
+    enum EReceiveThreadMode
+    {
+        ReceiveAllFrames = 0,   // All packets are queued, see CRTProtocol::PopFrame
+        ReceiveLatestFrame = 1  // Only the latest data packet is kept, see CRTProtocol::GetLatestFrame
+    };
+
     enum ECameraModel
     {
         ModelMacReflex = 0,
@@ -0,0 +1,442 @@
+#include "StreamAggregator.h"
+
+#include <algorithm>
+#include <chrono>
+
+#ifdef _WIN32
+#include <Ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#define closesocket close
+#endif
+
+using namespace qualisys_cpp_sdk;
+
+namespace
+{
+    // Networks without sockets are polled this often.
+    constexpr int cEventThreadPollMicroseconds = 1000;
+    // Without a wake socket, the event thread checks for Stop this often.
+    constexpr int cEventThreadWaitMicroseconds = 50000;
+
+    // Loopback UDP socket that the event thread waits on along with the sources. Stop sends it a datagram
+    // to itself, so that an idle thread only wakes up for data.
+    SOCKET CreateWakeSocket()
+    {
+        SOCKET wakeSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        if (wakeSocket == INVALID_SOCKET)
+        {
+            return INVALID_SOCKET;
+        }
+        sockaddr_in addr {};
+        addr.sin_family      = AF_INET;
+        addr.sin_port        = 0;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (bind(wakeSocket, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0)
+        {
+            closesocket(wakeSocket);
+            return INVALID_SOCKET;
+        }
+        return wakeSocket;
+    }
+
+    void Wake(SOCKET wakeSocket)
+    {
+        sockaddr_in addr {};
+        socklen_t   length = sizeof(addr);
+        if (getsockname(wakeSocket, reinterpret_cast<sockaddr*>(&addr), &length) == 0)
+        {
+            const char wake = 0;
+            sendto(wakeSocket, &wake, 1, 0, reinterpret_cast<sockaddr*>(&addr), length);
+        }
+    }
+
+    unsigned long long NowMicroseconds()
+    {
+        return static_cast<unsigned long long>(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+}
+
+
+StreamAggregator::StreamAggregator(EMergeKey mergeKey, unsigned long long tolerance, unsigned int sourceBufferSize, unsigned int outputQueueSize) :
+    mMergeKey(mergeKey),
+    mTolerance(tolerance),
+    mSourceBufferSize(std::max(1u, sourceBufferSize)),
+    mOutputQueueSize(std::max(1u, outputQueueSize)),
+    mStopThread(false),
+    mRunning(false),
+    mDroppedFrames(0),
+    mWakeSocket(INVALID_SOCKET)
+{
+}
+
+
+StreamAggregator::~StreamAggregator()
+{
+    Stop();
+    // Release all frames before their pools go away with the protocols.
+    mOutput.clear();
+    for (auto& source : mSources)
+    {
+        source.frames.clear();
+    }
+}
+
+
+unsigned int StreamAggregator::AddSource(std::unique_ptr<CRTProtocol> protocol)
+{
+    // Every buffered and queued frame holds a buffer of its source's pool.
+    protocol->SetFramePoolSize(mSourceBufferSize + mOutputQueueSize + 2);
+
+    Source source;
+    source.protocol   = std::move(protocol);
+    source.statistics = AggregatorSourceStatistics();
+    source.statistics.connected = source.protocol->Connected();
+    source.lagSum     = 0;
+    source.lagCount   = 0;
+    mSources.push_back(std::move(source));
+    return static_cast<unsigned int>(mSources.size() - 1);
+}
+
+
+unsigned int StreamAggregator::GetSourceCount() const
+{
+    return static_cast<unsigned int>(mSources.size());
+}
+
+
+CRTProtocol* StreamAggregator::GetSource(unsigned int index)
+{
+    return index < mSources.size() ? mSources[index].protocol.get() : nullptr;
+}
+
+
+bool StreamAggregator::Start()
+{
+    if (mSources.empty())
+    {
+        return false;
+    }
+    Stop();
+
+    mStopThread = false;
+    mRunning    = true;
+    mWakeSocket = CreateWakeSocket();
+    mThread     = std::thread([this]() { EventThread(); });
+    return true;
+}
+
+
+void StreamAggregator::Stop()
+{
+    mStopThread = true;
+    if (mThread.joinable())
+    {
+        if (mWakeSocket != INVALID_SOCKET)
+        {
+            Wake(mWakeSocket);
+        }
+        mThread.join();
+    }
+    if (mWakeSocket != INVALID_SOCKET)
+    {
+        closesocket(mWakeSocket);
+        mWakeSocket = INVALID_SOCKET;
+    }
+}
+
+
+bool StreamAggregator::IsRunning() const
+{
+    return mRunning;
+}
+
+
+bool StreamAggregator::PopFrame(AggregatedFrame& frame, int timeoutMicroseconds)
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    auto available = [this]() { return !mOutput.empty() || !mRunning; };
+    if (timeoutMicroseconds < 0)
+    {
+        mFrameAvailable.wait(lock, available);
+    }
+    else if (timeoutMicroseconds > 0)
+    {
+        mFrameAvailable.wait_for(lock, std::chrono::microseconds(timeoutMicroseconds), available);
+    }
+    if (mOutput.empty())
+    {
+        return false;
+    }
+    frame = std::move(mOutput.front());
+    mOutput.pop_front();
+    return true;
+}
+
+
+unsigned int StreamAggregator::GetDroppedFrameCount() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mDroppedFrames;
+}
+
+
+AggregatorSourceStatistics StreamAggregator::GetSourceStatistics(unsigned int index) const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return index < mSources.size() ? mSources[index].statistics : AggregatorSourceStatistics();
+}
+
+
+void StreamAggregator::EventThread()
+{
+    while (!mStopThread)
+    {
+        fd_set readFDs;
+        FD_ZERO(&readFDs);
+        SOCKET maxSocket      = 0;
+        bool   waitForSockets = false;
+        bool   pollSources    = false; // A source without sockets
+        bool   connected      = false;
+
+        for (auto& source : mSources)
+        {
+            if (!source.statistics.connected)
+            {
+                continue;
+            }
+            connected = true;
+            auto network = source.protocol->GetNetwork();
+            pollSources = pollSources || network->GetSocket() == INVALID_SOCKET;
+            for (auto socket : { network->GetSocket(), network->GetUdpSocket() })
+            {
+                if (socket != INVALID_SOCKET)
+                {
+                    FD_SET(socket, &readFDs);
+                    maxSocket = std::max(maxSocket, socket);
+                    waitForSockets = true;
+                }
+            }
+        }
+        if (!connected)
+        {
+            break;
+        }
+
+        if (waitForSockets)
+        {
+            timeval timeout;
+            timeout.tv_sec  = 0;
+            timeout.tv_usec = pollSources ? cEventThreadPollMicroseconds : cEventThreadWaitMicroseconds;
+            if (mWakeSocket != INVALID_SOCKET)
+            {
+                FD_SET(mWakeSocket, &readFDs);
+                maxSocket = std::max(maxSocket, mWakeSocket);
+            }
+            if (select((int)maxSocket + 1, &readFDs, nullptr, nullptr, mWakeSocket != INVALID_SOCKET && !pollSources ? nullptr : &timeout) < 0)
+            {
+                break;
+            }
+        }
+        else
+        {
+            std::this_thread::sleep_for(std::chrono::microseconds(cEventThreadPollMicroseconds));
+        }
+
+        for (auto& source : mSources)
+        {
+            if (!source.statistics.connected)
+            {
+                continue;
+            }
+            auto network = source.protocol->GetNetwork();
+            const SOCKET socket    = network->GetSocket();
+            const SOCKET udpSocket = network->GetUdpSocket();
+            if (socket != INVALID_SOCKET && !FD_ISSET(socket, &readFDs) && (udpSocket == INVALID_SOCKET || !FD_ISSET(udpSocket, &readFDs)))
+            {
+                continue;
+            }
+
+            const auto now = NowMicroseconds();
+            auto result = source.protocol->ProcessReadable([&](CRTPacket::EPacketType type, CRTPacket*)
+            {
+                if (type == CRTPacket::PacketData)
+                {
+                    AddFrame(source, now);
+                }
+            });
+            if (result != CNetwork::ResponseType::success)
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                source.statistics.connected = false;
+                source.statistics.unmatchedFrames += static_cast<unsigned int>(source.frames.size());
+                source.statistics.bufferedFrames = 0;
+                source.frames.clear();
+            }
+        }
+
+        Merge();
+    }
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    mRunning = false;
+    mFrameAvailable.notify_all();
+} // EventThread
+
+
+bool StreamAggregator::GetKey(CRTPacket& packet, unsigned long long& key) const
+{
+    if (mMergeKey == EMergeKey::Timestamp)
+    {
+        key = packet.GetTimeStamp();
+        return true;
+    }
+
+    CRTPacket::ETimecodeType timecodeType;
+    if (!packet.GetTimecodeType(timecodeType))
+    {
+        return false;
+    }
+    switch (timecodeType)
+    {
+    case CRTPacket::TimecodeSMPTE:
+    {
+        int hours, minutes, seconds, frames;
+        if (!packet.GetTimecodeSMPTE(hours, minutes, seconds, frames))
+        {
+            return false;
+        }
+        // Frames per second is at most 30, so 32 frames per second keeps the key increasing.
+        key = ((hours * 60ull + minutes) * 60ull + seconds) * 32ull + frames;
+        return true;
+    }
+    case CRTPacket::TimecodeIRIG:
+    {
+        int years, days, hours, minutes, seconds, tenths;
+        if (!packet.GetTimecodeIRIG(years, days, hours, minutes, seconds, tenths))
+        {
+            return false;
+        }
+        key = ((((years * 366ull + days) * 24ull + hours) * 60ull + minutes) * 60ull + seconds) * 10ull + tenths;
+        return true;
+    }
+    case CRTPacket::TimecodeCamerTime:
+        return packet.GetTimecodeCameraTime(key);
+    }
+    return false;
+} // GetKey
+
+
+// Buffer the last received packet of a source.
+void StreamAggregator::AddFrame(Source& source, unsigned long long now)
+{
+    auto frame = source.protocol->GetFrameHandle();
+    unsigned long long key;
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    source.statistics.receivedFrames++;
+    if (!frame || !GetKey(*frame, key))
+    {
+        source.statistics.unmatchedFrames++;
+        return;
+    }
+    if (source.frames.size() == mSourceBufferSize)
+    {
+        // Still waiting for the other sources, give up on the oldest frame.
+        source.frames.pop_front();
+        source.statistics.unmatchedFrames++;
+    }
+    source.frames.push_back({ std::move(frame), key, now });
+    source.statistics.bufferedFrames = static_cast<unsigned int>(source.frames.size());
+} // AddFrame
+
+
+// Combine the buffered frames of all connected sources, oldest first.
+void StreamAggregator::Merge()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    while (true)
+    {
+        unsigned long long maxKey = 0;
+        bool connected = false;
+        for (auto& source : mSources)
+        {
+            if (source.statistics.connected)
+            {
+                if (source.frames.empty())
+                {
+                    return; // Wait for this source
+                }
+                maxKey = std::max(maxKey, source.frames.front().key);
+                connected = true;
+            }
+        }
+        if (!connected)
+        {
+            return;
+        }
+
+        // Frames older than the newest first frame of any source will never be matched.
+        bool dropped = false;
+        for (auto& source : mSources)
+        {
+            if (source.statistics.connected && source.frames.front().key + mTolerance < maxKey)
+            {
+                source.frames.pop_front();
+                source.statistics.unmatchedFrames++;
+                source.statistics.bufferedFrames = static_cast<unsigned int>(source.frames.size());
+                dropped = true;
+            }
+        }
+        if (dropped)
+        {
+            continue;
+        }
+
+        AggregatedFrame combined;
+        combined.key = maxKey;
+        combined.frames.resize(mSources.size());
+        unsigned long long firstArrival = ~0ull;
+        for (auto& source : mSources)
+        {
+            if (source.statistics.connected)
+            {
+                firstArrival = std::min(firstArrival, source.frames.front().arrival);
+            }
+        }
+        for (size_t i = 0; i < mSources.size(); i++)
+        {
+            auto& source = mSources[i];
+            if (!source.statistics.connected)
+            {
+                continue;
+            }
+            const auto lag = source.frames.front().arrival - firstArrival;
+            auto& statistics = source.statistics;
+            statistics.lastLag = lag;
+            statistics.maxLag  = std::max(statistics.maxLag, lag);
+            source.lagSum += lag;
+            source.lagCount++;
+            statistics.meanLag = static_cast<double>(source.lagSum) / source.lagCount;
+
+            combined.frames[i] = std::move(source.frames.front().frame);
+            source.frames.pop_front();
+            statistics.bufferedFrames = static_cast<unsigned int>(source.frames.size());
+        }
+
+        if (mOutput.size() < mOutputQueueSize)
+        {
+            mOutput.push_back(std::move(combined));
+            mFrameAvailable.notify_one();
+        }
+        else
+        {
+            mDroppedFrames++;
+        }
+    }
+} // Merge
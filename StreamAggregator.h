@@ -0,0 +1,116 @@
+#ifndef STREAM_AGGREGATOR_H
+#define STREAM_AGGREGATOR_H
+
+#include "RTProtocol.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace qualisys_cpp_sdk
+{
+    // One frame from every source, captured at the same time.
+    struct AggregatedFrame
+    {
+        unsigned long long       key;    // Timestamp or timecode key of the frame, see StreamAggregator
+        std::vector<FrameHandle> frames; // One per source in AddSource order. Empty for disconnected sources.
+    };
+
+    struct AggregatorSourceStatistics
+    {
+        bool         connected;
+        unsigned int receivedFrames;
+        unsigned int unmatchedFrames; // Dropped because the other sources had no frame with the same key
+        unsigned int bufferedFrames;
+        // How long after the first source of a combined frame this source's frame arrived, in microseconds.
+        unsigned long long lastLag;
+        unsigned long long maxLag;
+        double             meanLag;
+    };
+
+    // Merges the streams of several QTM servers, e.g. systems that cover adjacent volumes, into one stream
+    // of combined frames. All sources are received on one event thread, which waits for the sockets of all
+    // of them at once (see CRTProtocol::ProcessReadable).
+    // Frames are matched by the QTM timestamp, which requires the systems to share a clock, or by the
+    // timecode component (SMPTE, IRIG or camera time), which must then be included in the stream.
+    // Every source buffers at most sourceBufferSize frames while it waits for the others. A combined frame
+    // is made when all connected sources have a frame within tolerance of each other. Older frames that can
+    // no longer be matched are dropped and counted per source.
+    class StreamAggregator
+    {
+    public:
+        enum class EMergeKey
+        {
+            Timestamp, // QTM timestamp in microseconds, tolerance in microseconds
+            Timecode   // SMPTE: frames, IRIG: tenths of seconds, camera time: camera ticks. Use tolerance 0.
+        };
+
+        StreamAggregator(EMergeKey mergeKey = EMergeKey::Timestamp, unsigned long long tolerance = 0,
+                         unsigned int sourceBufferSize = 16, unsigned int outputQueueSize = 64);
+        ~StreamAggregator();
+
+        StreamAggregator(const StreamAggregator&) = delete;
+        StreamAggregator& operator=(const StreamAggregator&) = delete;
+
+        // Add a connected protocol that streams frames, only while the aggregator isn't running.
+        // The aggregator owns the protocol and sizes its frame pool for the buffering. Returns the index of the
+        // source.
+        unsigned int AddSource(std::unique_ptr<CRTProtocol> protocol);
+        unsigned int GetSourceCount() const;
+        // Don't read from the server through the protocol while the aggregator runs.
+        CRTProtocol* GetSource(unsigned int index);
+
+        // The event thread stops by itself when all sources have disconnected.
+        bool Start();
+        void Stop();
+        bool IsRunning() const;
+
+        // Get the oldest combined frame. Waits up to timeoutMicroseconds (< 0 : no limit) for one.
+        bool PopFrame(AggregatedFrame& frame, int timeoutMicroseconds = 0);
+        // Combined frames dropped because the output queue was full.
+        unsigned int GetDroppedFrameCount() const;
+        AggregatorSourceStatistics GetSourceStatistics(unsigned int index) const;
+
+    private:
+        struct BufferedFrame
+        {
+            FrameHandle        frame;
+            unsigned long long key;
+            unsigned long long arrival; // Microseconds, steady clock
+        };
+
+        struct Source
+        {
+            std::unique_ptr<CRTProtocol> protocol;
+            std::deque<BufferedFrame>    frames;
+            AggregatorSourceStatistics   statistics;
+            unsigned long long           lagSum;
+            unsigned int                 lagCount;
+        };
+
+        void EventThread();
+        bool GetKey(CRTPacket& packet, unsigned long long& key) const;
+        void AddFrame(Source& source, unsigned long long now);
+        void Merge();
+
+        EMergeKey                 mMergeKey;
+        unsigned long long        mTolerance;
+        unsigned int              mSourceBufferSize;
+        unsigned int              mOutputQueueSize;
+        std::vector<Source>       mSources;
+        std::thread               mThread;
+        std::atomic<bool>         mStopThread;
+        std::atomic<bool>         mRunning;
+        mutable std::mutex        mMutex;  // Statistics and output queue
+        std::condition_variable   mFrameAvailable;
+        std::deque<AggregatedFrame> mOutput;
+        unsigned int              mDroppedFrames;
+        SOCKET                    mWakeSocket; // Wakes the event thread for Stop
+    };
+}
+
+#endif // STREAM_AGGREGATOR_H
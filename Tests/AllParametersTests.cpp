@@ -0,0 +1,89 @@
+#include "Data/3d.h"
+#include "Data/6d.h"
+#include "Data/Analog.h"
+#include "Data/General.h"
+#include "Data/Skeleton.h"
+#include "ParametersTestsShared.h"
+
+#include <string>
+
+using namespace qualisys_cpp_sdk::tests;
+
+namespace
+{
+    // The sections of a GetParameters response, without the root element.
+    std::string GetSections(const char* xml)
+    {
+        const std::string document(xml);
+        const auto start = document.find('>', document.find('<')) + 1;
+        const auto end = document.rfind("</");
+        return document.substr(start, end - start);
+    }
+
+    std::string CombineParameters(std::initializer_list<const char*> documents)
+    {
+        std::string combined = "<QTM_Parameters_Ver_1.25>";
+        for (auto document : documents)
+        {
+            combined += GetSections(document);
+        }
+        return combined + "</QTM_Parameters_Ver_1.25>";
+    }
+}
+
+TEST_CASE("ReadAllSettingsTest")
+{
+    auto [protocol, network] = utils::CreateTestContext();
+
+    network->PrepareResponse("GetParameters General 3D 6D Analog Skeleton",
+        CombineParameters({ data::GetGeneralSettingsTest, data::Get3DSettingsTest, data::Get6DSettingsTest, data::GetAnalogSettingsTest, data::SkeletonSettingsGet }),
+        CRTPacket::PacketXML);
+
+    unsigned int available = 0;
+    const auto settings = CRTProtocol::cSettingsGeneral | CRTProtocol::cSettings3d | CRTProtocol::cSettings6d |
+                          CRTProtocol::cSettingsAnalog | CRTProtocol::cSettingsSkeleton;
+    if (!protocol->ReadAllSettings(settings, &available))
+    {
+        FAIL(protocol->GetErrorString());
+    }
+    CHECK(available == settings);
+
+    // The same as reading the sections one at a time.
+    auto [reference, referenceNetwork] = utils::CreateTestContext();
+    referenceNetwork->PrepareResponse("GetParameters General", data::GetGeneralSettingsTest, CRTPacket::PacketXML);
+    referenceNetwork->PrepareResponse("GetParameters 3D", data::Get3DSettingsTest, CRTPacket::PacketXML);
+    referenceNetwork->PrepareResponse("GetParameters 6D", data::Get6DSettingsTest, CRTPacket::PacketXML);
+    referenceNetwork->PrepareResponse("GetParameters Analog", data::GetAnalogSettingsTest, CRTPacket::PacketXML);
+    referenceNetwork->PrepareResponse("GetParameters Skeleton", data::SkeletonSettingsGet, CRTPacket::PacketXML);
+    bool dataAvailable;
+    REQUIRE(reference->ReadGeneralSettings());
+    REQUIRE(reference->Read3DSettings(dataAvailable));
+    REQUIRE(reference->Read6DOFSettings(dataAvailable));
+    REQUIRE(reference->ReadSkeletonSettings(dataAvailable));
+    REQUIRE(reference->ReadAnalogSettings(dataAvailable)); // Last, every ReadSettings clears the analog settings
+
+    CHECK(protocol->GetCameraCount() > 0);
+    CHECK(protocol->GetCameraCount() == reference->GetCameraCount());
+    CHECK(protocol->Get3DLabeledMarkerCount() == reference->Get3DLabeledMarkerCount());
+    CHECK(protocol->Get3DBoneCount() == reference->Get3DBoneCount());
+    CHECK(protocol->Get6DOFBodyCount() == reference->Get6DOFBodyCount());
+    CHECK(protocol->GetAnalogDeviceCount() > 0);
+    CHECK(protocol->GetAnalogDeviceCount() == reference->GetAnalogDeviceCount());
+    CHECK(protocol->GetSkeletonCount() == reference->GetSkeletonCount());
+    CHECK(protocol->GetSkeletonCount() == 2);
+}
+
+TEST_CASE("ReadAllSettingsMissingSectionTest")
+{
+    auto [protocol, network] = utils::CreateTestContext();
+
+    network->PrepareResponse("GetParameters 3D Force", CombineParameters({ data::Get3DSettingsTest }), CRTPacket::PacketXML);
+
+    unsigned int available = 0;
+    if (!protocol->ReadAllSettings(CRTProtocol::cSettings3d | CRTProtocol::cSettingsForce, &available))
+    {
+        FAIL(protocol->GetErrorString());
+    }
+    CHECK(available == CRTProtocol::cSettings3d);
+    CHECK(protocol->GetForcePlateCount() == 0);
+}
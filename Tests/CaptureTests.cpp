@@ -0,0 +1,134 @@
+#include "TestUtils.h"
+
+#include <doctest/doctest.h>
+
+#include <RTProtocol.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+using namespace qualisys_cpp_sdk::tests;
+
+namespace
+{
+    std::string CreateFilePacket(const std::string& file, CRTPacket::EPacketType type)
+    {
+        const std::uint32_t header[2] = { static_cast<std::uint32_t>(8 + file.size()), static_cast<std::uint32_t>(type) };
+        return std::string(reinterpret_cast<const char*>(header), sizeof(header)) + file;
+    }
+
+    std::string CreateCaptureFile(size_t size)
+    {
+        std::string file(size, '\0');
+        for (size_t i = 0; i < size; i++)
+        {
+            file[i] = static_cast<char>(i * 7 + i / 4096);
+        }
+        return file;
+    }
+
+    std::string ReadFile(const std::string& fileName)
+    {
+        std::ifstream stream(fileName, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+    }
+}
+
+TEST_CASE("GetCaptureToFileTest")
+{
+    for (bool mapFile : { false, true })
+    {
+        auto [protocol, network] = utils::CreateTestContext();
+
+        const auto file = CreateCaptureFile(700001);
+        network->PrepareResponse("GetCaptureC3D", "Sending capture", CRTPacket::PacketCommand, CreateFilePacket(file, CRTPacket::PacketC3DFile));
+
+        const auto fileName = (std::filesystem::temp_directory_path() / "qualisys_cpp_sdk_capture_test.c3d").string();
+
+        unsigned int lastReceived = 0;
+        unsigned int lastSize = 0;
+        auto progress = [&](unsigned int received, unsigned int size)
+        {
+            CHECK(received >= lastReceived);
+            lastReceived = received;
+            lastSize = size;
+        };
+
+        if (!protocol->GetCapture(fileName.c_str(), true, progress, mapFile))
+        {
+            FAIL(protocol->GetErrorString());
+        }
+        CHECK(lastReceived == file.size());
+        CHECK(lastSize == file.size());
+        CHECK(ReadFile(fileName) == file);
+
+        std::remove(fileName.c_str());
+    }
+}
+
+TEST_CASE("CaptureFileSinkChunksTest")
+{
+    const auto fileName = (std::filesystem::temp_directory_path() / "qualisys_cpp_sdk_sink_test.qtm").string();
+    const auto file = CreateCaptureFile(10000);
+
+    {
+        // Many chunks, so the I/O thread gets to write while the next chunk is filled.
+        qualisys_cpp_sdk::CaptureFileSink sink(fileName.c_str(), 1000);
+        REQUIRE(sink.IsOpen());
+        REQUIRE(sink.Begin(static_cast<unsigned int>(file.size())));
+
+        size_t written = 0;
+        while (written < file.size())
+        {
+            unsigned int size;
+            char* buffer = sink.GetWriteBuffer(size);
+            REQUIRE(buffer != nullptr);
+            size = std::min(size, 333u);
+            std::memcpy(buffer, file.data() + written, size);
+            written += size;
+            REQUIRE(sink.Commit(size));
+        }
+        CHECK(sink.End(true));
+    }
+    CHECK(ReadFile(fileName) == file);
+
+    std::remove(fileName.c_str());
+}
+
+TEST_CASE("GetCaptureToMemoryTest")
+{
+    auto [protocol, network] = utils::CreateTestContext();
+
+    const auto file = CreateCaptureFile(300007);
+    network->PrepareResponse("GetCaptureQTM", "Sending capture", CRTPacket::PacketCommand, CreateFilePacket(file, CRTPacket::PacketQTMFile));
+
+    std::vector<char> buffer(16, 'x');
+    if (!protocol->GetCapture(buffer, false))
+    {
+        FAIL(protocol->GetErrorString());
+    }
+    CHECK(std::string(buffer.begin(), buffer.end()) == file);
+}
+
+TEST_CASE("CaptureMemorySinkMappingTest")
+{
+    auto [protocol, network] = utils::CreateTestContext();
+
+    const auto file = CreateCaptureFile(123457);
+    network->PrepareResponse("GetCaptureC3D", "Sending capture", CRTPacket::PacketCommand, CreateFilePacket(file, CRTPacket::PacketC3DFile));
+
+    qualisys_cpp_sdk::CaptureMemorySink sink;
+    if (!protocol->GetCapture(sink, true))
+    {
+        FAIL(protocol->GetErrorString());
+    }
+    REQUIRE(sink.GetSize() == file.size());
+    CHECK(std::string(sink.GetData(), sink.GetSize()) == file);
+}
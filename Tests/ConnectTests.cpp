@@ -0,0 +1,125 @@
+#include "TestUtils.h"
+
+#include <doctest/doctest.h>
+
+#include <RTProtocol.h>
+
+#include <memory>
+#include <string>
+
+using namespace qualisys_cpp_sdk::tests;
+
+namespace
+{
+    const std::string cCurrentVersion  = std::to_string(MAJOR_VERSION) + "." + std::to_string(MINOR_VERSION);
+    const std::string cPreviousVersion = std::to_string(MAJOR_VERSION) + "." + std::to_string(MINOR_VERSION - 1);
+    const std::string cOlderVersion    = std::to_string(MAJOR_VERSION) + "." + std::to_string(MINOR_VERSION - 2);
+
+    std::unique_ptr<CRTProtocol> CreateProtocol(utils::DummyXmlNetwork*& network, bool fastConnect)
+    {
+        network = new utils::DummyXmlNetwork{};
+        auto protocol = std::make_unique<CRTProtocol>();
+        protocol->OverrideNetwork(network->GetInterfacePtr());
+        protocol->SetFastConnect(fastConnect);
+        return protocol;
+    }
+
+    std::string GetVersion(CRTProtocol& protocol)
+    {
+        unsigned int major, minor;
+        REQUIRE(protocol.GetVersion(major, minor));
+        return std::to_string(major) + "." + std::to_string(minor);
+    }
+}
+
+TEST_CASE("FastConnectTest")
+{
+    utils::DummyXmlNetwork* network;
+    auto protocol = CreateProtocol(network, true);
+    network->PrepareResponse("GetState", std::string(1, static_cast<char>(CRTPacket::EventCaptureStarted)), CRTPacket::PacketEvent);
+
+    if (!protocol->Connect("fast-connect"))
+    {
+        FAIL(protocol->GetErrorString());
+    }
+    CHECK(GetVersion(*protocol) == cCurrentVersion);
+    CHECK(network->ReadSentData().rfind("GetState", 0) == 0);
+
+    CRTPacket::EEvent state;
+    REQUIRE(protocol->GetState(state, false));
+    CHECK(state == CRTPacket::EventCaptureStarted);
+}
+
+TEST_CASE("FastConnectRemembersVersionTest")
+{
+    const char* server = "fast-connect-remember";
+    utils::DummyXmlNetwork* network;
+
+    // The server only supports the previous version, which the full negotiation finds.
+    {
+        auto protocol = CreateProtocol(network, false);
+        network->PrepareResponse("Version " + cCurrentVersion, "Version NOT supported", CRTPacket::PacketCommand);
+        network->PrepareResponse("Version " + cPreviousVersion, "Version set to " + cPreviousVersion, CRTPacket::PacketCommand);
+        if (!protocol->Connect(server))
+        {
+            FAIL(protocol->GetErrorString());
+        }
+        CHECK(GetVersion(*protocol) == cPreviousVersion);
+    }
+
+    // Fast connect asks for the remembered version first, although the current one would be accepted.
+    {
+        auto protocol = CreateProtocol(network, true);
+        network->PrepareResponse("Version " + cPreviousVersion, "Version set to " + cPreviousVersion, CRTPacket::PacketCommand);
+        if (!protocol->Connect(server))
+        {
+            FAIL(protocol->GetErrorString());
+        }
+        CHECK(GetVersion(*protocol) == cPreviousVersion);
+    }
+
+    // The server no longer accepts the remembered version, fall back to the full negotiation.
+    {
+        auto protocol = CreateProtocol(network, true);
+        network->PrepareResponse("Version " + cPreviousVersion, "Version NOT supported", CRTPacket::PacketCommand);
+        if (!protocol->Connect(server))
+        {
+            FAIL(protocol->GetErrorString());
+        }
+        CHECK(GetVersion(*protocol) == cCurrentVersion);
+    }
+
+    // Which is remembered instead.
+    {
+        auto protocol = CreateProtocol(network, true);
+        network->PrepareResponse("Version " + cPreviousVersion, "Version set to " + cPreviousVersion, CRTPacket::PacketCommand);
+        if (!protocol->Connect(server))
+        {
+            FAIL(protocol->GetErrorString());
+        }
+        CHECK(GetVersion(*protocol) == cCurrentVersion);
+    }
+
+    // A lower requested version is never replaced by the higher remembered one.
+    {
+        auto protocol = CreateProtocol(network, true);
+        network->PrepareResponse("Version " + cOlderVersion, "Version set to " + cOlderVersion, CRTPacket::PacketCommand);
+        if (!protocol->Connect(server, CRTProtocol::cDefaultBasePort, nullptr, MAJOR_VERSION, MINOR_VERSION - 2))
+        {
+            FAIL(protocol->GetErrorString());
+        }
+        CHECK(GetVersion(*protocol) == cOlderVersion);
+    }
+}
+
+TEST_CASE("FastConnectLongVersionResponseTest")
+{
+    utils::DummyXmlNetwork* network;
+    auto protocol = CreateProtocol(network, true);
+
+    // The response is quoted in the error, which must still fit in the error string.
+    const std::string response(100000, 'x');
+    network->PrepareResponse("Version " + cCurrentVersion, response, CRTPacket::PacketCommand);
+    CHECK_FALSE(protocol->Connect("fast-connect-long-response", CRTProtocol::cDefaultBasePort, nullptr, MAJOR_VERSION, MINOR_VERSION, false, false));
+    CHECK(std::string(protocol->GetErrorString()).size() < 1024);
+}
@@ -0,0 +1,123 @@
+#include <doctest/doctest.h>
+
+#if defined(__cpp_impl_coroutine)
+
+#include "Data/6d.h"
+#include "TestUtils.h"
+
+#include <RTCoroutine.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace qualisys_cpp_sdk;
+using namespace qualisys_cpp_sdk::tests;
+
+namespace
+{
+    Task<> ReadSettingsAndFrames(RTConnection& connection, std::vector<std::string>& log)
+    {
+        auto response = co_await connection.SendCommandAsync("GetState");
+        log.push_back(response.text);
+
+        std::vector<SSettings6DOFBody> bodies;
+        SSettingsGeneral general;
+        bool dataAvailable = false;
+        if (co_await connection.Read6DOFSettingsAsync(bodies, general, dataAvailable) && dataAvailable)
+        {
+            log.push_back(bodies.front().name);
+        }
+
+        while (auto frame = co_await connection.ReceiveFrame())
+        {
+            log.push_back(std::to_string(frame->GetFrameNumber()));
+        }
+        log.push_back("Done");
+    }
+}
+
+TEST_CASE("CoroutineCommandsAndFramesTest")
+{
+    auto [protocol, network] = utils::CreateTestContext();
+    network->PrepareResponse("GetState", "Connected", CRTPacket::PacketCommand);
+    network->PrepareResponse("GetParameters 6D", data::Get6DSettingsTest, CRTPacket::PacketXML);
+
+    // A frame that arrives before anyone waits for it is queued.
+    network->QueueDataPacket(0, 1);
+
+    RTReactor reactor;
+    RTConnection connection(reactor, *protocol);
+    std::vector<std::string> log;
+    reactor.Spawn(ReadSettingsAndFrames(connection, log));
+
+    for (int i = 0; i < 10; i++)
+    {
+        reactor.RunOnce(0);
+    }
+    network->QueueDataPacket(0, 2);
+    reactor.RunOnce(0);
+
+    REQUIRE(log.size() == 4);
+    CHECK(log[0] == "Connected");
+    CHECK(log[1] == "refined");
+    CHECK(log[2] == "1");
+    CHECK(log[3] == "2");
+    CHECK(reactor.HasTasks());
+}
+
+namespace
+{
+    // Before 1.21 the Euler rotation definitions are in the 6D settings.
+    const char* const c6DSettingsVersion120 = R"XMLDATA(
+<QTM_Parameters_Ver_1.20>
+    <The_6D/>
+    <Bodies>1</Bodies>
+    <Body>
+        <Name>Old</Name>
+        <RGBColor>255</RGBColor>
+        <Bone><X>1</X><Y>2</Y><Z>3</Z></Bone>
+    </Body>
+    <Euler>
+        <First>Roll</First>
+        <Second>Pitch</Second>
+        <Third>Yaw</Third>
+    </Euler>
+</QTM_Parameters_Ver_1.20>)XMLDATA";
+
+    Task<> Read6DOFSettings(RTConnection& connection, std::vector<SSettings6DOFBody>& bodies, SSettingsGeneral& general, bool& result)
+    {
+        bool dataAvailable = false;
+        result = co_await connection.Read6DOFSettingsAsync(bodies, general, dataAvailable) && dataAvailable;
+    }
+}
+
+TEST_CASE("CoroutineRead6DOFSettingsEulerTest")
+{
+    auto* network = new utils::DummyXmlNetwork{};
+    auto protocol = std::make_unique<CRTProtocol>();
+    protocol->OverrideNetwork(network->GetInterfacePtr());
+    network->PrepareResponse("Version 1.20", "Version set to 1.20", CRTPacket::PacketCommand);
+    REQUIRE(protocol->Connect("", CRTProtocol::cDefaultBasePort, nullptr, 1, 20));
+    network->PrepareResponse("GetParameters 6D", c6DSettingsVersion120, CRTPacket::PacketXML);
+
+    RTReactor reactor;
+    RTConnection connection(reactor, *protocol);
+    std::vector<SSettings6DOFBody> bodies;
+    SSettingsGeneral general;
+    bool result = false;
+    reactor.Spawn(Read6DOFSettings(connection, bodies, general, result));
+    for (int i = 0; i < 10; i++)
+    {
+        reactor.RunOnce(0);
+    }
+
+    REQUIRE(result);
+    REQUIRE(bodies.size() == 1);
+    CHECK(bodies[0].name == "Old");
+    CHECK(general.eulerRotations[0] == "Roll");
+    CHECK(general.eulerRotations[1] == "Pitch");
+    CHECK(general.eulerRotations[2] == "Yaw");
+}
+
+#endif
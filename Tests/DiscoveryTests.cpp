@@ -0,0 +1,192 @@
+#include <doctest/doctest.h>
+
+#include <DiscoveryService.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace qualisys_cpp_sdk;
+
+namespace
+{
+    // Answers every discover broadcast with one response per server.
+    class DummyDiscoverNetwork : public INetwork
+    {
+    public:
+        struct Server
+        {
+            unsigned int   address;
+            unsigned short basePort;
+            std::string    message;
+        };
+
+        void SetServers(const std::vector<Server>& servers)
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mServers = servers;
+        }
+
+        unsigned int GetBroadcastCount()
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            return mBroadcastCount;
+        }
+
+        unsigned int GetInterfaceRefreshCount()
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            return mInterfaceRefreshCount;
+        }
+
+        bool  Connect(const char*, unsigned short) override { return false; }
+        void  Disconnect() override {}
+        bool  Connected() const override { return false; }
+        bool  CreateUDPSocket(unsigned short& port, bool) override
+        {
+            port = 4545;
+            return true;
+        }
+        Response Receive(char*, int, bool, int, unsigned int*) override
+        {
+            return Response(ResponseType::error, 0);
+        }
+        Response ReceiveUdpBroadcast(char* buffer, int bufferSize, int, unsigned int* ipAddr) override
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            if (mPending.empty())
+            {
+                return Response(ResponseType::timeout, 0);
+            }
+            const auto server = mPending.front();
+            mPending.erase(mPending.begin());
+
+            const std::uint32_t size = static_cast<std::uint32_t>(8 + server.message.size() + 1 + 2);
+            const std::uint32_t type = CRTPacket::PacketCommand;
+            const unsigned short port = htons(server.basePort);
+            if (static_cast<int>(size) > bufferSize)
+            {
+                return Response(ResponseType::error, 0);
+            }
+            std::memcpy(buffer, &size, 4);
+            std::memcpy(buffer + 4, &type, 4);
+            std::memcpy(buffer + 8, server.message.c_str(), server.message.size() + 1);
+            std::memcpy(buffer + 8 + server.message.size() + 1, &port, 2);
+            *ipAddr = server.address;
+            return Response(ResponseType::success, static_cast<int>(size));
+        }
+        bool  Send(const char*, int) override { return false; }
+        bool  SendUDPBroadcast(const char* data, int size, short, unsigned int) override
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            if (size != 10 || ntohs(*reinterpret_cast<const unsigned short*>(data + 8)) != 4545)
+            {
+                return false;
+            }
+            mBroadcastCount++;
+            mPending = mServers;
+            return true;
+        }
+        char* GetErrorString() override { return mErrorStr; }
+        int   GetError() const override { return 0; }
+        bool  IsLocalAddress(unsigned int addr) const override { return addr == cLocalAddress; }
+        void  RefreshInterfaces() override
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mInterfaceRefreshCount++;
+        }
+        unsigned short GetUdpServerPort() override { return 0; }
+        unsigned short GetUdpBroadcastServerPort() override { return 4545; }
+
+        static const unsigned int cLocalAddress = 0x0100007f; // 127.0.0.1
+
+    private:
+        std::mutex          mMutex;
+        std::vector<Server> mServers;
+        std::vector<Server> mPending;
+        unsigned int        mBroadcastCount = 0;
+        unsigned int        mInterfaceRefreshCount = 0;
+        char                mErrorStr[1] = { 0 };
+    };
+}
+
+TEST_CASE("DiscoveryServiceTableTest")
+{
+    auto network = new DummyDiscoverNetwork();
+    network->SetServers({
+        { 0x0a01a8c0, 22222, "lab-one, QTM 2024.1, 8 cameras" }, // 192.168.1.10
+        { DummyDiscoverNetwork::cLocalAddress, 22222, "localhost, QTM 2024.1, 0 cameras" }
+    });
+
+    DiscoveryService discovery(CRTProtocol::cDefaultAutoDiscoverPort, 20000, 200000);
+    discovery.OverrideNetwork(network);
+
+    std::mutex eventMutex;
+    std::vector<std::pair<DiscoveryService::EEvent, std::string>> events;
+    REQUIRE(discovery.Start([&](DiscoveryService::EEvent event, const DiscoveredServer& server)
+    {
+        std::lock_guard<std::mutex> lock(eventMutex);
+        events.emplace_back(event, server.GetHostName());
+    }, true));
+
+    REQUIRE(discovery.WaitForServers(1, 2000000));
+
+    DiscoveredServer server;
+    REQUIRE(discovery.FindServer("lab-one", server));
+    CHECK(server.GetAddressString() == "192.168.1.10");
+    CHECK(server.basePort == 22222);
+    CHECK_FALSE(server.local);
+    CHECK(discovery.FindServer("192.168.1.10", server));
+    CHECK_FALSE(discovery.FindServer("localhost", server));
+
+    // The table is refreshed by the repeated broadcasts, the interfaces are only read at start.
+    while (network->GetBroadcastCount() < 5)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    CHECK(discovery.GetServers().size() == 1);
+    CHECK(network->GetInterfaceRefreshCount() == 1);
+
+    network->SetServers({ { 0x0a01a8c0, 22222, "lab-one, QTM 2024.1, 12 cameras" } });
+    while (network->GetBroadcastCount() < 8)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    REQUIRE(discovery.FindServer("lab-one", server));
+    CHECK(server.message == "lab-one, QTM 2024.1, 12 cameras");
+
+    // Servers that stop responding expire.
+    network->SetServers({ });
+    for (int i = 0; i < 200 && !discovery.GetServers().empty(); i++)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    CHECK(discovery.GetServers().empty());
+    discovery.Stop();
+
+    REQUIRE(events.size() == 3);
+    CHECK(events[0].first == DiscoveryService::EEvent::Found);
+    CHECK(events[1].first == DiscoveryService::EEvent::Changed);
+    CHECK(events[2].first == DiscoveryService::EEvent::Lost);
+    for (const auto& event : events)
+    {
+        CHECK(event.second == "lab-one");
+    }
+}
+
+TEST_CASE("DiscoveryServiceConnectUnknownServerTest")
+{
+    auto network = new DummyDiscoverNetwork();
+    DiscoveryService discovery(CRTProtocol::cDefaultAutoDiscoverPort, 20000, 200000);
+    discovery.OverrideNetwork(network);
+    REQUIRE(discovery.Start());
+
+    CRTProtocol protocol;
+    CHECK_FALSE(discovery.Connect(protocol, "lab-two", 50000));
+    CHECK(std::string(discovery.GetErrorString()) == "Server lab-two has not been discovered.");
+    CHECK(network->GetBroadcastCount() >= 1);
+}
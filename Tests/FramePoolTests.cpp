@@ -0,0 +1,106 @@
+#include <doctest/doctest.h>
+
+#include <FramePool.h>
+#include <RTPacket.h>
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <utility>
+#include <vector>
+
+using namespace qualisys_cpp_sdk;
+
+namespace
+{
+    std::vector<char> CreateCommandPacket(const char* str)
+    {
+        const auto size = static_cast<std::uint32_t>(8 + std::strlen(str) + 1);
+        const auto type = static_cast<std::uint32_t>(CRTPacket::PacketCommand);
+
+        std::vector<char> packet(size);
+        std::memcpy(packet.data(), &size, sizeof(size));
+        std::memcpy(packet.data() + 4, &type, sizeof(type));
+        std::memcpy(packet.data() + 8, str, std::strlen(str) + 1);
+        return packet;
+    }
+}
+
+TEST_CASE("FramePoolHandleTest")
+{
+    FramePool pool(2, 1024);
+    auto data = CreateCommandPacket("Frame");
+    CRTPacket packet;
+    packet.SetData(data.data());
+
+    auto handle = pool.Copy(packet);
+    REQUIRE(handle);
+    CHECK(std::strcmp(handle->GetCommandString(), "Frame") == 0);
+    CHECK(handle.GetUseCount() == 1);
+    CHECK(pool.GetFreeBlockCount() == 1);
+
+    {
+        auto shared = handle;
+        CHECK(shared.Get() == handle.Get());
+        CHECK(handle.GetUseCount() == 2);
+    }
+    CHECK(handle.GetUseCount() == 1);
+
+    auto moved = std::move(handle);
+    CHECK_FALSE(handle);
+    CHECK(moved.GetUseCount() == 1);
+
+    moved.Reset();
+    CHECK(pool.GetFreeBlockCount() == 2);
+}
+
+TEST_CASE("FramePoolOutlivedTest")
+{
+    auto pool = std::make_unique<FramePool>(2, 1024);
+    auto data = CreateCommandPacket("Frame");
+    CRTPacket packet;
+    packet.SetData(data.data());
+
+    auto first = pool->Copy(packet);
+    auto second = pool->Copy(packet);
+    REQUIRE(first);
+    REQUIRE(second);
+    auto shared = first;
+
+    // The handles keep the buffers alive.
+    pool.reset();
+    CHECK(std::strcmp(shared->GetCommandString(), "Frame") == 0);
+    first.Reset();
+    second.Reset();
+    CHECK(std::strcmp(shared->GetCommandString(), "Frame") == 0);
+    CHECK(shared.GetUseCount() == 1);
+}
+
+TEST_CASE("FramePoolExhaustedTest")
+{
+    FramePool pool(2, 1024);
+
+    auto first = pool.Acquire(100);
+    auto second = pool.Acquire(100);
+    CHECK(first);
+    CHECK(second);
+    CHECK_FALSE(pool.Acquire(100));
+
+    second.Reset();
+    CHECK(pool.Acquire(100));
+}
+
+TEST_CASE("FramePoolReuseTest")
+{
+    FramePool pool(1, 1024);
+
+    auto frame = pool.Acquire(512);
+    REQUIRE(frame);
+    const char* data = frame.GetData();
+    frame.Reset();
+
+    // A buffer within the retained size is reused without allocating.
+    frame = pool.Acquire(256);
+    REQUIRE(frame);
+    CHECK(frame.GetData() == data);
+}
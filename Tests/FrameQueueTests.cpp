@@ -0,0 +1,117 @@
+#include <doctest/doctest.h>
+
+#include <FrameQueue.h>
+#include <RTPacket.h>
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+using namespace qualisys_cpp_sdk;
+
+namespace
+{
+    std::vector<char> CreateCommandPacket(const char* str)
+    {
+        const auto size = static_cast<std::uint32_t>(8 + std::strlen(str) + 1);
+        const auto type = static_cast<std::uint32_t>(CRTPacket::PacketCommand);
+
+        std::vector<char> packet(size);
+        std::memcpy(packet.data(), &size, sizeof(size));
+        std::memcpy(packet.data() + 4, &type, sizeof(type));
+        std::memcpy(packet.data() + 8, str, std::strlen(str) + 1);
+        return packet;
+    }
+
+    bool Push(FrameQueue& queue, const char* str)
+    {
+        auto data = CreateCommandPacket(str);
+        CRTPacket packet;
+        packet.SetData(data.data());
+        return queue.Push(packet);
+    }
+
+    void Write(FrameMailbox& mailbox, const char* str, unsigned long long receiveTimestamp = 0)
+    {
+        auto data = CreateCommandPacket(str);
+        CRTPacket packet;
+        packet.SetData(data.data());
+        packet.SetReceiveTimestamp(receiveTimestamp);
+        mailbox.Write(packet);
+    }
+}
+
+TEST_CASE("FrameQueueOrderTest")
+{
+    FrameQueue queue(3);
+    CHECK(queue.GetCapacity() == 4);
+    CHECK(queue.Pop() == nullptr);
+
+    CHECK(Push(queue, "First"));
+    CHECK(Push(queue, "Second"));
+
+    auto packet = queue.Pop();
+    REQUIRE(packet != nullptr);
+    CHECK(std::strcmp(packet->GetCommandString(), "First") == 0);
+
+    packet = queue.Pop();
+    REQUIRE(packet != nullptr);
+    CHECK(std::strcmp(packet->GetCommandString(), "Second") == 0);
+
+    CHECK(queue.Pop() == nullptr);
+    CHECK(queue.GetDroppedCount() == 0);
+}
+
+TEST_CASE("FrameQueueDropTest")
+{
+    FrameQueue queue(2);
+
+    CHECK(Push(queue, "First"));
+    CHECK(Push(queue, "Second"));
+    CHECK_FALSE(Push(queue, "Third"));
+    CHECK(queue.GetDroppedCount() == 1);
+
+    // The popped packet keeps its slot until the next pop.
+    auto packet = queue.Pop();
+    REQUIRE(packet != nullptr);
+    CHECK_FALSE(Push(queue, "Fourth"));
+    CHECK(std::strcmp(packet->GetCommandString(), "First") == 0);
+    CHECK(queue.GetDroppedCount() == 2);
+
+    packet = queue.Pop();
+    REQUIRE(packet != nullptr);
+    CHECK(std::strcmp(packet->GetCommandString(), "Second") == 0);
+    CHECK(Push(queue, "Fifth"));
+
+    packet = queue.Pop();
+    REQUIRE(packet != nullptr);
+    CHECK(std::strcmp(packet->GetCommandString(), "Fifth") == 0);
+}
+
+TEST_CASE("FrameMailboxLatestFrameTest")
+{
+    FrameMailbox mailbox;
+    CHECK(mailbox.Read() == nullptr);
+
+    Write(mailbox, "First", 1);
+    Write(mailbox, "Second", 2);
+
+    auto packet = mailbox.Read();
+    REQUIRE(packet != nullptr);
+    CHECK(std::strcmp(packet->GetCommandString(), "Second") == 0);
+    CHECK(packet->GetReceiveTimestamp() == 2);
+    CHECK(mailbox.GetSkippedCount() == 1);
+
+    // Without new data, the same packet is returned again.
+    CHECK(mailbox.Read() == packet);
+
+    // Writing never touches the packet held by the reader.
+    Write(mailbox, "Third");
+    Write(mailbox, "First");
+    CHECK(std::strcmp(packet->GetCommandString(), "Second") == 0);
+
+    packet = mailbox.Read();
+    REQUIRE(packet != nullptr);
+    CHECK(std::strcmp(packet->GetCommandString(), "First") == 0);
+    CHECK(mailbox.GetSkippedCount() == 2);
+}
@@ -0,0 +1,344 @@
+#include "TestUtils.h"
+
+#include <doctest/doctest.h>
+
+#include <PacketLog.h>
+#include <RTProtocol.h>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace qualisys_cpp_sdk;
+using namespace qualisys_cpp_sdk::tests;
+
+namespace
+{
+    std::string ReadFile(const std::string& fileName)
+    {
+        std::ifstream stream(fileName, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+    }
+
+    struct Segment
+    {
+        PacketLogHeader                  header;
+        std::vector<PacketLogIndexEntry> index;
+        std::string                      data;
+    };
+
+    // Read a completed segment and check its layout.
+    Segment ReadSegment(const std::string& fileName)
+    {
+        Segment segment;
+        segment.data = ReadFile(fileName);
+        REQUIRE(segment.data.size() >= sizeof(PacketLogHeader) + sizeof(PacketLogFooter));
+        std::memcpy(&segment.header, segment.data.data(), sizeof(segment.header));
+        CHECK(std::memcmp(segment.header.magic, cPacketLogMagic, 8) == 0);
+
+        PacketLogFooter footer;
+        std::memcpy(&footer, segment.data.data() + segment.data.size() - sizeof(footer), sizeof(footer));
+        CHECK(std::memcmp(footer.magic, cPacketLogIndexMagic, 8) == 0);
+        REQUIRE(footer.indexOffset + footer.recordCount * sizeof(PacketLogIndexEntry) + sizeof(footer) == segment.data.size());
+
+        segment.index.resize(footer.recordCount);
+        std::memcpy(segment.index.data(), segment.data.data() + footer.indexOffset, segment.index.size() * sizeof(PacketLogIndexEntry));
+
+        // The records are back to back, up to the index.
+        std::uint64_t offset = sizeof(PacketLogHeader);
+        for (const auto& entry : segment.index)
+        {
+            CHECK(entry.recordOffset == offset);
+            PacketLogRecord record;
+            std::memcpy(&record, segment.data.data() + entry.recordOffset, sizeof(record));
+            CHECK(record.size % 8 == 0);
+            CHECK(record.receiveTimestamp == entry.receiveTimestamp);
+            offset += record.size;
+        }
+        CHECK(offset == footer.indexOffset);
+        return segment;
+    }
+
+    std::string CreateDataPacket(std::uint64_t timestamp, std::uint32_t frameNumber, std::size_t payloadSize)
+    {
+        const std::uint32_t header[2] = { static_cast<std::uint32_t>(24 + payloadSize), static_cast<std::uint32_t>(CRTPacket::PacketData) };
+        const std::uint32_t componentCount = 0;
+        std::string packet(reinterpret_cast<const char*>(header), sizeof(header));
+        packet.append(reinterpret_cast<const char*>(&timestamp), sizeof(timestamp));
+        packet.append(reinterpret_cast<const char*>(&frameNumber), sizeof(frameNumber));
+        packet.append(reinterpret_cast<const char*>(&componentCount), sizeof(componentCount));
+        return packet + std::string(payloadSize, 'p');
+    }
+}
+
+TEST_CASE("PacketLogRecordTest")
+{
+    auto [protocol, network] = utils::CreateTestContext();
+    const auto fileName = (std::filesystem::temp_directory_path() / "qualisys_cpp_sdk_packet_log_test.qpl").string();
+
+    PacketLogWriter log(fileName.c_str());
+    if (!log.IsOpen())
+    {
+        FAIL(log.GetErrorString());
+    }
+    protocol->SetPacketLog(&log);
+
+    const auto packet = CreateDataPacket(1000, 1, 3);
+    network->QueueData(packet.data(), packet.size());
+    network->QueueResponse("Event", CRTPacket::PacketCommand);
+    network->QueueDataPacket(2000, 2);
+
+    CRTPacket::EPacketType type;
+    for (int i = 0; i < 3; i++)
+    {
+        REQUIRE(protocol->Receive(type, true, 0) == CNetwork::ResponseType::success);
+    }
+    protocol->SetPacketLog(nullptr);
+    REQUIRE(log.Close());
+    CHECK(log.GetRecordCount() == 2);
+    CHECK(log.GetDroppedCount() == 0);
+    CHECK(log.GetSegmentCount() == 1);
+
+    // Only the data packets, as received, and the unused next segment is removed.
+    const auto segment = ReadSegment(PacketLogWriter::GetSegmentFileName(fileName, 0));
+    CHECK_FALSE(std::filesystem::exists(PacketLogWriter::GetSegmentFileName(fileName, 1)));
+    CHECK(segment.header.segmentIndex == 0);
+    CHECK(segment.header.majorVersion == MAJOR_VERSION);
+    CHECK(segment.header.bigEndian == 0);
+    REQUIRE(segment.index.size() == 2);
+    CHECK(segment.index[0].frameNumber == 1);
+    CHECK(segment.index[0].timestamp == 1000);
+    CHECK(segment.index[1].frameNumber == 2);
+    CHECK(segment.index[1].timestamp == 2000);
+    CHECK(segment.index[1].receiveTimestamp >= segment.index[0].receiveTimestamp);
+
+    PacketLogRecord record;
+    std::memcpy(&record, segment.data.data() + segment.index[0].recordOffset, sizeof(record));
+    CHECK(record.packetSize == packet.size());
+    CHECK(segment.data.compare(segment.index[0].recordOffset + sizeof(record), packet.size(), packet) == 0);
+
+    std::filesystem::remove(PacketLogWriter::GetSegmentFileName(fileName, 0));
+}
+
+TEST_CASE("PacketLogSegmentsTest")
+{
+    auto [protocol, network] = utils::CreateTestContext();
+    const auto fileName = (std::filesystem::temp_directory_path() / "qualisys_cpp_sdk_packet_log_segments_test.qpl").string();
+
+    PacketLogWriter log(fileName.c_str(), PacketLogWriter::cMinSegmentSize);
+    REQUIRE(log.IsOpen());
+    protocol->SetPacketLog(&log);
+
+    // Larger than a segment, never recorded.
+    const auto large = CreateDataPacket(0, 0, PacketLogWriter::cMinSegmentSize);
+    network->QueueData(large.data(), large.size());
+
+    const unsigned int frameCount = 150;
+    for (unsigned int frame = 1; frame <= frameCount; frame++)
+    {
+        network->QueueDataPacket(frame * 10ull, frame);
+    }
+
+    CRTPacket::EPacketType type;
+    for (unsigned int i = 0; i <= frameCount; i++)
+    {
+        REQUIRE(protocol->Receive(type, true, 0) == CNetwork::ResponseType::success);
+        // Give the log thread time to prepare the next segment.
+        std::this_thread::sleep_for(std::chrono::microseconds(500));
+    }
+    REQUIRE(log.Close());
+    CHECK(log.GetRecordCount() == frameCount);
+    CHECK(log.GetDroppedCount() == 1);
+    REQUIRE(log.GetSegmentCount() == 3);
+
+    unsigned int expectedFrame = 1;
+    for (unsigned int index = 0; index < log.GetSegmentCount(); index++)
+    {
+        const auto segmentFileName = PacketLogWriter::GetSegmentFileName(fileName, index);
+        const auto segment = ReadSegment(segmentFileName);
+        CHECK(segment.header.segmentIndex == index);
+        for (const auto& entry : segment.index)
+        {
+            CHECK(entry.frameNumber == expectedFrame);
+            CHECK(entry.timestamp == expectedFrame * 10ull);
+            expectedFrame++;
+        }
+        std::filesystem::remove(segmentFileName);
+    }
+    CHECK(expectedFrame == frameCount + 1);
+}
+
+namespace
+{
+    // Record frames 1 to frameCount, frameInterval apart.
+    void RecordPacketLog(const std::string& fileName, unsigned int frameCount, std::chrono::microseconds frameInterval)
+    {
+        auto [protocol, network] = utils::CreateTestContext();
+        PacketLogWriter log(fileName.c_str());
+        REQUIRE(log.IsOpen());
+        protocol->SetPacketLog(&log);
+
+        CRTPacket::EPacketType type;
+        for (unsigned int frame = 1; frame <= frameCount; frame++)
+        {
+            network->QueueDataPacket(frame * 1000ull, frame);
+            REQUIRE(protocol->Receive(type, true, 0) == CNetwork::ResponseType::success);
+            std::this_thread::sleep_for(frameInterval);
+        }
+        REQUIRE(log.Close());
+    }
+}
+
+TEST_CASE("PacketLogPlaybackTest")
+{
+    const auto fileName = (std::filesystem::temp_directory_path() / "qualisys_cpp_sdk_packet_log_playback_test.qpl").string();
+    const unsigned int frameCount = 20;
+    RecordPacketLog(fileName, frameCount, std::chrono::microseconds(0));
+
+    auto* playback = new PacketLogNetwork(fileName.c_str());
+    if (!playback->IsOpen())
+    {
+        FAIL(playback->GetErrorString());
+    }
+    CHECK(playback->GetFrameCount() == frameCount);
+
+    CRTProtocol protocol;
+    protocol.OverrideNetwork(playback);
+    REQUIRE(protocol.Connect("127.0.0.1"));
+
+    // Settings aren't recorded.
+    CHECK_FALSE(protocol.ReadGeneralSettings());
+
+    REQUIRE(protocol.StreamFrames(CRTProtocol::cComponent3d));
+    CRTPacket::EPacketType type;
+    for (unsigned int frame = 1; frame <= frameCount; frame++)
+    {
+        REQUIRE(protocol.Receive(type, true, 0) == CNetwork::ResponseType::success);
+        REQUIRE(type == CRTPacket::PacketData);
+        CHECK(protocol.GetRTPacket()->GetFrameNumber() == frame);
+        CHECK(protocol.GetRTPacket()->GetTimeStamp() == frame * 1000ull);
+        CHECK(protocol.GetRTPacket()->GetReceiveTimestamp() != 0);
+    }
+    REQUIRE(protocol.Receive(type, false, 0) == CNetwork::ResponseType::success);
+    REQUIRE(type == CRTPacket::PacketEvent);
+    CRTPacket::EEvent event;
+    REQUIRE(protocol.GetRTPacket()->GetEvent(event));
+    CHECK(event == CRTPacket::EventRTfromFileStopped);
+    CHECK(playback->IsFinished());
+    CHECK(protocol.Receive(type, false, 0) == CNetwork::ResponseType::timeout);
+
+    // Step through single frames from a seek position.
+    REQUIRE(playback->SeekFrame(10));
+    CHECK(playback->GetPosition() == 9);
+    REQUIRE(protocol.GetCurrentFrame(CRTProtocol::cComponent3d));
+    REQUIRE(protocol.Receive(type, true, 0) == CNetwork::ResponseType::success);
+    CHECK(protocol.GetRTPacket()->GetFrameNumber() == 10);
+    CHECK(protocol.Receive(type, true, 0) == CNetwork::ResponseType::timeout);
+    CHECK_FALSE(playback->SeekFrame(frameCount + 1));
+
+    protocol.Disconnect();
+    std::filesystem::remove(PacketLogWriter::GetSegmentFileName(fileName, 0));
+}
+
+TEST_CASE("PacketLogPlaybackSpeedTest")
+{
+    const auto fileName = (std::filesystem::temp_directory_path() / "qualisys_cpp_sdk_packet_log_speed_test.qpl").string();
+    const unsigned int frameCount = 10;
+    RecordPacketLog(fileName, frameCount, std::chrono::milliseconds(5));
+
+    auto play = [&](double speed)
+    {
+        CRTProtocol protocol;
+        protocol.OverrideNetwork(new PacketLogNetwork(fileName.c_str(), speed));
+        REQUIRE(protocol.Connect("127.0.0.1"));
+        REQUIRE(protocol.StreamFrames(CRTProtocol::cComponent3d));
+
+        const auto start = std::chrono::steady_clock::now();
+        CRTPacket::EPacketType type;
+        for (unsigned int frame = 1; frame <= frameCount; frame++)
+        {
+            REQUIRE(protocol.Receive(type, true) == CNetwork::ResponseType::success);
+            CHECK(protocol.GetRTPacket()->GetFrameNumber() == frame);
+        }
+        return std::chrono::steady_clock::now() - start;
+    };
+
+    // Nine intervals of at least 5 ms were recorded.
+    CHECK(play(1.0) >= std::chrono::milliseconds(45));
+    CHECK(play(3.0) >= std::chrono::milliseconds(15));
+    CHECK(play(0.0) < std::chrono::milliseconds(45));
+
+    std::filesystem::remove(PacketLogWriter::GetSegmentFileName(fileName, 0));
+}
+
+TEST_CASE("PacketLogPlaybackClockStepTest")
+{
+    const auto fileName = (std::filesystem::temp_directory_path() / "qualisys_cpp_sdk_packet_log_clock_test.qpl").string();
+    const unsigned int frameCount = 4;
+    RecordPacketLog(fileName, frameCount, std::chrono::microseconds(0));
+
+    // The system clock was set back an hour before the third frame was received.
+    const auto segmentFileName = PacketLogWriter::GetSegmentFileName(fileName, 0);
+    {
+        const auto segment = ReadSegment(segmentFileName);
+        std::fstream stream(segmentFileName, std::ios::binary | std::ios::in | std::ios::out);
+        for (std::size_t record = 2; record < segment.index.size(); record++)
+        {
+            const std::uint64_t receiveTimestamp = segment.index[record].receiveTimestamp - 3600000000000ull;
+            stream.seekp(segment.index[record].recordOffset + offsetof(PacketLogRecord, receiveTimestamp));
+            stream.write(reinterpret_cast<const char*>(&receiveTimestamp), sizeof(receiveTimestamp));
+        }
+    }
+
+    CRTProtocol protocol;
+    protocol.OverrideNetwork(new PacketLogNetwork(fileName.c_str(), 1.0));
+    REQUIRE(protocol.Connect("127.0.0.1"));
+    REQUIRE(protocol.StreamFrames(CRTProtocol::cComponent3d));
+
+    // Played back without waiting.
+    CRTPacket::EPacketType type;
+    for (unsigned int frame = 1; frame <= frameCount; frame++)
+    {
+        REQUIRE(protocol.Receive(type, true, 100000) == CNetwork::ResponseType::success);
+        CHECK(protocol.GetRTPacket()->GetFrameNumber() == frame);
+    }
+
+    protocol.Disconnect();
+    std::filesystem::remove(segmentFileName);
+}
+
+TEST_CASE("PacketLogPlaybackResponseLifetimeTest")
+{
+    const auto fileName = (std::filesystem::temp_directory_path() / "qualisys_cpp_sdk_packet_log_response_test.qpl").string();
+    RecordPacketLog(fileName, 1, std::chrono::microseconds(0));
+
+    PacketLogNetwork playback(fileName.c_str());
+    REQUIRE(playback.Connect("127.0.0.1", 0));
+    char* connected;
+    REQUIRE(playback.ReceivePacket(connected, 0).type == CNetwork::ResponseType::success);
+
+    // Responses to commands sent while the packet is still in use don't move it.
+    for (int i = 0; i < 100; i++)
+    {
+        const std::string command = "Unsupported command " + std::to_string(i);
+        std::vector<char> packet(8 + command.size() + 1);
+        const std::uint32_t header[2] = { static_cast<std::uint32_t>(packet.size()), static_cast<std::uint32_t>(CRTPacket::PacketCommand) };
+        std::memcpy(packet.data(), header, sizeof(header));
+        std::memcpy(packet.data() + 8, command.c_str(), command.size() + 1);
+        REQUIRE(playback.Send(packet.data(), static_cast<int>(packet.size())));
+    }
+    CHECK(std::string(connected + 8) == "QTM RT Interface connected");
+
+    char* response;
+    REQUIRE(playback.ReceivePacket(response, 0).type == CNetwork::ResponseType::success);
+    CHECK(std::string(response + 8) == "Unsupported command 0 is not available in packet log playback.");
+
+    std::filesystem::remove(PacketLogWriter::GetSegmentFileName(fileName, 0));
+}
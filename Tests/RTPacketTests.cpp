@@ -0,0 +1,838 @@
+#include <doctest/doctest.h>
+
+#include <RTPacket.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    // Data packet, little endian unless bigEndian is set.
+    class DataPacketBuilder
+    {
+    public:
+        DataPacketBuilder(std::uint64_t timestamp, std::uint32_t frameNumber, bool bigEndian = false)
+            : mBigEndian(bigEndian)
+        {
+            Put<std::uint32_t>(0);
+            Put<std::uint32_t>(CRTPacket::PacketData);
+            Put<std::uint64_t>(timestamp);
+            Put<std::uint32_t>(frameNumber);
+            Put<std::uint32_t>(0); // Component count
+        }
+
+        template <typename T>
+        void Put(T value)
+        {
+            const auto offset = mData.size();
+            mData.resize(offset + sizeof(T));
+            std::memcpy(mData.data() + offset, &value, sizeof(T));
+            if (mBigEndian)
+            {
+                std::reverse(mData.begin() + offset, mData.end());
+            }
+        }
+
+        // 2D, 3D and 6D components have drop and out of sync rates after the count.
+        void BeginComponent(CRTPacket::EComponentType type, std::uint32_t count, bool rates)
+        {
+            mComponentStart = mData.size();
+            Put<std::uint32_t>(0);
+            Put<std::uint32_t>(type);
+            Put<std::uint32_t>(count);
+            if (rates)
+            {
+                Put<std::uint16_t>(0);
+                Put<std::uint16_t>(0);
+            }
+        }
+
+        void EndComponent()
+        {
+            Patch(mComponentStart, static_cast<std::uint32_t>(mData.size() - mComponentStart));
+            mComponentCount++;
+        }
+
+        std::vector<char>& Finish()
+        {
+            Patch(0, static_cast<std::uint32_t>(mData.size()));
+            Patch(20, mComponentCount);
+            return mData;
+        }
+
+    private:
+        void Patch(std::size_t offset, std::uint32_t value)
+        {
+            std::memcpy(mData.data() + offset, &value, sizeof(value));
+            if (mBigEndian)
+            {
+                std::reverse(mData.begin() + offset, mData.begin() + offset + sizeof(value));
+            }
+        }
+
+        bool              mBigEndian;
+        std::vector<char> mData;
+        std::size_t       mComponentStart = 0;
+        std::uint32_t     mComponentCount = 0;
+    };
+
+    // Cameras and devices of different sizes, so that each one starts at an offset that depends on the others.
+    std::vector<char> CreateMixedPacket()
+    {
+        DataPacketBuilder builder(1000, 7);
+
+        builder.BeginComponent(CRTPacket::Component6d, 1, true);
+        for (float value : { 1.0f, 2.0f, 3.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f })
+        {
+            builder.Put(value);
+        }
+        builder.EndComponent();
+
+        builder.BeginComponent(CRTPacket::Component2d, 3, true);
+        for (std::uint32_t camera = 0; camera < 3; camera++)
+        {
+            const std::uint32_t markerCount = camera == 1 ? 0 : camera + 1;
+            builder.Put(markerCount);
+            builder.Put<std::uint8_t>(static_cast<std::uint8_t>(camera));
+            for (std::uint32_t marker = 0; marker < markerCount; marker++)
+            {
+                builder.Put<std::uint32_t>(camera * 100 + marker);
+                builder.Put<std::uint32_t>(camera * 200 + marker);
+                builder.Put<std::uint16_t>(10);
+                builder.Put<std::uint16_t>(20);
+            }
+        }
+        builder.EndComponent();
+
+        builder.BeginComponent(CRTPacket::ComponentAnalog, 2, false);
+        for (std::uint32_t device = 0; device < 2; device++)
+        {
+            const std::uint32_t channelCount = device + 2;
+            const std::uint32_t sampleCount = 3;
+            builder.Put<std::uint32_t>(device + 1);
+            builder.Put(channelCount);
+            builder.Put(sampleCount);
+            builder.Put<std::uint32_t>(50);
+            for (std::uint32_t i = 0; i < channelCount * sampleCount; i++)
+            {
+                builder.Put(static_cast<float>(device * 100 + i));
+            }
+        }
+        builder.EndComponent();
+
+        builder.BeginComponent(CRTPacket::ComponentForce, 2, false);
+        for (std::uint32_t plate = 0; plate < 2; plate++)
+        {
+            builder.Put<std::uint32_t>(plate + 1);
+            builder.Put<std::uint32_t>(plate + 1); // Force count
+            builder.Put<std::uint32_t>(60);
+            for (std::uint32_t i = 0; i < (plate + 1) * 9; i++)
+            {
+                builder.Put(static_cast<float>(plate * 1000 + i));
+            }
+        }
+        builder.EndComponent();
+
+        builder.BeginComponent(CRTPacket::ComponentSkeleton, 2, false);
+        for (std::uint32_t skeleton = 0; skeleton < 2; skeleton++)
+        {
+            builder.Put<std::uint32_t>(skeleton + 1); // Segment count
+            for (std::uint32_t segment = 0; segment <= skeleton; segment++)
+            {
+                builder.Put<std::uint32_t>(skeleton * 10 + segment);
+                for (int i = 0; i < 7; i++)
+                {
+                    builder.Put(static_cast<float>(i));
+                }
+            }
+        }
+        builder.EndComponent();
+
+        return builder.Finish();
+    }
+
+    void CheckMixedPacket(CRTPacket& packet)
+    {
+        CHECK(packet.GetComponentCount() == 5);
+        CHECK(packet.Get6DOFBodyCount() == 1);
+
+        REQUIRE(packet.Get2DCameraCount() == 3);
+        CHECK(packet.Get2DMarkerCount(0) == 1);
+        CHECK(packet.Get2DMarkerCount(1) == 0);
+        CHECK(packet.Get2DMarkerCount(2) == 3);
+        CHECK(packet.Get2DStatusFlags(2) == 2);
+        unsigned int x, y;
+        unsigned short xDiameter, yDiameter;
+        REQUIRE(packet.Get2DMarker(2, 2, x, y, xDiameter, yDiameter));
+        CHECK(x == 202);
+        CHECK(y == 402);
+        CHECK(yDiameter == 20);
+        CHECK_FALSE(packet.Get2DMarker(1, 0, x, y, xDiameter, yDiameter));
+
+        REQUIRE(packet.GetAnalogDeviceCount() == 2);
+        CHECK(packet.GetAnalogDeviceId(1) == 2);
+        CHECK(packet.GetAnalogChannelCount(1) == 3);
+        float analogValue;
+        REQUIRE(packet.GetAnalogData(1, 2, 1, analogValue));
+        CHECK(analogValue == 107.0f);
+
+        REQUIRE(packet.GetForcePlateCount() == 2);
+        CHECK(packet.GetForcePlateId(1) == 2);
+        CHECK(packet.GetForceCount(1) == 2);
+        CRTPacket::SForce force;
+        REQUIRE(packet.GetForceData(1, 1, force));
+        CHECK(force.fForceX == 1009.0f);
+
+        REQUIRE(packet.GetSkeletonCount() == 2);
+        CHECK(packet.GetSkeletonSegmentCount(1) == 2);
+        CRTPacket::SSkeletonSegment segment;
+        REQUIRE(packet.GetSkeletonSegment(1, 1, segment));
+        CHECK(segment.id == 11);
+        CHECK(segment.rotationW == 6.0f);
+    }
+}
+
+TEST_CASE("RTPacketLazyIndexTest")
+{
+    auto data = CreateMixedPacket();
+    CRTPacket packet;
+    packet.SetData(data.data());
+    CheckMixedPacket(packet);
+
+    // Indexed up front, and again after a packet without the components.
+    packet.SetData(data.data());
+    packet.IndexComponents();
+    CheckMixedPacket(packet);
+
+    DataPacketBuilder builder(2000, 8);
+    builder.BeginComponent(CRTPacket::Component6d, 0, true);
+    builder.EndComponent();
+    auto empty = builder.Finish();
+    packet.SetData(empty.data());
+    CHECK(packet.Get2DCameraCount() == 0);
+    CHECK(packet.Get2DMarkerCount(0) == 0);
+    CHECK(packet.GetAnalogDeviceCount() == 0);
+    CHECK(packet.GetSkeletonSegmentCount(0) == 0);
+
+    packet.SetData(data.data());
+    CheckMixedPacket(packet);
+}
+
+namespace
+{
+    // Camera c has c % 3 markers, marker m at (c, m).
+    std::vector<char> Create2DPacket(std::uint32_t cameraCount)
+    {
+        DataPacketBuilder builder(1000, 1);
+        builder.BeginComponent(CRTPacket::Component2d, cameraCount, true);
+        for (std::uint32_t camera = 0; camera < cameraCount; camera++)
+        {
+            builder.Put<std::uint32_t>(camera % 3);
+            builder.Put<std::uint8_t>(0);
+            for (std::uint32_t marker = 0; marker < camera % 3; marker++)
+            {
+                builder.Put<std::uint32_t>(camera);
+                builder.Put<std::uint32_t>(marker);
+                builder.Put<std::uint16_t>(0);
+                builder.Put<std::uint16_t>(0);
+            }
+        }
+        builder.EndComponent();
+        return builder.Finish();
+    }
+}
+
+TEST_CASE("RTPacketIndexCapacityTest")
+{
+    const std::uint32_t cameraCount = CRTPacket::cInlineIndexSize * 3;
+    auto large = Create2DPacket(cameraCount);
+    auto mixed = CreateMixedPacket();
+
+    // Grows past the inline entries when needed, and keeps the entries of the components indexed before.
+    CRTPacket packet;
+    CHECK(packet.GetIndexCapacity() == CRTPacket::cInlineIndexSize);
+    packet.SetData(mixed.data());
+    CHECK(packet.GetAnalogDeviceCount() == 2);
+    CheckMixedPacket(packet);
+    CHECK(packet.GetIndexCapacity() == CRTPacket::cInlineIndexSize);
+
+    packet.SetData(large.data());
+    unsigned int x, y;
+    unsigned short xDiameter, yDiameter;
+    REQUIRE(packet.Get2DMarker(cameraCount - 1, 1, x, y, xDiameter, yDiameter));
+    CHECK(x == cameraCount - 1);
+    CHECK(y == 1);
+    const auto capacity = packet.GetIndexCapacity();
+    CHECK(capacity >= cameraCount);
+
+    packet.SetData(mixed.data());
+    CheckMixedPacket(packet);
+    CHECK(packet.GetIndexCapacity() == capacity);
+
+    // Reserved up front.
+    CRTPacket reserved;
+    reserved.ReserveIndex(cameraCount);
+    CHECK(reserved.GetIndexCapacity() == cameraCount);
+    reserved.SetData(large.data());
+    reserved.IndexComponents();
+    CHECK(reserved.GetIndexCapacity() == cameraCount);
+    REQUIRE(reserved.Get2DMarker(cameraCount - 2, 0, x, y, xDiameter, yDiameter));
+    CHECK(x == cameraCount - 2);
+}
+
+TEST_CASE("RTPacketConcurrentIndexTest")
+{
+    const std::uint32_t cameraCount = CRTPacket::cInlineIndexSize * 3;
+    auto large = Create2DPacket(cameraCount);
+    auto mixed = CreateMixedPacket();
+
+    // Threads reading a shared packet index its components lazily, at the same time.
+    CRTPacket packet;
+    for (int round = 0; round < 50; round++)
+    {
+        packet.SetData(round % 2 == 0 ? large.data() : mixed.data());
+        std::atomic<bool> wrong(false);
+        std::vector<std::thread> threads;
+        for (int thread = 0; thread < 4; thread++)
+        {
+            threads.emplace_back([&packet, &wrong, cameraCount, round, thread]()
+            {
+                if (round % 2 == 0)
+                {
+                    for (std::uint32_t i = 0; i < cameraCount; i++)
+                    {
+                        const std::uint32_t camera = (i + thread * 17) % cameraCount;
+                        unsigned int x, y;
+                        unsigned short xDiameter, yDiameter;
+                        if (packet.Get2DMarkerCount(camera) != camera % 3 ||
+                            (camera % 3 > 0 && (!packet.Get2DMarker(camera, 0, x, y, xDiameter, yDiameter) || x != camera)))
+                        {
+                            wrong = true;
+                        }
+                    }
+                }
+                else
+                {
+                    float analogValue;
+                    CRTPacket::SSkeletonSegment segment;
+                    if (packet.GetForceCount(1) != 2 || !packet.GetAnalogData(1, 2, 1, analogValue) || analogValue != 107.0f ||
+                        !packet.GetSkeletonSegment(1, 1, segment) || segment.id != 11)
+                    {
+                        wrong = true;
+                    }
+                }
+            });
+        }
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+        if (wrong)
+        {
+            FAIL(("Wrong index in round " + std::to_string(round)).c_str());
+        }
+    }
+}
+
+namespace
+{
+    // 3D and 6D components in the layout of the protocol version, coordinates are doubles before 1.8.
+    std::vector<char> CreatePositionPacket(bool bigEndian, bool doubleLayout)
+    {
+        DataPacketBuilder builder(1000, 1, bigEndian);
+        auto putReals = [&](std::initializer_list<float> values)
+        {
+            for (float value : values)
+            {
+                if (doubleLayout)
+                {
+                    builder.Put(static_cast<double>(value));
+                }
+                else
+                {
+                    builder.Put(value);
+                }
+            }
+        };
+        // Items with a residual or id are padded to 8 bytes in the double layout.
+        auto pad = [&]()
+        {
+            if (doubleLayout)
+            {
+                builder.Put<std::uint32_t>(0);
+            }
+        };
+
+        builder.BeginComponent(CRTPacket::Component3d, 2, true);
+        putReals({ 1.0f, 2.0f, 3.0f });
+        putReals({ std::numeric_limits<float>::quiet_NaN(), 0.0f, 0.0f });
+        builder.EndComponent();
+
+        builder.BeginComponent(CRTPacket::Component3dRes, 1, true);
+        putReals({ 4.0f, 5.0f, 6.0f });
+        builder.Put(0.5f);
+        pad();
+        builder.EndComponent();
+
+        builder.BeginComponent(CRTPacket::Component3dNoLabels, 1, true);
+        putReals({ 7.0f, 8.0f, 9.0f });
+        builder.Put<std::uint32_t>(42);
+        pad();
+        builder.EndComponent();
+
+        builder.BeginComponent(CRTPacket::Component3dNoLabelsRes, 1, true);
+        putReals({ 10.0f, 11.0f, 12.0f });
+        builder.Put<std::uint32_t>(43);
+        builder.Put(0.25f);
+        builder.EndComponent();
+
+        builder.BeginComponent(CRTPacket::Component6d, 2, true);
+        for (float body = 0.0f; body < 2.0f; body += 1.0f)
+        {
+            putReals({ body + 1.0f, body + 2.0f, body + 3.0f });
+            putReals({ 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, body + 1.0f });
+        }
+        builder.EndComponent();
+
+        builder.BeginComponent(CRTPacket::Component6dRes, 1, true);
+        putReals({ 13.0f, 14.0f, 15.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f, 9.0f });
+        builder.Put(0.75f);
+        pad();
+        builder.EndComponent();
+
+        builder.BeginComponent(CRTPacket::Component6dEuler, 1, true);
+        putReals({ 16.0f, 17.0f, 18.0f, 90.0f, 45.0f, 30.0f });
+        builder.EndComponent();
+
+        builder.BeginComponent(CRTPacket::Component6dEulerRes, 1, true);
+        putReals({ 19.0f, 20.0f, 21.0f, 10.0f, 20.0f, 30.0f });
+        builder.Put(1.5f);
+        pad();
+        builder.EndComponent();
+
+        return builder.Finish();
+    }
+
+    void CheckPositionPacket(CRTPacket& packet)
+    {
+        float x, y, z, residual;
+        unsigned int id;
+        REQUIRE(packet.Get3DMarkerCount() == 2);
+        REQUIRE(packet.Get3DMarker(0, x, y, z));
+        CHECK(x == 1.0f);
+        CHECK(y == 2.0f);
+        CHECK(z == 3.0f);
+        CHECK_FALSE(packet.Get3DMarker(1, x, y, z));
+        CHECK(std::isnan(x));
+        CHECK_FALSE(packet.Get3DMarker(2, x, y, z));
+
+        REQUIRE(packet.Get3DResidualMarker(0, x, y, z, residual));
+        CHECK(x == 4.0f);
+        CHECK(z == 6.0f);
+        CHECK(residual == 0.5f);
+
+        REQUIRE(packet.Get3DNoLabelsMarker(0, x, y, z, id));
+        CHECK(y == 8.0f);
+        CHECK(id == 42);
+
+        REQUIRE(packet.Get3DNoLabelsResidualMarker(0, x, y, z, id, residual));
+        CHECK(z == 12.0f);
+        CHECK(id == 43);
+        CHECK(residual == 0.25f);
+
+        float rotation[9];
+        REQUIRE(packet.Get6DOFBodyCount() == 2);
+        REQUIRE(packet.Get6DOFBody(1, x, y, z, rotation));
+        CHECK(x == 2.0f);
+        CHECK(z == 4.0f);
+        CHECK(rotation[0] == 1.0f);
+        CHECK(rotation[8] == 2.0f);
+        CHECK_FALSE(packet.Get6DOFBody(2, x, y, z, rotation));
+
+        REQUIRE(packet.Get6DOFResidualBody(0, x, y, z, rotation, residual));
+        CHECK(x == 13.0f);
+        CHECK(rotation[8] == 9.0f);
+        CHECK(residual == 0.75f);
+
+        float angle1, angle2, angle3;
+        REQUIRE(packet.Get6DOFEulerBody(0, x, y, z, angle1, angle2, angle3));
+        CHECK(z == 18.0f);
+        CHECK(angle1 == 90.0f);
+        CHECK(angle3 == 30.0f);
+
+        REQUIRE(packet.Get6DOFEulerResidualBody(0, x, y, z, angle1, angle2, angle3, residual));
+        CHECK(x == 19.0f);
+        CHECK(angle2 == 20.0f);
+        CHECK(residual == 1.5f);
+    }
+}
+
+TEST_CASE("RTPacketDecoderTest")
+{
+    using namespace qualisys_cpp_sdk;
+    CHECK(PacketDecoder<false, PacketLayout::Double>::c6dResidualBodySize == 104);
+    CHECK(PacketDecoder<true, PacketLayout::Float>::c3dNoLabelsResidualMarkerSize == 20);
+
+    // Every byte order and layout generation, and the packet switching between them.
+    CRTPacket packet;
+    for (bool bigEndian : { false, true })
+    {
+        for (unsigned int minorVersion : { 7u, 8u, 28u })
+        {
+            auto data = CreatePositionPacket(bigEndian, minorVersion < 8);
+            packet.SetEndianness(bigEndian);
+            packet.SetVersion(1, minorVersion);
+            packet.SetData(data.data());
+            CHECK(packet.GetFrameNumber() == 1);
+            CheckPositionPacket(packet);
+        }
+    }
+
+    // Components that aren't in the packet.
+    auto mixed = CreateMixedPacket();
+    packet.SetEndianness(false);
+    packet.SetData(mixed.data());
+    float x, y, z;
+    CHECK_FALSE(packet.Get3DMarker(0, x, y, z));
+}
+
+namespace
+{
+    // All 3D components with the same markers, every fifth one occluded.
+    std::vector<char> Create3DPacket(bool bigEndian, bool doubleLayout, std::uint32_t markerCount)
+    {
+        DataPacketBuilder builder(1000, 1, bigEndian);
+        auto putPosition = [&](std::uint32_t marker)
+        {
+            const float x = marker % 5 == 3 ? std::numeric_limits<float>::quiet_NaN() : static_cast<float>(marker);
+            for (float value : { x, marker + 0.5f, -static_cast<float>(marker) })
+            {
+                if (doubleLayout)
+                {
+                    builder.Put(static_cast<double>(value));
+                }
+                else
+                {
+                    builder.Put(value);
+                }
+            }
+        };
+        const CRTPacket::EComponentType types[] = {
+            CRTPacket::Component3d, CRTPacket::Component3dRes, CRTPacket::Component3dNoLabels, CRTPacket::Component3dNoLabelsRes
+        };
+        for (auto type : types)
+        {
+            const bool id = type == CRTPacket::Component3dNoLabels || type == CRTPacket::Component3dNoLabelsRes;
+            const bool residual = type == CRTPacket::Component3dRes || type == CRTPacket::Component3dNoLabelsRes;
+            builder.BeginComponent(type, markerCount, true);
+            for (std::uint32_t marker = 0; marker < markerCount; marker++)
+            {
+                putPosition(marker);
+                if (id)
+                {
+                    builder.Put<std::uint32_t>(100 + marker);
+                }
+                if (residual)
+                {
+                    builder.Put(marker * 0.25f);
+                }
+                if (doubleLayout && (id || residual) && !(id && residual))
+                {
+                    builder.Put<std::uint32_t>(0);
+                }
+            }
+            builder.EndComponent();
+        }
+        return builder.Finish();
+    }
+
+    bool SamePosition(float x, float y, float z, std::uint32_t marker)
+    {
+        return (marker % 5 == 3 ? std::isnan(x) : x == static_cast<float>(marker)) &&
+            y == marker + 0.5f && z == -static_cast<float>(marker);
+    }
+
+    void CheckValidMask(const std::vector<unsigned int>& mask, std::uint32_t markerCount)
+    {
+        for (std::uint32_t marker = 0; marker < markerCount; marker++)
+        {
+            if (((mask[marker / 32] >> (marker % 32)) & 1) != (marker % 5 == 3 ? 0u : 1u))
+            {
+                FAIL(("Wrong valid bit for marker " + std::to_string(marker)).c_str());
+            }
+        }
+        // No bits past the last marker.
+        if (markerCount % 32 != 0)
+        {
+            CHECK((mask[markerCount / 32] >> (markerCount % 32)) == 0);
+        }
+    }
+}
+
+TEST_CASE("RTPacketBulk3DTest")
+{
+    const std::uint32_t markerCount = 71;
+    CRTPacket packet;
+    for (bool bigEndian : { false, true })
+    {
+        for (bool doubleLayout : { false, true })
+        {
+            auto data = Create3DPacket(bigEndian, doubleLayout, markerCount);
+            packet.SetEndianness(bigEndian);
+            packet.SetVersion(1, doubleLayout ? 7 : 28);
+            packet.SetData(data.data());
+
+            std::vector<CRTPacket::SPosition> positions(markerCount);
+            std::vector<CRTPacket::S3DResidualMarker> residualMarkers(markerCount);
+            std::vector<CRTPacket::S3DNoLabelsMarker> noLabelsMarkers(markerCount);
+            std::vector<CRTPacket::S3DNoLabelsResidualMarker> noLabelsResidualMarkers(markerCount);
+            std::vector<unsigned int> mask((markerCount + 31) / 32, ~0u);
+            REQUIRE(packet.Get3DMarkers(positions.data(), markerCount, mask.data()) == markerCount);
+            CheckValidMask(mask, markerCount);
+            REQUIRE(packet.Get3DResidualMarkers(residualMarkers.data(), markerCount, mask.data()) == markerCount);
+            CheckValidMask(mask, markerCount);
+            REQUIRE(packet.Get3DNoLabelsMarkers(noLabelsMarkers.data(), markerCount) == markerCount);
+            REQUIRE(packet.Get3DNoLabelsResidualMarkers(noLabelsResidualMarkers.data(), markerCount, mask.data()) == markerCount);
+            CheckValidMask(mask, markerCount);
+
+            std::vector<float> x(markerCount), y(markerCount), z(markerCount), residuals(markerCount);
+            std::vector<unsigned int> ids(markerCount);
+            const CRTPacket::S3DMarkerArrays arrays = { x.data(), y.data(), z.data(), residuals.data(), ids.data() };
+            std::fill(mask.begin(), mask.end(), ~0u);
+            REQUIRE(packet.Get3DMarkers(arrays, markerCount, mask.data()) == markerCount);
+            CheckValidMask(mask, markerCount);
+            for (std::uint32_t marker = 0; marker < markerCount; marker++)
+            {
+                const auto& position = positions[marker];
+                const auto& residualMarker = residualMarkers[marker];
+                const auto& noLabelsMarker = noLabelsMarkers[marker];
+                const auto& noLabelsResidualMarker = noLabelsResidualMarkers[marker];
+                if (!SamePosition(position.x, position.y, position.z, marker) ||
+                    !SamePosition(residualMarker.x, residualMarker.y, residualMarker.z, marker) ||
+                    residualMarker.residual != marker * 0.25f ||
+                    !SamePosition(noLabelsMarker.x, noLabelsMarker.y, noLabelsMarker.z, marker) || noLabelsMarker.id != 100 + marker ||
+                    !SamePosition(noLabelsResidualMarker.x, noLabelsResidualMarker.y, noLabelsResidualMarker.z, marker) ||
+                    noLabelsResidualMarker.id != 100 + marker || noLabelsResidualMarker.residual != marker * 0.25f ||
+                    !SamePosition(x[marker], y[marker], z[marker], marker))
+                {
+                    FAIL(("Wrong marker " + std::to_string(marker) + (bigEndian ? ", big endian" : "") + (doubleLayout ? ", double layout" : "")).c_str());
+                }
+            }
+
+            REQUIRE(packet.Get3DResidualMarkers(arrays, markerCount) == markerCount);
+            CHECK(residuals[markerCount - 1] == (markerCount - 1) * 0.25f);
+            REQUIRE(packet.Get3DNoLabelsMarkers(arrays, markerCount) == markerCount);
+            CHECK(ids[markerCount - 1] == 100 + markerCount - 1);
+            std::fill(ids.begin(), ids.end(), 0u);
+            REQUIRE(packet.Get3DNoLabelsResidualMarkers(arrays, markerCount) == markerCount);
+            CHECK(ids[7] == 107);
+            CHECK(residuals[7] == 7 * 0.25f);
+            float singleX, singleY, singleZ;
+            REQUIRE(packet.Get3DMarker(70, singleX, singleY, singleZ));
+            CHECK(y[70] == singleY);
+
+            // Too small buffers and missing arrays.
+            CHECK(packet.Get3DMarkers(positions.data(), markerCount - 1) == 0);
+            CHECK(packet.Get3DMarkers(CRTPacket::S3DMarkerArrays{ x.data(), nullptr, z.data(), nullptr, nullptr }, markerCount) == 0);
+        }
+    }
+
+    // Components that aren't in the packet.
+    auto mixed = CreateMixedPacket();
+    packet.SetEndianness(false);
+    packet.SetData(mixed.data());
+    CRTPacket::SPosition position;
+    CHECK(packet.Get3DMarkers(&position, 1) == 0);
+}
+
+namespace
+{
+    struct Quaternion
+    {
+        float x, y, z, w;
+    };
+
+    // Rotations of increasing angle about different axes, and one body that isn't tracked.
+    std::vector<Quaternion> CreateRotations(std::uint32_t bodyCount)
+    {
+        std::vector<Quaternion> rotations;
+        for (std::uint32_t body = 0; body + 1 < bodyCount; body++)
+        {
+            const float axis[3] = { 1.0f, static_cast<float>(body % 3), static_cast<float>(body * 7 % 5) - 2.0f };
+            const float length = std::sqrt(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+            const float angle = body * 0.6f;
+            const float s = std::sin(angle / 2) / length;
+            rotations.push_back({ axis[0] * s, axis[1] * s, axis[2] * s, std::cos(angle / 2) });
+        }
+        const float nan = std::numeric_limits<float>::quiet_NaN();
+        rotations.push_back({ nan, nan, nan, nan });
+        return rotations;
+    }
+
+    // Column major, as in the packet.
+    void ToMatrix(const Quaternion& q, float matrix[9])
+    {
+        const float r[3][3] = {
+            { 1 - 2 * (q.y * q.y + q.z * q.z), 2 * (q.x * q.y - q.z * q.w), 2 * (q.x * q.z + q.y * q.w) },
+            { 2 * (q.x * q.y + q.z * q.w), 1 - 2 * (q.x * q.x + q.z * q.z), 2 * (q.y * q.z - q.x * q.w) },
+            { 2 * (q.x * q.z - q.y * q.w), 2 * (q.y * q.z + q.x * q.w), 1 - 2 * (q.x * q.x + q.y * q.y) }
+        };
+        for (int column = 0; column < 3; column++)
+        {
+            for (int row = 0; row < 3; row++)
+            {
+                matrix[column * 3 + row] = r[row][column];
+            }
+        }
+    }
+
+    std::vector<char> Create6DOFPacket(bool bigEndian, bool doubleLayout, const std::vector<Quaternion>& rotations)
+    {
+        DataPacketBuilder builder(1000, 1, bigEndian);
+        auto putReal = [&](float value)
+        {
+            if (doubleLayout)
+            {
+                builder.Put(static_cast<double>(value));
+            }
+            else
+            {
+                builder.Put(value);
+            }
+        };
+        for (auto type : { CRTPacket::Component6d, CRTPacket::Component6dRes })
+        {
+            builder.BeginComponent(type, static_cast<std::uint32_t>(rotations.size()), true);
+            for (std::size_t body = 0; body < rotations.size(); body++)
+            {
+                float matrix[9];
+                ToMatrix(rotations[body], matrix);
+                putReal(body * 10.0f);
+                putReal(body * 20.0f);
+                putReal(body * 30.0f);
+                for (float value : matrix)
+                {
+                    putReal(value);
+                }
+                if (type == CRTPacket::Component6dRes)
+                {
+                    builder.Put(body * 0.5f);
+                    if (doubleLayout)
+                    {
+                        builder.Put<std::uint32_t>(0);
+                    }
+                }
+            }
+            builder.EndComponent();
+        }
+        return builder.Finish();
+    }
+
+    // The same rotation, q and -q included.
+    bool SameRotation(const CRTPacket::SRotation& rotation, const Quaternion& expected)
+    {
+        if (std::isnan(expected.w))
+        {
+            return std::isnan(rotation.x) && std::isnan(rotation.y) && std::isnan(rotation.z) && std::isnan(rotation.w);
+        }
+        const float length = rotation.x * rotation.x + rotation.y * rotation.y + rotation.z * rotation.z + rotation.w * rotation.w;
+        const float dot = rotation.x * expected.x + rotation.y * expected.y + rotation.z * expected.z + rotation.w * expected.w;
+        return std::fabs(length - 1.0f) < 1e-5f && std::fabs(std::fabs(dot) - 1.0f) < 1e-5f;
+    }
+}
+
+TEST_CASE("RTPacketBulk6DOFTest")
+{
+    // More than two batches, the last one partial.
+    const std::uint32_t bodyCount = 19;
+    const auto rotations = CreateRotations(bodyCount);
+
+    CRTPacket packet;
+    for (bool bigEndian : { false, true })
+    {
+        for (bool doubleLayout : { false, true })
+        {
+            auto data = Create6DOFPacket(bigEndian, doubleLayout, rotations);
+            packet.SetEndianness(bigEndian);
+            packet.SetVersion(1, doubleLayout ? 7 : 28);
+            packet.SetData(data.data());
+
+            std::vector<CRTPacket::S6DOFBody> bodies(bodyCount);
+            std::vector<CRTPacket::S6DOFResidualBody> residualBodies(bodyCount);
+            std::vector<CRTPacket::SPose> poses(bodyCount);
+            std::vector<CRTPacket::SPose> residualPoses(bodyCount);
+            std::vector<float> residuals(bodyCount);
+            REQUIRE(packet.Get6DOFBodies(bodies.data(), bodyCount) == bodyCount);
+            REQUIRE(packet.Get6DOFResidualBodies(residualBodies.data(), bodyCount) == bodyCount);
+            REQUIRE(packet.Get6DOFBodies(poses.data(), bodyCount) == bodyCount);
+            REQUIRE(packet.Get6DOFResidualBodies(residualPoses.data(), bodyCount, residuals.data()) == bodyCount);
+
+            for (std::uint32_t body = 0; body < bodyCount; body++)
+            {
+                float x, y, z, matrix[9], residual;
+                REQUIRE(packet.Get6DOFResidualBody(body, x, y, z, matrix, residual));
+                CRTPacket::SRotation rotation;
+                CRTPacket::RotationMatrixToQuaternion(matrix, rotation);
+
+                const auto& pose = poses[body];
+                const bool sameMatrix = std::memcmp(bodies[body].rotation, matrix, sizeof(matrix)) == 0 &&
+                    std::memcmp(residualBodies[body].rotation, matrix, sizeof(matrix)) == 0;
+                if (!sameMatrix || bodies[body].y != body * 20.0f || residualBodies[body].z != body * 30.0f ||
+                    residualBodies[body].residual != body * 0.5f ||
+                    pose.position.x != body * 10.0f || residualPoses[body].position.z != body * 30.0f || residuals[body] != residual ||
+                    !SameRotation(pose.rotation, rotations[body]) || !SameRotation(residualPoses[body].rotation, rotations[body]) ||
+                    !SameRotation(rotation, rotations[body]))
+                {
+                    FAIL(("Wrong body " + std::to_string(body) + (bigEndian ? ", big endian" : "") + (doubleLayout ? ", double layout" : "")).c_str());
+                }
+            }
+
+            CHECK(packet.Get6DOFBodies(poses.data(), bodyCount - 1) == 0);
+            CHECK(packet.Get6DOFResidualBodies(residualPoses.data(), bodyCount) == bodyCount);
+        }
+    }
+
+    // Half turns and close to half turns, where r32 - r23, r13 - r31 and r21 - r12 are 0 or close to it.
+    std::vector<Quaternion> halfTurns;
+    const float axes[][3] = { { 0, 0, 1 }, { 1, 0, 0 }, { 1, -1, 0 }, { 0, 1, -1 }, { -1, 0, 1 }, { 1, 2, -3 }, { -2, -1, 1 } };
+    for (const auto& axis : axes)
+    {
+        for (float angle : { 3.14159265f, 3.1f, 3.14f, -3.14f })
+        {
+            const float length = std::sqrt(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+            const float s = std::sin(angle / 2) / length;
+            halfTurns.push_back({ axis[0] * s, axis[1] * s, axis[2] * s, std::cos(angle / 2) });
+        }
+    }
+    auto halfTurnData = Create6DOFPacket(false, false, halfTurns);
+    packet.SetEndianness(false);
+    packet.SetVersion(1, 28);
+    packet.SetData(halfTurnData.data());
+    std::vector<CRTPacket::SPose> halfTurnPoses(halfTurns.size());
+    REQUIRE(packet.Get6DOFBodies(halfTurnPoses.data(), static_cast<unsigned int>(halfTurns.size())) == halfTurns.size());
+    for (std::size_t body = 0; body < halfTurns.size(); body++)
+    {
+        float matrix[9];
+        ToMatrix(halfTurns[body], matrix);
+        CRTPacket::SRotation rotation;
+        CRTPacket::RotationMatrixToQuaternion(matrix, rotation);
+        if (!SameRotation(rotation, halfTurns[body]) || !SameRotation(halfTurnPoses[body].rotation, halfTurns[body]) ||
+            rotation.w < 0.0f)
+        {
+            FAIL(("Wrong half turn " + std::to_string(body)).c_str());
+        }
+    }
+
+    auto mixed = CreateMixedPacket();
+    packet.SetEndianness(false);
+    packet.SetData(mixed.data());
+    CRTPacket::SPose pose;
+    CHECK(packet.Get6DOFResidualBodies(&pose, 1) == 0);
+}
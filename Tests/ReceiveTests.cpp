@@ -0,0 +1,294 @@
+#include "TestUtils.h"
+
+#include <doctest/doctest.h>
+
+#include <RTProtocol.h>
+#include <RTPacket.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+    #include <sys/socket.h>
+    #include <unistd.h>
+    #define closesocket close
+#endif
+
+using namespace qualisys_cpp_sdk::tests;
+
+TEST_CASE("ReceiveBackToBackPacketsTest")
+{
+    auto [protocol, network] = utils::CreateTestContext();
+
+    // Both packets become available in the same network read.
+    network->QueueResponse("First", CRTPacket::PacketCommand);
+    network->QueueResponse("Second", CRTPacket::PacketCommand);
+
+    CRTPacket::EPacketType type;
+    REQUIRE(protocol->Receive(type, true, 0) == CNetwork::ResponseType::success);
+    CHECK(type == CRTPacket::PacketCommand);
+    CHECK(std::strcmp(protocol->GetRTPacket()->GetCommandString(), "First") == 0);
+
+    REQUIRE(protocol->Receive(type, true, 0) == CNetwork::ResponseType::success);
+    CHECK(type == CRTPacket::PacketCommand);
+    CHECK(std::strcmp(protocol->GetRTPacket()->GetCommandString(), "Second") == 0);
+
+    CHECK(protocol->Receive(type, true, 0) == CNetwork::ResponseType::timeout);
+}
+
+TEST_CASE("ReceiveDatagramTest")
+{
+    auto [protocol, network] = utils::CreateTestContext();
+
+    // A streamed UDP frame arrives while a TCP packet is waiting. It isn't part of the TCP stream.
+    std::string datagram(24, '\0');
+    const std::uint32_t header[2] = { 24, static_cast<std::uint32_t>(CRTPacket::PacketData) };
+    const std::uint32_t frameNumber = 7;
+    std::memcpy(&datagram[0], header, sizeof(header));
+    std::memcpy(&datagram[16], &frameNumber, sizeof(frameNumber));
+    network->QueueResponse("First", CRTPacket::PacketCommand);
+    network->QueueDatagram(datagram);
+
+    CRTPacket::EPacketType type;
+    REQUIRE(protocol->Receive(type, true, 0) == CNetwork::ResponseType::success);
+    REQUIRE(type == CRTPacket::PacketData);
+    CHECK(protocol->GetRTPacket()->GetFrameNumber() == frameNumber);
+
+    REQUIRE(protocol->Receive(type, true, 0) == CNetwork::ResponseType::success);
+    REQUIRE(type == CRTPacket::PacketCommand);
+    CHECK(std::strcmp(protocol->GetRTPacket()->GetCommandString(), "First") == 0);
+}
+
+TEST_CASE("ReceiveLargePacketFrameHandleTest")
+{
+    auto [protocol, network] = utils::CreateTestContext();
+
+    // Larger than the receive buffer keeps, so it is received into a frame pool buffer.
+    const std::string large(300000, 'x');
+    network->QueueResponse(large.c_str(), CRTPacket::PacketCommand);
+    network->QueueResponse("Small", CRTPacket::PacketCommand);
+
+    CRTPacket::EPacketType type;
+    REQUIRE(protocol->Receive(type, true, 0) == CNetwork::ResponseType::success);
+    auto largeFrame = protocol->GetFrameHandle();
+    REQUIRE(largeFrame);
+
+    REQUIRE(protocol->Receive(type, true, 0) == CNetwork::ResponseType::success);
+    auto smallFrame = protocol->GetFrameHandle();
+    REQUIRE(smallFrame);
+
+    // Both frames stay valid after later receives.
+    CHECK(large == largeFrame->GetCommandString());
+    CHECK(std::strcmp(smallFrame->GetCommandString(), "Small") == 0);
+
+    // And after the pool is replaced and the protocol is destroyed.
+    protocol->SetFramePoolSize(2);
+    protocol.reset();
+    CHECK(large == largeFrame->GetCommandString());
+    CHECK(std::strcmp(smallFrame->GetCommandString(), "Small") == 0);
+}
+
+TEST_CASE("ProcessReadablePartialPacketTest")
+{
+    auto [protocol, network] = utils::CreateTestContext();
+
+    std::vector<std::string> received;
+    auto callback = [&received](CRTPacket::EPacketType type, CRTPacket* packet)
+    {
+        CHECK(type == CRTPacket::PacketCommand);
+        received.emplace_back(packet->GetCommandString());
+    };
+
+    CHECK(protocol->ProcessReadable(callback) == CNetwork::ResponseType::success);
+    CHECK(received.empty());
+
+    // The first packet arrives in two parts, the second part together with the next packet.
+    std::string packet(14, '\0');
+    packet[0] = 14;
+    packet[4] = static_cast<char>(CRTPacket::PacketCommand);
+    packet.replace(8, 5, "First");
+    network->QueueData(packet.data(), 10);
+    CHECK(protocol->ProcessReadable(callback) == CNetwork::ResponseType::success);
+    CHECK(received.empty());
+
+    network->QueueData(packet.data() + 10, packet.size() - 10);
+    network->QueueResponse("Second", CRTPacket::PacketCommand);
+    CHECK(protocol->ProcessReadable(callback) == CNetwork::ResponseType::success);
+    REQUIRE(received.size() == 2);
+    CHECK(received[0] == "First");
+    CHECK(received[1] == "Second");
+}
+
+TEST_CASE("ReceiveRestOfPacketTest")
+{
+    auto [protocol, network] = utils::CreateTestContext();
+
+    // Whole packets and datagrams are waited for as usual.
+    network->QueueResponse("Whole", CRTPacket::PacketCommand);
+    std::string datagram(24, '\0');
+    const std::uint32_t header[2] = { 24, static_cast<std::uint32_t>(CRTPacket::PacketData) };
+    std::memcpy(&datagram[0], header, sizeof(header));
+    network->QueueDatagram(datagram);
+    CRTPacket::EPacketType type;
+    REQUIRE(protocol->Receive(type, true, 0) == CNetwork::ResponseType::success);
+    CHECK(type == CRTPacket::PacketData);
+    REQUIRE(protocol->Receive(type, true, 0) == CNetwork::ResponseType::success);
+    CHECK(std::strcmp(protocol->GetRTPacket()->GetCommandString(), "Whole") == 0);
+    CHECK(network->GetRestReceiveCount() == 0);
+
+    // Only the rest of a partially read packet, 23 bytes in reads of 10.
+    network->SetMaxReadSize(10);
+    network->QueueResponse("Partial packet", CRTPacket::PacketCommand);
+    REQUIRE(protocol->Receive(type, true, 0) == CNetwork::ResponseType::success);
+    CHECK(std::strcmp(protocol->GetRTPacket()->GetCommandString(), "Partial packet") == 0);
+    CHECK(network->GetRestReceiveCount() == 2);
+}
+
+TEST_CASE("ProcessReadableMaxPacketsTest")
+{
+    auto [protocol, network] = utils::CreateTestContext();
+
+    // One packet per read.
+    network->SetMaxReadSize(14);
+    for (const char* command : { "Cmd01", "Cmd02", "Cmd03", "Cmd04", "Cmd05" })
+    {
+        network->QueueResponse(command, CRTPacket::PacketCommand);
+    }
+
+    std::vector<std::string> received;
+    auto callback = [&received](CRTPacket::EPacketType, CRTPacket* packet)
+    {
+        received.emplace_back(packet->GetCommandString());
+    };
+    CHECK(protocol->ProcessReadable(callback, 2) == CNetwork::ResponseType::success);
+    CHECK(received.size() == 2);
+    CHECK(protocol->ProcessReadable(callback, 2) == CNetwork::ResponseType::success);
+    CHECK(received.size() == 4);
+    CHECK(protocol->ProcessReadable(callback, 2) == CNetwork::ResponseType::success);
+    REQUIRE(received.size() == 5);
+    CHECK(received[4] == "Cmd05");
+}
+
+TEST_CASE("ProcessReadableFilePacketTest")
+{
+    auto [protocol, network] = utils::CreateTestContext();
+
+    // Only the start of a large file has arrived. It is an error outside of GetCapture, and the receive
+    // buffer isn't grown to hold the file.
+    std::string packet(16, '\0');
+    const std::uint32_t size = 100000000;
+    std::memcpy(&packet[0], &size, sizeof(size));
+    packet[4] = static_cast<char>(CRTPacket::PacketC3DFile);
+    network->QueueData(packet.data(), packet.size());
+
+    auto callback = [](CRTPacket::EPacketType, CRTPacket*) { FAIL("No packet expected."); };
+    CHECK(protocol->ProcessReadable(callback) == CNetwork::ResponseType::error);
+    CHECK(std::string(protocol->GetErrorString()) == "Receive file buffer not opened.");
+
+    // Not connected.
+    CRTProtocol unconnected;
+    CHECK(unconnected.ProcessReadable(callback) == CNetwork::ResponseType::error);
+}
+
+TEST_CASE("JoinMulticastGroupBoundSocketTest")
+{
+    // The UDP data socket was bound without address reuse, as by StreamFrames with a UDP port.
+    CNetwork first;
+    unsigned short udpPort = 0;
+    REQUIRE(first.CreateUDPSocket(udpPort));
+    if (!first.JoinMulticastGroup("239.255.0.1", udpPort, "127.0.0.1"))
+    {
+        FAIL(first.GetErrorString());
+    }
+    CHECK(first.GetUdpServerPort() == udpPort);
+
+    // So that another consumer can share the port.
+    CNetwork second;
+    if (!second.JoinMulticastGroup("239.255.0.1", udpPort, "127.0.0.1"))
+    {
+        FAIL(second.GetErrorString());
+    }
+}
+
+namespace
+{
+    // Send data to port on the loopback interface, from a socket of its own.
+    void SendLoopbackDatagram(unsigned short port, const std::string& data)
+    {
+        SOCKET udpSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        REQUIRE(udpSocket != INVALID_SOCKET);
+        sockaddr_in addr {};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        CHECK(sendto(udpSocket, data.data(), static_cast<int>(data.size()), 0, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == static_cast<int>(data.size()));
+        closesocket(udpSocket);
+    }
+}
+
+TEST_CASE("ReceiveUdpWhileWaitingTest")
+{
+    // Nothing is queued when the receive starts, so it waits in select on the UDP socket only.
+    CNetwork network;
+    unsigned short udpPort = 0;
+    REQUIRE(network.CreateUDPSocket(udpPort));
+
+    std::thread sender([udpPort]()
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        SendLoopbackDatagram(udpPort, "First datagram");
+    });
+    std::vector<char> buffer(1024);
+    char* buffers[] = { buffer.data() };
+    int sizes[1];
+    const auto batch = network.ReceiveUdpBatch(buffers, static_cast<int>(buffer.size()), sizes, 1, 5000000);
+    sender.join();
+    REQUIRE(batch.type == CNetwork::ResponseType::success);
+    REQUIRE(batch.received == 1);
+    CHECK(std::string(buffer.data(), sizes[0]) == "First datagram");
+
+    CNetwork broadcastNetwork;
+    unsigned short broadcastPort = 0;
+    REQUIRE(broadcastNetwork.CreateUDPSocket(broadcastPort, true));
+    sender = std::thread([broadcastPort]()
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        SendLoopbackDatagram(broadcastPort, "Second datagram");
+    });
+    const auto broadcast = broadcastNetwork.ReceiveUdpBroadcast(buffer.data(), static_cast<int>(buffer.size()), 5000000);
+    sender.join();
+    REQUIRE(broadcast.type == CNetwork::ResponseType::success);
+    CHECK(std::string(buffer.data(), broadcast.received) == "Second datagram");
+}
+
+TEST_CASE("ReceiveBatchDroppedDatagramsTest")
+{
+    auto [protocol, network] = utils::CreateTestContext();
+
+    auto dataPacket = [](std::uint32_t frameNumber)
+    {
+        std::string packet(24, '\0');
+        const std::uint32_t header[2] = { 24, static_cast<std::uint32_t>(CRTPacket::PacketData) };
+        std::memcpy(&packet[0], header, sizeof(header));
+        std::memcpy(&packet[16], &frameNumber, sizeof(frameNumber));
+        return packet;
+    };
+    network->QueueDatagram(dataPacket(1));
+    network->QueueDatagram(dataPacket(2).substr(0, 20)); // Truncated
+    network->QueueDatagram(std::string(4, '\0'));        // No header
+    network->QueueDatagram(dataPacket(3));
+
+    unsigned int frameCount;
+    REQUIRE(protocol->ReceiveBatch(frameCount, 8, 0) == CNetwork::ResponseType::success);
+    REQUIRE(frameCount == 2);
+    CHECK(protocol->GetBatchPacket(0)->GetFrameNumber() == 1);
+    CHECK(protocol->GetBatchPacket(1)->GetFrameNumber() == 3);
+    CHECK(protocol->GetDroppedDatagramCount() == 2);
+
+    CHECK(protocol->ReceiveBatch(frameCount, 8, 0) == CNetwork::ResponseType::timeout);
+    CHECK(protocol->GetDroppedDatagramCount() == 2);
+}
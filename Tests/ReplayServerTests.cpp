@@ -0,0 +1,127 @@
+#include <doctest/doctest.h>
+
+#include <RTProtocol.h>
+#include <ReplayServer.h>
+#include <StreamAggregator.h>
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+
+using namespace qualisys_cpp_sdk;
+using namespace qualisys_cpp_sdk::replay;
+
+namespace
+{
+    ReplayOptions CreateOptions()
+    {
+        ReplayOptions options;
+        options.basePort = 0;
+        options.frequency = 100;
+        options.markerCount = 4;
+        options.bodyCount = 2;
+        return options;
+    }
+
+    // The next packet that isn't an event, or PacketNone on timeout.
+    CRTPacket::EPacketType ReceivePacket(CRTProtocol& protocol)
+    {
+        CRTPacket::EPacketType type;
+        if (protocol.Receive(type) != CNetwork::ResponseType::success)
+        {
+            return CRTPacket::PacketNone;
+        }
+        return type;
+    }
+}
+
+TEST_CASE("ReplayServerStreamFramesTest")
+{
+    ReplayServer server(CreateOptions());
+    REQUIRE(server.Start());
+
+    CRTProtocol protocol;
+    REQUIRE(protocol.Connect("127.0.0.1", server.GetBasePort()));
+    unsigned int major, minor;
+    REQUIRE(protocol.GetVersion(major, minor));
+    CHECK(major == MAJOR_VERSION);
+    CHECK(minor == MINOR_VERSION);
+
+    REQUIRE(protocol.StreamFrames(CRTProtocol::EStreamRate::RateAllFrames, 0, 0, nullptr, CRTProtocol::cComponent3d | CRTProtocol::cComponent6d));
+    REQUIRE(ReceivePacket(protocol) == CRTPacket::PacketData);
+
+    CRTPacket* packet = protocol.GetRTPacket();
+    CHECK(packet->GetFrameNumber() >= 1);
+    CHECK(packet->GetComponentCount() == 2);
+    CHECK(packet->Get3DMarkerCount() == 4);
+    float x, y, z;
+    REQUIRE(packet->Get3DMarker(1, x, y, z));
+    CHECK(z == 10.0f);
+    REQUIRE(packet->Get6DOFBodyCount() == 2);
+    float rotation[9];
+    REQUIRE(packet->Get6DOFBody(1, x, y, z, rotation));
+    CHECK(x == 200.0f);
+    CHECK(rotation[8] == 1.0f);
+
+    CHECK(protocol.StreamFramesStop());
+    protocol.Disconnect();
+}
+
+TEST_CASE("ReplayServerOldVersionTest")
+{
+    // Synthetic frames are never built with the double coordinates of versions before 1.8.
+    ReplayServer server(CreateOptions());
+    REQUIRE(server.Start());
+
+    CRTProtocol protocol;
+    CHECK_FALSE(protocol.Connect("127.0.0.1", server.GetBasePort(), nullptr, 1, 7));
+    CHECK_FALSE(protocol.Connected());
+}
+
+TEST_CASE("ReplayServerUdpWithoutPortTest")
+{
+    ReplayServer server(CreateOptions());
+    REQUIRE(server.Start());
+
+    CRTProtocol protocol;
+    REQUIRE(protocol.Connect("127.0.0.1", server.GetBasePort()));
+
+    // Without a port the frames must not be streamed over TCP instead.
+    REQUIRE(protocol.PostCommand("StreamFrames AllFrames UDP 3D"));
+    REQUIRE(ReceivePacket(protocol) == CRTPacket::PacketError);
+    CHECK(std::string(protocol.GetRTPacket()->GetErrorString()) == "Missing UDP port in UDP");
+
+    REQUIRE(protocol.PostCommand("StreamFrames AllFrames UDP:nowhere:5000 3D"));
+    REQUIRE(ReceivePacket(protocol) == CRTPacket::PacketError);
+    CHECK(std::string(protocol.GetRTPacket()->GetErrorString()) == "Invalid UDP address in UDP:nowhere:5000");
+
+    CHECK(server.GetSentFrames() == 0);
+    protocol.Disconnect();
+}
+
+TEST_CASE("ReplayServerAggregatorStopTest")
+{
+    ReplayServer server(CreateOptions());
+    REQUIRE(server.Start());
+
+    auto protocol = std::make_unique<CRTProtocol>();
+    REQUIRE(protocol->Connect("127.0.0.1", server.GetBasePort()));
+    REQUIRE(protocol->StreamFrames(CRTProtocol::EStreamRate::RateAllFrames, 0, 0, nullptr, CRTProtocol::cComponent3d));
+
+    StreamAggregator aggregator;
+    aggregator.AddSource(std::move(protocol));
+    REQUIRE(aggregator.Start());
+    AggregatedFrame frame;
+    REQUIRE(aggregator.PopFrame(frame, 5000000));
+    REQUIRE(frame.frames.size() == 1);
+    CHECK(frame.frames[0]->Get3DMarkerCount() == 4);
+
+    // The event thread waits for the idle source without a timeout, Stop must wake it.
+    REQUIRE(aggregator.GetSource(0)->StreamFramesStop());
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    const auto start = std::chrono::steady_clock::now();
+    aggregator.Stop();
+    CHECK(std::chrono::steady_clock::now() - start < std::chrono::seconds(1));
+    CHECK_FALSE(aggregator.IsRunning());
+}
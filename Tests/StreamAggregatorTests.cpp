@@ -0,0 +1,51 @@
+#include "TestUtils.h"
+
+#include <doctest/doctest.h>
+
+#include <StreamAggregator.h>
+
+using namespace qualisys_cpp_sdk;
+using namespace qualisys_cpp_sdk::tests;
+
+TEST_CASE("StreamAggregatorTimestampMergeTest")
+{
+    auto [protocolA, networkA] = utils::CreateTestContext();
+    auto [protocolB, networkB] = utils::CreateTestContext();
+
+    networkA->QueueDataPacket(100, 1);
+    networkA->QueueDataPacket(200, 2);
+    networkA->QueueDataPacket(300, 3);
+    networkB->QueueDataPacket(205, 11);
+    networkB->QueueDataPacket(305, 12);
+    networkB->QueueDataPacket(405, 13);
+
+    StreamAggregator aggregator(StreamAggregator::EMergeKey::Timestamp, 10);
+    aggregator.AddSource(std::move(protocolA));
+    aggregator.AddSource(std::move(protocolB));
+    REQUIRE(aggregator.Start());
+
+    AggregatedFrame frame;
+    REQUIRE(aggregator.PopFrame(frame, 1000000));
+    CHECK(frame.key == 205);
+    REQUIRE(frame.frames.size() == 2);
+    CHECK(frame.frames[0]->GetFrameNumber() == 2);
+    CHECK(frame.frames[1]->GetFrameNumber() == 11);
+
+    REQUIRE(aggregator.PopFrame(frame, 1000000));
+    CHECK(frame.key == 305);
+    CHECK(frame.frames[0]->GetFrameNumber() == 3);
+    CHECK(frame.frames[1]->GetFrameNumber() == 12);
+
+    CHECK_FALSE(aggregator.PopFrame(frame, 10000));
+    aggregator.Stop();
+
+    const auto statisticsA = aggregator.GetSourceStatistics(0);
+    CHECK(statisticsA.receivedFrames == 3);
+    CHECK(statisticsA.unmatchedFrames == 1);
+    CHECK(statisticsA.bufferedFrames == 0);
+
+    const auto statisticsB = aggregator.GetSourceStatistics(1);
+    CHECK(statisticsB.receivedFrames == 3);
+    CHECK(statisticsB.unmatchedFrames == 0);
+    CHECK(statisticsB.bufferedFrames == 1);
+}
@@ -5,8 +5,12 @@
 
 #include <doctest/doctest.h>
 #include <tinyxml2.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
 #include <optional>
 #include <sstream>
+#include <string>
 #include <vector>
 #include <memory>
 
@@ -17,6 +21,7 @@ namespace qualisys_cpp_sdk::tests::utils
         std::string startWith;
         std::string response;
         CRTPacket::EPacketType packetType;
+        std::string followingData; // Raw bytes sent after the response
 
         bool Compare(const std::string& message) const
         {
@@ -30,6 +35,9 @@ namespace qualisys_cpp_sdk::tests::utils
         std::stringstream stringStream;
         std::stringstream outputStream;
         std::vector<MessageFilter> messageAndResponses;
+        int maxReadSize = 0; // Bytes per Receive, 0 for all that is queued
+        std::vector<std::string> datagrams;
+        int restReceiveCount = 0; // ReceiveRest calls
 
         bool Connect(const char*, unsigned short) override
         {
@@ -55,8 +63,17 @@ namespace qualisys_cpp_sdk::tests::utils
 
         Response Receive(char* rtDataBuff, int nDataBufSize, bool bHeader, int, unsigned*) override
         {
+            // Queued datagrams arrive first, as if the UDP data socket had become readable.
+            if (!datagrams.empty())
+            {
+                Response response{ ResponseType::success, std::min(nDataBufSize, static_cast<int>(datagrams.front().size())) };
+                std::memcpy(rtDataBuff, datagrams.front().data(), response.received);
+                response.datagram = true;
+                datagrams.erase(datagrams.begin());
+                return response;
+            }
             auto start = stringStream.tellg();
-            auto sizeRead = stringStream.readsome(rtDataBuff, bHeader ? 8 : nDataBufSize);
+            auto sizeRead = stringStream.readsome(rtDataBuff, bHeader ? 8 : (maxReadSize > 0 && maxReadSize < nDataBufSize ? maxReadSize : nDataBufSize));
             stringStream.seekg(start + sizeRead);
             return Response{
                 sizeRead > 0 ? ResponseType::success : ResponseType::timeout,
@@ -64,6 +81,12 @@ namespace qualisys_cpp_sdk::tests::utils
             };
         }
 
+        Response ReceiveRest(char* rtDataBuff, int nDataBufSize, int timeoutMicroseconds) override
+        {
+            restReceiveCount++;
+            return Receive(rtDataBuff, nDataBufSize, false, timeoutMicroseconds, nullptr);
+        }
+
         Response ReceiveUdpBroadcast(char*, int, int, unsigned*) override
         {
             return Response{
@@ -81,6 +104,7 @@ namespace qualisys_cpp_sdk::tests::utils
                 if (x.Compare(sendText))
                 {
                     QueueResponse(x.response.data(), x.packetType);
+                    QueueData(x.followingData.data(), x.followingData.size());
                     break;
                 }
             }
@@ -90,6 +114,23 @@ namespace qualisys_cpp_sdk::tests::utils
             return true;
         }
 
+        Response ReceiveUdpBatch(char* const* buffers, int bufferSize, int* sizes, int maxCount, int, unsigned long long* timestamps) override
+        {
+            int count = 0;
+            for (; count < maxCount && count < static_cast<int>(datagrams.size()); count++)
+            {
+                const auto& datagram = datagrams[count];
+                sizes[count] = std::min(bufferSize, static_cast<int>(datagram.size()));
+                std::memcpy(buffers[count], datagram.data(), sizes[count]);
+                if (timestamps != nullptr)
+                {
+                    timestamps[count] = 0;
+                }
+            }
+            datagrams.erase(datagrams.begin(), datagrams.begin() + count);
+            return Response{ count > 0 ? ResponseType::success : ResponseType::timeout, count };
+        }
+
         bool SendUDPBroadcast(const char*, int, short, unsigned) override
         {
             return true;
@@ -142,13 +183,52 @@ namespace qualisys_cpp_sdk::tests::utils
             stringStream.write(str, dataSize);
         }
 
+        void SetMaxReadSize(int size)
+        {
+            maxReadSize = size;
+        }
+
+        int GetRestReceiveCount() const
+        {
+            return restReceiveCount;
+        }
+
+        void QueueData(const char* data, size_t size)
+        {
+            stringStream.write(data, static_cast<long long>(size));
+        }
+
+        // Read by Receive and ReceiveUdpBatch, like a datagram of the UDP data socket.
+        void QueueDatagram(const std::string& datagram)
+        {
+            datagrams.push_back(datagram);
+        }
+
+        // Data packet without components.
+        void QueueDataPacket(std::uint64_t timestamp, std::uint32_t frameNumber)
+        {
+            const std::uint32_t header[2] = { 24, static_cast<std::uint32_t>(CRTPacket::PacketData) };
+            const std::uint32_t componentCount = 0;
+            stringStream.write(reinterpret_cast<const char*>(header), sizeof(header));
+            stringStream.write(reinterpret_cast<const char*>(&timestamp), sizeof(timestamp));
+            stringStream.write(reinterpret_cast<const char*>(&frameNumber), sizeof(frameNumber));
+            stringStream.write(reinterpret_cast<const char*>(&componentCount), sizeof(componentCount));
+        }
+
         void PrepareResponse(const std::string& message, const std::string& response,
                              const CRTPacket::EPacketType responsePacketType)
+        {
+            PrepareResponse(message, response, responsePacketType, std::string{});
+        }
+
+        void PrepareResponse(const std::string& message, const std::string& response,
+                             const CRTPacket::EPacketType responsePacketType, const std::string& followingData)
         {
             messageAndResponses.push_back(MessageFilter{
                 message,
                 response,
-                responsePacketType
+                responsePacketType,
+                followingData
             });
         }
 